@@ -0,0 +1,502 @@
+#include "Engine/common/Inflate.h"
+
+namespace
+{
+    constexpr uint32_t WINDOW_SIZE = 1 << 15;
+    constexpr uint32_t WINDOW_MASK = WINDOW_SIZE - 1;
+    constexpr uint32_t ADLER_MOD = 65521;
+    // largest n such that 255 * n * (n + 1) / 2 + (n + 1) * (ADLER_MOD - 1) fits in 32 bits
+    constexpr uint32_t ADLER_NMAX = 5552;
+
+    constexpr uint16_t LENGTH_BASE[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    constexpr uint8_t LENGTH_EXTRA[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    constexpr uint16_t DIST_BASE[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    constexpr uint8_t DIST_EXTRA[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    constexpr uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    enum : int { NEED_BITS = -1, INVALID_CODE = -2 };
+
+    // peeks a symbol from the low bits of the bit buffer without consuming it.
+    int DecodeSymbol(const Inflater::Huffman& huffman, uint64_t bits, uint32_t numBits, uint32_t& codeLength)
+    {
+        uint16_t entry = huffman.mFast[bits & ((1u << Inflater::FAST_BITS) - 1)];
+        if (entry)
+        {
+            codeLength = entry & 15;
+            return codeLength <= numBits ? entry >> 4 : NEED_BITS;
+        }
+        // canonical walk, codes are stored msb first inside the lsb first bit stream
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (uint32_t length = 1; length < 16; ++length)
+        {
+            if (length > numBits) return NEED_BITS;
+            code |= static_cast<int>((bits >> (length - 1)) & 1);
+            int count = huffman.mCount[length];
+            if (code - count < first)
+            {
+                codeLength = length;
+                return huffman.mSymbol[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return INVALID_CODE;
+    }
+
+    void BuildFixedTables(Inflater::Huffman& litLen, Inflater::Huffman& dist)
+    {
+        uint8_t lengths[288];
+        memset(lengths, 8, 144);
+        memset(lengths + 144, 9, 112);
+        memset(lengths + 256, 7, 24);
+        memset(lengths + 280, 8, 8);
+        litLen.build(lengths, 288);
+        memset(lengths, 5, 30);
+        dist.build(lengths, 30);
+    }
+
+    const Inflater::Huffman* FixedTables()
+    {
+        static const std::unique_ptr<Inflater::Huffman[]> sTables = []
+        {
+            std::unique_ptr<Inflater::Huffman[]> tables{ new Inflater::Huffman[2] };
+            BuildFixedTables(tables[0], tables[1]);
+            return tables;
+        }();
+        return sTables.get();
+    }
+
+    void UpdateAdler(uint32_t& a, uint32_t& b, const byte* pData, uint64_t size)
+    {
+        while (size)
+        {
+            uint64_t chunk = (std::min)(size, static_cast<uint64_t>(ADLER_NMAX));
+            size -= chunk;
+            for (uint64_t i = 0; i < chunk; ++i)
+            {
+                a += pData[i];
+                b += a;
+            }
+            pData += chunk;
+            a %= ADLER_MOD;
+            b %= ADLER_MOD;
+        }
+    }
+}
+
+bool Inflater::Huffman::build(const uint8_t* pLengths, uint32_t numSymbols)
+{
+    memset(mCount, 0, sizeof(mCount));
+    memset(mFast, 0, sizeof(mFast));
+    for (uint32_t symbol = 0; symbol < numSymbols; ++symbol)
+    {
+        mCount[pLengths[symbol]]++;
+    }
+    mCount[0] = 0;
+
+    // over-subscribed sets can't be decoded, incomplete ones are legal (a lone distance code)
+    int left = 1;
+    for (uint32_t length = 1; length < 16; ++length)
+    {
+        left <<= 1;
+        left -= mCount[length];
+        if (left < 0) return false;
+    }
+
+    uint16_t offsets[16];
+    offsets[1] = 0;
+    for (uint32_t length = 1; length < 15; ++length)
+    {
+        offsets[length + 1] = offsets[length] + mCount[length];
+    }
+    for (uint32_t symbol = 0; symbol < numSymbols; ++symbol)
+    {
+        if (pLengths[symbol]) mSymbol[offsets[pLengths[symbol]]++] = static_cast<uint16_t>(symbol);
+    }
+
+    // walk the symbols in canonical order and spread the short codes over the fast table
+    uint32_t code = 0;
+    uint32_t index = 0;
+    for (uint32_t length = 1; length <= FAST_BITS; ++length)
+    {
+        for (uint32_t i = 0; i < mCount[length]; ++i, ++code, ++index)
+        {
+            uint32_t reversed = 0;
+            for (uint32_t bit = 0; bit < length; ++bit)
+            {
+                reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+            }
+            for (uint32_t slot = reversed; slot < (1u << FAST_BITS); slot += 1u << length)
+            {
+                mFast[slot] = static_cast<uint16_t>(mSymbol[index] << 4 | length);
+            }
+        }
+        code <<= 1;
+    }
+    return true;
+}
+
+Inflater::Inflater() : mWindow(new byte[WINDOW_SIZE]), mTables(new Huffman[3])
+{
+    reset();
+}
+
+void Inflater::reset()
+{
+    mLitLen = nullptr;
+    mDist = nullptr;
+    mBits = 0;
+    mTotalOut = 0;
+    mNumBits = 0;
+    mWindowPos = 0;
+    mAdlerA = 1;
+    mAdlerB = 0;
+    mStoredRemaining = 0;
+    mMatchLength = 0;
+    mMatchDistance = 0;
+    mNumTrailingBytes = 0;
+    mNumLitLenCodes = 0;
+    mNumDistCodes = 0;
+    mNumCodeLengthCodes = 0;
+    mCodeIndex = 0;
+    mIsFinalBlock = false;
+    mState = State::ZLIB_HEADER;
+}
+
+void Inflater::refill(const byte*& pIn, const byte* pInEnd)
+{
+    if (pInEnd - pIn >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, pIn, sizeof(word));
+        mBits |= word << mNumBits;
+        pIn += (63 - mNumBits) >> 3;
+        mNumBits |= 56;
+        // drop the bits of bytes that were peeked but not taken, the buffer only ever holds consumed input
+        mBits &= (1ull << mNumBits) - 1;
+        return;
+    }
+    while (mNumBits < 56 && pIn < pInEnd)
+    {
+        mBits |= static_cast<uint64_t>(*pIn++) << mNumBits;
+        mNumBits += 8;
+    }
+}
+
+void Inflater::consume(uint32_t numBits)
+{
+    mBits >>= numBits;
+    mNumBits -= numBits;
+}
+
+void Inflater::emit(byte*& pOut, byte value)
+{
+    *pOut++ = value;
+    mWindow[mWindowPos] = value;
+    mWindowPos = (mWindowPos + 1) & WINDOW_MASK;
+}
+
+Inflater::Status Inflater::fail()
+{
+    mState = State::FAILED;
+    return Status::FAILED;
+}
+
+Inflater::Status Inflater::inflate(const byte*& pIn, const byte* pInEnd, byte*& pOut, byte* pOutEnd)
+{
+    if (mState == State::DONE) return Status::DONE;
+    const byte* pInBegin = pIn;
+    byte* pOutBegin = pOut;
+    Status status = Status::NEED_INPUT;
+    bool isRunning = true;
+    while (isRunning)
+    {
+        refill(pIn, pInEnd);
+        switch (mState)
+        {
+        case State::ZLIB_HEADER:
+        {
+            if (mNumBits < 16) { status = Status::NEED_INPUT; isRunning = false; break; }
+            uint32_t cmf = mBits & 0xFF;
+            uint32_t flg = (mBits >> 8) & 0xFF;
+            // deflate only, window <= 32k, no preset dictionary
+            if ((cmf & 0xF) != 8 || (cmf >> 4) > 7 || (flg & 0x20) || (cmf << 8 | flg) % 31 != 0) return fail();
+            consume(16);
+            mState = State::BLOCK_HEADER;
+            break;
+        }
+        case State::BLOCK_HEADER:
+        {
+            if (mNumBits < 3) { status = Status::NEED_INPUT; isRunning = false; break; }
+            mIsFinalBlock = mBits & 1;
+            uint32_t type = (mBits >> 1) & 3;
+            consume(3);
+            if (type == 0)
+            {
+                mState = State::STORED_HEADER;
+            }
+            else if (type == 1)
+            {
+                const Huffman* pFixed = FixedTables();
+                mLitLen = pFixed;
+                mDist = pFixed + 1;
+                mState = State::SYMBOLS;
+            }
+            else if (type == 2)
+            {
+                mState = State::TABLE_HEADER;
+            }
+            else
+            {
+                return fail();
+            }
+            break;
+        }
+        case State::STORED_HEADER:
+        {
+            consume(mNumBits & 7);
+            if (mNumBits < 32) { status = Status::NEED_INPUT; isRunning = false; break; }
+            uint32_t length = mBits & 0xFFFF;
+            uint32_t inverted = (mBits >> 16) & 0xFFFF;
+            if ((length ^ 0xFFFF) != inverted) return fail();
+            consume(32);
+            mStoredRemaining = length;
+            mState = State::STORED_COPY;
+            break;
+        }
+        case State::STORED_COPY:
+        {
+            // drain the whole bytes still sitting in the bit buffer, then copy straight from the input
+            while (mStoredRemaining && pOut < pOutEnd && mNumBits >= 8)
+            {
+                emit(pOut, static_cast<byte>(mBits & 0xFF));
+                consume(8);
+                mStoredRemaining--;
+            }
+            if (mNumBits < 8)
+            {
+                uint64_t count = (std::min)({ static_cast<uint64_t>(mStoredRemaining),
+                                              static_cast<uint64_t>(pOutEnd - pOut),
+                                              static_cast<uint64_t>(pInEnd - pIn) });
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    emit(pOut, pIn[i]);
+                }
+                pIn += count;
+                mStoredRemaining -= static_cast<uint32_t>(count);
+            }
+            if (mStoredRemaining == 0)
+            {
+                mState = mIsFinalBlock ? State::CHECKSUM : State::BLOCK_HEADER;
+            }
+            else if (pOut == pOutEnd)
+            {
+                status = Status::OUTPUT_FULL;
+                isRunning = false;
+            }
+            else if (pIn == pInEnd && mNumBits < 8)
+            {
+                status = Status::NEED_INPUT;
+                isRunning = false;
+            }
+            break;
+        }
+        case State::TABLE_HEADER:
+        {
+            if (mNumBits < 14) { status = Status::NEED_INPUT; isRunning = false; break; }
+            mNumLitLenCodes = static_cast<uint16_t>((mBits & 0x1F) + 257);
+            mNumDistCodes = static_cast<uint16_t>(((mBits >> 5) & 0x1F) + 1);
+            mNumCodeLengthCodes = static_cast<uint16_t>(((mBits >> 10) & 0xF) + 4);
+            consume(14);
+            if (mNumLitLenCodes > 286 || mNumDistCodes > 30) return fail();
+            memset(mLengths, 0, sizeof(mLengths));
+            mCodeIndex = 0;
+            mState = State::CODE_LENGTH_LENGTHS;
+            break;
+        }
+        case State::CODE_LENGTH_LENGTHS:
+        {
+            while (mCodeIndex < mNumCodeLengthCodes && mNumBits >= 3)
+            {
+                mLengths[CODE_LENGTH_ORDER[mCodeIndex++]] = mBits & 7;
+                consume(3);
+            }
+            if (mCodeIndex < mNumCodeLengthCodes)
+            {
+                if (pIn == pInEnd) { status = Status::NEED_INPUT; isRunning = false; }
+                break;
+            }
+            if (!mTables[2].build(mLengths, 19)) return fail();
+            memset(mLengths, 0, 19);
+            mCodeIndex = 0;
+            mState = State::CODE_LENGTHS;
+            break;
+        }
+        case State::CODE_LENGTHS:
+        {
+            uint32_t numCodes = mNumLitLenCodes + mNumDistCodes;
+            while (mCodeIndex < numCodes)
+            {
+                uint32_t codeLength;
+                int symbol = DecodeSymbol(mTables[2], mBits, mNumBits, codeLength);
+                if (symbol == INVALID_CODE) return fail();
+                if (symbol == NEED_BITS) break;
+                if (symbol < 16)
+                {
+                    consume(codeLength);
+                    mLengths[mCodeIndex++] = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+                // repeat codes carry 2, 3 or 7 extra bits, all of them have to be there before committing
+                uint32_t numExtra = symbol == 16 ? 2 : symbol == 17 ? 3 : 7;
+                if (codeLength + numExtra > mNumBits) { symbol = NEED_BITS; break; }
+                uint32_t extra = (mBits >> codeLength) & ((1u << numExtra) - 1);
+                uint32_t repeat;
+                uint8_t value = 0;
+                if (symbol == 16)
+                {
+                    if (mCodeIndex == 0) return fail();
+                    value = mLengths[mCodeIndex - 1];
+                    repeat = 3 + extra;
+                }
+                else
+                {
+                    repeat = symbol == 17 ? 3 + extra : 11 + extra;
+                }
+                if (mCodeIndex + repeat > numCodes) return fail();
+                consume(codeLength + numExtra);
+                memset(mLengths + mCodeIndex, value, repeat);
+                mCodeIndex = static_cast<uint16_t>(mCodeIndex + repeat);
+            }
+            if (mCodeIndex < numCodes)
+            {
+                if (pIn == pInEnd) { status = Status::NEED_INPUT; isRunning = false; }
+                break;
+            }
+            if (mLengths[256] == 0) return fail();
+            uint8_t distLengths[32];
+            memcpy(distLengths, mLengths + mNumLitLenCodes, mNumDistCodes);
+            if (!mTables[0].build(mLengths, mNumLitLenCodes) || !mTables[1].build(distLengths, mNumDistCodes)) return fail();
+            mLitLen = &mTables[0];
+            mDist = &mTables[1];
+            mState = State::SYMBOLS;
+            break;
+        }
+        case State::SYMBOLS:
+        {
+            while (pOut < pOutEnd)
+            {
+                refill(pIn, pInEnd);
+                uint32_t litLength;
+                int symbol = DecodeSymbol(*mLitLen, mBits, mNumBits, litLength);
+                if (symbol == INVALID_CODE) return fail();
+                if (symbol == NEED_BITS) break;
+                if (symbol < 256)
+                {
+                    consume(litLength);
+                    emit(pOut, static_cast<byte>(symbol));
+                    continue;
+                }
+                if (symbol == 256)
+                {
+                    consume(litLength);
+                    mState = mIsFinalBlock ? State::CHECKSUM : State::BLOCK_HEADER;
+                    break;
+                }
+                symbol -= 257;
+                if (symbol >= 29) return fail();
+                // a whole length / distance pair is at most 48 bits, peek all of it before committing
+                uint32_t used = litLength;
+                uint32_t lengthExtra = LENGTH_EXTRA[symbol];
+                if (used + lengthExtra > mNumBits) { symbol = NEED_BITS; break; }
+                uint32_t length = LENGTH_BASE[symbol] + static_cast<uint32_t>((mBits >> used) & ((1u << lengthExtra) - 1));
+                used += lengthExtra;
+                uint32_t distLength;
+                int distSymbol = DecodeSymbol(*mDist, mBits >> used, mNumBits - used, distLength);
+                if (distSymbol == INVALID_CODE || distSymbol >= 30) return fail();
+                if (distSymbol == NEED_BITS) break;
+                used += distLength;
+                uint32_t distExtra = DIST_EXTRA[distSymbol];
+                if (used + distExtra > mNumBits) break;
+                uint32_t distance = DIST_BASE[distSymbol] + static_cast<uint32_t>((mBits >> used) & ((1u << distExtra) - 1));
+                used += distExtra;
+                if (distance > mTotalOut + (pOut - pOutBegin)) return fail();
+                consume(used);
+                mMatchLength = length;
+                mMatchDistance = distance;
+                mState = State::MATCH_COPY;
+                break;
+            }
+            if (mState == State::SYMBOLS)
+            {
+                status = pOut == pOutEnd ? Status::OUTPUT_FULL : Status::NEED_INPUT;
+                isRunning = false;
+            }
+            break;
+        }
+        case State::MATCH_COPY:
+        {
+            uint64_t count = (std::min)(static_cast<uint64_t>(mMatchLength), static_cast<uint64_t>(pOutEnd - pOut));
+            uint32_t src = (mWindowPos - mMatchDistance) & WINDOW_MASK;
+            for (uint64_t i = 0; i < count; ++i)
+            {
+                emit(pOut, mWindow[src]);
+                src = (src + 1) & WINDOW_MASK;
+            }
+            mMatchLength -= static_cast<uint32_t>(count);
+            if (mMatchLength == 0)
+            {
+                mState = State::SYMBOLS;
+            }
+            else
+            {
+                status = Status::OUTPUT_FULL;
+                isRunning = false;
+            }
+            break;
+        }
+        case State::CHECKSUM:
+        {
+            consume(mNumBits & 7);
+            if (mNumBits < 32) { status = Status::NEED_INPUT; isRunning = false; break; }
+            UpdateAdler(mAdlerA, mAdlerB, pOutBegin, pOut - pOutBegin);
+            mTotalOut += pOut - pOutBegin;
+            pOutBegin = pOut;
+            uint32_t stored = static_cast<uint32_t>(mBits & 0xFFFFFFFF);
+            stored = (stored >> 24) | ((stored >> 8) & 0xFF00) | ((stored << 8) & 0xFF0000) | (stored << 24);
+            consume(32);
+            if (stored != (mAdlerB << 16 | mAdlerA)) return fail();
+            // the whole bytes left in the bit buffer lie past the end of the stream. they are the ones read last,
+            // this call's input is handed back, what earlier calls read is only counted
+            uint64_t numTrailing = mNumBits >> 3;
+            uint64_t numHandedBack = (std::min)(numTrailing, static_cast<uint64_t>(pIn - pInBegin));
+            pIn -= numHandedBack;
+            mNumTrailingBytes = static_cast<uint32_t>(numTrailing - numHandedBack);
+            consume(mNumBits);
+            mState = State::DONE;
+            status = Status::DONE;
+            isRunning = false;
+            break;
+        }
+        case State::DONE:
+            break;
+        case State::FAILED:
+            return Status::FAILED;
+        }
+    }
+    UpdateAdler(mAdlerA, mAdlerB, pOutBegin, pOut - pOutBegin);
+    mTotalOut += pOut - pOutBegin;
+    return status;
+}
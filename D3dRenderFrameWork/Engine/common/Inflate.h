@@ -0,0 +1,91 @@
+#pragma once
+#include "Engine/pch.h"
+
+// resumable zlib (rfc 1950 / 1951) decompressor. input and output may come and go in pieces of any size,
+// decoding stops at the first boundary it can't cross and picks up from there on the next call.
+class Inflater
+{
+public:
+    enum class Status : uint8_t
+    {
+        NEED_INPUT,
+        OUTPUT_FULL,
+        DONE,
+        FAILED,
+    };
+
+    // advances pIn and pOut past the bytes consumed and produced.
+    Status inflate(const byte*& pIn, const byte* pInEnd, byte*& pOut, byte* pOutEnd);
+    void reset();
+    // once DONE: bytes past the end of the stream that calls before the last one already took from their input.
+    // the last call leaves its own ones in front of pIn, these the caller has to get back from the previous input.
+    uint32_t numTrailingBytes() const;
+
+    Inflater();
+
+    DELETE_COPY_CONSTRUCTOR(Inflater)
+    DELETE_COPY_OPERATOR(Inflater)
+    DEFAULT_MOVE_CONSTRUCTOR(Inflater)
+    DEFAULT_MOVE_OPERATOR(Inflater)
+
+    static constexpr uint32_t FAST_BITS = 10;
+
+    struct Huffman
+    {
+        bool build(const uint8_t* pLengths, uint32_t numSymbols);
+
+        // (symbol << 4) | code length for codes up to FAST_BITS long, 0 falls back to the canonical walk.
+        uint16_t mFast[1 << FAST_BITS];
+        uint16_t mCount[16];
+        uint16_t mSymbol[288];
+    };
+
+private:
+    enum class State : uint8_t
+    {
+        ZLIB_HEADER,
+        BLOCK_HEADER,
+        STORED_HEADER,
+        STORED_COPY,
+        TABLE_HEADER,
+        CODE_LENGTH_LENGTHS,
+        CODE_LENGTHS,
+        SYMBOLS,
+        MATCH_COPY,
+        CHECKSUM,
+        DONE,
+        FAILED,
+    };
+
+    void refill(const byte*& pIn, const byte* pInEnd);
+    void consume(uint32_t numBits);
+    void emit(byte*& pOut, byte value);
+    Status fail();
+
+    std::unique_ptr<byte[]> mWindow;
+    std::unique_ptr<Huffman[]> mTables;     // literal/length, distance, code length
+    const Huffman* mLitLen;
+    const Huffman* mDist;
+    uint64_t mBits;
+    uint64_t mTotalOut;
+    uint32_t mNumBits;
+    uint32_t mWindowPos;
+    uint32_t mAdlerA;
+    uint32_t mAdlerB;
+    uint32_t mStoredRemaining;
+    uint32_t mMatchLength;
+    uint32_t mMatchDistance;
+    uint32_t mNumTrailingBytes;
+    uint16_t mNumLitLenCodes;
+    uint16_t mNumDistCodes;
+    uint16_t mNumCodeLengthCodes;
+    uint16_t mCodeIndex;
+    uint8_t mLengths[288 + 32];
+    bool mIsFinalBlock;
+    State mState;
+};
+
+inline uint32_t Inflater::numTrailingBytes() const
+{
+    return mNumTrailingBytes;
+}
@@ -0,0 +1,58 @@
+#ifdef WIN32
+#include "Engine/common/PC/MappedFile.h"
+#include "Engine/common/Exception.h"
+
+std::shared_ptr<MappedFile> MappedFile::sOpen(const String& path)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        THROW_EXCEPTION(TEXT("Failed to open file"));
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        THROW_EXCEPTION(TEXT("Failed to map empty file"));
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        THROW_EXCEPTION(TEXT("Failed to create file mapping"));
+    }
+
+    void* pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!pView)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        THROW_EXCEPTION(TEXT("Failed to map view of file"));
+    }
+    return std::shared_ptr<MappedFile>(new MappedFile(file, mapping, static_cast<const byte*>(pView),
+                                                      static_cast<uint64_t>(fileSize.QuadPart)));
+}
+
+const byte* MappedFile::data() const
+{
+    return mView;
+}
+
+uint64_t MappedFile::size() const
+{
+    return mSize;
+}
+
+MappedFile::MappedFile(HANDLE file, HANDLE mapping, const byte* pView, uint64_t size) :
+    mFile(file), mMapping(mapping), mView(pView), mSize(size) { }
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(mView);
+    CloseHandle(mMapping);
+    CloseHandle(mFile);
+}
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+
+// read only view of a whole file, pages are faulted in by the os on first access.
+// hand it out as shared_ptr so anything pointing into the view keeps it alive.
+class MappedFile
+{
+public:
+    static std::shared_ptr<MappedFile> sOpen(const String& path);
+
+    const byte* data() const;
+    uint64_t size() const;
+
+    ~MappedFile();
+
+    DELETE_COPY_CONSTRUCTOR(MappedFile)
+    DELETE_COPY_OPERATOR(MappedFile)
+    DELETE_MOVE_CONSTRUCTOR(MappedFile)
+    DELETE_MOVE_OPERATOR(MappedFile)
+
+private:
+    MappedFile(HANDLE file, HANDLE mapping, const byte* pView, uint64_t size);
+
+    HANDLE mFile;
+    HANDLE mMapping;
+    const byte* mView;
+    uint64_t mSize;
+};
+#endif
@@ -0,0 +1,202 @@
+#pragma once
+#include "Engine/pch.h"
+#include <atomic>
+#include <condition_variable>
+
+// persistent worker threads shared by the cpu side data-parallel kernels (texture decoding, conversion...).
+// a parallelFor splits [begin, end) into grains, the calling thread works on grains too. a grain that throws
+// doesn't stop the others, the first exception is rethrown on the calling thread once all grains finished.
+class WorkerPool
+{
+public:
+    static WorkerPool& instance();
+
+    template<typename Func>
+    void parallelFor(uint64_t begin, uint64_t end, uint64_t grainSize, Func&& func);
+    uint32_t numThreads() const;
+
+    ~WorkerPool();
+
+    DELETE_COPY_CONSTRUCTOR(WorkerPool)
+    DELETE_COPY_OPERATOR(WorkerPool)
+    DELETE_MOVE_CONSTRUCTOR(WorkerPool)
+    DELETE_MOVE_OPERATOR(WorkerPool)
+
+private:
+    struct Job
+    {
+        void (*mInvoke)(void* pFunc, uint64_t begin, uint64_t end);
+        void* mFunc;
+        uint64_t mBegin;
+        uint64_t mEnd;
+        uint64_t mGrainSize;
+        uint64_t mNumGrains;
+        std::atomic<uint64_t> mNextGrain;
+        std::atomic<uint64_t> mNumFinishedGrains;
+        std::atomic<bool> mHasFailed;
+        std::exception_ptr mException;      // of the first grain that threw, written once mHasFailed is claimed
+    };
+
+    WorkerPool();
+    void workerLoop();
+    void runGrains(Job& job) const;
+    void dispatch(Job& job);
+
+    static thread_local bool sIsWorkerThread;
+    static thread_local bool sIsRunningGrains;     // the dispatching thread, while it works on its own job
+
+    std::vector<std::thread> mThreads;
+    std::mutex mDispatchMutex;
+    std::mutex mJobMutex;
+    std::condition_variable mJobReady;
+    std::condition_variable mJobDone;
+    Job* mJob;
+    uint64_t mJobGeneration;
+    uint32_t mNumActiveWorkers;
+    bool mIsQuitting;
+};
+
+inline WorkerPool& WorkerPool::instance()
+{
+    static WorkerPool pool{};
+    return pool;
+}
+
+template <typename Func>
+void WorkerPool::parallelFor(uint64_t begin, uint64_t end, uint64_t grainSize, Func&& func)
+{
+    if (end <= begin) return;
+    grainSize = (std::max)(grainSize, static_cast<uint64_t>(1));
+    uint64_t numGrains = (end - begin + grainSize - 1) / grainSize;
+    // nested calls from inside a grain or a single grain run inline, the pool never waits on itself. that covers
+    // grains on the dispatching thread as well, which still holds mDispatchMutex.
+    if (numGrains == 1 || mThreads.empty() || sIsWorkerThread || sIsRunningGrains)
+    {
+        func(begin, end);
+        return;
+    }
+
+    using FuncType = std::remove_reference_t<Func>;
+    Job job;
+    job.mInvoke = [](void* pFunc, uint64_t grainBegin, uint64_t grainEnd)
+    {
+        (*static_cast<FuncType*>(pFunc))(grainBegin, grainEnd);
+    };
+    job.mFunc = const_cast<void*>(static_cast<const void*>(std::addressof(func)));
+    job.mBegin = begin;
+    job.mEnd = end;
+    job.mGrainSize = grainSize;
+    job.mNumGrains = numGrains;
+    job.mNextGrain = 0;
+    job.mNumFinishedGrains = 0;
+    job.mHasFailed = false;
+    dispatch(job);
+}
+
+inline uint32_t WorkerPool::numThreads() const
+{
+    return static_cast<uint32_t>(mThreads.size()) + 1;
+}
+
+inline WorkerPool::WorkerPool() : mJob(nullptr), mJobGeneration(0), mNumActiveWorkers(0), mIsQuitting(false)
+{
+    uint32_t numHardwareThreads = std::thread::hardware_concurrency();
+    uint32_t numWorkers = numHardwareThreads > 1 ? numHardwareThreads - 1 : 0;
+    mThreads.reserve(numWorkers);
+    for (uint32_t i = 0; i < numWorkers; ++i)
+    {
+        mThreads.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+inline WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{ mJobMutex };
+        mIsQuitting = true;
+    }
+    mJobReady.notify_all();
+    for (auto& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+inline void WorkerPool::runGrains(Job& job) const
+{
+    uint64_t grain;
+    while ((grain = job.mNextGrain.fetch_add(1, std::memory_order_relaxed)) < job.mNumGrains)
+    {
+        uint64_t grainBegin = job.mBegin + grain * job.mGrainSize;
+        uint64_t grainEnd = (std::min)(grainBegin + job.mGrainSize, job.mEnd);
+        try
+        {
+            job.mInvoke(job.mFunc, grainBegin, grainEnd);
+        }
+        catch (...)
+        {
+            bool hasFailed = false;
+            if (job.mHasFailed.compare_exchange_strong(hasFailed, true)) job.mException = std::current_exception();
+        }
+        // counted either way, the job outlives its grains only if every one of them is
+        job.mNumFinishedGrains.fetch_add(1, std::memory_order_release);
+    }
+}
+
+inline void WorkerPool::dispatch(Job& job)
+{
+    // only one job is in flight at a time, concurrent callers queue up here.
+    std::lock_guard<std::mutex> dispatchLock{ mDispatchMutex };
+    {
+        std::lock_guard<std::mutex> lock{ mJobMutex };
+        mJob = &job;
+        mJobGeneration++;
+    }
+    mJobReady.notify_all();
+    {
+        struct RunningGrainsScope
+        {
+            RunningGrainsScope() { sIsRunningGrains = true; }
+            ~RunningGrainsScope() { sIsRunningGrains = false; }
+        } runningGrains;
+        runGrains(job);
+    }
+
+    std::unique_lock<std::mutex> lock{ mJobMutex };
+    mJobDone.wait(lock, [&]
+    {
+        return job.mNumFinishedGrains.load(std::memory_order_acquire) == job.mNumGrains && mNumActiveWorkers == 0;
+    });
+    mJob = nullptr;
+    lock.unlock();
+    if (job.mException) std::rethrow_exception(job.mException);
+}
+
+inline void WorkerPool::workerLoop()
+{
+    sIsWorkerThread = true;
+    uint64_t seenGeneration = 0;
+    std::unique_lock<std::mutex> lock{ mJobMutex };
+    while (true)
+    {
+        mJobReady.wait(lock, [&] { return mIsQuitting || (mJob && mJobGeneration != seenGeneration); });
+        if (mIsQuitting) return;
+        seenGeneration = mJobGeneration;
+        Job* job = mJob;
+        mNumActiveWorkers++;
+        lock.unlock();
+        runGrains(*job);
+        lock.lock();
+        mNumActiveWorkers--;
+        if (mNumActiveWorkers == 0) mJobDone.notify_all();
+    }
+}
+
+inline thread_local bool WorkerPool::sIsWorkerThread = false;
+inline thread_local bool WorkerPool::sIsRunningGrains = false;
+
+template<typename Func>
+void ParallelFor(uint64_t begin, uint64_t end, uint64_t grainSize, Func&& func)
+{
+    WorkerPool::instance().parallelFor(begin, end, grainSize, std::forward<Func>(func));
+}
@@ -0,0 +1,112 @@
+#include "Engine/common/RadixSort.h"
+#include "Engine/common/Parallel.h"
+
+#undef max
+#undef min
+
+namespace
+{
+    constexpr uint32_t NUM_PASSES = 8;
+    constexpr uint32_t NUM_BUCKETS = 256;
+    // keys per parallel grain, grains are the unit the histograms and the scatter are split by
+    constexpr uint64_t KEYS_PER_GRAIN = 16 * 1024;
+
+    using Histogram = std::array<uint64_t, NUM_BUCKETS>;
+}
+
+void RadixSort(uint64_t* pKeys, uint32_t* pValues, uint64_t count, uint64_t* pKeyScratch, uint32_t* pValueScratch)
+{
+    if (count < 2) return;
+    uint64_t numGrains = (count + KEYS_PER_GRAIN - 1) / KEYS_PER_GRAIN;
+
+    // histograms of all bytes up front to find the passes that can be skipped, the histogram of a byte over all
+    // keys doesn't depend on their order
+    std::vector<std::array<Histogram, NUM_PASSES>> grainTotals(numGrains);
+    ParallelFor(0, numGrains, 1, [&](uint64_t firstGrain, uint64_t lastGrain)
+    {
+        for (uint64_t grain = firstGrain; grain < lastGrain; ++grain)
+        {
+            auto& totals = grainTotals[grain];
+            for (Histogram& histogram : totals) histogram.fill(0);
+            uint64_t end = (std::min)((grain + 1) * KEYS_PER_GRAIN, count);
+            for (uint64_t i = grain * KEYS_PER_GRAIN; i < end; ++i)
+            {
+                uint64_t key = pKeys[i];
+                for (uint32_t pass = 0; pass < NUM_PASSES; ++pass)
+                {
+                    ++totals[pass][key >> (pass * 8) & 0xff];
+                }
+            }
+        }
+    });
+    bool isPassNeeded[NUM_PASSES];
+    for (uint32_t pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        Histogram totals{};
+        for (const auto& grainTotal : grainTotals)
+        {
+            for (uint32_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) totals[bucket] += grainTotal[pass][bucket];
+        }
+        isPassNeeded[pass] = std::find(totals.begin(), totals.end(), count) == totals.end();
+    }
+
+    uint64_t* pSrcKeys = pKeys;
+    uint32_t* pSrcValues = pValues;
+    uint64_t* pDstKeys = pKeyScratch;
+    uint32_t* pDstValues = pValueScratch;
+    std::vector<Histogram> grainOffsets(numGrains);
+    for (uint32_t pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        if (!isPassNeeded[pass]) continue;
+        uint32_t shift = pass * 8;
+        ParallelFor(0, numGrains, 1, [&](uint64_t firstGrain, uint64_t lastGrain)
+        {
+            for (uint64_t grain = firstGrain; grain < lastGrain; ++grain)
+            {
+                Histogram& counts = grainOffsets[grain];
+                counts.fill(0);
+                uint64_t end = (std::min)((grain + 1) * KEYS_PER_GRAIN, count);
+                for (uint64_t i = grain * KEYS_PER_GRAIN; i < end; ++i)
+                {
+                    ++counts[pSrcKeys[i] >> shift & 0xff];
+                }
+            }
+        });
+
+        // a grain writes bucket b after all smaller buckets and after the earlier grains' keys of bucket b
+        uint64_t offset = 0;
+        for (uint32_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+        {
+            for (uint64_t grain = 0; grain < numGrains; ++grain)
+            {
+                uint64_t numKeys = grainOffsets[grain][bucket];
+                grainOffsets[grain][bucket] = offset;
+                offset += numKeys;
+            }
+        }
+
+        ParallelFor(0, numGrains, 1, [&](uint64_t firstGrain, uint64_t lastGrain)
+        {
+            for (uint64_t grain = firstGrain; grain < lastGrain; ++grain)
+            {
+                Histogram& offsets = grainOffsets[grain];
+                uint64_t end = (std::min)((grain + 1) * KEYS_PER_GRAIN, count);
+                for (uint64_t i = grain * KEYS_PER_GRAIN; i < end; ++i)
+                {
+                    uint64_t key = pSrcKeys[i];
+                    uint64_t dst = offsets[key >> shift & 0xff]++;
+                    pDstKeys[dst] = key;
+                    pDstValues[dst] = pSrcValues[i];
+                }
+            }
+        });
+        std::swap(pSrcKeys, pDstKeys);
+        std::swap(pSrcValues, pDstValues);
+    }
+
+    if (pSrcKeys != pKeys)
+    {
+        memcpy(pKeys, pSrcKeys, count * sizeof(uint64_t));
+        memcpy(pValues, pSrcValues, count * sizeof(uint32_t));
+    }
+}
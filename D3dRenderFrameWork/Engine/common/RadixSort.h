@@ -0,0 +1,8 @@
+#pragma once
+#include "Engine/pch.h"
+
+// stable lsd radix sort of 64 bit keys with a 32 bit payload each, one byte per pass.
+// every pass builds per grain histograms and scatters the grains in parallel. passes whose byte is the same in
+// all keys are skipped, so keys that only use their upper bits cost as much as the bits that actually differ.
+// pKeyScratch and pValueScratch must hold count entries, the sorted result ends up in pKeys and pValues.
+void RadixSort(uint64_t* pKeys, uint32_t* pValues, uint64_t count, uint64_t* pKeyScratch, uint32_t* pValueScratch);
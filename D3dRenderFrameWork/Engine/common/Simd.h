@@ -0,0 +1,79 @@
+#pragma once
+#include "Engine/pch.h"
+
+// x86 simd support shared by the cpu side kernels. the project is built for the sse2 baseline, wider kernels
+// are compiled with SIMD_TARGET_AVX2 and only called after GetCpuFeatures() says the cpu and os support them.
+#if defined(_M_X64) || defined(__x86_64__)
+#define SIMD_X64
+#endif
+// sse2 kernels need no dispatch, every x64 cpu has it
+#if defined(SIMD_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define SIMD_SSE2
+#include <immintrin.h>
+#endif
+// set when the whole build targets avx (/arch:AVX2 or -mavx2), inline header kernels then use ymm registers directly
+#if defined(SIMD_SSE2) && defined(__AVX__)
+#define SIMD_AVX
+#endif
+#if defined(SIMD_AVX) && (defined(__AVX2__) || defined(__FMA__))
+#define SIMD_FMA
+#endif
+#ifdef SIMD_X64
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#endif
+#endif
+
+struct CpuFeatures
+{
+    bool mHasSse41;
+    bool mHasAvx2;      // avx2 and fma, with ymm state saved by the os
+    bool mHasF16c;
+};
+
+namespace Simd
+{
+    inline CpuFeatures DetectCpuFeatures()
+    {
+        CpuFeatures features{ false, false, false };
+#ifdef SIMD_X64
+        uint32_t leaf1[4] = {};
+        uint32_t leaf7[4] = {};
+#if defined(_MSC_VER)
+        __cpuid(reinterpret_cast<int*>(leaf1), 1);
+        __cpuidex(reinterpret_cast<int*>(leaf7), 7, 0);
+#else
+        __get_cpuid(1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]);
+        __get_cpuid_count(7, 0, &leaf7[0], &leaf7[1], &leaf7[2], &leaf7[3]);
+#endif
+        bool hasOsXsave = leaf1[2] & (1u << 27);
+        bool hasAvx = leaf1[2] & (1u << 28);
+        uint64_t xcr0 = 0;
+        if (hasOsXsave)
+        {
+#if defined(_MSC_VER)
+            xcr0 = _xgetbv(0);
+#else
+            uint32_t low, high;
+            __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+            xcr0 = static_cast<uint64_t>(high) << 32 | low;
+#endif
+        }
+        bool hasYmmState = (xcr0 & 6) == 6;
+        features.mHasSse41 = leaf1[2] & (1u << 19);
+        features.mHasAvx2 = hasAvx && hasYmmState && (leaf7[1] & (1u << 5)) && (leaf1[2] & (1u << 12));
+        features.mHasF16c = hasAvx && hasYmmState && (leaf1[2] & (1u << 29));
+#endif
+        return features;
+    }
+}
+
+inline const CpuFeatures& GetCpuFeatures()
+{
+    static const CpuFeatures features = Simd::DetectCpuFeatures();
+    return features;
+}
@@ -0,0 +1,104 @@
+#include "Engine/common/StreamCopy.h"
+#include "Engine/common/Exception.h"
+#include "Engine/common/Simd.h"
+#include <map>
+
+namespace
+{
+    constexpr uint64_t BLOCK_SIZE = 16;
+    constexpr uint64_t BLOCKS_PER_LINE = 4;
+
+#if defined(DEBUG) or defined(_DEBUG)
+    // begin address to size of every registered range
+    std::map<uintptr_t, uint64_t> gUploadRanges;
+    std::mutex gUploadRangesMutex;
+#endif
+}
+
+void StreamWrite(void* pDst, const void* pSrc, uint64_t size)
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    UploadMemory::CheckRead(pSrc, size);
+#endif
+    uint8_t* pDstBytes = static_cast<uint8_t*>(pDst);
+    const uint8_t* pSrcBytes = static_cast<const uint8_t*>(pSrc);
+#ifdef SIMD_SSE2
+    if (size >= BLOCK_SIZE)
+    {
+        uint64_t head = (BLOCK_SIZE - (reinterpret_cast<uintptr_t>(pDstBytes) & (BLOCK_SIZE - 1))) & (BLOCK_SIZE - 1);
+        memcpy(pDstBytes, pSrcBytes, head);
+        pDstBytes += head;
+        pSrcBytes += head;
+        size -= head;
+
+        __m128i* pDstBlocks = reinterpret_cast<__m128i*>(pDstBytes);
+        const __m128i* pSrcBlocks = reinterpret_cast<const __m128i*>(pSrcBytes);
+        uint64_t numBlocks = size / BLOCK_SIZE;
+        uint64_t block = 0;
+        // all loads of a line before its stores, the write combining buffer is filled in one go
+        for (; block + BLOCKS_PER_LINE <= numBlocks; block += BLOCKS_PER_LINE)
+        {
+            __m128i a = _mm_loadu_si128(pSrcBlocks + block);
+            __m128i b = _mm_loadu_si128(pSrcBlocks + block + 1);
+            __m128i c = _mm_loadu_si128(pSrcBlocks + block + 2);
+            __m128i d = _mm_loadu_si128(pSrcBlocks + block + 3);
+            _mm_stream_si128(pDstBlocks + block, a);
+            _mm_stream_si128(pDstBlocks + block + 1, b);
+            _mm_stream_si128(pDstBlocks + block + 2, c);
+            _mm_stream_si128(pDstBlocks + block + 3, d);
+        }
+        for (; block < numBlocks; ++block)
+        {
+            _mm_stream_si128(pDstBlocks + block, _mm_loadu_si128(pSrcBlocks + block));
+        }
+        pDstBytes += numBlocks * BLOCK_SIZE;
+        pSrcBytes += numBlocks * BLOCK_SIZE;
+        size -= numBlocks * BLOCK_SIZE;
+    }
+#endif
+    memcpy(pDstBytes, pSrcBytes, size);
+}
+
+void StreamFence()
+{
+#ifdef SIMD_SSE2
+    _mm_sfence();
+#endif
+}
+
+void StreamCopy(void* pDst, const void* pSrc, uint64_t size)
+{
+    StreamWrite(pDst, pSrc, size);
+    StreamFence();
+}
+
+// the parameters are only read by the debug bookkeeping
+void UploadMemory::Register([[maybe_unused]] const void* pBegin, [[maybe_unused]] uint64_t size)
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    std::lock_guard<std::mutex> lock(gUploadRangesMutex);
+    gUploadRanges[reinterpret_cast<uintptr_t>(pBegin)] = size;
+#endif
+}
+
+void UploadMemory::Unregister([[maybe_unused]] const void* pBegin)
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    std::lock_guard<std::mutex> lock(gUploadRangesMutex);
+    gUploadRanges.erase(reinterpret_cast<uintptr_t>(pBegin));
+#endif
+}
+
+void UploadMemory::CheckRead([[maybe_unused]] const void* p, [[maybe_unused]] uint64_t size)
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    if (size == 0) return;
+    uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+    std::lock_guard<std::mutex> lock(gUploadRangesMutex);
+    // the last range starting before the end of the read is the only one that can overlap it
+    auto range = gUploadRanges.lower_bound(begin + size);
+    if (range == gUploadRanges.begin()) return;
+    --range;
+    ASSERT(range->first + range->second <= begin, TEXT("reading back from write combined upload memory\n"));
+#endif
+}
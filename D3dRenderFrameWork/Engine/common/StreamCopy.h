@@ -0,0 +1,21 @@
+#pragma once
+#include "Engine/pch.h"
+
+// copy into write combined memory such as mapped upload heaps. the 16 byte aligned blocks of the destination are
+// written with non temporal stores, a cache line per iteration, only an unaligned head and tail go through plain
+// stores. the destination is never read. debug builds assert when the source lies in registered upload memory.
+// StreamWrite leaves the stores unordered, a thread issuing several of them calls StreamFence once after the last.
+void StreamWrite(void* pDst, const void* pSrc, uint64_t size);
+void StreamFence();
+// StreamWrite followed by StreamFence
+void StreamCopy(void* pDst, const void* pSrc, uint64_t size);
+
+// bookkeeping of cpu mapped upload memory for debug builds, which check that it is only ever written.
+// reads from write combined memory bypass the cache and stall on every access. no-ops in release builds.
+namespace UploadMemory
+{
+    void Register(const void* pBegin, uint64_t size);
+    void Unregister(const void* pBegin);
+    // asserts when [p, p + size) overlaps registered upload memory
+    void CheckRead(const void* p, uint64_t size);
+}
@@ -0,0 +1,198 @@
+#include "Engine/game/TransformHierarchy.h"
+#include "Engine/math/TransformBatch.h"
+#include "Engine/common/Parallel.h"
+
+#undef max
+#undef min
+
+namespace
+{
+    // slots per parallel grain when looking for changed nodes
+    constexpr uint64_t SLOTS_PER_GRAIN = 16 * 1024;
+    constexpr uint32_t FREE = ~0u;
+}
+
+TransformHandle TransformHierarchy::add(TransformHandle parent, const Vector3& translation, const Quaternion& rotation,
+                                        const Vector3& scale)
+{
+    uint32_t levelIndex = 0;
+    uint32_t parentSlot = 0;
+    if (parent != INVALID_HANDLE)
+    {
+        location(parent);
+        Location& parentLocation = mLocations[parent.mIndex];
+        levelIndex = parentLocation.mLevel + 1;
+        parentSlot = parentLocation.mSlot;
+        ++parentLocation.mNumChildren;
+    }
+    if (levelIndex == mLevels.size()) mLevels.emplace_back();
+
+    TransformHandle handle;
+    if (mFreeHandles.empty())
+    {
+        handle.mIndex = static_cast<uint32_t>(mLocations.size());
+        mLocations.emplace_back();
+    }
+    else
+    {
+        handle.mIndex = mFreeHandles.back();
+        mFreeHandles.pop_back();
+    }
+
+    Level& level = mLevels[levelIndex];
+    uint32_t slot;
+    if (level.mFreeSlots.empty())
+    {
+        slot = static_cast<uint32_t>(level.mNodes.size());
+        level.mParents.push_back(parentSlot);
+        for (auto& component : level.mTranslation) component.push_back(0);
+        for (auto& component : level.mRotation) component.push_back(0);
+        for (auto& component : level.mScale) component.push_back(0);
+        level.mWorld.emplace_back();
+        level.mIsDirty.push_back(0);
+        level.mIsChanged.push_back(0);
+        level.mNodes.push_back(handle.mIndex);
+    }
+    else
+    {
+        slot = level.mFreeSlots.back();
+        level.mFreeSlots.pop_back();
+        level.mParents[slot] = parentSlot;
+        level.mNodes[slot] = handle.mIndex;
+    }
+    mLocations[handle.mIndex] = { levelIndex, slot, 0 };
+    ++mNumNodes;
+    setLocal(handle, translation, rotation, scale);
+    return handle;
+}
+
+void TransformHierarchy::remove(TransformHandle node)
+{
+    Location& nodeLocation = mLocations[node.mIndex];
+#if defined(DEBUG) or defined(_DEBUG)
+    location(node);
+    ASSERT(nodeLocation.mNumChildren == 0, TEXT("removing a transform that still has children\n"));
+#endif
+    Level& level = mLevels[nodeLocation.mLevel];
+    if (nodeLocation.mLevel > 0)
+    {
+        uint32_t parentHandle = mLevels[nodeLocation.mLevel - 1].mNodes[level.mParents[nodeLocation.mSlot]];
+        --mLocations[parentHandle].mNumChildren;
+    }
+    level.mNodes[nodeLocation.mSlot] = FREE;
+    level.mIsDirty[nodeLocation.mSlot] = 0;
+    level.mFreeSlots.push_back(nodeLocation.mSlot);
+    nodeLocation.mLevel = FREE;
+    mFreeHandles.push_back(node.mIndex);
+    --mNumNodes;
+}
+
+void TransformHierarchy::setLocal(TransformHandle node, const Vector3& translation, const Quaternion& rotation,
+                                  const Vector3& scale)
+{
+    const Location& nodeLocation = location(node);
+    Level& level = mLevels[nodeLocation.mLevel];
+    for (int i = 0; i < 3; ++i)
+    {
+        level.mTranslation[i][nodeLocation.mSlot] = translation[i];
+        level.mScale[i][nodeLocation.mSlot] = scale[i];
+    }
+    level.mRotation[0][nodeLocation.mSlot] = rotation.x;
+    level.mRotation[1][nodeLocation.mSlot] = rotation.y;
+    level.mRotation[2][nodeLocation.mSlot] = rotation.z;
+    level.mRotation[3][nodeLocation.mSlot] = rotation.w;
+    markDirty(nodeLocation);
+}
+
+void TransformHierarchy::setTranslation(TransformHandle node, const Vector3& translation)
+{
+    const Location& nodeLocation = location(node);
+    Level& level = mLevels[nodeLocation.mLevel];
+    for (int i = 0; i < 3; ++i)
+    {
+        level.mTranslation[i][nodeLocation.mSlot] = translation[i];
+    }
+    markDirty(nodeLocation);
+}
+
+void TransformHierarchy::setRotation(TransformHandle node, const Quaternion& rotation)
+{
+    const Location& nodeLocation = location(node);
+    Level& level = mLevels[nodeLocation.mLevel];
+    level.mRotation[0][nodeLocation.mSlot] = rotation.x;
+    level.mRotation[1][nodeLocation.mSlot] = rotation.y;
+    level.mRotation[2][nodeLocation.mSlot] = rotation.z;
+    level.mRotation[3][nodeLocation.mSlot] = rotation.w;
+    markDirty(nodeLocation);
+}
+
+TransformHandle TransformHierarchy::parent(TransformHandle node) const
+{
+    const Location& nodeLocation = location(node);
+    if (nodeLocation.mLevel == 0) return INVALID_HANDLE;
+    return { mLevels[nodeLocation.mLevel - 1].mNodes[mLevels[nodeLocation.mLevel].mParents[nodeLocation.mSlot]] };
+}
+
+void TransformHierarchy::markDirty(const Location& location)
+{
+    mLevels[location.mLevel].mIsDirty[location.mSlot] = 1;
+}
+
+void TransformHierarchy::update()
+{
+    mChangedNodes.clear();
+    for (uint32_t i = 0; i < mLevels.size(); ++i)
+    {
+        updateLevel(i);
+    }
+}
+
+// a node changes when it was marked or its parent changed in this update. the changed slots are compacted per grain
+// like the culling kernels do, then their world matrices are recomputed in one batch against the finished level above
+void TransformHierarchy::updateLevel(uint32_t levelIndex)
+{
+    Level& level = mLevels[levelIndex];
+    const Level* pParentLevel = levelIndex > 0 ? &mLevels[levelIndex - 1] : nullptr;
+    uint64_t numSlots = level.mNodes.size();
+    uint64_t numGrains = (numSlots + SLOTS_PER_GRAIN - 1) / SLOTS_PER_GRAIN;
+    std::vector<uint64_t> numGrainChanged(numGrains);
+    level.mChangedSlots.resize(numSlots);
+
+    const uint8_t* pParentChanged = pParentLevel ? pParentLevel->mIsChanged.data() : nullptr;
+    ParallelFor(0, numSlots, SLOTS_PER_GRAIN, [&](uint64_t begin, uint64_t end)
+    {
+        uint32_t* pGrainChanged = level.mChangedSlots.data() + begin;
+        uint64_t numChanged = 0;
+        for (uint64_t slot = begin; slot < end; ++slot)
+        {
+            uint8_t isChanged = level.mIsDirty[slot] | (pParentChanged ? pParentChanged[level.mParents[slot]] : 0);
+            isChanged &= level.mNodes[slot] != FREE;
+            level.mIsChanged[slot] = isChanged;
+            level.mIsDirty[slot] = 0;
+            pGrainChanged[numChanged] = static_cast<uint32_t>(slot);
+            numChanged += isChanged;
+        }
+        numGrainChanged[begin / SLOTS_PER_GRAIN] = numChanged;
+    });
+
+    uint64_t numChanged = numGrainChanged.empty() ? 0 : numGrainChanged[0];
+    for (uint64_t i = 1; i < numGrains; ++i)
+    {
+        memmove(level.mChangedSlots.data() + numChanged, level.mChangedSlots.data() + i * SLOTS_PER_GRAIN,
+                numGrainChanged[i] * sizeof(uint32_t));
+        numChanged += numGrainChanged[i];
+    }
+    level.mChangedSlots.resize(numChanged);
+    if (numChanged == 0) return;
+
+    TransformBatch::TrsArrays local{
+        { level.mTranslation[0].data(), level.mTranslation[1].data(), level.mTranslation[2].data() },
+        { level.mRotation[0].data(), level.mRotation[1].data(), level.mRotation[2].data(), level.mRotation[3].data() },
+        { level.mScale[0].data(), level.mScale[1].data(), level.mScale[2].data() } };
+    TransformBatch::UpdateWorlds(local, level.mParents.data(), pParentLevel ? pParentLevel->mWorld.data() : nullptr,
+                                 level.mChangedSlots.data(), numChanged, level.mWorld.data());
+    for (uint32_t slot : level.mChangedSlots)
+    {
+        mChangedNodes.push_back({ level.mNodes[slot] });
+    }
+}
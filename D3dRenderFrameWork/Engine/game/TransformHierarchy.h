@@ -0,0 +1,105 @@
+#pragma once
+#include "Engine/common/Exception.h"
+#include "Engine/math/Matrix.h"
+
+struct TransformHandle
+{
+    uint32_t mIndex;
+
+    bool operator==(const TransformHandle& rhs) const { return mIndex == rhs.mIndex; }
+    bool operator!=(const TransformHandle& rhs) const { return mIndex != rhs.mIndex; }
+};
+
+// scene graph of local transforms. nodes live in one level per depth, every level keeps its nodes as parallel arrays
+// (parent slot in the level above, local translation / rotation / scale per component, world matrix and flags),
+// so an update walks the levels top down and every level is a flat data parallel pass.
+// setting a local transform only marks the node, update() recomputes the marked nodes and everything below them.
+// handles stay valid until the node is removed, slots of removed nodes are reused by later nodes of the same depth.
+class TransformHierarchy
+{
+public:
+    static constexpr TransformHandle INVALID_HANDLE = { ~0u };
+
+    // parent INVALID_HANDLE adds a root, the world matrix is valid after the next update
+    TransformHandle add(TransformHandle parent, const Vector3& translation, const Quaternion& rotation, const Vector3& scale);
+    // the node must not have children
+    void remove(TransformHandle node);
+    void setLocal(TransformHandle node, const Vector3& translation, const Quaternion& rotation, const Vector3& scale);
+    void setTranslation(TransformHandle node, const Vector3& translation);
+    void setRotation(TransformHandle node, const Quaternion& rotation);
+    const Matrix3x4& world(TransformHandle node) const;
+    TransformHandle parent(TransformHandle node) const;
+    uint32_t numNodes() const;
+    uint32_t numLevels() const;
+
+    void update();
+    // nodes whose world matrix was recomputed by the last update, level by level
+    const std::vector<TransformHandle>& changedNodes() const;
+
+    TransformHierarchy() = default;
+    DEFAULT_COPY_CONSTRUCTOR(TransformHierarchy)
+    DEFAULT_COPY_OPERATOR(TransformHierarchy)
+    DEFAULT_MOVE_CONSTRUCTOR(TransformHierarchy)
+    DEFAULT_MOVE_OPERATOR(TransformHierarchy)
+
+private:
+    struct Level
+    {
+        std::vector<uint32_t> mParents;
+        std::vector<float> mTranslation[3];
+        std::vector<float> mRotation[4];
+        std::vector<float> mScale[3];
+        std::vector<Matrix3x4> mWorld;
+        std::vector<uint8_t> mIsDirty;      // local transform set since the last update
+        std::vector<uint8_t> mIsChanged;    // world recomputed by the last update
+        std::vector<uint32_t> mNodes;       // handle of every slot, ~0u for free slots
+        std::vector<uint32_t> mFreeSlots;
+        std::vector<uint32_t> mChangedSlots;
+    };
+
+    struct Location
+    {
+        uint32_t mLevel;
+        uint32_t mSlot;
+        uint32_t mNumChildren;
+    };
+
+    const Location& location(TransformHandle node) const;
+    void markDirty(const Location& location);
+    void updateLevel(uint32_t levelIndex);
+
+    std::vector<Level> mLevels;
+    std::vector<Location> mLocations;   // by handle, mLevel is ~0u for free handles
+    std::vector<uint32_t> mFreeHandles;
+    std::vector<TransformHandle> mChangedNodes;
+    uint32_t mNumNodes = 0;
+};
+
+inline const Matrix3x4& TransformHierarchy::world(TransformHandle node) const
+{
+    const Location& nodeLocation = location(node);
+    return mLevels[nodeLocation.mLevel].mWorld[nodeLocation.mSlot];
+}
+
+inline uint32_t TransformHierarchy::numNodes() const
+{
+    return mNumNodes;
+}
+
+inline uint32_t TransformHierarchy::numLevels() const
+{
+    return static_cast<uint32_t>(mLevels.size());
+}
+
+inline const std::vector<TransformHandle>& TransformHierarchy::changedNodes() const
+{
+    return mChangedNodes;
+}
+
+inline const TransformHierarchy::Location& TransformHierarchy::location(TransformHandle node) const
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(node.mIndex < mLocations.size() && mLocations[node.mIndex].mLevel != ~0u, TEXT("invalid transform handle\n"));
+#endif
+    return mLocations[node.mIndex];
+}
@@ -0,0 +1,193 @@
+#include "Engine/math/FrustumCulling.h"
+#include "Engine/math/SoA.h"
+#include "Engine/common/Parallel.h"
+
+#undef max
+#undef min
+
+namespace
+{
+    // objects per parallel grain, a multiple of the 8 lanes
+    constexpr uint64_t OBJECTS_PER_GRAIN = 4 * 1024;
+
+    struct PlaneLanes
+    {
+        Float8 mNormal[3];
+        Float8 mAbsNormal[3];
+        Float8 mDistance;
+    };
+
+    PlaneLanes SplatPlane(const Vector4& plane)
+    {
+        return {
+            { Float8::Splat(plane.x), Float8::Splat(plane.y), Float8::Splat(plane.z) },
+            { Float8::Splat(std::fabs(plane.x)), Float8::Splat(std::fabs(plane.y)), Float8::Splat(std::fabs(plane.z)) },
+            Float8::Splat(plane.w)
+        };
+    }
+
+    // lane i holds the plane pIndices[i]
+    PlaneLanes GatherPlanes(const Frustum& frustum, const uint8_t* pIndices, uint32_t count)
+    {
+        alignas(32) float lanes[7][8] = {};
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const Vector4& plane = frustum.mPlanes[pIndices[i]];
+            lanes[0][i] = plane.x;
+            lanes[1][i] = plane.y;
+            lanes[2][i] = plane.z;
+            lanes[3][i] = std::fabs(plane.x);
+            lanes[4][i] = std::fabs(plane.y);
+            lanes[5][i] = std::fabs(plane.z);
+            lanes[6][i] = plane.w;
+        }
+        return {
+            { Float8::Load(lanes[0]), Float8::Load(lanes[1]), Float8::Load(lanes[2]) },
+            { Float8::Load(lanes[3]), Float8::Load(lanes[4]), Float8::Load(lanes[5]) },
+            Float8::Load(lanes[6])
+        };
+    }
+
+    struct AabbBatch
+    {
+        Vec3x8 mCenter;
+        Vec3x8 mExtent;
+
+        AabbBatch(const FrustumCulling::AabbArrays& bounds, uint64_t first, uint32_t count)
+        {
+            mCenter.x = Float8::LoadPartial(bounds.mCenter[0] + first, count);
+            mCenter.y = Float8::LoadPartial(bounds.mCenter[1] + first, count);
+            mCenter.z = Float8::LoadPartial(bounds.mCenter[2] + first, count);
+            mExtent.x = Float8::LoadPartial(bounds.mExtent[0] + first, count);
+            mExtent.y = Float8::LoadPartial(bounds.mExtent[1] + first, count);
+            mExtent.z = Float8::LoadPartial(bounds.mExtent[2] + first, count);
+        }
+
+        // bit i is set when box i is completely on the outer side of the plane
+        uint32_t outside(const PlaneLanes& plane) const
+        {
+            Float8 distance = Float8::MulAdd(mCenter.x, plane.mNormal[0],
+                              Float8::MulAdd(mCenter.y, plane.mNormal[1],
+                              Float8::MulAdd(mCenter.z, plane.mNormal[2], plane.mDistance)));
+            Float8 radius = Float8::MulAdd(mExtent.x, plane.mAbsNormal[0],
+                            Float8::MulAdd(mExtent.y, plane.mAbsNormal[1], mExtent.z * plane.mAbsNormal[2]));
+            return (distance + radius < Float8::Zero()).mask();
+        }
+    };
+
+    struct SphereBatch
+    {
+        Vec3x8 mCenter;
+        Float8 mRadius;
+
+        SphereBatch(const FrustumCulling::SphereArrays& bounds, uint64_t first, uint32_t count)
+        {
+            mCenter.x = Float8::LoadPartial(bounds.mCenter[0] + first, count);
+            mCenter.y = Float8::LoadPartial(bounds.mCenter[1] + first, count);
+            mCenter.z = Float8::LoadPartial(bounds.mCenter[2] + first, count);
+            mRadius = Float8::LoadPartial(bounds.mRadius + first, count);
+        }
+
+        uint32_t outside(const PlaneLanes& plane) const
+        {
+            Float8 distance = Float8::MulAdd(mCenter.x, plane.mNormal[0],
+                              Float8::MulAdd(mCenter.y, plane.mNormal[1],
+                              Float8::MulAdd(mCenter.z, plane.mNormal[2], plane.mDistance)));
+            return (distance + mRadius < Float8::Zero()).mask();
+        }
+    };
+
+    template<typename Batch, typename Bounds>
+    uint64_t Cull(const Frustum& frustum, const Bounds& bounds, uint64_t count, uint32_t* pVisible,
+                  uint8_t planeMask, uint8_t* pLastPlanes)
+    {
+        PlaneLanes planes[Frustum::NUM_PLANES];
+        uint32_t planeIndices[Frustum::NUM_PLANES];
+        uint32_t numPlanes = 0;
+        for (uint32_t i = 0; i < Frustum::NUM_PLANES; ++i)
+        {
+            if (!(planeMask >> i & 1)) continue;
+            planes[numPlanes] = SplatPlane(frustum.mPlanes[i]);
+            planeIndices[numPlanes++] = i;
+        }
+
+        // every grain compacts into its own part of pVisible, which starts at the grain's first object.
+        // a grain can't write past its own range as it never has more visible objects than objects.
+        uint64_t numGrains = (count + OBJECTS_PER_GRAIN - 1) / OBJECTS_PER_GRAIN;
+        std::vector<uint64_t> numGrainVisible(numGrains);
+        ParallelFor(0, count, OBJECTS_PER_GRAIN, [&](uint64_t begin, uint64_t end)
+        {
+            uint64_t numVisible = 0;
+            uint32_t* pGrainVisible = pVisible + begin;
+            for (uint64_t first = begin; first < end; first += 8)
+            {
+                uint32_t numLanes = static_cast<uint32_t>((std::min)(end - first, uint64_t{ 8 }));
+                uint32_t activeLanes = (1u << numLanes) - 1;
+                Batch batch(bounds, first, numLanes);
+
+                uint32_t outside = 0;
+                if (pLastPlanes)
+                {
+                    outside = batch.outside(GatherPlanes(frustum, pLastPlanes + first, numLanes)) & activeLanes;
+                }
+                for (uint32_t i = 0; i < numPlanes && outside != activeLanes; ++i)
+                {
+                    uint32_t rejected = batch.outside(planes[i]) & activeLanes & ~outside;
+                    if (pLastPlanes)
+                    {
+                        for (uint32_t lane = 0; lane < numLanes; ++lane)
+                        {
+                            if (rejected >> lane & 1) pLastPlanes[first + lane] = static_cast<uint8_t>(planeIndices[i]);
+                        }
+                    }
+                    outside |= rejected;
+                }
+
+                // branchless append, every lane writes its index and only the visible ones advance
+                uint32_t visible = activeLanes & ~outside;
+                for (uint32_t lane = 0; lane < numLanes; ++lane)
+                {
+                    pGrainVisible[numVisible] = static_cast<uint32_t>(first + lane);
+                    numVisible += visible >> lane & 1;
+                }
+            }
+            numGrainVisible[begin / OBJECTS_PER_GRAIN] = numVisible;
+        });
+
+        uint64_t numVisible = numGrainVisible.empty() ? 0 : numGrainVisible[0];
+        for (uint64_t i = 1; i < numGrains; ++i)
+        {
+            memmove(pVisible + numVisible, pVisible + i * OBJECTS_PER_GRAIN, numGrainVisible[i] * sizeof(uint32_t));
+            numVisible += numGrainVisible[i];
+        }
+        return numVisible;
+    }
+}
+
+Frustum Frustum::FromViewProjection(const Matrix4x4& viewProjection)
+{
+    // clip = (v, 1) * m, the planes are combinations of the columns of m (gribb and hartmann)
+    Matrix4x4 columns = viewProjection.Transpose();
+    Vector4 x = columns.row(0);
+    Vector4 y = columns.row(1);
+    Vector4 z = columns.row(2);
+    Vector4 w = columns.row(3);
+    Frustum frustum{ { w + x, w - x, w + y, w - y, z, w - z } };
+    for (Vector4& plane : frustum.mPlanes)
+    {
+        plane = plane / plane.xyz().Length();
+    }
+    return frustum;
+}
+
+uint64_t FrustumCulling::CullAabbs(const Frustum& frustum, const AabbArrays& bounds, uint64_t count, uint32_t* pVisible,
+                                   uint8_t planeMask, uint8_t* pLastPlanes)
+{
+    return Cull<AabbBatch>(frustum, bounds, count, pVisible, planeMask, pLastPlanes);
+}
+
+uint64_t FrustumCulling::CullSpheres(const Frustum& frustum, const SphereArrays& bounds, uint64_t count, uint32_t* pVisible,
+                                     uint8_t planeMask, uint8_t* pLastPlanes)
+{
+    return Cull<SphereBatch>(frustum, bounds, count, pVisible, planeMask, pLastPlanes);
+}
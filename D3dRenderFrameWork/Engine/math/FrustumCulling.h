@@ -0,0 +1,41 @@
+#pragma once
+#include "Engine/math/Matrix.h"
+
+// a point p is inside plane i when dot(mPlanes[i].xyz, p) + mPlanes[i].w >= 0, plane normals are unit length.
+// planes are ordered left, right, bottom, top, near, far.
+struct Frustum
+{
+    static constexpr uint32_t NUM_PLANES = 6;
+    static constexpr uint8_t ALL_PLANES = 0x3f;
+
+    // planes of the d3d clip volume (z in [0, 1]) in the space the matrix transforms from
+    static Frustum FromViewProjection(const Matrix4x4& viewProjection);
+
+    Vector4 mPlanes[NUM_PLANES];
+};
+
+// bounds are tested 8 per iteration, the visible ones are written as a compacted list of ascending indices.
+// only the planes set in planeMask are tested, clear the bits of planes a parent volume is known to be inside of.
+// pLastPlanes, when not null, holds one plane index per object: the plane that rejected it last time. it is tested
+// first and a batch whose objects are all rejected by their cached plane is done after a single test.
+// the indices start at 0 and the array is updated by the call.
+namespace FrustumCulling
+{
+    struct AabbArrays
+    {
+        const float* mCenter[3];
+        const float* mExtent[3];    // half sizes
+    };
+
+    struct SphereArrays
+    {
+        const float* mCenter[3];
+        const float* mRadius;
+    };
+
+    // returns the number of visible objects written to pVisible, which must have room for count indices
+    uint64_t CullAabbs(const Frustum& frustum, const AabbArrays& bounds, uint64_t count, uint32_t* pVisible,
+                       uint8_t planeMask = Frustum::ALL_PLANES, uint8_t* pLastPlanes = nullptr);
+    uint64_t CullSpheres(const Frustum& frustum, const SphereArrays& bounds, uint64_t count, uint32_t* pVisible,
+                         uint8_t planeMask = Frustum::ALL_PLANES, uint8_t* pLastPlanes = nullptr);
+}
@@ -0,0 +1,118 @@
+#include "Engine/math/Matrix.h"
+
+Matrix4x4 Matrix4x4::LookToLH(const Vector3& eye, const Vector3& direction, const Vector3& up)
+{
+    Vector3 zAxis = direction.Normalize();
+    Vector3 xAxis = up.Cross(zAxis).Normalize();
+    Vector3 yAxis = zAxis.Cross(xAxis);
+    return { {
+        { xAxis.x, yAxis.x, zAxis.x, 0 },
+        { xAxis.y, yAxis.y, zAxis.y, 0 },
+        { xAxis.z, yAxis.z, zAxis.z, 0 },
+        { -xAxis.Dot(eye), -yAxis.Dot(eye), -zAxis.Dot(eye), 1 },
+    } };
+}
+
+Matrix4x4 Matrix4x4::PerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ)
+{
+    float height = 1.0f / std::tan(fovY * 0.5f);
+    float width = height / aspect;
+    float range = farZ / (farZ - nearZ);
+    return { {
+        { width, 0, 0, 0 },
+        { 0, height, 0, 0 },
+        { 0, 0, range, 1 },
+        { 0, 0, -range * nearZ, 0 },
+    } };
+}
+
+Matrix4x4 Matrix4x4::OrthographicLH(float width, float height, float nearZ, float farZ)
+{
+    float range = 1.0f / (farZ - nearZ);
+    return { {
+        { 2 / width, 0, 0, 0 },
+        { 0, 2 / height, 0, 0 },
+        { 0, 0, range, 0 },
+        { 0, 0, -range * nearZ, 1 },
+    } };
+}
+
+float Matrix4x4::Determinant() const
+{
+    // laplace expansion over the 2x2 minors of the top and bottom row pairs
+    float top0 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+    float top1 = m[0][0] * m[1][2] - m[0][2] * m[1][0];
+    float top2 = m[0][0] * m[1][3] - m[0][3] * m[1][0];
+    float top3 = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    float top4 = m[0][1] * m[1][3] - m[0][3] * m[1][1];
+    float top5 = m[0][2] * m[1][3] - m[0][3] * m[1][2];
+    float bottom0 = m[2][0] * m[3][1] - m[2][1] * m[3][0];
+    float bottom1 = m[2][0] * m[3][2] - m[2][2] * m[3][0];
+    float bottom2 = m[2][0] * m[3][3] - m[2][3] * m[3][0];
+    float bottom3 = m[2][1] * m[3][2] - m[2][2] * m[3][1];
+    float bottom4 = m[2][1] * m[3][3] - m[2][3] * m[3][1];
+    float bottom5 = m[2][2] * m[3][3] - m[2][3] * m[3][2];
+    return top0 * bottom5 - top1 * bottom4 + top2 * bottom3 + top3 * bottom2 - top4 * bottom1 + top5 * bottom0;
+}
+
+Matrix4x4 Matrix4x4::Inverse() const
+{
+    float top0 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+    float top1 = m[0][0] * m[1][2] - m[0][2] * m[1][0];
+    float top2 = m[0][0] * m[1][3] - m[0][3] * m[1][0];
+    float top3 = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    float top4 = m[0][1] * m[1][3] - m[0][3] * m[1][1];
+    float top5 = m[0][2] * m[1][3] - m[0][3] * m[1][2];
+    float bottom0 = m[2][0] * m[3][1] - m[2][1] * m[3][0];
+    float bottom1 = m[2][0] * m[3][2] - m[2][2] * m[3][0];
+    float bottom2 = m[2][0] * m[3][3] - m[2][3] * m[3][0];
+    float bottom3 = m[2][1] * m[3][2] - m[2][2] * m[3][1];
+    float bottom4 = m[2][1] * m[3][3] - m[2][3] * m[3][1];
+    float bottom5 = m[2][2] * m[3][3] - m[2][3] * m[3][2];
+    float determinant = top0 * bottom5 - top1 * bottom4 + top2 * bottom3 + top3 * bottom2 - top4 * bottom1 + top5 * bottom0;
+    float scale = 1.0f / determinant;
+
+    Matrix4x4 result;
+    result.m[0][0] = (m[1][1] * bottom5 - m[1][2] * bottom4 + m[1][3] * bottom3) * scale;
+    result.m[0][1] = (-m[0][1] * bottom5 + m[0][2] * bottom4 - m[0][3] * bottom3) * scale;
+    result.m[0][2] = (m[3][1] * top5 - m[3][2] * top4 + m[3][3] * top3) * scale;
+    result.m[0][3] = (-m[2][1] * top5 + m[2][2] * top4 - m[2][3] * top3) * scale;
+    result.m[1][0] = (-m[1][0] * bottom5 + m[1][2] * bottom2 - m[1][3] * bottom1) * scale;
+    result.m[1][1] = (m[0][0] * bottom5 - m[0][2] * bottom2 + m[0][3] * bottom1) * scale;
+    result.m[1][2] = (-m[3][0] * top5 + m[3][2] * top2 - m[3][3] * top1) * scale;
+    result.m[1][3] = (m[2][0] * top5 - m[2][2] * top2 + m[2][3] * top1) * scale;
+    result.m[2][0] = (m[1][0] * bottom4 - m[1][1] * bottom2 + m[1][3] * bottom0) * scale;
+    result.m[2][1] = (-m[0][0] * bottom4 + m[0][1] * bottom2 - m[0][3] * bottom0) * scale;
+    result.m[2][2] = (m[3][0] * top4 - m[3][1] * top2 + m[3][3] * top0) * scale;
+    result.m[2][3] = (-m[2][0] * top4 + m[2][1] * top2 - m[2][3] * top0) * scale;
+    result.m[3][0] = (-m[1][0] * bottom3 + m[1][1] * bottom1 - m[1][2] * bottom0) * scale;
+    result.m[3][1] = (m[0][0] * bottom3 - m[0][1] * bottom1 + m[0][2] * bottom0) * scale;
+    result.m[3][2] = (-m[3][0] * top3 + m[3][1] * top1 - m[3][2] * top0) * scale;
+    result.m[3][3] = (m[2][0] * top3 - m[2][1] * top1 + m[2][2] * top0) * scale;
+    return result;
+}
+
+Matrix3x4 Matrix3x4::Inverse() const
+{
+    // the inverse of the linear part is its adjugate over the determinant, the translation is moved back through it
+    float cofactor00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float cofactor01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float cofactor02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    float scale = 1.0f / (m[0][0] * cofactor00 + m[0][1] * cofactor01 + m[0][2] * cofactor02);
+
+    Matrix3x4 result;
+    result.m[0][0] = cofactor00 * scale;
+    result.m[1][0] = cofactor01 * scale;
+    result.m[2][0] = cofactor02 * scale;
+    result.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * scale;
+    result.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * scale;
+    result.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * scale;
+    result.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * scale;
+    result.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * scale;
+    result.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * scale;
+    Vector3 translation = result.TransformVector(this->translation());
+    result.m[0][3] = -translation.x;
+    result.m[1][3] = -translation.y;
+    result.m[2][3] = -translation.z;
+    return result;
+}
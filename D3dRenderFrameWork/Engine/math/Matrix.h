@@ -0,0 +1,353 @@
+#pragma once
+#include "Engine/math/Vector.h"
+#include "Engine/math/Quaternion.h"
+
+// row vector convention like DirectXMath, a point is transformed as v * m and a * b applies a first.
+// the memory layout matches XMFLOAT4X4, so the bytes go to the gpu the same way an XMMATRIX did.
+struct alignas(16) Matrix4x4
+{
+    float m[4][4];
+
+    static Matrix4x4 Identity();
+    static Matrix4x4 Translation(const Vector3& translation);
+    static Matrix4x4 Scaling(const Vector3& scale);
+    static Matrix4x4 Rotation(const Quaternion& rotation);
+    // scale, then rotate, then translate
+    static Matrix4x4 Trs(const Vector3& translation, const Quaternion& rotation, const Vector3& scale);
+    // left handed views and projections with d3d clip space (z in [0, 1]), same results as the XMMatrix*LH functions
+    static Matrix4x4 LookToLH(const Vector3& eye, const Vector3& direction, const Vector3& up);
+    static Matrix4x4 LookAtLH(const Vector3& eye, const Vector3& focus, const Vector3& up);
+    static Matrix4x4 PerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ);
+    static Matrix4x4 OrthographicLH(float width, float height, float nearZ, float farZ);
+
+    Matrix4x4 Transpose() const;
+    // general inverse, the result is not finite when the matrix is singular
+    Matrix4x4 Inverse() const;
+    float Determinant() const;
+    Vector4 Transform(const Vector4& v) const;
+    // w = 1 without the perspective divide
+    Vector3 TransformPoint(const Vector3& point) const;
+    // w = 0, translation is ignored
+    Vector3 TransformVector(const Vector3& vector) const;
+    Vector4 row(int index) const;
+
+    Matrix4x4 operator*(const Matrix4x4& rhs) const;
+    Matrix4x4& operator*=(const Matrix4x4& rhs);
+    bool operator==(const Matrix4x4& rhs) const;
+    bool operator!=(const Matrix4x4& rhs) const;
+};
+
+// affine transform in 48 bytes. the rows hold the columns of the matching Matrix4x4 (the transposed upper 4x3),
+// so row i dotted with (x, y, z, 1) gives the transformed coordinate i. this is also what a row_major float3x4
+// expects in a constant buffer. a * b applies a first, like Matrix4x4.
+struct alignas(16) Matrix3x4
+{
+    float m[3][4];
+
+    static Matrix3x4 Identity();
+    static Matrix3x4 Trs(const Vector3& translation, const Quaternion& rotation, const Vector3& scale);
+
+    Matrix4x4 toMatrix4x4() const;
+    // affine inverse, the result is not finite when the linear part is singular
+    Matrix3x4 Inverse() const;
+    Vector3 TransformPoint(const Vector3& point) const;
+    Vector3 TransformVector(const Vector3& vector) const;
+    Vector3 translation() const;
+
+    Matrix3x4() = default;
+    // drops the last column of an affine Matrix4x4
+    explicit Matrix3x4(const Matrix4x4& matrix);
+
+    Matrix3x4 operator*(const Matrix3x4& rhs) const;
+    Matrix3x4& operator*=(const Matrix3x4& rhs);
+    bool operator==(const Matrix3x4& rhs) const;
+    bool operator!=(const Matrix3x4& rhs) const;
+};
+
+// -------------------------------------- Matrix4x4 -------------------------------------- //
+
+inline Matrix4x4 Matrix4x4::Identity()
+{
+    return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+}
+
+inline Matrix4x4 Matrix4x4::Translation(const Vector3& translation)
+{
+    Matrix4x4 result = Identity();
+    result.m[3][0] = translation.x;
+    result.m[3][1] = translation.y;
+    result.m[3][2] = translation.z;
+    return result;
+}
+
+inline Matrix4x4 Matrix4x4::Scaling(const Vector3& scale)
+{
+    return { { { scale.x, 0, 0, 0 }, { 0, scale.y, 0, 0 }, { 0, 0, scale.z, 0 }, { 0, 0, 0, 1 } } };
+}
+
+inline Matrix4x4 Matrix4x4::Rotation(const Quaternion& rotation)
+{
+    return Trs(Vector3(), rotation, Vector3(1, 1, 1));
+}
+
+inline Matrix4x4 Matrix4x4::Trs(const Vector3& translation, const Quaternion& rotation, const Vector3& scale)
+{
+    return Matrix3x4::Trs(translation, rotation, scale).toMatrix4x4();
+}
+
+inline Matrix4x4 Matrix4x4::LookAtLH(const Vector3& eye, const Vector3& focus, const Vector3& up)
+{
+    return LookToLH(eye, focus - eye, up);
+}
+
+inline Vector4 Matrix4x4::row(int index) const
+{
+    return { m[index][0], m[index][1], m[index][2], m[index][3] };
+}
+
+inline Matrix4x4& Matrix4x4::operator*=(const Matrix4x4& rhs)
+{
+    return *this = *this * rhs;
+}
+
+inline bool Matrix4x4::operator==(const Matrix4x4& rhs) const
+{
+    return row(0) == rhs.row(0) && row(1) == rhs.row(1) && row(2) == rhs.row(2) && row(3) == rhs.row(3);
+}
+
+inline bool Matrix4x4::operator!=(const Matrix4x4& rhs) const
+{
+    return !(*this == rhs);
+}
+
+#ifdef SIMD_SSE2
+inline Matrix4x4 Matrix4x4::Transpose() const
+{
+    __m128 row0 = _mm_load_ps(m[0]);
+    __m128 row1 = _mm_load_ps(m[1]);
+    __m128 row2 = _mm_load_ps(m[2]);
+    __m128 row3 = _mm_load_ps(m[3]);
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    Matrix4x4 result;
+    _mm_store_ps(result.m[0], row0);
+    _mm_store_ps(result.m[1], row1);
+    _mm_store_ps(result.m[2], row2);
+    _mm_store_ps(result.m[3], row3);
+    return result;
+}
+
+inline Vector4 Matrix4x4::Transform(const Vector4& v) const
+{
+    __m128 result = _mm_mul_ps(_mm_set1_ps(v.x), _mm_load_ps(m[0]));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(v.y), _mm_load_ps(m[1])));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(v.z), _mm_load_ps(m[2])));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(v.w), _mm_load_ps(m[3])));
+    return Vector4(result);
+}
+
+inline Matrix4x4 Matrix4x4::operator*(const Matrix4x4& rhs) const
+{
+    __m128 rhs0 = _mm_load_ps(rhs.m[0]);
+    __m128 rhs1 = _mm_load_ps(rhs.m[1]);
+    __m128 rhs2 = _mm_load_ps(rhs.m[2]);
+    __m128 rhs3 = _mm_load_ps(rhs.m[3]);
+    Matrix4x4 result;
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128 row = _mm_mul_ps(_mm_set1_ps(m[i][0]), rhs0);
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][1]), rhs1));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][2]), rhs2));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][3]), rhs3));
+        _mm_store_ps(result.m[i], row);
+    }
+    return result;
+}
+#else
+inline Matrix4x4 Matrix4x4::Transpose() const
+{
+    Matrix4x4 result;
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            result.m[i][j] = m[j][i];
+        }
+    }
+    return result;
+}
+
+inline Vector4 Matrix4x4::Transform(const Vector4& v) const
+{
+    return row(0) * v.x + row(1) * v.y + row(2) * v.z + row(3) * v.w;
+}
+
+inline Matrix4x4 Matrix4x4::operator*(const Matrix4x4& rhs) const
+{
+    Matrix4x4 result;
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            result.m[i][j] = m[i][0] * rhs.m[0][j] + m[i][1] * rhs.m[1][j] + m[i][2] * rhs.m[2][j] + m[i][3] * rhs.m[3][j];
+        }
+    }
+    return result;
+}
+#endif
+
+inline Vector3 Matrix4x4::TransformPoint(const Vector3& point) const
+{
+    return Transform(Vector4(point, 1)).xyz();
+}
+
+inline Vector3 Matrix4x4::TransformVector(const Vector3& vector) const
+{
+    return Transform(Vector4(vector, 0)).xyz();
+}
+
+// -------------------------------------- Matrix3x4 -------------------------------------- //
+
+inline Matrix3x4 Matrix3x4::Identity()
+{
+    Matrix3x4 result;
+    result.m[0][0] = 1; result.m[0][1] = 0; result.m[0][2] = 0; result.m[0][3] = 0;
+    result.m[1][0] = 0; result.m[1][1] = 1; result.m[1][2] = 0; result.m[1][3] = 0;
+    result.m[2][0] = 0; result.m[2][1] = 0; result.m[2][2] = 1; result.m[2][3] = 0;
+    return result;
+}
+
+inline Matrix3x4 Matrix3x4::Trs(const Vector3& translation, const Quaternion& rotation, const Vector3& scale)
+{
+    float xx = rotation.x * rotation.x;
+    float yy = rotation.y * rotation.y;
+    float zz = rotation.z * rotation.z;
+    float xy = rotation.x * rotation.y;
+    float xz = rotation.x * rotation.z;
+    float yz = rotation.y * rotation.z;
+    float wx = rotation.w * rotation.x;
+    float wy = rotation.w * rotation.y;
+    float wz = rotation.w * rotation.z;
+    Matrix3x4 result;
+    result.m[0][0] = (1 - 2 * (yy + zz)) * scale.x;
+    result.m[0][1] = 2 * (xy - wz) * scale.y;
+    result.m[0][2] = 2 * (xz + wy) * scale.z;
+    result.m[0][3] = translation.x;
+    result.m[1][0] = 2 * (xy + wz) * scale.x;
+    result.m[1][1] = (1 - 2 * (xx + zz)) * scale.y;
+    result.m[1][2] = 2 * (yz - wx) * scale.z;
+    result.m[1][3] = translation.y;
+    result.m[2][0] = 2 * (xz - wy) * scale.x;
+    result.m[2][1] = 2 * (yz + wx) * scale.y;
+    result.m[2][2] = (1 - 2 * (xx + yy)) * scale.z;
+    result.m[2][3] = translation.z;
+    return result;
+}
+
+inline Matrix3x4::Matrix3x4(const Matrix4x4& matrix)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            m[i][j] = matrix.m[j][i];
+        }
+    }
+}
+
+inline Matrix4x4 Matrix3x4::toMatrix4x4() const
+{
+    return { {
+        { m[0][0], m[1][0], m[2][0], 0 },
+        { m[0][1], m[1][1], m[2][1], 0 },
+        { m[0][2], m[1][2], m[2][2], 0 },
+        { m[0][3], m[1][3], m[2][3], 1 },
+    } };
+}
+
+inline Vector3 Matrix3x4::TransformPoint(const Vector3& point) const
+{
+    return {
+        m[0][0] * point.x + m[0][1] * point.y + m[0][2] * point.z + m[0][3],
+        m[1][0] * point.x + m[1][1] * point.y + m[1][2] * point.z + m[1][3],
+        m[2][0] * point.x + m[2][1] * point.y + m[2][2] * point.z + m[2][3],
+    };
+}
+
+inline Vector3 Matrix3x4::TransformVector(const Vector3& vector) const
+{
+    return {
+        m[0][0] * vector.x + m[0][1] * vector.y + m[0][2] * vector.z,
+        m[1][0] * vector.x + m[1][1] * vector.y + m[1][2] * vector.z,
+        m[2][0] * vector.x + m[2][1] * vector.y + m[2][2] * vector.z,
+    };
+}
+
+inline Vector3 Matrix3x4::translation() const
+{
+    return { m[0][3], m[1][3], m[2][3] };
+}
+
+#ifdef SIMD_SSE2
+inline Matrix3x4 Matrix3x4::operator*(const Matrix3x4& rhs) const
+{
+    // column form: rhs * this, the implicit fourth row of this is (0, 0, 0, 1)
+    __m128 row0 = _mm_load_ps(m[0]);
+    __m128 row1 = _mm_load_ps(m[1]);
+    __m128 row2 = _mm_load_ps(m[2]);
+    __m128 lastRow = _mm_set_ps(1, 0, 0, 0);
+    Matrix3x4 result;
+    for (int i = 0; i < 3; ++i)
+    {
+        __m128 row = _mm_mul_ps(_mm_set1_ps(rhs.m[i][0]), row0);
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(rhs.m[i][1]), row1));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(rhs.m[i][2]), row2));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(rhs.m[i][3]), lastRow));
+        _mm_store_ps(result.m[i], row);
+    }
+    return result;
+}
+
+inline bool Matrix3x4::operator==(const Matrix3x4& rhs) const
+{
+    __m128 equal = _mm_and_ps(_mm_cmpeq_ps(_mm_load_ps(m[0]), _mm_load_ps(rhs.m[0])),
+                              _mm_cmpeq_ps(_mm_load_ps(m[1]), _mm_load_ps(rhs.m[1])));
+    equal = _mm_and_ps(equal, _mm_cmpeq_ps(_mm_load_ps(m[2]), _mm_load_ps(rhs.m[2])));
+    return _mm_movemask_ps(equal) == 0xf;
+}
+#else
+inline Matrix3x4 Matrix3x4::operator*(const Matrix3x4& rhs) const
+{
+    Matrix3x4 result;
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            result.m[i][j] = rhs.m[i][0] * m[0][j] + rhs.m[i][1] * m[1][j] + rhs.m[i][2] * m[2][j];
+        }
+        result.m[i][3] += rhs.m[i][3];
+    }
+    return result;
+}
+
+inline bool Matrix3x4::operator==(const Matrix3x4& rhs) const
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            if (m[i][j] != rhs.m[i][j]) return false;
+        }
+    }
+    return true;
+}
+#endif
+
+inline Matrix3x4& Matrix3x4::operator*=(const Matrix3x4& rhs)
+{
+    return *this = *this * rhs;
+}
+
+inline bool Matrix3x4::operator!=(const Matrix3x4& rhs) const
+{
+    return !(*this == rhs);
+}
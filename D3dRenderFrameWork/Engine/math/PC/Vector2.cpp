@@ -1,3 +0,0 @@
-﻿#ifdef WIN32
-#include "Vector2.h"
-#endif
\ No newline at end of file
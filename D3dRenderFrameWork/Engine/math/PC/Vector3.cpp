@@ -1,3 +0,0 @@
-﻿#ifdef WIN32
-#include "Vector3.h"
-#endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+#include "Engine/math/Vector.h"
+
+// unit quaternion rotation, (x, y, z) is the imaginary part. a * b rotates by a first and then by b,
+// the same order as multiplying the matching row vector matrices.
+struct alignas(16) Quaternion
+{
+    float x;
+    float y;
+    float z;
+    float w;
+
+    static Quaternion Identity();
+    // angle in radians, same rotation sense as XMQuaternionRotationAxis
+    static Quaternion FromAxisAngle(const Vector3& axis, float angle);
+    static float Dot(const Quaternion& q1, const Quaternion& q2);
+    // shortest arc interpolation, falls back to nlerp when the rotations are almost equal
+    static Quaternion Slerp(const Quaternion& q1, const Quaternion& q2, float t);
+    static Quaternion Nlerp(const Quaternion& q1, const Quaternion& q2, float t);
+
+    Quaternion Conjugate() const;
+    Quaternion Normalize() const;
+    Vector3 Rotate(const Vector3& v) const;
+
+    Quaternion() : x(0), y(0), z(0), w(1) {}
+    Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+    Quaternion operator*(const Quaternion& rhs) const;
+    Quaternion& operator*=(const Quaternion& rhs);
+    bool operator==(const Quaternion& rhs) const;
+    bool operator!=(const Quaternion& rhs) const;
+};
+
+inline Quaternion Quaternion::Identity()
+{
+    return { 0, 0, 0, 1 };
+}
+
+inline Quaternion Quaternion::FromAxisAngle(const Vector3& axis, float angle)
+{
+    Vector3 v = axis.Normalize() * std::sin(angle * 0.5f);
+    return { v.x, v.y, v.z, std::cos(angle * 0.5f) };
+}
+
+inline float Quaternion::Dot(const Quaternion& q1, const Quaternion& q2)
+{
+    return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+}
+
+inline Quaternion Quaternion::Nlerp(const Quaternion& q1, const Quaternion& q2, float t)
+{
+    float sign = Dot(q1, q2) < 0 ? -1.0f : 1.0f;
+    float s = 1 - t;
+    float u = t * sign;
+    return Quaternion(q1.x * s + q2.x * u, q1.y * s + q2.y * u, q1.z * s + q2.z * u, q1.w * s + q2.w * u).Normalize();
+}
+
+inline Quaternion Quaternion::Slerp(const Quaternion& q1, const Quaternion& q2, float t)
+{
+    float cosTheta = Dot(q1, q2);
+    float sign = cosTheta < 0 ? -1.0f : 1.0f;
+    cosTheta *= sign;
+    if (cosTheta > 0.9995f)
+    {
+        return Nlerp(q1, q2, t);
+    }
+    float theta = std::acos(cosTheta);
+    float sinTheta = std::sin(theta);
+    float s = std::sin((1 - t) * theta) / sinTheta;
+    float u = std::sin(t * theta) / sinTheta * sign;
+    return { q1.x * s + q2.x * u, q1.y * s + q2.y * u, q1.z * s + q2.z * u, q1.w * s + q2.w * u };
+}
+
+inline Quaternion Quaternion::Conjugate() const
+{
+    return { -x, -y, -z, w };
+}
+
+inline Quaternion Quaternion::Normalize() const
+{
+    float length = std::sqrt(Dot(*this, *this));
+    return length > 0 ? Quaternion(x / length, y / length, z / length, w / length) : Identity();
+}
+
+inline Vector3 Quaternion::Rotate(const Vector3& v) const
+{
+    // v + 2w (u x v) + 2u x (u x v)
+    Vector3 u(x, y, z);
+    Vector3 t = u.Cross(v) * 2.0f;
+    return v + t * w + u.Cross(t);
+}
+
+inline Quaternion Quaternion::operator*(const Quaternion& rhs) const
+{
+    // rhs * this in hamilton order, so that this rotation is applied first
+    return {
+        rhs.w * x + rhs.x * w + rhs.y * z - rhs.z * y,
+        rhs.w * y - rhs.x * z + rhs.y * w + rhs.z * x,
+        rhs.w * z + rhs.x * y - rhs.y * x + rhs.z * w,
+        rhs.w * w - rhs.x * x - rhs.y * y - rhs.z * z
+    };
+}
+
+inline Quaternion& Quaternion::operator*=(const Quaternion& rhs)
+{
+    return *this = *this * rhs;
+}
+
+inline bool Quaternion::operator==(const Quaternion& rhs) const
+{
+    return x == rhs.x && y == rhs.y && z == rhs.z && w == rhs.w;
+}
+
+inline bool Quaternion::operator!=(const Quaternion& rhs) const
+{
+    return !(*this == rhs);
+}
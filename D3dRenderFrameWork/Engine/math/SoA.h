@@ -0,0 +1,328 @@
+#pragma once
+#include "Engine/math/Vector.h"
+
+// 8 wide float lanes for data parallel kernels: one ymm register in avx builds, a pair of sse registers on the
+// sse2 baseline, plain floats elsewhere. comparisons return lane masks with every bit set, feed them to Select
+// or mask(). loads and stores are unaligned, keep soa arrays 32 byte aligned anyway so they don't split cache lines.
+struct Float8
+{
+#if defined(SIMD_AVX)
+    __m256 v;
+#elif defined(SIMD_SSE2)
+    __m128 lo;
+    __m128 hi;
+#else
+    float v[8];
+#endif
+
+    static Float8 Splat(float value);
+    static Float8 Zero();
+    static Float8 Load(const float* pSrc);
+    // lanes past count are zero
+    static Float8 LoadPartial(const float* pSrc, uint32_t count);
+    static Float8 Min(const Float8& a, const Float8& b);
+    static Float8 Max(const Float8& a, const Float8& b);
+    static Float8 Sqrt(const Float8& a);
+    // a * b + c, fused when the build has fma
+    static Float8 MulAdd(const Float8& a, const Float8& b, const Float8& c);
+    // mask ? a : b per lane
+    static Float8 Select(const Float8& mask, const Float8& a, const Float8& b);
+
+    void store(float* pDst) const;
+    void storePartial(float* pDst, uint32_t count) const;
+    // bit i is set when lane i of a comparison result is true
+    uint32_t mask() const;
+    float lane(uint32_t index) const;
+
+    Float8 operator-() const;
+    Float8 operator+(const Float8& rhs) const;
+    Float8 operator-(const Float8& rhs) const;
+    Float8 operator*(const Float8& rhs) const;
+    Float8 operator/(const Float8& rhs) const;
+    Float8 operator&(const Float8& rhs) const;
+    Float8 operator|(const Float8& rhs) const;
+    Float8 operator<(const Float8& rhs) const;
+    Float8 operator<=(const Float8& rhs) const;
+    Float8 operator>(const Float8& rhs) const;
+    Float8 operator>=(const Float8& rhs) const;
+    Float8& operator+=(const Float8& rhs);
+    Float8& operator-=(const Float8& rhs);
+    Float8& operator*=(const Float8& rhs);
+};
+
+// 8 vectors with one Float8 per component
+struct Vec3x8
+{
+    Float8 x;
+    Float8 y;
+    Float8 z;
+
+    static Vec3x8 Splat(const Vector3& v);
+    static Vec3x8 Load(const float* pX, const float* pY, const float* pZ);
+    // transposes 8 consecutive aos vectors, lanes past count are zero
+    static Vec3x8 Gather(const Vector3* pSrc, uint32_t count = 8);
+    static Float8 Dot(const Vec3x8& a, const Vec3x8& b);
+    static Vec3x8 Cross(const Vec3x8& a, const Vec3x8& b);
+    static Vec3x8 Min(const Vec3x8& a, const Vec3x8& b);
+    static Vec3x8 Max(const Vec3x8& a, const Vec3x8& b);
+    // zero length vectors come back as nan
+    static Vec3x8 Normalize(const Vec3x8& a);
+
+    void store(float* pX, float* pY, float* pZ) const;
+    void scatter(Vector3* pDst, uint32_t count = 8) const;
+    Float8 lengthSquared() const;
+    Vector3 lane(uint32_t index) const;
+
+    Vec3x8 operator+(const Vec3x8& rhs) const;
+    Vec3x8 operator-(const Vec3x8& rhs) const;
+    Vec3x8 operator*(const Vec3x8& rhs) const;
+    Vec3x8 operator*(const Float8& scalar) const;
+};
+
+// ---------------------------------------- Float8 ---------------------------------------- //
+
+#if defined(SIMD_AVX)
+inline Float8 Float8::Splat(float value) { return { _mm256_set1_ps(value) }; }
+inline Float8 Float8::Zero() { return { _mm256_setzero_ps() }; }
+inline Float8 Float8::Load(const float* pSrc) { return { _mm256_loadu_ps(pSrc) }; }
+inline Float8 Float8::Min(const Float8& a, const Float8& b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline Float8 Float8::Max(const Float8& a, const Float8& b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline Float8 Float8::Sqrt(const Float8& a) { return { _mm256_sqrt_ps(a.v) }; }
+inline Float8 Float8::Select(const Float8& mask, const Float8& a, const Float8& b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+#ifdef SIMD_FMA
+inline Float8 Float8::MulAdd(const Float8& a, const Float8& b, const Float8& c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+#else
+inline Float8 Float8::MulAdd(const Float8& a, const Float8& b, const Float8& c) { return { _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v) }; }
+#endif
+inline void Float8::store(float* pDst) const { _mm256_storeu_ps(pDst, v); }
+inline uint32_t Float8::mask() const { return static_cast<uint32_t>(_mm256_movemask_ps(v)); }
+inline Float8 Float8::operator-() const { return { _mm256_sub_ps(_mm256_setzero_ps(), v) }; }
+inline Float8 Float8::operator+(const Float8& rhs) const { return { _mm256_add_ps(v, rhs.v) }; }
+inline Float8 Float8::operator-(const Float8& rhs) const { return { _mm256_sub_ps(v, rhs.v) }; }
+inline Float8 Float8::operator*(const Float8& rhs) const { return { _mm256_mul_ps(v, rhs.v) }; }
+inline Float8 Float8::operator/(const Float8& rhs) const { return { _mm256_div_ps(v, rhs.v) }; }
+inline Float8 Float8::operator&(const Float8& rhs) const { return { _mm256_and_ps(v, rhs.v) }; }
+inline Float8 Float8::operator|(const Float8& rhs) const { return { _mm256_or_ps(v, rhs.v) }; }
+inline Float8 Float8::operator<(const Float8& rhs) const { return { _mm256_cmp_ps(v, rhs.v, _CMP_LT_OQ) }; }
+inline Float8 Float8::operator<=(const Float8& rhs) const { return { _mm256_cmp_ps(v, rhs.v, _CMP_LE_OQ) }; }
+inline Float8 Float8::operator>(const Float8& rhs) const { return { _mm256_cmp_ps(v, rhs.v, _CMP_GT_OQ) }; }
+inline Float8 Float8::operator>=(const Float8& rhs) const { return { _mm256_cmp_ps(v, rhs.v, _CMP_GE_OQ) }; }
+#elif defined(SIMD_SSE2)
+inline Float8 Float8::Splat(float value) { return { _mm_set1_ps(value), _mm_set1_ps(value) }; }
+inline Float8 Float8::Zero() { return { _mm_setzero_ps(), _mm_setzero_ps() }; }
+inline Float8 Float8::Load(const float* pSrc) { return { _mm_loadu_ps(pSrc), _mm_loadu_ps(pSrc + 4) }; }
+inline Float8 Float8::Min(const Float8& a, const Float8& b) { return { _mm_min_ps(a.lo, b.lo), _mm_min_ps(a.hi, b.hi) }; }
+inline Float8 Float8::Max(const Float8& a, const Float8& b) { return { _mm_max_ps(a.lo, b.lo), _mm_max_ps(a.hi, b.hi) }; }
+inline Float8 Float8::Sqrt(const Float8& a) { return { _mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi) }; }
+inline Float8 Float8::MulAdd(const Float8& a, const Float8& b, const Float8& c) { return a * b + c; }
+
+inline Float8 Float8::Select(const Float8& mask, const Float8& a, const Float8& b)
+{
+    return { _mm_or_ps(_mm_and_ps(mask.lo, a.lo), _mm_andnot_ps(mask.lo, b.lo)),
+             _mm_or_ps(_mm_and_ps(mask.hi, a.hi), _mm_andnot_ps(mask.hi, b.hi)) };
+}
+
+inline void Float8::store(float* pDst) const
+{
+    _mm_storeu_ps(pDst, lo);
+    _mm_storeu_ps(pDst + 4, hi);
+}
+
+inline uint32_t Float8::mask() const { return static_cast<uint32_t>(_mm_movemask_ps(lo) | _mm_movemask_ps(hi) << 4); }
+inline Float8 Float8::operator-() const { return Zero() - *this; }
+inline Float8 Float8::operator+(const Float8& rhs) const { return { _mm_add_ps(lo, rhs.lo), _mm_add_ps(hi, rhs.hi) }; }
+inline Float8 Float8::operator-(const Float8& rhs) const { return { _mm_sub_ps(lo, rhs.lo), _mm_sub_ps(hi, rhs.hi) }; }
+inline Float8 Float8::operator*(const Float8& rhs) const { return { _mm_mul_ps(lo, rhs.lo), _mm_mul_ps(hi, rhs.hi) }; }
+inline Float8 Float8::operator/(const Float8& rhs) const { return { _mm_div_ps(lo, rhs.lo), _mm_div_ps(hi, rhs.hi) }; }
+inline Float8 Float8::operator&(const Float8& rhs) const { return { _mm_and_ps(lo, rhs.lo), _mm_and_ps(hi, rhs.hi) }; }
+inline Float8 Float8::operator|(const Float8& rhs) const { return { _mm_or_ps(lo, rhs.lo), _mm_or_ps(hi, rhs.hi) }; }
+inline Float8 Float8::operator<(const Float8& rhs) const { return { _mm_cmplt_ps(lo, rhs.lo), _mm_cmplt_ps(hi, rhs.hi) }; }
+inline Float8 Float8::operator<=(const Float8& rhs) const { return { _mm_cmple_ps(lo, rhs.lo), _mm_cmple_ps(hi, rhs.hi) }; }
+inline Float8 Float8::operator>(const Float8& rhs) const { return { _mm_cmpgt_ps(lo, rhs.lo), _mm_cmpgt_ps(hi, rhs.hi) }; }
+inline Float8 Float8::operator>=(const Float8& rhs) const { return { _mm_cmpge_ps(lo, rhs.lo), _mm_cmpge_ps(hi, rhs.hi) }; }
+#else
+namespace Simd
+{
+    // scalar lanes keep comparison masks as all ones bit patterns, like the simd paths
+    inline float MaskLane(bool isSet)
+    {
+        uint32_t bits = isSet ? ~0u : 0u;
+        float lane;
+        memcpy(&lane, &bits, sizeof(lane));
+        return lane;
+    }
+
+    inline uint32_t LaneBits(float lane)
+    {
+        uint32_t bits;
+        memcpy(&bits, &lane, sizeof(bits));
+        return bits;
+    }
+
+    template<typename Function>
+    Float8 Map8(Function function)
+    {
+        Float8 result;
+        for (uint32_t i = 0; i < 8; ++i) result.v[i] = function(i);
+        return result;
+    }
+}
+
+inline Float8 Float8::Splat(float value) { return Simd::Map8([=](uint32_t) { return value; }); }
+inline Float8 Float8::Zero() { return Splat(0); }
+inline Float8 Float8::Load(const float* pSrc) { return Simd::Map8([=](uint32_t i) { return pSrc[i]; }); }
+
+inline Float8 Float8::Min(const Float8& a, const Float8& b)
+{
+    return Simd::Map8([&](uint32_t i) { return a.v[i] < b.v[i] ? a.v[i] : b.v[i]; });
+}
+
+inline Float8 Float8::Max(const Float8& a, const Float8& b)
+{
+    return Simd::Map8([&](uint32_t i) { return a.v[i] > b.v[i] ? a.v[i] : b.v[i]; });
+}
+
+inline Float8 Float8::Sqrt(const Float8& a) { return Simd::Map8([&](uint32_t i) { return std::sqrt(a.v[i]); }); }
+inline Float8 Float8::MulAdd(const Float8& a, const Float8& b, const Float8& c) { return a * b + c; }
+
+inline Float8 Float8::Select(const Float8& mask, const Float8& a, const Float8& b)
+{
+    return Simd::Map8([&](uint32_t i) { return Simd::LaneBits(mask.v[i]) >> 31 ? a.v[i] : b.v[i]; });
+}
+
+inline void Float8::store(float* pDst) const { memcpy(pDst, v, sizeof(v)); }
+
+inline uint32_t Float8::mask() const
+{
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < 8; ++i) bits |= (Simd::LaneBits(v[i]) >> 31) << i;
+    return bits;
+}
+
+inline Float8 Float8::operator-() const { return Simd::Map8([&](uint32_t i) { return -v[i]; }); }
+inline Float8 Float8::operator+(const Float8& rhs) const { return Simd::Map8([&](uint32_t i) { return v[i] + rhs.v[i]; }); }
+inline Float8 Float8::operator-(const Float8& rhs) const { return Simd::Map8([&](uint32_t i) { return v[i] - rhs.v[i]; }); }
+inline Float8 Float8::operator*(const Float8& rhs) const { return Simd::Map8([&](uint32_t i) { return v[i] * rhs.v[i]; }); }
+inline Float8 Float8::operator/(const Float8& rhs) const { return Simd::Map8([&](uint32_t i) { return v[i] / rhs.v[i]; }); }
+
+inline Float8 Float8::operator&(const Float8& rhs) const
+{
+    return Simd::Map8([&](uint32_t i) { return Simd::MaskLane(Simd::LaneBits(v[i]) & Simd::LaneBits(rhs.v[i])); });
+}
+
+inline Float8 Float8::operator|(const Float8& rhs) const
+{
+    return Simd::Map8([&](uint32_t i) { return Simd::MaskLane(Simd::LaneBits(v[i]) | Simd::LaneBits(rhs.v[i])); });
+}
+
+inline Float8 Float8::operator<(const Float8& rhs) const { return Simd::Map8([&](uint32_t i) { return Simd::MaskLane(v[i] < rhs.v[i]); }); }
+inline Float8 Float8::operator<=(const Float8& rhs) const { return Simd::Map8([&](uint32_t i) { return Simd::MaskLane(v[i] <= rhs.v[i]); }); }
+inline Float8 Float8::operator>(const Float8& rhs) const { return Simd::Map8([&](uint32_t i) { return Simd::MaskLane(v[i] > rhs.v[i]); }); }
+inline Float8 Float8::operator>=(const Float8& rhs) const { return Simd::Map8([&](uint32_t i) { return Simd::MaskLane(v[i] >= rhs.v[i]); }); }
+#endif
+
+inline Float8 Float8::LoadPartial(const float* pSrc, uint32_t count)
+{
+    if (count >= 8) return Load(pSrc);
+    alignas(32) float lanes[8] = {};
+    memcpy(lanes, pSrc, count * sizeof(float));
+    return Load(lanes);
+}
+
+inline void Float8::storePartial(float* pDst, uint32_t count) const
+{
+    if (count >= 8)
+    {
+        store(pDst);
+        return;
+    }
+    alignas(32) float lanes[8];
+    store(lanes);
+    memcpy(pDst, lanes, count * sizeof(float));
+}
+
+inline float Float8::lane(uint32_t index) const
+{
+    alignas(32) float lanes[8];
+    store(lanes);
+    return lanes[index];
+}
+
+inline Float8& Float8::operator+=(const Float8& rhs) { return *this = *this + rhs; }
+inline Float8& Float8::operator-=(const Float8& rhs) { return *this = *this - rhs; }
+inline Float8& Float8::operator*=(const Float8& rhs) { return *this = *this * rhs; }
+
+// ---------------------------------------- Vec3x8 ---------------------------------------- //
+
+inline Vec3x8 Vec3x8::Splat(const Vector3& v)
+{
+    return { Float8::Splat(v.x), Float8::Splat(v.y), Float8::Splat(v.z) };
+}
+
+inline Vec3x8 Vec3x8::Load(const float* pX, const float* pY, const float* pZ)
+{
+    return { Float8::Load(pX), Float8::Load(pY), Float8::Load(pZ) };
+}
+
+inline Vec3x8 Vec3x8::Gather(const Vector3* pSrc, uint32_t count)
+{
+    alignas(32) float lanes[3][8] = {};
+    count = (std::min)(count, 8u);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        lanes[0][i] = pSrc[i].x;
+        lanes[1][i] = pSrc[i].y;
+        lanes[2][i] = pSrc[i].z;
+    }
+    return Load(lanes[0], lanes[1], lanes[2]);
+}
+
+inline Float8 Vec3x8::Dot(const Vec3x8& a, const Vec3x8& b)
+{
+    return Float8::MulAdd(a.x, b.x, Float8::MulAdd(a.y, b.y, a.z * b.z));
+}
+
+inline Vec3x8 Vec3x8::Cross(const Vec3x8& a, const Vec3x8& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+inline Vec3x8 Vec3x8::Min(const Vec3x8& a, const Vec3x8& b)
+{
+    return { Float8::Min(a.x, b.x), Float8::Min(a.y, b.y), Float8::Min(a.z, b.z) };
+}
+
+inline Vec3x8 Vec3x8::Max(const Vec3x8& a, const Vec3x8& b)
+{
+    return { Float8::Max(a.x, b.x), Float8::Max(a.y, b.y), Float8::Max(a.z, b.z) };
+}
+
+inline Vec3x8 Vec3x8::Normalize(const Vec3x8& a)
+{
+    return a * (Float8::Splat(1) / Float8::Sqrt(a.lengthSquared()));
+}
+
+inline void Vec3x8::store(float* pX, float* pY, float* pZ) const
+{
+    x.store(pX);
+    y.store(pY);
+    z.store(pZ);
+}
+
+inline void Vec3x8::scatter(Vector3* pDst, uint32_t count) const
+{
+    alignas(32) float lanes[3][8];
+    store(lanes[0], lanes[1], lanes[2]);
+    count = (std::min)(count, 8u);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        pDst[i] = Vector3(lanes[0][i], lanes[1][i], lanes[2][i]);
+    }
+}
+
+inline Float8 Vec3x8::lengthSquared() const { return Dot(*this, *this); }
+inline Vector3 Vec3x8::lane(uint32_t index) const { return { x.lane(index), y.lane(index), z.lane(index) }; }
+inline Vec3x8 Vec3x8::operator+(const Vec3x8& rhs) const { return { x + rhs.x, y + rhs.y, z + rhs.z }; }
+inline Vec3x8 Vec3x8::operator-(const Vec3x8& rhs) const { return { x - rhs.x, y - rhs.y, z - rhs.z }; }
+inline Vec3x8 Vec3x8::operator*(const Vec3x8& rhs) const { return { x * rhs.x, y * rhs.y, z * rhs.z }; }
+inline Vec3x8 Vec3x8::operator*(const Float8& scalar) const { return { x * scalar, y * scalar, z * scalar }; }
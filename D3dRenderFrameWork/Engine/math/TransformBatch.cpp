@@ -0,0 +1,302 @@
+#include "Engine/math/TransformBatch.h"
+#include "Engine/math/SoA.h"
+#include "Engine/common/Parallel.h"
+#include "Engine/common/StreamCopy.h"
+
+#undef max
+#undef min
+
+namespace
+{
+    // objects per parallel grain, a multiple of the 8 lanes
+    constexpr uint64_t OBJECTS_PER_GRAIN = 1024;
+
+    // 8 affine matrices, element (row, column) of every matrix in one Float8
+    struct Matrix3x4x8
+    {
+        Float8 m[3][4];
+    };
+
+    Matrix3x4x8 LoadMatrices(const Matrix3x4* pSrc, uint64_t count)
+    {
+        alignas(32) float lanes[3][4][8] = {};
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            for (int row = 0; row < 3; ++row)
+            {
+                for (int column = 0; column < 4; ++column)
+                {
+                    lanes[row][column][i] = pSrc[i].m[row][column];
+                }
+            }
+        }
+        Matrix3x4x8 result;
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                result.m[row][column] = Float8::Load(lanes[row][column]);
+            }
+        }
+        return result;
+    }
+
+    void StoreMatrices(const Matrix3x4x8& matrices, Matrix3x4* pDst, uint64_t count)
+    {
+        alignas(32) float lanes[3][4][8];
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                matrices.m[row][column].store(lanes[row][column]);
+            }
+        }
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            for (int row = 0; row < 3; ++row)
+            {
+                for (int column = 0; column < 4; ++column)
+                {
+                    pDst[i].m[row][column] = lanes[row][column][i];
+                }
+            }
+        }
+    }
+
+    // translation, rotation and scale components of 8 transforms
+    struct Trs8
+    {
+        Float8 mComponents[10];
+    };
+
+    const float* TrsComponent(const TransformBatch::TrsArrays& local, int component)
+    {
+        return component < 3 ? local.mTranslation[component] :
+               component < 7 ? local.mRotation[component - 3] : local.mScale[component - 7];
+    }
+
+    Trs8 LoadTrs(const TransformBatch::TrsArrays& local, uint64_t first, uint32_t count)
+    {
+        Trs8 result;
+        for (int component = 0; component < 10; ++component)
+        {
+            result.mComponents[component] = Float8::LoadPartial(TrsComponent(local, component) + first, count);
+        }
+        return result;
+    }
+
+    Trs8 GatherTrs(const TransformBatch::TrsArrays& local, const uint32_t* pIndices, uint32_t count)
+    {
+        alignas(32) float lanes[10][8] = {};
+        Trs8 result;
+        for (int component = 0; component < 10; ++component)
+        {
+            const float* pComponent = TrsComponent(local, component);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                lanes[component][i] = pComponent[pIndices[i]];
+            }
+            result.mComponents[component] = Float8::Load(lanes[component]);
+        }
+        return result;
+    }
+
+    Matrix3x4x8 ComposeTrs8(const Trs8& trs)
+    {
+        const Float8& tx = trs.mComponents[0];
+        const Float8& ty = trs.mComponents[1];
+        const Float8& tz = trs.mComponents[2];
+        const Float8& qx = trs.mComponents[3];
+        const Float8& qy = trs.mComponents[4];
+        const Float8& qz = trs.mComponents[5];
+        const Float8& qw = trs.mComponents[6];
+        const Float8& sx = trs.mComponents[7];
+        const Float8& sy = trs.mComponents[8];
+        const Float8& sz = trs.mComponents[9];
+
+        Float8 one = Float8::Splat(1);
+        Float8 two = Float8::Splat(2);
+        Float8 xx = qx * qx;
+        Float8 yy = qy * qy;
+        Float8 zz = qz * qz;
+        Float8 xy = qx * qy;
+        Float8 xz = qx * qz;
+        Float8 yz = qy * qz;
+        Float8 wx = qw * qx;
+        Float8 wy = qw * qy;
+        Float8 wz = qw * qz;
+
+        Matrix3x4x8 result;
+        result.m[0][0] = (one - two * (yy + zz)) * sx;
+        result.m[0][1] = two * (xy - wz) * sy;
+        result.m[0][2] = two * (xz + wy) * sz;
+        result.m[0][3] = tx;
+        result.m[1][0] = two * (xy + wz) * sx;
+        result.m[1][1] = (one - two * (xx + zz)) * sy;
+        result.m[1][2] = two * (yz - wx) * sz;
+        result.m[1][3] = ty;
+        result.m[2][0] = two * (xz - wy) * sx;
+        result.m[2][1] = two * (yz + wx) * sy;
+        result.m[2][2] = (one - two * (xx + yy)) * sz;
+        result.m[2][3] = tz;
+        return result;
+    }
+
+    // local applied first, then parent, in column form parent * local
+    Matrix3x4x8 Multiply8(const Matrix3x4x8& local, const Matrix3x4x8& parent)
+    {
+        Matrix3x4x8 result;
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                Float8 element = Float8::MulAdd(parent.m[row][0], local.m[0][column],
+                                 Float8::MulAdd(parent.m[row][1], local.m[1][column], parent.m[row][2] * local.m[2][column]));
+                result.m[row][column] = column == 3 ? element + parent.m[row][3] : element;
+            }
+        }
+        return result;
+    }
+
+    void WriteObjectMatrices8(const Matrix3x4* pWorld, const Float8 (&viewProjection)[4][4],
+                              byte* pDst, uint64_t dstStride, uint32_t count)
+    {
+        Matrix3x4x8 world = LoadMatrices(pWorld, count);
+        const Float8 (&a)[3][4] = world.m;
+        alignas(32) float lanes[3][4][4][8];
+
+        // model in row vector form is the transposed affine matrix with a (0, 0, 0, 1) column
+        Float8 zero = Float8::Zero();
+        Float8 one = Float8::Splat(1);
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                a[column][row].store(lanes[0][row][column]);
+            }
+            (row == 3 ? one : zero).store(lanes[0][row][3]);
+        }
+
+        // model * viewProjection, only the first three columns of the model are not constant
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                Float8 element = Float8::MulAdd(a[0][row], viewProjection[0][column],
+                                 Float8::MulAdd(a[1][row], viewProjection[1][column], a[2][row] * viewProjection[2][column]));
+                if (row == 3) element += viewProjection[3][column];
+                element.store(lanes[1][row][column]);
+            }
+        }
+
+        // in row vector form the inverse transpose of the model is the inverse of the affine matrix,
+        // inverse(a)[i][j] = cofactor(a)[j][i] / det(a)
+        Float8 cofactors[3][3];
+        for (int i = 0; i < 3; ++i)
+        {
+            int i1 = (i + 1) % 3;
+            int i2 = (i + 2) % 3;
+            for (int j = 0; j < 3; ++j)
+            {
+                int j1 = (j + 1) % 3;
+                int j2 = (j + 2) % 3;
+                cofactors[i][j] = a[i1][j1] * a[i2][j2] - a[i1][j2] * a[i2][j1];
+            }
+        }
+        Float8 determinant = Float8::MulAdd(a[0][0], cofactors[0][0],
+                             Float8::MulAdd(a[0][1], cofactors[0][1], a[0][2] * cofactors[0][2]));
+        Float8 isRegular = (determinant < zero) | (determinant > zero);
+        Float8 scale = Float8::Select(isRegular, one / determinant, zero);
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                Float8 element = row < 3 && column < 3 ? cofactors[column][row] * scale : (row == 3 && column == 3 ? one : zero);
+                element.store(lanes[2][row][column]);
+            }
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            TransformBatch::ObjectMatrices matrices;
+            Matrix4x4* pMatrices = &matrices.mModel;
+            for (int matrix = 0; matrix < 3; ++matrix)
+            {
+                for (int row = 0; row < 4; ++row)
+                {
+                    for (int column = 0; column < 4; ++column)
+                    {
+                        pMatrices[matrix].m[row][column] = lanes[matrix][row][column][i];
+                    }
+                }
+            }
+            StreamWrite(pDst + i * dstStride, &matrices, sizeof(matrices));
+        }
+    }
+}
+
+void TransformBatch::ComposeTrs(const TrsArrays& local, Matrix3x4* pWorld, uint64_t count)
+{
+    ParallelFor(0, count, OBJECTS_PER_GRAIN, [=](uint64_t begin, uint64_t end)
+    {
+        for (uint64_t first = begin; first < end; first += 8)
+        {
+            uint32_t numLanes = static_cast<uint32_t>((std::min)(end - first, uint64_t{ 8 }));
+            StoreMatrices(ComposeTrs8(LoadTrs(local, first, numLanes)), pWorld + first, numLanes);
+        }
+    });
+}
+
+void TransformBatch::WriteObjectMatrices(const Matrix3x4* pWorld, const Matrix4x4& viewProjection,
+                                         void* pDst, uint64_t dstStride, uint64_t count)
+{
+    static_assert(sizeof(ObjectMatrices) == 3 * sizeof(Matrix4x4), "object matrices are copied as one block");
+    Float8 splatViewProjection[4][4];
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int column = 0; column < 4; ++column)
+        {
+            splatViewProjection[row][column] = Float8::Splat(viewProjection.m[row][column]);
+        }
+    }
+    byte* pDstBytes = static_cast<byte*>(pDst);
+    ParallelFor(0, count, OBJECTS_PER_GRAIN, [=, &splatViewProjection](uint64_t begin, uint64_t end)
+    {
+        for (uint64_t first = begin; first < end; first += 8)
+        {
+            uint32_t numLanes = static_cast<uint32_t>((std::min)(end - first, uint64_t{ 8 }));
+            WriteObjectMatrices8(pWorld + first, splatViewProjection, pDstBytes + first * dstStride, dstStride, numLanes);
+        }
+        // the streaming stores of this thread are done before the frame is submitted
+        StreamFence();
+    });
+}
+
+void TransformBatch::UpdateWorlds(const TrsArrays& local, const uint32_t* pParents, const Matrix3x4* pParentWorld,
+                                  const uint32_t* pIndices, uint64_t count, Matrix3x4* pWorld)
+{
+    ParallelFor(0, count, OBJECTS_PER_GRAIN, [=](uint64_t begin, uint64_t end)
+    {
+        for (uint64_t first = begin; first < end; first += 8)
+        {
+            uint32_t numLanes = static_cast<uint32_t>((std::min)(end - first, uint64_t{ 8 }));
+            const uint32_t* pBatch = pIndices + first;
+            Matrix3x4x8 world = ComposeTrs8(GatherTrs(local, pBatch, numLanes));
+            if (pParentWorld)
+            {
+                Matrix3x4 parents[8];
+                for (uint32_t i = 0; i < numLanes; ++i)
+                {
+                    parents[i] = pParentWorld[pParents[pBatch[i]]];
+                }
+                world = Multiply8(world, LoadMatrices(parents, numLanes));
+            }
+            alignas(16) Matrix3x4 results[8];
+            StoreMatrices(world, results, numLanes);
+            for (uint32_t i = 0; i < numLanes; ++i)
+            {
+                pWorld[pBatch[i]] = results[i];
+            }
+        }
+    });
+}
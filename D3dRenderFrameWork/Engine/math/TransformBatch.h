@@ -0,0 +1,36 @@
+#pragma once
+#include "Engine/math/Matrix.h"
+
+// batched transform kernels, objects are processed 8 at a time in Float8 lanes and the batches are spread over
+// the worker pool. inputs are plain arrays so scene data can be fed without repacking.
+namespace TransformBatch
+{
+    // local transforms as separate component arrays, rotations are unit quaternions
+    struct TrsArrays
+    {
+        const float* mTranslation[3];
+        const float* mRotation[4];
+        const float* mScale[3];
+    };
+
+    // what a vertex shader needs per object, as row vector matrices in XMMATRIX layout:
+    // the model matrix, model * viewProjection and the inverse transpose of the model for normals.
+    struct ObjectMatrices
+    {
+        Matrix4x4 mModel;
+        Matrix4x4 mModelViewProjection;
+        Matrix4x4 mNormal;
+    };
+
+    // pWorld[i] = Matrix3x4::Trs(translation[i], rotation[i], scale[i])
+    void ComposeTrs(const TrsArrays& local, Matrix3x4* pWorld, uint64_t count);
+    // for every i in pIndices: pWorld[i] = Trs(local[i]) * pParentWorld[pParents[i]], or just Trs(local[i]) when
+    // pParentWorld is null. pWorld must not alias pParentWorld.
+    void UpdateWorlds(const TrsArrays& local, const uint32_t* pParents, const Matrix3x4* pParentWorld,
+                      const uint32_t* pIndices, uint64_t count, Matrix3x4* pWorld);
+    // writes one ObjectMatrices for every world matrix to pDst + i * dstStride. each object is assembled on the stack
+    // and streamed out in one go with non temporal stores, pDst is meant to point into write combined upload memory.
+    // the normal matrix of a singular model is zero.
+    void WriteObjectMatrices(const Matrix3x4* pWorld, const Matrix4x4& viewProjection,
+                             void* pDst, uint64_t dstStride, uint64_t count);
+}
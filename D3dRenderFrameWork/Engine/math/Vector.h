@@ -0,0 +1,342 @@
+#pragma once
+#include "Engine/common/Simd.h"
+#include <cmath>
+
+// plain float vectors, layout compatible with float2/3/4 in hlsl and the XMFLOAT types. Vector2 and Vector3 stay scalar,
+// a single 2 or 3 wide operation loses more on loads and shuffles than sse wins back. Vector4 runs in one sse register.
+struct Vector2
+{
+    float x;
+    float y;
+
+    static float Length(const Vector2& v);
+    static float LengthSquared(const Vector2& v);
+    static float Dot(const Vector2& v1, const Vector2& v2);
+    static float Distance(const Vector2& v1, const Vector2& v2);
+    static void Normalize(Vector2& v);
+
+    float Length() const;
+    float LengthSquared() const;
+    float Dot(const Vector2& rhs) const;
+    Vector2 Normalize() const;
+
+    Vector2() : x(0), y(0) {}
+    Vector2(float x, float y) : x(x), y(y) {}
+
+    float operator[](int index) const;
+    float& operator[](int index);
+    Vector2 operator-() const;
+    Vector2 operator+(float scalar) const;
+    Vector2 operator-(float scalar) const;
+    Vector2 operator*(float scalar) const;
+    Vector2 operator/(float scalar) const;
+    Vector2 operator+(const Vector2& rhs) const;
+    Vector2 operator-(const Vector2& rhs) const;
+    Vector2 operator*(const Vector2& rhs) const;
+    Vector2 operator/(const Vector2& rhs) const;
+    Vector2& operator+=(const Vector2& rhs);
+    Vector2& operator-=(const Vector2& rhs);
+    Vector2& operator*=(const Vector2& rhs);
+    Vector2& operator/=(const Vector2& rhs);
+    Vector2& operator+=(float scalar);
+    Vector2& operator-=(float scalar);
+    Vector2& operator*=(float scalar);
+    Vector2& operator/=(float scalar);
+    bool operator==(const Vector2& rhs) const;
+    bool operator!=(const Vector2& rhs) const;
+};
+
+struct Vector3
+{
+    float x;
+    float y;
+    float z;
+
+    static float Length(const Vector3& v);
+    static float LengthSquared(const Vector3& v);
+    static float Dot(const Vector3& v1, const Vector3& v2);
+    static Vector3 Cross(const Vector3& v1, const Vector3& v2);
+    static float Distance(const Vector3& v1, const Vector3& v2);
+    static void Normalize(Vector3& v);
+    static Vector3 Min(const Vector3& v1, const Vector3& v2);
+    static Vector3 Max(const Vector3& v1, const Vector3& v2);
+    static Vector3 Lerp(const Vector3& v1, const Vector3& v2, float t);
+
+    float Length() const;
+    float LengthSquared() const;
+    float Dot(const Vector3& rhs) const;
+    Vector3 Cross(const Vector3& rhs) const;
+    Vector3 Normalize() const;
+
+    Vector3() : x(0), y(0), z(0) {}
+    Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+    float operator[](int index) const;
+    float& operator[](int index);
+    Vector3 operator-() const;
+    Vector3 operator+(float scalar) const;
+    Vector3 operator-(float scalar) const;
+    Vector3 operator*(float scalar) const;
+    Vector3 operator/(float scalar) const;
+    Vector3 operator+(const Vector3& rhs) const;
+    Vector3 operator-(const Vector3& rhs) const;
+    Vector3 operator*(const Vector3& rhs) const;
+    Vector3 operator/(const Vector3& rhs) const;
+    Vector3& operator+=(const Vector3& rhs);
+    Vector3& operator-=(const Vector3& rhs);
+    Vector3& operator*=(const Vector3& rhs);
+    Vector3& operator/=(const Vector3& rhs);
+    Vector3& operator+=(float scalar);
+    Vector3& operator-=(float scalar);
+    Vector3& operator*=(float scalar);
+    Vector3& operator/=(float scalar);
+    bool operator==(const Vector3& rhs) const;
+    bool operator!=(const Vector3& rhs) const;
+};
+
+struct alignas(16) Vector4
+{
+    float x;
+    float y;
+    float z;
+    float w;
+
+    static float Length(const Vector4& v);
+    static float LengthSquared(const Vector4& v);
+    static float Dot(const Vector4& v1, const Vector4& v2);
+    static float Distance(const Vector4& v1, const Vector4& v2);
+    static void Normalize(Vector4& v);
+    static Vector4 Min(const Vector4& v1, const Vector4& v2);
+    static Vector4 Max(const Vector4& v1, const Vector4& v2);
+    static Vector4 Lerp(const Vector4& v1, const Vector4& v2, float t);
+
+    float Length() const;
+    float LengthSquared() const;
+    float Dot(const Vector4& rhs) const;
+    Vector4 Normalize() const;
+    Vector3 xyz() const;
+
+    Vector4() : x(0), y(0), z(0), w(0) {}
+    Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+    Vector4(const Vector3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    float operator[](int index) const;
+    float& operator[](int index);
+    Vector4 operator-() const;
+    Vector4 operator+(float scalar) const;
+    Vector4 operator-(float scalar) const;
+    Vector4 operator*(float scalar) const;
+    Vector4 operator/(float scalar) const;
+    Vector4 operator+(const Vector4& rhs) const;
+    Vector4 operator-(const Vector4& rhs) const;
+    Vector4 operator*(const Vector4& rhs) const;
+    Vector4 operator/(const Vector4& rhs) const;
+    Vector4& operator+=(const Vector4& rhs);
+    Vector4& operator-=(const Vector4& rhs);
+    Vector4& operator*=(const Vector4& rhs);
+    Vector4& operator/=(const Vector4& rhs);
+    Vector4& operator+=(float scalar);
+    Vector4& operator-=(float scalar);
+    Vector4& operator*=(float scalar);
+    Vector4& operator/=(float scalar);
+    bool operator==(const Vector4& rhs) const;
+    bool operator!=(const Vector4& rhs) const;
+
+#ifdef SIMD_SSE2
+    explicit Vector4(__m128 v) { _mm_store_ps(&x, v); }
+    __m128 load() const { return _mm_load_ps(&x); }
+#endif
+};
+
+// --------------------------------------- Vector2 --------------------------------------- //
+
+inline float Vector2::Length(const Vector2& v) { return v.Length(); }
+inline float Vector2::LengthSquared(const Vector2& v) { return v.LengthSquared(); }
+inline float Vector2::Dot(const Vector2& v1, const Vector2& v2) { return v1.Dot(v2); }
+inline float Vector2::Distance(const Vector2& v1, const Vector2& v2) { return (v1 - v2).Length(); }
+inline void Vector2::Normalize(Vector2& v) { v = v.Normalize(); }
+
+inline float Vector2::Length() const { return std::sqrt(LengthSquared()); }
+inline float Vector2::LengthSquared() const { return x * x + y * y; }
+inline float Vector2::Dot(const Vector2& rhs) const { return x * rhs.x + y * rhs.y; }
+
+inline Vector2 Vector2::Normalize() const
+{
+    float length = Length();
+    return length > 0 ? *this / length : *this;
+}
+
+inline float Vector2::operator[](int index) const { return (&x)[index]; }
+inline float& Vector2::operator[](int index) { return (&x)[index]; }
+inline Vector2 Vector2::operator-() const { return { -x, -y }; }
+inline Vector2 Vector2::operator+(float scalar) const { return { x + scalar, y + scalar }; }
+inline Vector2 Vector2::operator-(float scalar) const { return { x - scalar, y - scalar }; }
+inline Vector2 Vector2::operator*(float scalar) const { return { x * scalar, y * scalar }; }
+inline Vector2 Vector2::operator/(float scalar) const { return { x / scalar, y / scalar }; }
+inline Vector2 Vector2::operator+(const Vector2& rhs) const { return { x + rhs.x, y + rhs.y }; }
+inline Vector2 Vector2::operator-(const Vector2& rhs) const { return { x - rhs.x, y - rhs.y }; }
+inline Vector2 Vector2::operator*(const Vector2& rhs) const { return { x * rhs.x, y * rhs.y }; }
+inline Vector2 Vector2::operator/(const Vector2& rhs) const { return { x / rhs.x, y / rhs.y }; }
+inline Vector2& Vector2::operator+=(const Vector2& rhs) { return *this = *this + rhs; }
+inline Vector2& Vector2::operator-=(const Vector2& rhs) { return *this = *this - rhs; }
+inline Vector2& Vector2::operator*=(const Vector2& rhs) { return *this = *this * rhs; }
+inline Vector2& Vector2::operator/=(const Vector2& rhs) { return *this = *this / rhs; }
+inline Vector2& Vector2::operator+=(float scalar) { return *this = *this + scalar; }
+inline Vector2& Vector2::operator-=(float scalar) { return *this = *this - scalar; }
+inline Vector2& Vector2::operator*=(float scalar) { return *this = *this * scalar; }
+inline Vector2& Vector2::operator/=(float scalar) { return *this = *this / scalar; }
+inline bool Vector2::operator==(const Vector2& rhs) const { return x == rhs.x && y == rhs.y; }
+inline bool Vector2::operator!=(const Vector2& rhs) const { return !(*this == rhs); }
+
+// --------------------------------------- Vector3 --------------------------------------- //
+
+inline float Vector3::Length(const Vector3& v) { return v.Length(); }
+inline float Vector3::LengthSquared(const Vector3& v) { return v.LengthSquared(); }
+inline float Vector3::Dot(const Vector3& v1, const Vector3& v2) { return v1.Dot(v2); }
+inline Vector3 Vector3::Cross(const Vector3& v1, const Vector3& v2) { return v1.Cross(v2); }
+inline float Vector3::Distance(const Vector3& v1, const Vector3& v2) { return (v1 - v2).Length(); }
+inline void Vector3::Normalize(Vector3& v) { v = v.Normalize(); }
+
+inline Vector3 Vector3::Min(const Vector3& v1, const Vector3& v2)
+{
+    return { (std::min)(v1.x, v2.x), (std::min)(v1.y, v2.y), (std::min)(v1.z, v2.z) };
+}
+
+inline Vector3 Vector3::Max(const Vector3& v1, const Vector3& v2)
+{
+    return { (std::max)(v1.x, v2.x), (std::max)(v1.y, v2.y), (std::max)(v1.z, v2.z) };
+}
+
+inline Vector3 Vector3::Lerp(const Vector3& v1, const Vector3& v2, float t) { return v1 + (v2 - v1) * t; }
+
+inline float Vector3::Length() const { return std::sqrt(LengthSquared()); }
+inline float Vector3::LengthSquared() const { return x * x + y * y + z * z; }
+inline float Vector3::Dot(const Vector3& rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z; }
+
+inline Vector3 Vector3::Cross(const Vector3& rhs) const
+{
+    return { y * rhs.z - z * rhs.y, z * rhs.x - x * rhs.z, x * rhs.y - y * rhs.x };
+}
+
+inline Vector3 Vector3::Normalize() const
+{
+    float length = Length();
+    return length > 0 ? *this / length : *this;
+}
+
+inline float Vector3::operator[](int index) const { return (&x)[index]; }
+inline float& Vector3::operator[](int index) { return (&x)[index]; }
+inline Vector3 Vector3::operator-() const { return { -x, -y, -z }; }
+inline Vector3 Vector3::operator+(float scalar) const { return { x + scalar, y + scalar, z + scalar }; }
+inline Vector3 Vector3::operator-(float scalar) const { return { x - scalar, y - scalar, z - scalar }; }
+inline Vector3 Vector3::operator*(float scalar) const { return { x * scalar, y * scalar, z * scalar }; }
+inline Vector3 Vector3::operator/(float scalar) const { return { x / scalar, y / scalar, z / scalar }; }
+inline Vector3 Vector3::operator+(const Vector3& rhs) const { return { x + rhs.x, y + rhs.y, z + rhs.z }; }
+inline Vector3 Vector3::operator-(const Vector3& rhs) const { return { x - rhs.x, y - rhs.y, z - rhs.z }; }
+inline Vector3 Vector3::operator*(const Vector3& rhs) const { return { x * rhs.x, y * rhs.y, z * rhs.z }; }
+inline Vector3 Vector3::operator/(const Vector3& rhs) const { return { x / rhs.x, y / rhs.y, z / rhs.z }; }
+inline Vector3& Vector3::operator+=(const Vector3& rhs) { return *this = *this + rhs; }
+inline Vector3& Vector3::operator-=(const Vector3& rhs) { return *this = *this - rhs; }
+inline Vector3& Vector3::operator*=(const Vector3& rhs) { return *this = *this * rhs; }
+inline Vector3& Vector3::operator/=(const Vector3& rhs) { return *this = *this / rhs; }
+inline Vector3& Vector3::operator+=(float scalar) { return *this = *this + scalar; }
+inline Vector3& Vector3::operator-=(float scalar) { return *this = *this - scalar; }
+inline Vector3& Vector3::operator*=(float scalar) { return *this = *this * scalar; }
+inline Vector3& Vector3::operator/=(float scalar) { return *this = *this / scalar; }
+inline bool Vector3::operator==(const Vector3& rhs) const { return x == rhs.x && y == rhs.y && z == rhs.z; }
+inline bool Vector3::operator!=(const Vector3& rhs) const { return !(*this == rhs); }
+
+// --------------------------------------- Vector4 --------------------------------------- //
+
+#ifdef SIMD_SSE2
+namespace Simd
+{
+    // horizontal sum of the 4 lanes, broadcast to every lane
+    inline __m128 Sum4(__m128 v)
+    {
+        __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 sums = _mm_add_ps(v, shuffled);
+        return _mm_add_ps(sums, _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+}
+#endif
+
+inline float Vector4::Length(const Vector4& v) { return v.Length(); }
+inline float Vector4::LengthSquared(const Vector4& v) { return v.LengthSquared(); }
+inline float Vector4::Dot(const Vector4& v1, const Vector4& v2) { return v1.Dot(v2); }
+inline float Vector4::Distance(const Vector4& v1, const Vector4& v2) { return (v1 - v2).Length(); }
+inline void Vector4::Normalize(Vector4& v) { v = v.Normalize(); }
+inline Vector4 Vector4::Lerp(const Vector4& v1, const Vector4& v2, float t) { return v1 + (v2 - v1) * t; }
+inline float Vector4::Length() const { return std::sqrt(LengthSquared()); }
+inline float Vector4::LengthSquared() const { return Dot(*this); }
+inline Vector3 Vector4::xyz() const { return { x, y, z }; }
+inline float Vector4::operator[](int index) const { return (&x)[index]; }
+inline float& Vector4::operator[](int index) { return (&x)[index]; }
+inline Vector4& Vector4::operator+=(const Vector4& rhs) { return *this = *this + rhs; }
+inline Vector4& Vector4::operator-=(const Vector4& rhs) { return *this = *this - rhs; }
+inline Vector4& Vector4::operator*=(const Vector4& rhs) { return *this = *this * rhs; }
+inline Vector4& Vector4::operator/=(const Vector4& rhs) { return *this = *this / rhs; }
+inline Vector4& Vector4::operator+=(float scalar) { return *this = *this + scalar; }
+inline Vector4& Vector4::operator-=(float scalar) { return *this = *this - scalar; }
+inline Vector4& Vector4::operator*=(float scalar) { return *this = *this * scalar; }
+inline Vector4& Vector4::operator/=(float scalar) { return *this = *this / scalar; }
+inline bool Vector4::operator!=(const Vector4& rhs) const { return !(*this == rhs); }
+
+#ifdef SIMD_SSE2
+inline Vector4 Vector4::Min(const Vector4& v1, const Vector4& v2) { return Vector4(_mm_min_ps(v1.load(), v2.load())); }
+inline Vector4 Vector4::Max(const Vector4& v1, const Vector4& v2) { return Vector4(_mm_max_ps(v1.load(), v2.load())); }
+inline float Vector4::Dot(const Vector4& rhs) const { return _mm_cvtss_f32(Simd::Sum4(_mm_mul_ps(load(), rhs.load()))); }
+
+inline Vector4 Vector4::Normalize() const
+{
+    __m128 v = load();
+    __m128 lengthSquared = Simd::Sum4(_mm_mul_ps(v, v));
+    __m128 isZero = _mm_cmpeq_ps(lengthSquared, _mm_setzero_ps());
+    __m128 normalized = _mm_div_ps(v, _mm_sqrt_ps(lengthSquared));
+    return Vector4(_mm_or_ps(_mm_and_ps(isZero, v), _mm_andnot_ps(isZero, normalized)));
+}
+
+inline Vector4 Vector4::operator-() const { return Vector4(_mm_sub_ps(_mm_setzero_ps(), load())); }
+inline Vector4 Vector4::operator+(float scalar) const { return Vector4(_mm_add_ps(load(), _mm_set1_ps(scalar))); }
+inline Vector4 Vector4::operator-(float scalar) const { return Vector4(_mm_sub_ps(load(), _mm_set1_ps(scalar))); }
+inline Vector4 Vector4::operator*(float scalar) const { return Vector4(_mm_mul_ps(load(), _mm_set1_ps(scalar))); }
+inline Vector4 Vector4::operator/(float scalar) const { return Vector4(_mm_div_ps(load(), _mm_set1_ps(scalar))); }
+inline Vector4 Vector4::operator+(const Vector4& rhs) const { return Vector4(_mm_add_ps(load(), rhs.load())); }
+inline Vector4 Vector4::operator-(const Vector4& rhs) const { return Vector4(_mm_sub_ps(load(), rhs.load())); }
+inline Vector4 Vector4::operator*(const Vector4& rhs) const { return Vector4(_mm_mul_ps(load(), rhs.load())); }
+inline Vector4 Vector4::operator/(const Vector4& rhs) const { return Vector4(_mm_div_ps(load(), rhs.load())); }
+inline bool Vector4::operator==(const Vector4& rhs) const { return _mm_movemask_ps(_mm_cmpeq_ps(load(), rhs.load())) == 0xf; }
+#else
+inline Vector4 Vector4::Min(const Vector4& v1, const Vector4& v2)
+{
+    return { (std::min)(v1.x, v2.x), (std::min)(v1.y, v2.y), (std::min)(v1.z, v2.z), (std::min)(v1.w, v2.w) };
+}
+
+inline Vector4 Vector4::Max(const Vector4& v1, const Vector4& v2)
+{
+    return { (std::max)(v1.x, v2.x), (std::max)(v1.y, v2.y), (std::max)(v1.z, v2.z), (std::max)(v1.w, v2.w) };
+}
+
+inline float Vector4::Dot(const Vector4& rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z + w * rhs.w; }
+
+inline Vector4 Vector4::Normalize() const
+{
+    float length = Length();
+    return length > 0 ? *this / length : *this;
+}
+
+inline Vector4 Vector4::operator-() const { return { -x, -y, -z, -w }; }
+inline Vector4 Vector4::operator+(float scalar) const { return { x + scalar, y + scalar, z + scalar, w + scalar }; }
+inline Vector4 Vector4::operator-(float scalar) const { return { x - scalar, y - scalar, z - scalar, w - scalar }; }
+inline Vector4 Vector4::operator*(float scalar) const { return { x * scalar, y * scalar, z * scalar, w * scalar }; }
+inline Vector4 Vector4::operator/(float scalar) const { return { x / scalar, y / scalar, z / scalar, w / scalar }; }
+inline Vector4 Vector4::operator+(const Vector4& rhs) const { return { x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w }; }
+inline Vector4 Vector4::operator-(const Vector4& rhs) const { return { x - rhs.x, y - rhs.y, z - rhs.z, w - rhs.w }; }
+inline Vector4 Vector4::operator*(const Vector4& rhs) const { return { x * rhs.x, y * rhs.y, z * rhs.z, w * rhs.w }; }
+inline Vector4 Vector4::operator/(const Vector4& rhs) const { return { x / rhs.x, y / rhs.y, z / rhs.z, w / rhs.w }; }
+
+inline bool Vector4::operator==(const Vector4& rhs) const
+{
+    return x == rhs.x && y == rhs.y && z == rhs.z && w == rhs.w;
+}
+#endif
@@ -1,6 +1,5 @@
 ﻿#pragma once
-#ifdef WIN32
-#include <Engine/math/PC/Vector2.h>
-#include <Engine/math/PC/Vector3.h>
-#else
-#endif
\ No newline at end of file
+#include "Engine/math/Vector.h"
+#include "Engine/math/Quaternion.h"
+#include "Engine/math/Matrix.h"
+#include "Engine/math/SoA.h"
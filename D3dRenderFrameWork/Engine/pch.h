@@ -4,6 +4,8 @@
 #endif
 
 // ------------------------------------Include------------------------------------------- //
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <algorithm>
 #include <stack>
@@ -11,6 +13,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 #include <string>
 #include <array>
 #include <mutex>
@@ -61,6 +64,8 @@ using namespace Microsoft::WRL;
 template<typename T>
 concept Numeric = std::is_arithmetic_v<T>;
 #endif
+#else
+using byte = unsigned char;
 #endif
 
 // -----------------------------------Definition----------------------------------------- //
@@ -0,0 +1,904 @@
+#include "Engine/render/BCnDecoder.h"
+#include "Engine/common/Parallel.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BCN_USE_SSE2
+#endif
+
+#undef max
+#undef min
+
+namespace
+{
+    // 128-bit little endian block, bits are consumed from the lowest bit.
+    struct BlockBits
+    {
+        explicit BlockBits(const uint8_t* pBlock) : mPos(0)
+        {
+            memcpy(&mLow, pBlock, sizeof(uint64_t));
+            memcpy(&mHigh, pBlock + sizeof(uint64_t), sizeof(uint64_t));
+        }
+
+        uint32_t read(uint32_t count)
+        {
+            uint32_t value = peek(mPos, count);
+            mPos += count;
+            return value;
+        }
+
+        uint32_t peek(uint32_t pos, uint32_t count) const
+        {
+            if (count == 0) return 0;
+            uint64_t value;
+            if (pos >= 64) value = mHigh >> (pos - 64);
+            else if (pos + count <= 64) value = mLow >> pos;
+            else value = (mLow >> pos) | (mHigh << (64 - pos));
+            return static_cast<uint32_t>(value & ((1ull << count) - 1));
+        }
+
+        uint64_t mLow;
+        uint64_t mHigh;
+        uint32_t mPos;
+    };
+
+    // bit i set means texel i belongs to subset 1, shared by BC6H (first 32 entries) and BC7.
+    constexpr uint16_t PARTITIONS_2[64] = {
+        0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+        0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+        0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+        0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+        0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+        0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+        0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+        0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+    };
+
+    // 2 bits per texel, texel 0 in the lowest bits.
+    constexpr uint32_t PARTITIONS_3[64] = {
+        0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+        0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+        0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+        0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+        0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+        0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+        0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+        0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254,
+    };
+
+    constexpr uint8_t ANCHORS_2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+    };
+
+    constexpr uint8_t ANCHORS_3A[64] = {
+         3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+         3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+         8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+         3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+    };
+
+    constexpr uint8_t ANCHORS_3B[64] = {
+        15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+        15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+        15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+        15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+    };
+
+    constexpr uint8_t WEIGHTS_2[4] = { 0, 21, 43, 64 };
+    constexpr uint8_t WEIGHTS_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    constexpr uint8_t WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    const uint8_t* GetWeights(uint32_t indexBits)
+    {
+        return indexBits == 2 ? WEIGHTS_2 : indexBits == 3 ? WEIGHTS_3 : WEIGHTS_4;
+    }
+
+    uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return r | g << 8 | b << 16 | a << 24;
+    }
+
+    // palette[i] = (e0 * (64 - w[i]) + e1 * w[i] + 32) >> 6 for all four channels.
+    void InterpolatePalette(const uint8_t* e0, const uint8_t* e1, const uint8_t* weights, uint32_t numWeights, uint32_t* pPalette)
+    {
+#ifdef BCN_USE_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        uint32_t packed0 = PackRGBA(e0[0], e0[1], e0[2], e0[3]);
+        uint32_t packed1 = PackRGBA(e1[0], e1[1], e1[2], e1[3]);
+        __m128i v0 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(packed0)), zero);
+        __m128i v1 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(packed1)), zero);
+        const __m128i sixtyFour = _mm_set1_epi16(64);
+        const __m128i round = _mm_set1_epi16(32);
+        // two palette entries per iteration, numWeights is always even.
+        for (uint32_t i = 0; i < numWeights; i += 2)
+        {
+            __m128i w = _mm_set_epi16(weights[i + 1], weights[i + 1], weights[i + 1], weights[i + 1],
+                                      weights[i], weights[i], weights[i], weights[i]);
+            __m128i value = _mm_add_epi16(_mm_mullo_epi16(v0, _mm_sub_epi16(sixtyFour, w)), _mm_mullo_epi16(v1, w));
+            value = _mm_srli_epi16(_mm_add_epi16(value, round), 6);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pPalette + i), _mm_packus_epi16(value, zero));
+        }
+#else
+        for (uint32_t i = 0; i < numWeights; ++i)
+        {
+            uint32_t w = weights[i];
+            uint32_t channels[4];
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                channels[c] = (e0[c] * (64 - w) + e1[c] * w + 32) >> 6;
+            }
+            pPalette[i] = PackRGBA(channels[0], channels[1], channels[2], channels[3]);
+        }
+#endif
+    }
+
+    uint32_t Expand565(uint16_t color)
+    {
+        uint32_t r = (color >> 11) & 31;
+        uint32_t g = (color >> 5) & 63;
+        uint32_t b = color & 31;
+        return PackRGBA(r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2, 255);
+    }
+
+    uint32_t Channel(uint32_t color, uint32_t c)
+    {
+        return (color >> (c * 8)) & 0xff;
+    }
+
+    // color part of BC1/BC2/BC3, BC2/BC3 always use the four color palette.
+    void DecodeColorBlock(const uint8_t* pBlock, uint32_t* pTexels, bool allowPunchThrough)
+    {
+        uint16_t c0 = static_cast<uint16_t>(pBlock[0] | pBlock[1] << 8);
+        uint16_t c1 = static_cast<uint16_t>(pBlock[2] | pBlock[3] << 8);
+        uint32_t palette[4] = { Expand565(c0), Expand565(c1), 0, 0 };
+        if (!allowPunchThrough || c0 > c1)
+        {
+            uint32_t channels2[3], channels3[3];
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                uint32_t v0 = Channel(palette[0], c), v1 = Channel(palette[1], c);
+                channels2[c] = (2 * v0 + v1 + 1) / 3;
+                channels3[c] = (v0 + 2 * v1 + 1) / 3;
+            }
+            palette[2] = PackRGBA(channels2[0], channels2[1], channels2[2], 255);
+            palette[3] = PackRGBA(channels3[0], channels3[1], channels3[2], 255);
+        }
+        else
+        {
+            uint32_t channels2[3];
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                channels2[c] = (Channel(palette[0], c) + Channel(palette[1], c) + 1) / 2;
+            }
+            palette[2] = PackRGBA(channels2[0], channels2[1], channels2[2], 255);
+            palette[3] = 0;
+        }
+        uint32_t indices;
+        memcpy(&indices, pBlock + 4, sizeof(uint32_t));
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            pTexels[i] = palette[(indices >> (i * 2)) & 3];
+        }
+    }
+
+    // BC4 style 3-bit interpolated channel, values are in [0, 1] or [-1, 1].
+    void DecodeChannelBlock(const uint8_t* pBlock, bool isSigned, float* pValues)
+    {
+        float palette[8];
+        bool isSixValueMode;
+        if (isSigned)
+        {
+            int32_t r0 = static_cast<int8_t>(pBlock[0]);
+            int32_t r1 = static_cast<int8_t>(pBlock[1]);
+            palette[0] = static_cast<float>(r0 < -127 ? -127 : r0) / 127.0f;
+            palette[1] = static_cast<float>(r1 < -127 ? -127 : r1) / 127.0f;
+            isSixValueMode = r0 <= r1;
+        }
+        else
+        {
+            palette[0] = static_cast<float>(pBlock[0]) / 255.0f;
+            palette[1] = static_cast<float>(pBlock[1]) / 255.0f;
+            isSixValueMode = pBlock[0] <= pBlock[1];
+        }
+        if (!isSixValueMode)
+        {
+            for (uint32_t i = 1; i < 7; ++i)
+            {
+                palette[i + 1] = (static_cast<float>(7 - i) * palette[0] + static_cast<float>(i) * palette[1]) / 7.0f;
+            }
+        }
+        else
+        {
+            for (uint32_t i = 1; i < 5; ++i)
+            {
+                palette[i + 1] = (static_cast<float>(5 - i) * palette[0] + static_cast<float>(i) * palette[1]) / 5.0f;
+            }
+            palette[6] = isSigned ? -1.0f : 0.0f;
+            palette[7] = 1.0f;
+        }
+        uint64_t indices = 0;
+        memcpy(&indices, pBlock + 2, 6);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            pValues[i] = palette[(indices >> (i * 3)) & 7];
+        }
+    }
+
+    uint8_t ChannelToUnorm8(float value, bool isSigned)
+    {
+        if (isSigned) value = value * 0.5f + 0.5f;
+        return static_cast<uint8_t>(value * 255.0f + 0.5f);
+    }
+
+    void DecodeBC1(const uint8_t* pBlock, uint32_t* pTexels)
+    {
+        DecodeColorBlock(pBlock, pTexels, true);
+    }
+
+    void DecodeBC2(const uint8_t* pBlock, uint32_t* pTexels)
+    {
+        DecodeColorBlock(pBlock + 8, pTexels, false);
+        uint64_t alpha;
+        memcpy(&alpha, pBlock, sizeof(uint64_t));
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t a = (alpha >> (i * 4)) & 15;
+            pTexels[i] = (pTexels[i] & 0x00ffffff) | (a * 17) << 24;
+        }
+    }
+
+    void DecodeBC3(const uint8_t* pBlock, uint32_t* pTexels)
+    {
+        DecodeColorBlock(pBlock + 8, pTexels, false);
+        float alpha[16];
+        DecodeChannelBlock(pBlock, false, alpha);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            pTexels[i] = (pTexels[i] & 0x00ffffff) | static_cast<uint32_t>(ChannelToUnorm8(alpha[i], false)) << 24;
+        }
+    }
+
+    template<bool IS_SIGNED>
+    void DecodeBC4(const uint8_t* pBlock, uint32_t* pTexels)
+    {
+        float red[16];
+        DecodeChannelBlock(pBlock, IS_SIGNED, red);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            pTexels[i] = PackRGBA(ChannelToUnorm8(red[i], IS_SIGNED), 0, 0, 255);
+        }
+    }
+
+    template<bool IS_SIGNED>
+    void DecodeBC5(const uint8_t* pBlock, uint32_t* pTexels)
+    {
+        float red[16], green[16];
+        DecodeChannelBlock(pBlock, IS_SIGNED, red);
+        DecodeChannelBlock(pBlock + 8, IS_SIGNED, green);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            pTexels[i] = PackRGBA(ChannelToUnorm8(red[i], IS_SIGNED), ChannelToUnorm8(green[i], IS_SIGNED), 0, 255);
+        }
+    }
+
+    struct Bc7ModeInfo
+    {
+        uint8_t mNumSubsets;
+        uint8_t mPartitionBits;
+        uint8_t mRotationBits;
+        uint8_t mIndexSelectionBits;
+        uint8_t mColorBits;
+        uint8_t mAlphaBits;
+        uint8_t mEndpointPBits;
+        uint8_t mSharedPBits;
+        uint8_t mIndexBits;
+        uint8_t mIndexBits2;
+    };
+
+    constexpr Bc7ModeInfo BC7_MODES[8] = {
+        { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+        { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+    };
+
+    uint32_t GetSubset(uint32_t numSubsets, uint32_t partition, uint32_t texel)
+    {
+        if (numSubsets == 2) return (PARTITIONS_2[partition] >> texel) & 1;
+        if (numSubsets == 3) return (PARTITIONS_3[partition] >> (texel * 2)) & 3;
+        return 0;
+    }
+
+    bool IsAnchor(uint32_t numSubsets, uint32_t partition, uint32_t texel)
+    {
+        if (texel == 0) return true;
+        if (numSubsets == 2) return texel == ANCHORS_2[partition];
+        if (numSubsets == 3) return texel == ANCHORS_3A[partition] || texel == ANCHORS_3B[partition];
+        return false;
+    }
+
+    void DecodeBC7(const uint8_t* pBlock, uint32_t* pTexels)
+    {
+        BlockBits bits{ pBlock };
+        uint32_t mode = 0;
+        while (mode < 8 && !bits.read(1)) mode++;
+        if (mode == 8)
+        {
+            memset(pTexels, 0, sizeof(uint32_t) * 16);
+            return;
+        }
+        const Bc7ModeInfo& info = BC7_MODES[mode];
+        uint32_t partition = bits.read(info.mPartitionBits);
+        uint32_t rotation = bits.read(info.mRotationBits);
+        uint32_t indexSelection = bits.read(info.mIndexSelectionBits);
+
+        uint32_t numEndpoints = info.mNumSubsets * 2u;
+        uint8_t endpoints[6][4];
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            for (uint32_t e = 0; e < numEndpoints; ++e)
+            {
+                endpoints[e][c] = static_cast<uint8_t>(bits.read(info.mColorBits));
+            }
+        }
+        for (uint32_t e = 0; e < numEndpoints; ++e)
+        {
+            endpoints[e][3] = static_cast<uint8_t>(info.mAlphaBits ? bits.read(info.mAlphaBits) : 255);
+        }
+
+        uint32_t pBits[6] = {};
+        bool hasPBits = info.mEndpointPBits || info.mSharedPBits;
+        if (info.mEndpointPBits)
+        {
+            for (uint32_t e = 0; e < numEndpoints; ++e) pBits[e] = bits.read(1);
+        }
+        else if (info.mSharedPBits)
+        {
+            for (uint32_t s = 0; s < info.mNumSubsets; ++s) pBits[s * 2] = pBits[s * 2 + 1] = bits.read(1);
+        }
+
+        for (uint32_t e = 0; e < numEndpoints; ++e)
+        {
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                uint32_t precision = c < 3 ? info.mColorBits : info.mAlphaBits;
+                if (precision == 0) continue;
+                uint32_t value = endpoints[e][c];
+                if (hasPBits)
+                {
+                    value = value << 1 | pBits[e];
+                    precision++;
+                }
+                value <<= 8 - precision;
+                endpoints[e][c] = static_cast<uint8_t>(value | value >> precision);
+            }
+        }
+
+        uint8_t indices[16];
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            indices[i] = static_cast<uint8_t>(bits.read(IsAnchor(info.mNumSubsets, partition, i) ? info.mIndexBits - 1 : info.mIndexBits));
+        }
+        alignas(16) uint32_t palettes[3][16];
+        InterpolatePalette(endpoints[0], endpoints[1], GetWeights(info.mIndexBits), 1u << info.mIndexBits, palettes[0]);
+        for (uint32_t s = 1; s < info.mNumSubsets; ++s)
+        {
+            InterpolatePalette(endpoints[s * 2], endpoints[s * 2 + 1], GetWeights(info.mIndexBits), 1u << info.mIndexBits, palettes[s]);
+        }
+
+        if (info.mIndexBits2)
+        {
+            // single subset modes with a separate index set, one set drives color and the other alpha.
+            uint8_t indices2[16];
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                indices2[i] = static_cast<uint8_t>(bits.read(i == 0 ? info.mIndexBits2 - 1 : info.mIndexBits2));
+            }
+            alignas(16) uint32_t palette2[8];
+            InterpolatePalette(endpoints[0], endpoints[1], GetWeights(info.mIndexBits2), 1u << info.mIndexBits2, palette2);
+            const uint32_t* colorPalette = indexSelection ? palette2 : palettes[0];
+            const uint32_t* alphaPalette = indexSelection ? palettes[0] : palette2;
+            const uint8_t* colorIndices = indexSelection ? indices2 : indices;
+            const uint8_t* alphaIndices = indexSelection ? indices : indices2;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                pTexels[i] = (colorPalette[colorIndices[i]] & 0x00ffffff) | (alphaPalette[alphaIndices[i]] & 0xff000000);
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                pTexels[i] = palettes[GetSubset(info.mNumSubsets, partition, i)][indices[i]];
+            }
+        }
+
+        if (rotation)
+        {
+            uint32_t shift = (rotation - 1) * 8;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                uint32_t texel = pTexels[i];
+                uint32_t alpha = texel >> 24;
+                uint32_t swapped = Channel(texel, rotation - 1);
+                texel = (texel & ~(0xffu << shift) & 0x00ffffff) | alpha << shift;
+                pTexels[i] = texel | swapped << 24;
+            }
+        }
+    }
+
+    // ------------------------------------BC6H------------------------------------ //
+
+    enum Bc6hField : uint8_t { RW, RX, RY, RZ, GW, GX, GY, GZ, BW, BX, BY, BZ, PD };
+
+    struct Bc6hBitRun
+    {
+        uint8_t mField;
+        uint8_t mShift;
+        uint8_t mNumBits;
+    };
+
+    struct Bc6hModeInfo
+    {
+        uint8_t mMode;
+        bool mIsTransformed;
+        uint8_t mEndpointBits;
+        uint8_t mDeltaBits[3];
+        uint8_t mNumRuns;
+        Bc6hBitRun mRuns[32];
+    };
+
+    // header layouts after the mode bits, in stream order.
+    const Bc6hModeInfo BC6H_MODES[14] = {
+        { 0x00, true, 10, { 5, 5, 5 }, 28, {
+            { GY, 4, 1 }, { BY, 4, 1 }, { BZ, 4, 1 }, { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 },
+            { RX, 0, 5 }, { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 }, { GZ, 0, 4 },
+            { BX, 0, 5 }, { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 },
+            { BZ, 3, 1 }, { PD, 0, 5 } } },
+        { 0x01, true, 7, { 6, 6, 6 }, 25, {
+            { GY, 5, 1 }, { GZ, 4, 1 }, { GZ, 5, 1 }, { RW, 0, 7 }, { BZ, 0, 1 }, { BZ, 1, 1 },
+            { BY, 4, 1 }, { GW, 0, 7 }, { BY, 5, 1 }, { BZ, 2, 1 }, { GY, 4, 1 }, { BW, 0, 7 },
+            { BZ, 3, 1 }, { BZ, 5, 1 }, { BZ, 4, 1 }, { RX, 0, 6 }, { GY, 0, 4 }, { GX, 0, 6 },
+            { GZ, 0, 4 }, { BX, 0, 6 }, { BY, 0, 4 }, { RY, 0, 6 }, { RZ, 0, 6 }, { PD, 0, 5 } } },
+        { 0x02, true, 11, { 5, 4, 4 }, 19, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 5 }, { RW, 10, 1 }, { GY, 0, 4 },
+            { GX, 0, 4 }, { GW, 10, 1 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 4 }, { BW, 10, 1 },
+            { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 },
+            { PD, 0, 5 } } },
+        { 0x06, true, 11, { 4, 5, 4 }, 21, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 4 }, { RW, 10, 1 }, { GZ, 4, 1 },
+            { GY, 0, 4 }, { GX, 0, 5 }, { GW, 10, 1 }, { GZ, 0, 4 }, { BX, 0, 4 }, { BW, 10, 1 },
+            { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 4 }, { BZ, 0, 1 }, { BZ, 2, 1 }, { RZ, 0, 4 },
+            { GY, 4, 1 }, { BZ, 3, 1 }, { PD, 0, 5 } } },
+        { 0x0a, true, 11, { 4, 4, 5 }, 21, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 4 }, { RW, 10, 1 }, { BY, 4, 1 },
+            { GY, 0, 4 }, { GX, 0, 4 }, { GW, 10, 1 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 5 },
+            { BW, 10, 1 }, { BY, 0, 4 }, { RY, 0, 4 }, { BZ, 1, 1 }, { BZ, 2, 1 }, { RZ, 0, 4 },
+            { BZ, 4, 1 }, { BZ, 3, 1 }, { PD, 0, 5 } } },
+        { 0x0e, true, 9, { 5, 5, 5 }, 20, {
+            { RW, 0, 9 }, { BY, 4, 1 }, { GW, 0, 9 }, { GY, 4, 1 }, { BW, 0, 9 }, { BZ, 4, 1 },
+            { RX, 0, 5 }, { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 }, { GZ, 0, 4 },
+            { BX, 0, 5 }, { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 },
+            { BZ, 3, 1 }, { PD, 0, 5 } } },
+        { 0x12, true, 8, { 6, 5, 5 }, 20, {
+            { RW, 0, 8 }, { GZ, 4, 1 }, { BY, 4, 1 }, { GW, 0, 8 }, { BZ, 2, 1 }, { GY, 4, 1 },
+            { BW, 0, 8 }, { BZ, 3, 1 }, { BZ, 4, 1 }, { RX, 0, 6 }, { GY, 0, 4 }, { GX, 0, 5 },
+            { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 5 }, { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 6 },
+            { RZ, 0, 6 }, { PD, 0, 5 } } },
+        { 0x16, true, 8, { 5, 6, 5 }, 22, {
+            { RW, 0, 8 }, { BZ, 0, 1 }, { BY, 4, 1 }, { GW, 0, 8 }, { GY, 5, 1 }, { GY, 4, 1 },
+            { BW, 0, 8 }, { GZ, 5, 1 }, { BZ, 4, 1 }, { RX, 0, 5 }, { GZ, 4, 1 }, { GY, 0, 4 },
+            { GX, 0, 6 }, { GZ, 0, 4 }, { BX, 0, 5 }, { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 5 },
+            { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 }, { PD, 0, 5 } } },
+        { 0x1a, true, 8, { 5, 5, 6 }, 22, {
+            { RW, 0, 8 }, { BZ, 1, 1 }, { BY, 4, 1 }, { GW, 0, 8 }, { BY, 5, 1 }, { GY, 4, 1 },
+            { BW, 0, 8 }, { BZ, 5, 1 }, { BZ, 4, 1 }, { RX, 0, 5 }, { GZ, 4, 1 }, { GY, 0, 4 },
+            { GX, 0, 5 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 6 }, { BY, 0, 4 }, { RY, 0, 5 },
+            { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 }, { PD, 0, 5 } } },
+        { 0x1e, false, 6, { 6, 6, 6 }, 24, {
+            { RW, 0, 6 }, { GZ, 4, 1 }, { BZ, 0, 1 }, { BZ, 1, 1 }, { BY, 4, 1 }, { GW, 0, 6 },
+            { GY, 5, 1 }, { BY, 5, 1 }, { BZ, 2, 1 }, { GY, 4, 1 }, { BW, 0, 6 }, { GZ, 5, 1 },
+            { BZ, 3, 1 }, { BZ, 5, 1 }, { BZ, 4, 1 }, { RX, 0, 6 }, { GY, 0, 4 }, { GX, 0, 6 },
+            { GZ, 0, 4 }, { BX, 0, 6 }, { BY, 0, 4 }, { RY, 0, 6 }, { RZ, 0, 6 }, { PD, 0, 5 } } },
+        { 0x03, false, 10, { 10, 10, 10 }, 6, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 10 }, { GX, 0, 10 }, { BX, 0, 10 } } },
+        { 0x07, true, 11, { 9, 9, 9 }, 9, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 9 }, { RW, 10, 1 }, { GX, 0, 9 },
+            { GW, 10, 1 }, { BX, 0, 9 }, { BW, 10, 1 } } },
+        { 0x0b, true, 12, { 8, 8, 8 }, 12, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 8 }, { RW, 11, 1 }, { RW, 10, 1 },
+            { GX, 0, 8 }, { GW, 11, 1 }, { GW, 10, 1 }, { BX, 0, 8 }, { BW, 11, 1 }, { BW, 10, 1 } } },
+        { 0x0f, true, 16, { 4, 4, 4 }, 24, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 4 },
+            { RW, 15, 1 }, { RW, 14, 1 }, { RW, 13, 1 }, { RW, 12, 1 }, { RW, 11, 1 }, { RW, 10, 1 },
+            { GX, 0, 4 },
+            { GW, 15, 1 }, { GW, 14, 1 }, { GW, 13, 1 }, { GW, 12, 1 }, { GW, 11, 1 }, { GW, 10, 1 },
+            { BX, 0, 4 },
+            { BW, 15, 1 }, { BW, 14, 1 }, { BW, 13, 1 }, { BW, 12, 1 }, { BW, 11, 1 }, { BW, 10, 1 } } },
+    };
+
+    int32_t SignExtend(int32_t value, uint32_t numBits)
+    {
+        int32_t shift = 32 - static_cast<int32_t>(numBits);
+        return static_cast<int32_t>(static_cast<uint32_t>(value) << shift) >> shift;
+    }
+
+    int32_t Bc6hUnquantize(int32_t value, uint32_t numBits, bool isSigned)
+    {
+        if (!isSigned)
+        {
+            if (numBits >= 15) return value;
+            if (value == 0) return 0;
+            if (value == (1 << numBits) - 1) return 0xffff;
+            return ((value << 16) + 0x8000) >> numBits;
+        }
+        if (numBits >= 16) return value;
+        bool isNegative = value < 0;
+        if (isNegative) value = -value;
+        int32_t result;
+        if (value == 0) result = 0;
+        else if (value >= (1 << (numBits - 1)) - 1) result = 0x7fff;
+        else result = ((value << 15) + 0x4000) >> (numBits - 1);
+        return isNegative ? -result : result;
+    }
+
+    uint16_t Bc6hFinishUnquantize(int32_t value, bool isSigned)
+    {
+        if (!isSigned) return static_cast<uint16_t>((value * 31) >> 6);
+        if (value < 0) return static_cast<uint16_t>(0x8000 | (((-value) * 31) >> 5));
+        return static_cast<uint16_t>((value * 31) >> 5);
+    }
+
+    float HalfToFloat(uint16_t half)
+    {
+        uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+        uint32_t exponent = (half >> 10) & 0x1f;
+        uint32_t mantissa = half & 0x3ff;
+        uint32_t bits;
+        if (exponent == 0)
+        {
+            if (mantissa == 0)
+            {
+                bits = sign;
+            }
+            else
+            {
+                // subnormal half, renormalize into a float.
+                exponent = 127 - 15 + 1;
+                while (!(mantissa & 0x400))
+                {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                bits = sign | exponent << 23 | (mantissa & 0x3ff) << 13;
+            }
+        }
+        else if (exponent == 31)
+        {
+            bits = sign | 0x7f800000 | mantissa << 13;
+        }
+        else
+        {
+            bits = sign | (exponent + 127 - 15) << 23 | mantissa << 13;
+        }
+        float value;
+        memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+
+    template<bool IS_SIGNED>
+    void DecodeBC6H(const uint8_t* pBlock, float* pTexels)
+    {
+        BlockBits bits{ pBlock };
+        uint32_t mode = bits.read(2);
+        if (mode >= 2) mode |= bits.read(3) << 2;
+        const Bc6hModeInfo* pInfo = nullptr;
+        for (const auto& info : BC6H_MODES)
+        {
+            if (info.mMode == mode)
+            {
+                pInfo = &info;
+                break;
+            }
+        }
+        if (!pInfo)
+        {
+            // reserved modes decode to black.
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                pTexels[i * 4 + 0] = pTexels[i * 4 + 1] = pTexels[i * 4 + 2] = 0.0f;
+                pTexels[i * 4 + 3] = 1.0f;
+            }
+            return;
+        }
+
+        int32_t fields[13] = {};
+        for (uint32_t i = 0; i < pInfo->mNumRuns; ++i)
+        {
+            const Bc6hBitRun& run = pInfo->mRuns[i];
+            fields[run.mField] |= static_cast<int32_t>(bits.read(run.mNumBits) << run.mShift);
+        }
+        bool isTwoRegions = mode < 0x03 || (mode & 0x03) == 0x02;
+        uint32_t numEndpoints = isTwoRegions ? 4 : 2;
+        uint32_t partition = static_cast<uint32_t>(fields[PD]);
+
+        // endpoints[e][c], e: w x y z
+        int32_t endpoints[4][3];
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            uint32_t base = c * 4;
+            for (uint32_t e = 0; e < numEndpoints; ++e)
+            {
+                endpoints[e][c] = fields[base + e];
+            }
+            if (IS_SIGNED) endpoints[0][c] = SignExtend(endpoints[0][c], pInfo->mEndpointBits);
+            if (IS_SIGNED || pInfo->mIsTransformed)
+            {
+                for (uint32_t e = 1; e < numEndpoints; ++e)
+                {
+                    endpoints[e][c] = SignExtend(endpoints[e][c], pInfo->mDeltaBits[c]);
+                }
+            }
+            if (pInfo->mIsTransformed)
+            {
+                int32_t mask = (1 << pInfo->mEndpointBits) - 1;
+                for (uint32_t e = 1; e < numEndpoints; ++e)
+                {
+                    endpoints[e][c] = (endpoints[0][c] + endpoints[e][c]) & mask;
+                    if (IS_SIGNED) endpoints[e][c] = SignExtend(endpoints[e][c], pInfo->mEndpointBits);
+                }
+            }
+            for (uint32_t e = 0; e < numEndpoints; ++e)
+            {
+                endpoints[e][c] = Bc6hUnquantize(endpoints[e][c], pInfo->mEndpointBits, IS_SIGNED);
+            }
+        }
+
+        uint32_t indexBits = isTwoRegions ? 3 : 4;
+        const uint8_t* weights = GetWeights(indexBits);
+        bits.mPos = isTwoRegions ? 82 : 65;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            bool isAnchor = i == 0 || (isTwoRegions && i == ANCHORS_2[partition]);
+            uint32_t index = bits.read(isAnchor ? indexBits - 1 : indexBits);
+            uint32_t region = isTwoRegions ? (PARTITIONS_2[partition] >> i) & 1 : 0;
+            int32_t w = weights[index];
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                int32_t value = (endpoints[region * 2][c] * (64 - w) + endpoints[region * 2 + 1][c] * w + 32) >> 6;
+                pTexels[i * 4 + c] = HalfToFloat(Bc6hFinishUnquantize(value, IS_SIGNED));
+            }
+            pTexels[i * 4 + 3] = 1.0f;
+        }
+    }
+
+    // ------------------------------------Dispatch------------------------------------ //
+
+    using BlockDecoderRGBA8 = void (*)(const uint8_t* pBlock, uint32_t* pTexels);
+    using BlockDecoderRGBA32F = void (*)(const uint8_t* pBlock, float* pTexels);
+
+    BlockDecoderRGBA8 GetDecoderRGBA8(TextureFormat format)
+    {
+        switch (format)
+        {
+        case TextureFormat::BC1_UNORM:
+        case TextureFormat::BC1_UNORM_SRGB:
+            return DecodeBC1;
+        case TextureFormat::BC2_UNORM:
+        case TextureFormat::BC2_UNORM_SRGB:
+            return DecodeBC2;
+        case TextureFormat::BC3_UNORM:
+        case TextureFormat::BC3_UNORM_SRGB:
+            return DecodeBC3;
+        case TextureFormat::BC4_UNORM:
+            return DecodeBC4<false>;
+        case TextureFormat::BC4_SNORM:
+            return DecodeBC4<true>;
+        case TextureFormat::BC5_UNORM:
+            return DecodeBC5<false>;
+        case TextureFormat::BC5_SNORM:
+            return DecodeBC5<true>;
+        case TextureFormat::BC7_UNORM:
+        case TextureFormat::BC7_UNORM_SRGB:
+            return DecodeBC7;
+        default:
+            return nullptr;
+        }
+    }
+
+    const float* SrgbToLinearTable()
+    {
+        static const std::array<float, 256> table = []
+        {
+            std::array<float, 256> values{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                float c = static_cast<float>(i) / 255.0f;
+                values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return values;
+        }();
+        return table.data();
+    }
+
+    template<bool IS_SIGNED>
+    void DecodeBC4Float(const uint8_t* pBlock, float* pTexels)
+    {
+        float red[16];
+        DecodeChannelBlock(pBlock, IS_SIGNED, red);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            pTexels[i * 4 + 0] = red[i];
+            pTexels[i * 4 + 1] = pTexels[i * 4 + 2] = 0.0f;
+            pTexels[i * 4 + 3] = 1.0f;
+        }
+    }
+
+    template<bool IS_SIGNED>
+    void DecodeBC5Float(const uint8_t* pBlock, float* pTexels)
+    {
+        float red[16], green[16];
+        DecodeChannelBlock(pBlock, IS_SIGNED, red);
+        DecodeChannelBlock(pBlock + 8, IS_SIGNED, green);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            pTexels[i * 4 + 0] = red[i];
+            pTexels[i * 4 + 1] = green[i];
+            pTexels[i * 4 + 2] = 0.0f;
+            pTexels[i * 4 + 3] = 1.0f;
+        }
+    }
+
+    BlockDecoderRGBA32F GetDirectDecoderRGBA32F(TextureFormat format)
+    {
+        switch (format)
+        {
+        case TextureFormat::BC4_UNORM:
+            return DecodeBC4Float<false>;
+        case TextureFormat::BC4_SNORM:
+            return DecodeBC4Float<true>;
+        case TextureFormat::BC5_UNORM:
+            return DecodeBC5Float<false>;
+        case TextureFormat::BC5_SNORM:
+            return DecodeBC5Float<true>;
+        case TextureFormat::BC6H_UF16:
+            return DecodeBC6H<false>;
+        case TextureFormat::BC6H_SF16:
+            return DecodeBC6H<true>;
+        default:
+            return nullptr;
+        }
+    }
+
+    void ExpandRGBA8ToFloat(const uint32_t* pTexels, float* pOut, bool isSrgb)
+    {
+        const float* srgbTable = SrgbToLinearTable();
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t texel = pTexels[i];
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                uint32_t value = Channel(texel, c);
+                pOut[i * 4 + c] = isSrgb ? srgbTable[value] : static_cast<float>(value) / 255.0f;
+            }
+            pOut[i * 4 + 3] = static_cast<float>(texel >> 24) / 255.0f;
+        }
+    }
+
+    // roughly 1k blocks per grain keeps the scheduling overhead negligible.
+    uint64_t BlockRowsPerGrain(uint32_t numBlocksX)
+    {
+        return (std::max)(static_cast<uint64_t>(1), static_cast<uint64_t>(1024 / (std::max)(numBlocksX, 1u)));
+    }
+
+    template<typename TexelType, typename DecodeFunc>
+    void DecodeSurface(const uint8_t* pSrc, uint32_t width, uint32_t height, uint32_t bytesPerBlock,
+                       uint8_t* pDst, uint64_t dstRowPitch, uint64_t srcRowPitch, DecodeFunc&& decode)
+    {
+        uint32_t numBlocksX = (width + 3) / 4;
+        uint32_t numBlocksY = (height + 3) / 4;
+        if (!srcRowPitch) srcRowPitch = static_cast<uint64_t>(numBlocksX) * bytesPerBlock;
+        constexpr uint32_t texelSize = 4 * sizeof(TexelType);
+        ParallelFor(0, numBlocksY, BlockRowsPerGrain(numBlocksX), [&](uint64_t begin, uint64_t end)
+        {
+            alignas(16) TexelType texels[16 * 4];
+            for (uint64_t by = begin; by < end; ++by)
+            {
+                const uint8_t* pBlock = pSrc + by * srcRowPitch;
+                uint32_t numRows = (std::min)(4u, height - static_cast<uint32_t>(by) * 4);
+                for (uint32_t bx = 0; bx < numBlocksX; ++bx, pBlock += bytesPerBlock)
+                {
+                    decode(pBlock, texels);
+                    uint32_t numColumns = (std::min)(4u, width - bx * 4);
+                    uint8_t* pDstBlock = pDst + by * 4 * dstRowPitch + static_cast<uint64_t>(bx) * 4 * texelSize;
+                    for (uint32_t row = 0; row < numRows; ++row)
+                    {
+                        memcpy(pDstBlock + row * dstRowPitch, texels + row * 16, numColumns * texelSize);
+                    }
+                }
+            }
+        });
+    }
+}
+
+bool BCn::DecodeBlockRGBA8(TextureFormat format, const uint8_t* pBlock, uint8_t* pTexels)
+{
+    BlockDecoderRGBA8 decoder = GetDecoderRGBA8(format);
+    if (decoder)
+    {
+        uint32_t texels[16];
+        decoder(pBlock, texels);
+        memcpy(pTexels, texels, sizeof(texels));
+        return true;
+    }
+    BlockDecoderRGBA32F floatDecoder = GetDirectDecoderRGBA32F(format);
+    if (!floatDecoder) return false;
+    float texels[16 * 4];
+    floatDecoder(pBlock, texels);
+    for (uint32_t i = 0; i < 16 * 4; ++i)
+    {
+        float value = texels[i] < 0.0f ? 0.0f : texels[i] > 1.0f ? 1.0f : texels[i];
+        pTexels[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+    }
+    return true;
+}
+
+bool BCn::DecodeBlockRGBA32F(TextureFormat format, const uint8_t* pBlock, float* pTexels)
+{
+    BlockDecoderRGBA32F floatDecoder = GetDirectDecoderRGBA32F(format);
+    if (floatDecoder)
+    {
+        floatDecoder(pBlock, pTexels);
+        return true;
+    }
+    BlockDecoderRGBA8 decoder = GetDecoderRGBA8(format);
+    if (!decoder) return false;
+    uint32_t texels[16];
+    decoder(pBlock, texels);
+    ExpandRGBA8ToFloat(texels, pTexels, GetFormatTraits(format).mIsSrgb);
+    return true;
+}
+
+bool BCn::DecodeRGBA8(TextureFormat format, const uint8_t* pSrc, uint32_t width, uint32_t height,
+                      uint8_t* pDst, uint64_t dstRowPitch, uint64_t srcRowPitch)
+{
+    if (!IsBlockCompressed(format)) return false;
+    uint32_t bytesPerBlock = GetFormatTraits(format).mBytesPerBlock;
+    BlockDecoderRGBA8 decoder = GetDecoderRGBA8(format);
+    if (decoder)
+    {
+        DecodeSurface<uint8_t>(pSrc, width, height, bytesPerBlock, pDst, dstRowPitch, srcRowPitch,
+            [decoder](const uint8_t* pBlock, uint8_t* pTexels)
+            {
+                decoder(pBlock, reinterpret_cast<uint32_t*>(pTexels));
+            });
+        return true;
+    }
+    DecodeSurface<uint8_t>(pSrc, width, height, bytesPerBlock, pDst, dstRowPitch, srcRowPitch,
+        [format](const uint8_t* pBlock, uint8_t* pTexels)
+        {
+            DecodeBlockRGBA8(format, pBlock, pTexels);
+        });
+    return true;
+}
+
+bool BCn::DecodeRGBA32F(TextureFormat format, const uint8_t* pSrc, uint32_t width, uint32_t height,
+                        float* pDst, uint64_t dstRowPitch, uint64_t srcRowPitch)
+{
+    if (!IsBlockCompressed(format)) return false;
+    uint32_t bytesPerBlock = GetFormatTraits(format).mBytesPerBlock;
+    DecodeSurface<float>(pSrc, width, height, bytesPerBlock, reinterpret_cast<uint8_t*>(pDst), dstRowPitch, srcRowPitch,
+        [format](const uint8_t* pBlock, float* pTexels)
+        {
+            DecodeBlockRGBA32F(format, pBlock, pTexels);
+        });
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "Engine/pch.h"
+#include "Engine/render/Texture.h"
+
+// cpu decoder for block compressed formats, used where no gpu is around (golden image tests,
+// thumbnails, cpu sampling). blocks are decoded in parallel over block rows.
+// sRGB formats keep their encoded bytes in the RGBA8 output, the float output is always linear.
+// snorm formats are remapped to [0, 255] in the RGBA8 output.
+namespace BCn
+{
+    // decode a single 4x4 block into 16 RGBA8 texels (row major, 64 bytes).
+    bool DecodeBlockRGBA8(TextureFormat format, const uint8_t* pBlock, uint8_t* pTexels);
+    // decode a single 4x4 block into 16 RGBA float texels (row major, 64 floats).
+    bool DecodeBlockRGBA32F(TextureFormat format, const uint8_t* pBlock, float* pTexels);
+
+    // decode a whole surface, pSrc holds ceil(width / 4) * ceil(height / 4) tightly packed blocks
+    // unless srcRowPitch (bytes per block row) says otherwise.
+    bool DecodeRGBA8(TextureFormat format, const uint8_t* pSrc, uint32_t width, uint32_t height,
+                     uint8_t* pDst, uint64_t dstRowPitch, uint64_t srcRowPitch = 0);
+    bool DecodeRGBA32F(TextureFormat format, const uint8_t* pSrc, uint32_t width, uint32_t height,
+                       float* pDst, uint64_t dstRowPitch, uint64_t srcRowPitch = 0);
+}
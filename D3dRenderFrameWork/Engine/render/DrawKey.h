@@ -0,0 +1,58 @@
+#pragma once
+#include "Engine/pch.h"
+
+enum class RenderLayer : uint8_t
+{
+    SOLID,
+    TRANSLUCENT,
+};
+
+// 64 bit submission order of a draw, the draws of a view are recorded in ascending key order.
+// solid:       layer 4 | pipeline 12 | material 16 | mesh 16 | depth 16
+//              draws sharing a state end up next to each other and go front to back within it
+// translucent: layer 4 | inverted depth 16 | pipeline 12 | material 16 | mesh 16
+//              back to front first so blending composes correctly, state only breaks ties
+// the state part (layer, pipeline, material, mesh) doesn't change with the camera and is built once per proxy.
+namespace DrawKey
+{
+    constexpr uint32_t PIPELINE_BITS = 12;
+    constexpr uint32_t MATERIAL_BITS = 16;
+    constexpr uint32_t MESH_BITS = 16;
+    constexpr uint32_t STATE_BITS = PIPELINE_BITS + MATERIAL_BITS + MESH_BITS;
+
+    // ids wrap around when they don't fit their bits, which only costs batching
+    uint64_t MakeState(RenderLayer layer, uint32_t pipeline, uint32_t material, uint32_t mesh);
+    uint64_t Make(uint64_t state, float viewDepth);
+    // positive floats order like their bit patterns, keeping the exponent and the top mantissa bits gives a
+    // logarithmic depth that needs no near and far plane. depths behind the camera map to 0
+    uint16_t QuantizeDepth(float viewDepth);
+}
+
+inline uint64_t DrawKey::MakeState(RenderLayer layer, uint32_t pipeline, uint32_t material, uint32_t mesh)
+{
+    return static_cast<uint64_t>(layer) << STATE_BITS |
+           static_cast<uint64_t>(pipeline & ((1u << PIPELINE_BITS) - 1)) << (MATERIAL_BITS + MESH_BITS) |
+           static_cast<uint64_t>(material & ((1u << MATERIAL_BITS) - 1)) << MESH_BITS |
+           (mesh & ((1u << MESH_BITS) - 1));
+}
+
+inline uint64_t DrawKey::Make(uint64_t state, float viewDepth)
+{
+    uint64_t layer = state >> STATE_BITS;
+    uint64_t drawState = state & ((uint64_t{ 1 } << STATE_BITS) - 1);
+    uint64_t depth = QuantizeDepth(viewDepth);
+    if (layer == static_cast<uint64_t>(RenderLayer::TRANSLUCENT))
+    {
+        return layer << 60 | (depth ^ 0xffff) << STATE_BITS | drawState;
+    }
+    return layer << 60 | drawState << 16 | depth;
+}
+
+inline uint16_t DrawKey::QuantizeDepth(float viewDepth)
+{
+    uint32_t bits;
+    float depth = (std::max)(viewDepth, 0.0f);
+    memcpy(&bits, &depth, sizeof(bits));
+    // the sign bit is clear, shifting out 15 bits leaves 16
+    return static_cast<uint16_t>(bits >> 15);
+}
@@ -0,0 +1,547 @@
+#include "Engine/render/FormatConversion.h"
+#include "Engine/common/Parallel.h"
+#include "Engine/common/Simd.h"
+#include <cfloat>
+#include <cmath>
+
+#undef max
+#undef min
+
+namespace
+{
+    // texels per parallel grain, smaller images are converted on the calling thread
+    constexpr uint64_t TEXELS_PER_GRAIN = 64 * 1024;
+
+    enum class ComponentType : uint8_t
+    {
+        UNORM,
+        SNORM,
+        UINT,
+        SINT,
+        FLOAT,
+        SRGB,       // 8 bit rgb with linear alpha
+        NONE,
+    };
+
+    struct ComponentLayout
+    {
+        ComponentType mType;
+        uint8_t mBytes;
+        uint8_t mNumComponents;
+    };
+
+    constexpr ComponentLayout GetLayout(TextureFormat format)
+    {
+        switch (format)
+        {
+        case TextureFormat::R8_UNORM: return { ComponentType::UNORM, 1, 1 };
+        case TextureFormat::R8G8_UNORM: return { ComponentType::UNORM, 1, 2 };
+        case TextureFormat::R8G8B8A8_UNORM: return { ComponentType::UNORM, 1, 4 };
+        case TextureFormat::R8G8B8A8_UNORM_SRGB: return { ComponentType::SRGB, 1, 4 };
+        case TextureFormat::R8_SNORM: return { ComponentType::SNORM, 1, 1 };
+        case TextureFormat::R8G8_SNORM: return { ComponentType::SNORM, 1, 2 };
+        case TextureFormat::R8G8B8A8_SNORM: return { ComponentType::SNORM, 1, 4 };
+        case TextureFormat::R8_UINT: return { ComponentType::UINT, 1, 1 };
+        case TextureFormat::R8G8_UINT: return { ComponentType::UINT, 1, 2 };
+        case TextureFormat::R8G8B8A8_UINT: return { ComponentType::UINT, 1, 4 };
+        case TextureFormat::R8_SINT: return { ComponentType::SINT, 1, 1 };
+        case TextureFormat::R8G8_SINT: return { ComponentType::SINT, 1, 2 };
+        case TextureFormat::R8G8B8A8_SINT: return { ComponentType::SINT, 1, 4 };
+        case TextureFormat::R16_UNORM: return { ComponentType::UNORM, 2, 1 };
+        case TextureFormat::R16G16_UNORM: return { ComponentType::UNORM, 2, 2 };
+        case TextureFormat::R16G16B16A16_UNORM: return { ComponentType::UNORM, 2, 4 };
+        case TextureFormat::R16_SNORM: return { ComponentType::SNORM, 2, 1 };
+        case TextureFormat::R16G16_SNORM: return { ComponentType::SNORM, 2, 2 };
+        case TextureFormat::R16G16B16A16_SNORM: return { ComponentType::SNORM, 2, 4 };
+        case TextureFormat::R16_UINT: return { ComponentType::UINT, 2, 1 };
+        case TextureFormat::R16G16_UINT: return { ComponentType::UINT, 2, 2 };
+        case TextureFormat::R16G16B16A16_UINT: return { ComponentType::UINT, 2, 4 };
+        case TextureFormat::R16_SINT: return { ComponentType::SINT, 2, 1 };
+        case TextureFormat::R16G16_SINT: return { ComponentType::SINT, 2, 2 };
+        case TextureFormat::R16G16B16A16_SINT: return { ComponentType::SINT, 2, 4 };
+        case TextureFormat::R16_FLOAT: return { ComponentType::FLOAT, 2, 1 };
+        case TextureFormat::R16G16_FLOAT: return { ComponentType::FLOAT, 2, 2 };
+        case TextureFormat::R16G16B16A16_FLOAT: return { ComponentType::FLOAT, 2, 4 };
+        case TextureFormat::R32_FLOAT: return { ComponentType::FLOAT, 4, 1 };
+        case TextureFormat::R32G32_FLOAT: return { ComponentType::FLOAT, 4, 2 };
+        case TextureFormat::R32G32B32A32_FLOAT: return { ComponentType::FLOAT, 4, 4 };
+        default: return { ComponentType::NONE, 0, 0 };
+        }
+    }
+
+    // range of the stored integers, scale maps them to the float value. snorm skips the lowest integer, it decodes to -1 as well
+    struct IntegerRange
+    {
+        float mScale;
+        float mLowest;
+        float mHighest;
+    };
+
+    IntegerRange GetIntegerRange(ComponentLayout layout)
+    {
+        bool isWide = layout.mBytes == 2;
+        switch (layout.mType)
+        {
+        case ComponentType::UNORM: return { 1.0f / (isWide ? 65535.0f : 255.0f), 0.0f, isWide ? 65535.0f : 255.0f };
+        case ComponentType::SNORM: return { 1.0f / (isWide ? 32767.0f : 127.0f), isWide ? -32767.0f : -127.0f, isWide ? 32767.0f : 127.0f };
+        case ComponentType::UINT: return { 1.0f, 0.0f, isWide ? 65535.0f : 255.0f };
+        default: return { 1.0f, isWide ? -32768.0f : -128.0f, isWide ? 32767.0f : 127.0f };
+        }
+    }
+
+    // -------------------------------------------half------------------------------------------- //
+
+    float HalfToFloatScalar(uint16_t half)
+    {
+        uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+        uint32_t exponent = half >> 10 & 0x1Fu;
+        uint32_t mantissa = half & 0x3FFu;
+        uint32_t bits;
+        if (exponent == 0x1F)
+        {
+            bits = sign | 0x7F800000u | mantissa << 13;
+        }
+        else if (exponent != 0)
+        {
+            bits = sign | (exponent + 112) << 23 | mantissa << 13;
+        }
+        else
+        {
+            // zero or denormal, mantissa * 2^-24 is exact in float
+            float value = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+            memcpy(&bits, &value, sizeof(bits));
+            bits |= sign;
+        }
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint16_t FloatToHalfScalar(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint16_t sign = static_cast<uint16_t>(bits >> 16 & 0x8000u);
+        uint32_t magnitude = bits & 0x7FFFFFFFu;
+        if (magnitude >= 0x7F800000u) return sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u);
+        // 65520 and up round to infinity
+        if (magnitude >= 0x477FF000u) return sign | 0x7C00u;
+        if (magnitude < 0x38800000u)
+        {
+            // below the smallest normal half, the denormal mantissa is value * 2^24 rounded
+            float absValue;
+            memcpy(&absValue, &magnitude, sizeof(absValue));
+            return sign | static_cast<uint16_t>(std::nearbyint(absValue * 16777216.0f));
+        }
+        // round to nearest even on the 13 dropped mantissa bits, a carry moves into the exponent on its own
+        uint32_t rounded = magnitude + 0xFFFu + (magnitude >> 13 & 1u);
+        return sign | static_cast<uint16_t>((rounded - (112u << 23)) >> 13);
+    }
+
+    // -------------------------------------------srgb------------------------------------------- //
+
+    constexpr uint32_t SRGB_ENCODE_STEPS = 65536;
+
+    // the encode table is indexed by the linear value quantized to 16 bits. its entries are the codes of the
+    // quantized values, an input close to a rounding boundary can quantize across it and get a code one off.
+    // the smallest linear value of every code fixes those up, so every input gets the code of
+    // nearbyint(LinearToSrgb(linear) * 255), and 8 bit codes survive a round trip through linear.
+    struct SrgbTables
+    {
+        float mToLinear[256];
+        float mFirstLinear[256];
+        uint8_t mToSrgb[SRGB_ENCODE_STEPS];
+    };
+
+    uint32_t SrgbCode(float linear)
+    {
+        return static_cast<uint32_t>(std::nearbyint(FormatConversion::LinearToSrgb(linear) * 255.0f));
+    }
+
+    const SrgbTables& GetSrgbTables()
+    {
+        static const std::unique_ptr<SrgbTables> pTables = []
+        {
+            auto pNewTables = std::make_unique<SrgbTables>();
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                pNewTables->mToLinear[i] = FormatConversion::SrgbToLinear(static_cast<float>(i) / 255.0f);
+            }
+            for (uint32_t i = 0; i < SRGB_ENCODE_STEPS; ++i)
+            {
+                float srgb = FormatConversion::LinearToSrgb(static_cast<float>(i) / (SRGB_ENCODE_STEPS - 1));
+                pNewTables->mToSrgb[i] = static_cast<uint8_t>(std::nearbyint(srgb * 255.0f));
+            }
+            // non negative floats order like their bits, the boundaries are searched on the bits of [0, 1]
+            pNewTables->mFirstLinear[0] = 0.0f;
+            uint32_t oneBits;
+            float one = 1.0f;
+            memcpy(&oneBits, &one, sizeof(oneBits));
+            for (uint32_t code = 1; code < 256; ++code)
+            {
+                uint32_t low = 0;
+                uint32_t high = oneBits;
+                while (low < high)
+                {
+                    uint32_t middle = low + (high - low) / 2;
+                    float linear;
+                    memcpy(&linear, &middle, sizeof(linear));
+                    if (SrgbCode(linear) >= code) high = middle;
+                    else low = middle + 1;
+                }
+                memcpy(&pNewTables->mFirstLinear[code], &low, sizeof(float));
+            }
+            return pNewTables;
+        }();
+        return *pTables;
+    }
+
+    uint8_t EncodeSrgb(const SrgbTables& tables, float linear)
+    {
+        linear = linear > 0.0f ? (std::min)(linear, 1.0f) : 0.0f;
+        uint32_t code = tables.mToSrgb[static_cast<uint32_t>(linear * (SRGB_ENCODE_STEPS - 1) + 0.5f)];
+        // the quantized value is at most one code away
+        if (code < 255 && linear >= tables.mFirstLinear[code + 1]) return static_cast<uint8_t>(code + 1);
+        if (linear < tables.mFirstLinear[code]) return static_cast<uint8_t>(code - 1);
+        return static_cast<uint8_t>(code);
+    }
+
+    uint8_t EncodeUnorm8(float value)
+    {
+        value = value > 0.0f ? (std::min)(value, 1.0f) : 0.0f;
+        return static_cast<uint8_t>(std::nearbyint(value * 255.0f));
+    }
+
+    // ------------------------------------------scalar------------------------------------------ //
+
+    template<typename T>
+    void DecodeIntegers(const byte* pSrc, float* pDst, uint64_t count, IntegerRange range)
+    {
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            T value;
+            memcpy(&value, pSrc + i * sizeof(T), sizeof(T));
+            pDst[i] = (std::max)(static_cast<float>(value) * range.mScale, range.mLowest * range.mScale);
+        }
+    }
+
+    template<typename T>
+    void EncodeIntegers(const float* pSrc, byte* pDst, uint64_t count, IntegerRange range)
+    {
+        float inverseScale = 1.0f / range.mScale;
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            float value = pSrc[i] == pSrc[i] ? pSrc[i] * inverseScale : 0.0f;
+            value = value > range.mLowest ? (std::min)(value, range.mHighest) : range.mLowest;
+            T integer = static_cast<T>(std::nearbyint(value));
+            memcpy(pDst + i * sizeof(T), &integer, sizeof(T));
+        }
+    }
+
+    // ------------------------------------------avx2-------------------------------------------- //
+    // each kernel handles whole groups of 8 components and returns how many it did, the scalar loop takes the rest.
+
+#ifdef SIMD_X64
+    template<typename T>
+    SIMD_TARGET_AVX2 __m256i LoadIntegers8(const byte* pSrc)
+    {
+        if constexpr (std::is_same_v<T, uint8_t>)
+            return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc)));
+        else if constexpr (std::is_same_v<T, int8_t>)
+            return _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc)));
+        else if constexpr (std::is_same_v<T, uint16_t>)
+            return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc)));
+        else
+            return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc)));
+    }
+
+    template<typename T>
+    SIMD_TARGET_AVX2 void StoreIntegers8(byte* pDst, __m256i values)
+    {
+        __m128i low = _mm256_castsi256_si128(values);
+        __m128i high = _mm256_extracti128_si256(values, 1);
+        if constexpr (std::is_same_v<T, uint8_t>)
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pDst), _mm_packus_epi16(_mm_packs_epi32(low, high), _mm_setzero_si128()));
+        else if constexpr (std::is_same_v<T, int8_t>)
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pDst), _mm_packs_epi16(_mm_packs_epi32(low, high), _mm_setzero_si128()));
+        else if constexpr (std::is_same_v<T, uint16_t>)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst), _mm_packus_epi32(low, high));
+        else
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst), _mm_packs_epi32(low, high));
+    }
+
+    template<typename T>
+    SIMD_TARGET_AVX2 uint64_t DecodeIntegersAvx2(const byte* pSrc, float* pDst, uint64_t count, IntegerRange range)
+    {
+        const __m256 scale = _mm256_set1_ps(range.mScale);
+        const __m256 lowest = _mm256_set1_ps(range.mLowest * range.mScale);
+        uint64_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 values = _mm256_mul_ps(_mm256_cvtepi32_ps(LoadIntegers8<T>(pSrc + i * sizeof(T))), scale);
+            _mm256_storeu_ps(pDst + i, _mm256_max_ps(values, lowest));
+        }
+        return i;
+    }
+
+    template<typename T>
+    SIMD_TARGET_AVX2 uint64_t EncodeIntegersAvx2(const float* pSrc, byte* pDst, uint64_t count, IntegerRange range)
+    {
+        const __m256 inverseScale = _mm256_set1_ps(1.0f / range.mScale);
+        const __m256 lowest = _mm256_set1_ps(range.mLowest);
+        const __m256 highest = _mm256_set1_ps(range.mHighest);
+        uint64_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 values = _mm256_loadu_ps(pSrc + i);
+            // nan -> 0 before clamping, max / min would otherwise pick their second operand
+            values = _mm256_and_ps(values, _mm256_cmp_ps(values, values, _CMP_ORD_Q));
+            values = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(values, inverseScale), lowest), highest);
+            StoreIntegers8<T>(pDst + i * sizeof(T), _mm256_cvtps_epi32(values));
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2 uint64_t HalfToFloatF16c(const uint16_t* pSrc, float* pDst, uint64_t count)
+    {
+        uint64_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_ps(pDst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i))));
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2 uint64_t FloatToHalfF16c(const float* pSrc, uint16_t* pDst, uint64_t count)
+    {
+        uint64_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(pSrc + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), halves);
+        }
+        return i;
+    }
+#endif
+
+    // ------------------------------------------dispatch----------------------------------------- //
+
+    template<typename T>
+    void DecodeIntegerComponents(const byte* pSrc, float* pDst, uint64_t count, IntegerRange range)
+    {
+        uint64_t done = 0;
+#ifdef SIMD_X64
+        if (GetCpuFeatures().mHasAvx2) done = DecodeIntegersAvx2<T>(pSrc, pDst, count, range);
+#endif
+        DecodeIntegers<T>(pSrc + done * sizeof(T), pDst + done, count - done, range);
+    }
+
+    template<typename T>
+    void EncodeIntegerComponents(const float* pSrc, byte* pDst, uint64_t count, IntegerRange range)
+    {
+        uint64_t done = 0;
+#ifdef SIMD_X64
+        if (GetCpuFeatures().mHasAvx2) done = EncodeIntegersAvx2<T>(pSrc, pDst, count, range);
+#endif
+        EncodeIntegers<T>(pSrc + done, pDst + done * sizeof(T), count - done, range);
+    }
+
+    // width texels into layout.mNumComponents floats each
+    void DecodeComponents(ComponentLayout layout, const byte* pSrc, float* pDst, uint32_t width)
+    {
+        uint64_t count = static_cast<uint64_t>(width) * layout.mNumComponents;
+        bool isWide = layout.mBytes == 2;
+        switch (layout.mType)
+        {
+        case ComponentType::UNORM:
+        case ComponentType::UINT:
+            if (isWide) DecodeIntegerComponents<uint16_t>(pSrc, pDst, count, GetIntegerRange(layout));
+            else DecodeIntegerComponents<uint8_t>(pSrc, pDst, count, GetIntegerRange(layout));
+            break;
+        case ComponentType::SNORM:
+        case ComponentType::SINT:
+            if (isWide) DecodeIntegerComponents<int16_t>(pSrc, pDst, count, GetIntegerRange(layout));
+            else DecodeIntegerComponents<int8_t>(pSrc, pDst, count, GetIntegerRange(layout));
+            break;
+        case ComponentType::FLOAT:
+            if (layout.mBytes == 4) memcpy(pDst, pSrc, count * sizeof(float));
+            else FormatConversion::HalfToFloat(reinterpret_cast<const uint16_t*>(pSrc), pDst, count);
+            break;
+        case ComponentType::SRGB:
+        {
+            const SrgbTables& tables = GetSrgbTables();
+            for (uint64_t i = 0; i < count; i += 4)
+            {
+                pDst[i] = tables.mToLinear[pSrc[i]];
+                pDst[i + 1] = tables.mToLinear[pSrc[i + 1]];
+                pDst[i + 2] = tables.mToLinear[pSrc[i + 2]];
+                pDst[i + 3] = static_cast<float>(pSrc[i + 3]) * (1.0f / 255.0f);
+            }
+            break;
+        }
+        case ComponentType::NONE:
+            break;
+        }
+    }
+
+    void EncodeComponents(ComponentLayout layout, const float* pSrc, byte* pDst, uint32_t width)
+    {
+        uint64_t count = static_cast<uint64_t>(width) * layout.mNumComponents;
+        bool isWide = layout.mBytes == 2;
+        switch (layout.mType)
+        {
+        case ComponentType::UNORM:
+        case ComponentType::UINT:
+            if (isWide) EncodeIntegerComponents<uint16_t>(pSrc, pDst, count, GetIntegerRange(layout));
+            else EncodeIntegerComponents<uint8_t>(pSrc, pDst, count, GetIntegerRange(layout));
+            break;
+        case ComponentType::SNORM:
+        case ComponentType::SINT:
+            if (isWide) EncodeIntegerComponents<int16_t>(pSrc, pDst, count, GetIntegerRange(layout));
+            else EncodeIntegerComponents<int8_t>(pSrc, pDst, count, GetIntegerRange(layout));
+            break;
+        case ComponentType::FLOAT:
+            if (layout.mBytes == 4) memcpy(pDst, pSrc, count * sizeof(float));
+            else FormatConversion::FloatToHalf(pSrc, reinterpret_cast<uint16_t*>(pDst), count);
+            break;
+        case ComponentType::SRGB:
+        {
+            const SrgbTables& tables = GetSrgbTables();
+            for (uint64_t i = 0; i < count; i += 4)
+            {
+                pDst[i] = EncodeSrgb(tables, pSrc[i]);
+                pDst[i + 1] = EncodeSrgb(tables, pSrc[i + 1]);
+                pDst[i + 2] = EncodeSrgb(tables, pSrc[i + 2]);
+                pDst[i + 3] = EncodeUnorm8(pSrc[i + 3]);
+            }
+            break;
+        }
+        case ComponentType::NONE:
+            break;
+        }
+    }
+
+    // changes the number of components per texel, new color channels are 0 and a new alpha is 1
+    void RemapComponents(const float* pSrc, uint8_t srcComponents, float* pDst, uint8_t dstComponents, uint32_t width)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            for (uint8_t c = 0; c < dstComponents; ++c)
+            {
+                pDst[c] = c < srcComponents ? pSrc[c] : (c == 3 ? 1.0f : 0.0f);
+            }
+            pSrc += srcComponents;
+            pDst += dstComponents;
+        }
+    }
+}
+
+bool FormatConversion::IsConvertible(TextureFormat format)
+{
+    return GetLayout(format).mType != ComponentType::NONE;
+}
+
+bool FormatConversion::Convert(TextureFormat srcFormat, const byte* pSrc, uint64_t srcRowPitch,
+                               TextureFormat dstFormat, byte* pDst, uint64_t dstRowPitch,
+                               uint32_t width, uint32_t height)
+{
+    ComponentLayout srcLayout = GetLayout(srcFormat);
+    ComponentLayout dstLayout = GetLayout(dstFormat);
+    uint64_t grainSize = (std::max)(TEXELS_PER_GRAIN / (std::max)(width, 1u), static_cast<uint64_t>(1));
+    if (srcFormat == dstFormat && !IsBlockCompressed(srcFormat))
+    {
+        uint64_t rowSize = static_cast<uint64_t>(width) * GetFormatTraits(srcFormat).mBytesPerBlock;
+        ParallelFor(0, height, grainSize, [=](uint64_t begin, uint64_t end)
+        {
+            for (uint64_t y = begin; y < end; ++y)
+            {
+                memcpy(pDst + y * dstRowPitch, pSrc + y * srcRowPitch, rowSize);
+            }
+        });
+        return true;
+    }
+    if (srcLayout.mType == ComponentType::NONE || dstLayout.mType == ComponentType::NONE) return false;
+
+    ParallelFor(0, height, grainSize, [=](uint64_t begin, uint64_t end)
+    {
+        std::vector<float> srcComponents(static_cast<uint64_t>(width) * srcLayout.mNumComponents);
+        std::vector<float> dstComponents(srcLayout.mNumComponents == dstLayout.mNumComponents ? 0 :
+                static_cast<uint64_t>(width) * dstLayout.mNumComponents);
+        for (uint64_t y = begin; y < end; ++y)
+        {
+            DecodeComponents(srcLayout, pSrc + y * srcRowPitch, srcComponents.data(), width);
+            const float* pComponents = srcComponents.data();
+            if (!dstComponents.empty())
+            {
+                RemapComponents(pComponents, srcLayout.mNumComponents, dstComponents.data(), dstLayout.mNumComponents, width);
+                pComponents = dstComponents.data();
+            }
+            EncodeComponents(dstLayout, pComponents, pDst + y * dstRowPitch, width);
+        }
+    });
+    return true;
+}
+
+bool FormatConversion::DecodeRow(TextureFormat format, const byte* pSrc, float* pRgba, uint32_t width)
+{
+    ComponentLayout layout = GetLayout(format);
+    if (layout.mType == ComponentType::NONE) return false;
+    if (layout.mNumComponents == 4)
+    {
+        DecodeComponents(layout, pSrc, pRgba, width);
+        return true;
+    }
+    std::vector<float> components(static_cast<uint64_t>(width) * layout.mNumComponents);
+    DecodeComponents(layout, pSrc, components.data(), width);
+    RemapComponents(components.data(), layout.mNumComponents, pRgba, 4, width);
+    return true;
+}
+
+bool FormatConversion::EncodeRow(TextureFormat format, const float* pRgba, byte* pDst, uint32_t width)
+{
+    ComponentLayout layout = GetLayout(format);
+    if (layout.mType == ComponentType::NONE) return false;
+    if (layout.mNumComponents == 4)
+    {
+        EncodeComponents(layout, pRgba, pDst, width);
+        return true;
+    }
+    std::vector<float> components(static_cast<uint64_t>(width) * layout.mNumComponents);
+    RemapComponents(pRgba, 4, components.data(), layout.mNumComponents, width);
+    EncodeComponents(layout, components.data(), pDst, width);
+    return true;
+}
+
+void FormatConversion::HalfToFloat(const uint16_t* pSrc, float* pDst, uint64_t count)
+{
+    uint64_t done = 0;
+#ifdef SIMD_X64
+    if (GetCpuFeatures().mHasF16c) done = HalfToFloatF16c(pSrc, pDst, count);
+#endif
+    for (uint64_t i = done; i < count; ++i)
+    {
+        pDst[i] = HalfToFloatScalar(pSrc[i]);
+    }
+}
+
+void FormatConversion::FloatToHalf(const float* pSrc, uint16_t* pDst, uint64_t count)
+{
+    uint64_t done = 0;
+#ifdef SIMD_X64
+    if (GetCpuFeatures().mHasF16c) done = FloatToHalfF16c(pSrc, pDst, count);
+#endif
+    for (uint64_t i = done; i < count; ++i)
+    {
+        pDst[i] = FloatToHalfScalar(pSrc[i]);
+    }
+}
+
+float FormatConversion::SrgbToLinear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float FormatConversion::LinearToSrgb(float value)
+{
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Engine/pch.h"
+#include "Engine/render/Texture.h"
+
+// conversion between the uncompressed texture formats. texels go through floats holding their value:
+// unorm -> [0, 1], snorm -> [-1, 1], uint / sint -> the integer, srgb -> linear [0, 1].
+// encoding clamps to the range of the destination and rounds to nearest even, nan becomes 0.
+// missing color channels read as 0 and a missing alpha as 1, extra channels are dropped.
+// avx2 / f16c kernels are picked at runtime, large images are converted in parallel over rows.
+namespace FormatConversion
+{
+    // uncompressed, non planar and not typeless.
+    bool IsConvertible(TextureFormat format);
+
+    // converts width x height texels, identical formats are copied row by row.
+    bool Convert(TextureFormat srcFormat, const byte* pSrc, uint64_t srcRowPitch,
+                 TextureFormat dstFormat, byte* pDst, uint64_t dstRowPitch,
+                 uint32_t width, uint32_t height);
+
+    // one row to or from 4 floats per texel, the building blocks for filtering passes.
+    bool DecodeRow(TextureFormat format, const byte* pSrc, float* pRgba, uint32_t width);
+    bool EncodeRow(TextureFormat format, const float* pRgba, byte* pDst, uint32_t width);
+
+    void HalfToFloat(const uint16_t* pSrc, float* pDst, uint64_t count);
+    void FloatToHalf(const float* pSrc, uint16_t* pDst, uint64_t count);
+    float SrgbToLinear(float value);
+    float LinearToSrgb(float value);
+}
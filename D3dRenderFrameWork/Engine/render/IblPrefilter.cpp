@@ -0,0 +1,489 @@
+#ifdef WIN32
+#include "Engine/render/IblPrefilter.h"
+#include "Engine/common/Exception.h"
+#include "Engine/common/Parallel.h"
+#include "Engine/common/Simd.h"
+#include "Engine/render/FormatConversion.h"
+#include "Engine/render/TextureSampler.h"
+#include <cmath>
+
+#undef max
+#undef min
+
+namespace
+{
+    constexpr float PI = 3.14159265358979f;
+    // source texels per parallel grain for sh projection, texel samples per grain when prefiltering
+    constexpr uint64_t TEXELS_PER_GRAIN = 16 * 1024;
+    constexpr uint64_t SAMPLES_PER_GRAIN = 64 * 1024;
+
+    // unnormalized direction through s, t in [-1, 1] on a face, t points down the face
+    void GetCubeDirection(uint32_t face, float s, float t, float* pDirection)
+    {
+        switch (face)
+        {
+        case 0: pDirection[0] = 1.0f; pDirection[1] = -t; pDirection[2] = -s; break;
+        case 1: pDirection[0] = -1.0f; pDirection[1] = -t; pDirection[2] = s; break;
+        case 2: pDirection[0] = s; pDirection[1] = 1.0f; pDirection[2] = t; break;
+        case 3: pDirection[0] = s; pDirection[1] = -1.0f; pDirection[2] = -t; break;
+        case 4: pDirection[0] = s; pDirection[1] = -t; pDirection[2] = 1.0f; break;
+        default: pDirection[0] = -s; pDirection[1] = -t; pDirection[2] = -1.0f; break;
+        }
+    }
+
+    uint32_t GetCubeFace(const float* pDirection, float& u, float& v)
+    {
+        float x = pDirection[0];
+        float y = pDirection[1];
+        float z = pDirection[2];
+        float absX = std::fabs(x);
+        float absY = std::fabs(y);
+        float absZ = std::fabs(z);
+        uint32_t face;
+        float major, s, t;
+        if (absX >= absY && absX >= absZ)
+        {
+            face = x > 0.0f ? 0 : 1;
+            major = absX;
+            s = x > 0.0f ? -z : z;
+            t = -y;
+        }
+        else if (absY >= absZ)
+        {
+            face = y > 0.0f ? 2 : 3;
+            major = absY;
+            s = x;
+            t = y > 0.0f ? z : -z;
+        }
+        else
+        {
+            face = z > 0.0f ? 4 : 5;
+            major = absZ;
+            s = z > 0.0f ? x : -x;
+            t = -y;
+        }
+        u = 0.5f * (s / major + 1.0f);
+        v = 0.5f * (t / major + 1.0f);
+        return face;
+    }
+
+    void Normalize(float* pVector)
+    {
+        float inverseLength = 1.0f / std::sqrt(pVector[0] * pVector[0] + pVector[1] * pVector[1] + pVector[2] * pVector[2]);
+        pVector[0] *= inverseLength;
+        pVector[1] *= inverseLength;
+        pVector[2] *= inverseLength;
+    }
+
+    void GetShBasis(const float* pDirection, float* pBasis)
+    {
+        float x = pDirection[0];
+        float y = pDirection[1];
+        float z = pDirection[2];
+        pBasis[0] = 0.282095f;
+        pBasis[1] = 0.488603f * y;
+        pBasis[2] = 0.488603f * z;
+        pBasis[3] = 0.488603f * x;
+        pBasis[4] = 1.092548f * x * y;
+        pBasis[5] = 1.092548f * y * z;
+        pBasis[6] = 0.315392f * (3.0f * z * z - 1.0f);
+        pBasis[7] = 1.092548f * x * z;
+        pBasis[8] = 0.546274f * (x * x - y * y);
+    }
+
+    float RadicalInverse(uint32_t bits)
+    {
+        bits = (bits << 16) | (bits >> 16);
+        bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+        bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+        bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+        bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+        return static_cast<float>(bits) * 2.3283064365386963e-10f;
+    }
+
+    // half vector around +z for the point (i / n, radical inverse of i) of a hammersley set, alpha2 = roughness^4
+    void ImportanceSampleGgx(uint32_t i, uint32_t numSamples, float alpha2, float* pHalfVector)
+    {
+        float phi = 2.0f * PI * static_cast<float>(i) / static_cast<float>(numSamples);
+        float xi = RadicalInverse(i);
+        float cosTheta = std::sqrt((1.0f - xi) / (1.0f + (alpha2 - 1.0f) * xi));
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        pHalfVector[0] = sinTheta * std::cos(phi);
+        pHalfVector[1] = sinTheta * std::sin(phi);
+        pHalfVector[2] = cosTheta;
+    }
+
+    // the sample set of a roughness is the same for every texel up to a rotation, so it is built once per mip
+    struct TangentSample
+    {
+        float mDirection[3];
+        float mWeight;
+        float mLod;
+    };
+
+    // filtered importance sampling: a sample reads the source mip whose texels cover the solid angle the sample stands for
+    std::vector<TangentSample> GetSpecularSamples(float roughness, uint32_t numSamples, float texelSolidAngle)
+    {
+        if (roughness == 0.0f) return { { { 0.0f, 0.0f, 1.0f }, 1.0f, 0.0f } };
+        float alpha = roughness * roughness;
+        float alpha2 = alpha * alpha;
+        std::vector<TangentSample> samples;
+        samples.reserve(numSamples);
+        for (uint32_t i = 0; i < numSamples; ++i)
+        {
+            float h[3];
+            ImportanceSampleGgx(i, numSamples, alpha2, h);
+            // n = v, so l is h mirrored around +z and n.h = v.h
+            TangentSample sample{ { 2.0f * h[2] * h[0], 2.0f * h[2] * h[1], 2.0f * h[2] * h[2] - 1.0f }, 0.0f, 0.0f };
+            if (sample.mDirection[2] <= 0.0f) continue;
+            float denominator = h[2] * h[2] * (alpha2 - 1.0f) + 1.0f;
+            float pdf = alpha2 / (PI * denominator * denominator) * 0.25f;
+            float sampleSolidAngle = 1.0f / (static_cast<float>(numSamples) * pdf);
+            sample.mWeight = sample.mDirection[2];
+            sample.mLod = (std::max)(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f);
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+
+    // reads radiance by direction from either environment layout. cube reads are grouped by face so each face
+    // sampler still filters whole batches.
+    class EnvironmentSource
+    {
+    public:
+        struct Scratch
+        {
+            std::vector<float> mU;
+            std::vector<float> mV;
+            std::vector<float> mLods;
+            std::vector<float> mRgba;
+            std::vector<uint32_t> mIndices;
+            std::vector<uint8_t> mFaces;
+        };
+
+        // directions are xyz triples and need not be normalized
+        void sample(const float* pDirections, const float* pLods, float* pRgba, uint64_t count, Scratch& scratch) const
+        {
+            scratch.mU.resize(count);
+            scratch.mV.resize(count);
+            if (!mIsCube)
+            {
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    const float* pDirection = pDirections + i * 3;
+                    float length = std::sqrt(pDirection[0] * pDirection[0] + pDirection[1] * pDirection[1] + pDirection[2] * pDirection[2]);
+                    float y = (std::min)((std::max)(pDirection[1] / length, -1.0f), 1.0f);
+                    scratch.mU[i] = std::atan2(pDirection[2], pDirection[0]) / (2.0f * PI) + 0.5f;
+                    scratch.mV[i] = std::acos(y) / PI;
+                }
+                mSamplers[0].sampleLevel(mSamplerDesc, scratch.mU.data(), scratch.mV.data(), pLods, pRgba, count);
+                return;
+            }
+
+            scratch.mLods.resize(count);
+            scratch.mRgba.resize(count * 4);
+            scratch.mIndices.resize(count);
+            scratch.mFaces.resize(count);
+            uint64_t faceStarts[7] = {};
+            for (uint64_t i = 0; i < count; ++i)
+            {
+                float u, v;
+                scratch.mFaces[i] = static_cast<uint8_t>(GetCubeFace(pDirections + i * 3, u, v));
+                faceStarts[scratch.mFaces[i] + 1]++;
+            }
+            for (uint32_t face = 0; face < 6; ++face)
+            {
+                faceStarts[face + 1] += faceStarts[face];
+            }
+            uint64_t faceEnds[6];
+            memcpy(faceEnds, faceStarts, sizeof(faceEnds));
+            for (uint64_t i = 0; i < count; ++i)
+            {
+                uint64_t slot = faceEnds[scratch.mFaces[i]]++;
+                GetCubeFace(pDirections + i * 3, scratch.mU[slot], scratch.mV[slot]);
+                scratch.mLods[slot] = pLods[i];
+                scratch.mIndices[slot] = static_cast<uint32_t>(i);
+            }
+            for (uint32_t face = 0; face < 6; ++face)
+            {
+                uint64_t start = faceStarts[face];
+                if (faceEnds[face] == start) continue;
+                mSamplers[face].sampleLevel(mSamplerDesc, scratch.mU.data() + start, scratch.mV.data() + start,
+                        scratch.mLods.data() + start, scratch.mRgba.data() + start * 4, faceEnds[face] - start);
+            }
+            for (uint64_t slot = 0; slot < count; ++slot)
+            {
+                memcpy(pRgba + scratch.mIndices[slot] * 4, scratch.mRgba.data() + slot * 4, 4 * sizeof(float));
+            }
+        }
+
+        bool isCube() const
+        {
+            return mIsCube;
+        }
+
+        float texelSolidAngle() const
+        {
+            return mTexelSolidAngle;
+        }
+
+        explicit EnvironmentSource(const RawTexture& environment) : mIsCube(environment.arraySize() == 6)
+        {
+            ASSERT(environment.Type() == TextureType::TEXTURE_2D && (environment.arraySize() == 1 || mIsCube),
+                   TEXT("environments are equirectangular or 6 cube faces"));
+            mSamplers.reserve(environment.arraySize());
+            for (uint32_t slice = 0; slice < environment.arraySize(); ++slice)
+            {
+                mSamplers.emplace_back(environment, slice);
+            }
+            float numTexels = static_cast<float>(environment.Width() * environment.Height() * environment.arraySize());
+            mTexelSolidAngle = 4.0f * PI / numTexels;
+            // cube faces don't continue across their borders. equirectangular maps wrap around the horizon only,
+            // wrapping v would blend the rows next to one pole with the rows at the other
+            SamplerAddressMode addressU = mIsCube ? SamplerAddressMode::CLAMP : SamplerAddressMode::WRAP;
+            mSamplerDesc = { SamplerFilter::LINEAR, addressU, SamplerAddressMode::CLAMP, 1 };
+        }
+
+    private:
+        std::vector<TextureSampler> mSamplers;
+        SamplerDesc mSamplerDesc;
+        float mTexelSolidAngle;
+        bool mIsCube;
+    };
+}
+
+// every source texel contributes its radiance weighted by the solid angle it covers
+Ibl::ShIrradiance Ibl::ProjectIrradiance(const RawTexture& environment)
+{
+    EnvironmentSource source{ environment };
+    uint32_t width = static_cast<uint32_t>(environment.Width());
+    uint32_t height = static_cast<uint32_t>(environment.Height());
+    uint64_t numRows = static_cast<uint64_t>(height) * environment.arraySize();
+    uint64_t grainSize = (std::max)(TEXELS_PER_GRAIN / width, uint64_t{ 1 });
+
+    struct ShSum
+    {
+        float mCoefficients[9][4];
+        float mSolidAngle;
+    };
+    std::vector<ShSum> sums((numRows + grainSize - 1) / grainSize);
+    ParallelFor(0, numRows, grainSize, [&](uint64_t begin, uint64_t end)
+    {
+        EnvironmentSource::Scratch scratch;
+        std::vector<float> directions(width * 3);
+        std::vector<float> solidAngles(width);
+        std::vector<float> lods(width, 0.0f);
+        std::vector<float> radiance(width * 4);
+        float solidAngle = 0.0f;
+#ifdef SIMD_SSE2
+        __m128 coefficients[9];
+        for (__m128& coefficient : coefficients) coefficient = _mm_setzero_ps();
+#else
+        float coefficients[9][4] = {};
+#endif
+        for (uint64_t row = begin; row < end; ++row)
+        {
+            uint32_t face = static_cast<uint32_t>(row / height);
+            uint32_t y = static_cast<uint32_t>(row % height);
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float* pDirection = directions.data() + x * 3;
+                if (source.isCube())
+                {
+                    float s = 2.0f * (static_cast<float>(x) + 0.5f) / static_cast<float>(width) - 1.0f;
+                    float t = 2.0f * (static_cast<float>(y) + 0.5f) / static_cast<float>(height) - 1.0f;
+                    GetCubeDirection(face, s, t, pDirection);
+                    float distance2 = 1.0f + s * s + t * t;
+                    solidAngles[x] = 4.0f / (static_cast<float>(width) * static_cast<float>(height) * distance2 * std::sqrt(distance2));
+                }
+                else
+                {
+                    float theta = PI * (static_cast<float>(y) + 0.5f) / static_cast<float>(height);
+                    float phi = 2.0f * PI * ((static_cast<float>(x) + 0.5f) / static_cast<float>(width) - 0.5f);
+                    pDirection[0] = std::sin(theta) * std::cos(phi);
+                    pDirection[1] = std::cos(theta);
+                    pDirection[2] = std::sin(theta) * std::sin(phi);
+                    solidAngles[x] = 2.0f * PI * PI / (static_cast<float>(width) * static_cast<float>(height)) * std::sin(theta);
+                }
+            }
+            source.sample(directions.data(), lods.data(), radiance.data(), width, scratch);
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float basis[9];
+                Normalize(directions.data() + x * 3);
+                GetShBasis(directions.data() + x * 3, basis);
+                solidAngle += solidAngles[x];
+#ifdef SIMD_SSE2
+                __m128 weighted = _mm_mul_ps(_mm_loadu_ps(radiance.data() + x * 4), _mm_set1_ps(solidAngles[x]));
+                for (uint32_t i = 0; i < 9; ++i)
+                {
+                    coefficients[i] = _mm_add_ps(coefficients[i], _mm_mul_ps(weighted, _mm_set1_ps(basis[i])));
+                }
+#else
+                for (uint32_t i = 0; i < 9; ++i)
+                {
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        coefficients[i][c] += radiance[x * 4 + c] * solidAngles[x] * basis[i];
+                    }
+                }
+#endif
+            }
+        }
+        ShSum& sum = sums[begin / grainSize];
+        sum.mSolidAngle = solidAngle;
+#ifdef SIMD_SSE2
+        for (uint32_t i = 0; i < 9; ++i) _mm_storeu_ps(sum.mCoefficients[i], coefficients[i]);
+#else
+        memcpy(sum.mCoefficients, coefficients, sizeof(coefficients));
+#endif
+    });
+
+    // the texel solid angles only approximately add up to the sphere, the rest of the error is normalized away.
+    // the bands are scaled by the sh coefficients of the clamped cosine lobe.
+    ShIrradiance irradiance{};
+    float totalSolidAngle = 0.0f;
+    for (const ShSum& sum : sums)
+    {
+        totalSolidAngle += sum.mSolidAngle;
+        for (uint32_t i = 0; i < 9; ++i)
+        {
+            for (uint32_t c = 0; c < 3; ++c) irradiance.mCoefficients[i][c] += sum.mCoefficients[i][c];
+        }
+    }
+    const float bandScales[9] = { PI, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f,
+                                  PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f };
+    float normalization = 4.0f * PI / totalSolidAngle;
+    for (uint32_t i = 0; i < 9; ++i)
+    {
+        for (uint32_t c = 0; c < 3; ++c) irradiance.mCoefficients[i][c] *= normalization * bandScales[i];
+    }
+    return irradiance;
+}
+
+void Ibl::EvaluateIrradiance(const ShIrradiance& irradiance, const float* pDirection, float* pRgb)
+{
+    float direction[3] = { pDirection[0], pDirection[1], pDirection[2] };
+    float basis[9];
+    Normalize(direction);
+    GetShBasis(direction, basis);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        pRgb[c] = 0.0f;
+        for (uint32_t i = 0; i < 9; ++i) pRgb[c] += irradiance.mCoefficients[i][c] * basis[i];
+    }
+}
+
+// every output texel integrates the source around its own direction with n = v = r
+RawTexture Ibl::PrefilterSpecular(const RawTexture& environment, uint32_t faceSize, uint8_t numMips, uint32_t numSamples)
+{
+    EnvironmentSource source{ environment };
+    RawTexture prefiltered{ TextureType::TEXTURE_2D, faceSize, faceSize, 6, TextureFormat::R16G16B16A16_FLOAT, nullptr, numMips };
+    uint64_t texelSize = GetFormatTraits(TextureFormat::R16G16B16A16_FLOAT).mBytesPerBlock;
+    for (uint8_t mip = 0; mip < numMips; ++mip)
+    {
+        uint32_t size = (std::max)(faceSize >> mip, 1u);
+        float roughness = numMips > 1 ? static_cast<float>(mip) / static_cast<float>(numMips - 1) : 0.0f;
+        std::vector<TangentSample> samples = GetSpecularSamples(roughness, numSamples, source.texelSolidAngle());
+        uint64_t grainSize = (std::max)(SAMPLES_PER_GRAIN / (static_cast<uint64_t>(size) * samples.size()), uint64_t{ 1 });
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            byte* pDst = prefiltered.writableSubResourcePtr(mip, face);
+            ParallelFor(0, size, grainSize, [&](uint64_t begin, uint64_t end)
+            {
+                EnvironmentSource::Scratch scratch;
+                std::vector<float> directions(samples.size() * 3);
+                std::vector<float> lods(samples.size());
+                std::vector<float> radiance(samples.size() * 4);
+                std::vector<float> row(static_cast<uint64_t>(size) * 4);
+                for (uint64_t k = 0; k < samples.size(); ++k) lods[k] = samples[k].mLod;
+                for (uint64_t y = begin; y < end; ++y)
+                {
+                    for (uint32_t x = 0; x < size; ++x)
+                    {
+                        float normal[3];
+                        float s = 2.0f * (static_cast<float>(x) + 0.5f) / static_cast<float>(size) - 1.0f;
+                        float t = 2.0f * (static_cast<float>(y) + 0.5f) / static_cast<float>(size) - 1.0f;
+                        GetCubeDirection(face, s, t, normal);
+                        Normalize(normal);
+                        bool isNearZ = std::fabs(normal[2]) > 0.999f;
+                        float up[3] = { isNearZ ? 1.0f : 0.0f, 0.0f, isNearZ ? 0.0f : 1.0f };
+                        float tangent[3] = { up[1] * normal[2] - up[2] * normal[1], up[2] * normal[0] - up[0] * normal[2],
+                                             up[0] * normal[1] - up[1] * normal[0] };
+                        Normalize(tangent);
+                        float bitangent[3] = { normal[1] * tangent[2] - normal[2] * tangent[1], normal[2] * tangent[0] - normal[0] * tangent[2],
+                                               normal[0] * tangent[1] - normal[1] * tangent[0] };
+                        for (uint64_t k = 0; k < samples.size(); ++k)
+                        {
+                            const float* pLocal = samples[k].mDirection;
+                            for (uint32_t c = 0; c < 3; ++c)
+                            {
+                                directions[k * 3 + c] = tangent[c] * pLocal[0] + bitangent[c] * pLocal[1] + normal[c] * pLocal[2];
+                            }
+                        }
+                        source.sample(directions.data(), lods.data(), radiance.data(), samples.size(), scratch);
+
+                        float sum[3] = {};
+                        float weightSum = 0.0f;
+                        for (uint64_t k = 0; k < samples.size(); ++k)
+                        {
+                            for (uint32_t c = 0; c < 3; ++c) sum[c] += radiance[k * 4 + c] * samples[k].mWeight;
+                            weightSum += samples[k].mWeight;
+                        }
+                        for (uint32_t c = 0; c < 3; ++c) row[x * 4 + c] = sum[c] / weightSum;
+                        row[x * 4 + 3] = 1.0f;
+                    }
+                    FormatConversion::EncodeRow(TextureFormat::R16G16B16A16_FLOAT, row.data(), pDst + y * size * texelSize, size);
+                }
+            });
+        }
+    }
+    return prefiltered;
+}
+
+// split sum approximation of the specular brdf with smith-schlick visibility (k = alpha / 2)
+RawTexture Ibl::IntegrateBrdf(uint32_t size, uint32_t numSamples)
+{
+    RawTexture lut{ TextureType::TEXTURE_2D, size, size, 1, TextureFormat::R16G16_FLOAT };
+    byte* pDst = lut.writableSubResourcePtr(0, 0);
+    uint64_t texelSize = GetFormatTraits(TextureFormat::R16G16_FLOAT).mBytesPerBlock;
+    uint64_t grainSize = (std::max)(SAMPLES_PER_GRAIN / (static_cast<uint64_t>(size) * numSamples), uint64_t{ 1 });
+    ParallelFor(0, size, grainSize, [&](uint64_t begin, uint64_t end)
+    {
+        std::vector<float> row(static_cast<uint64_t>(size) * 4);
+        for (uint64_t y = begin; y < end; ++y)
+        {
+            float roughness = (static_cast<float>(y) + 0.5f) / static_cast<float>(size);
+            float alpha = roughness * roughness;
+            float k = alpha * 0.5f;
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                float nDotV = (static_cast<float>(x) + 0.5f) / static_cast<float>(size);
+                float view[3] = { std::sqrt(1.0f - nDotV * nDotV), 0.0f, nDotV };
+                float scale = 0.0f;
+                float bias = 0.0f;
+                for (uint32_t i = 0; i < numSamples; ++i)
+                {
+                    float h[3];
+                    ImportanceSampleGgx(i, numSamples, alpha * alpha, h);
+                    float vDotH = view[0] * h[0] + view[1] * h[1] + view[2] * h[2];
+                    float nDotL = 2.0f * vDotH * h[2] - view[2];
+                    if (nDotL <= 0.0f) continue;
+                    float nDotH = h[2];
+                    float visibility = nDotV / (nDotV * (1.0f - k) + k) * nDotL / (nDotL * (1.0f - k) + k);
+                    float weight = visibility * (std::max)(vDotH, 0.0f) / (nDotH * nDotV);
+                    float fresnel = std::pow(1.0f - (std::max)(vDotH, 0.0f), 5.0f);
+                    scale += (1.0f - fresnel) * weight;
+                    bias += fresnel * weight;
+                }
+                row[x * 4] = scale / static_cast<float>(numSamples);
+                row[x * 4 + 1] = bias / static_cast<float>(numSamples);
+                row[x * 4 + 2] = 0.0f;
+                row[x * 4 + 3] = 1.0f;
+            }
+            FormatConversion::EncodeRow(TextureFormat::R16G16_FLOAT, row.data(), pDst + y * size * texelSize, size);
+        }
+    });
+    return lut;
+}
+#endif
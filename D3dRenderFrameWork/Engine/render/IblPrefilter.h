@@ -0,0 +1,29 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+#include "Engine/render/RawTexture.h"
+
+// offline image based lighting inputs. an environment is either an equirectangular TEXTURE_2D with one slice
+// (u = atan2(z, x) / 2pi + 0.5, v = acos(y) / pi) or a TEXTURE_2D with 6 slices in d3d cube face order
+// (+x, -x, +y, -y, +z, -z). work is spread over the worker pool, texture reads go through TextureSampler.
+namespace Ibl
+{
+    // irradiance as 9 rgb sh coefficients, already convolved with the clamped cosine:
+    // E(n) = sum mCoefficients[i].rgb * Y_i(n), diffuse radiance is albedo / pi * E(n).
+    // coefficients are padded to float4 so the array can be copied into a constant buffer as is.
+    struct ShIrradiance
+    {
+        float mCoefficients[9][4];
+    };
+
+    ShIrradiance ProjectIrradiance(const RawTexture& environment);
+    void EvaluateIrradiance(const ShIrradiance& irradiance, const float* pDirection, float* pRgb);
+
+    // R16G16B16A16_FLOAT cube with 6 slices, mip m is the radiance prefiltered with ggx at roughness m / (numMips - 1).
+    // samples are importance sampled and read from a blurrier source mip the less likely they are.
+    RawTexture PrefilterSpecular(const RawTexture& environment, uint32_t faceSize, uint8_t numMips, uint32_t numSamples = 128);
+
+    // R16G16_FLOAT split sum lut, scale and bias applied to f0 for u = n.v and v = roughness.
+    RawTexture IntegrateBrdf(uint32_t size = 128, uint32_t numSamples = 256);
+}
+#endif
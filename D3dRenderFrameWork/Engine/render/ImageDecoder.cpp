@@ -0,0 +1,98 @@
+#include "Engine/render/ImageDecoder.h"
+#include "Engine/render/PngDecoder.h"
+#include "Engine/render/TgaDecoder.h"
+#include "Engine/render/TextureFootprint.h"
+#include "Engine/common/Parallel.h"
+#include "Engine/common/helper.h"
+#include <filesystem>
+
+namespace
+{
+    constexpr uint64_t STREAM_CHUNK_SIZE = 64 * 1024;
+
+    // feeds one chunk, stopping once to ask the job for a destination.
+    DecodeStatus FeedChunk(ImageDecoder& decoder, ImageDecodeJob& job, const byte* pData, uint64_t size)
+    {
+        uint64_t consumed = 0;
+        DecodeStatus status = decoder.feed(pData, size, &consumed);
+        if (status == DecodeStatus::NEED_DESTINATION)
+        {
+            job.mInfo = decoder.info();
+            ImageDestination destination = job.mAllocDestination(job.mInfo);
+            if (!destination.mData || destination.mRowPitch < job.mInfo.rowSize()) return DecodeStatus::FAILED;
+            decoder.setDestination(destination);
+            uint64_t rest = 0;
+            status = decoder.feed(pData + consumed, size - consumed, &rest);
+        }
+        return status;
+    }
+
+    DecodeStatus DecodeFromMemory(ImageDecodeJob& job)
+    {
+        std::unique_ptr<ImageDecoder> decoder = ImageDecoder::sCreate(job.mSource, job.mSourceSize);
+        DecodeStatus status = FeedChunk(*decoder, job, job.mSource, job.mSourceSize);
+        return status == DecodeStatus::DONE ? status : DecodeStatus::FAILED;
+    }
+
+    DecodeStatus DecodeFromFile(ImageDecodeJob& job)
+    {
+        std::ifstream file{ std::filesystem::path{ job.mPath }, std::ios::binary };
+        if (!file) return DecodeStatus::FAILED;
+
+        std::unique_ptr<byte[]> chunk{ new byte[STREAM_CHUNK_SIZE] };
+        std::unique_ptr<ImageDecoder> decoder;
+        DecodeStatus status = DecodeStatus::NEED_INPUT;
+        while (status == DecodeStatus::NEED_INPUT && file)
+        {
+            file.read(reinterpret_cast<char*>(chunk.get()), STREAM_CHUNK_SIZE);
+            uint64_t size = static_cast<uint64_t>(file.gcount());
+            if (size == 0) break;
+            if (!decoder) decoder = ImageDecoder::sCreate(chunk.get(), size);
+            status = FeedChunk(*decoder, job, chunk.get(), size);
+        }
+        return status == DecodeStatus::DONE ? status : DecodeStatus::FAILED;
+    }
+}
+
+uint64_t ImageInfo::rowSize() const
+{
+    return static_cast<uint64_t>(mWidth) * GetFormatTraits(mFormat).mBytesPerBlock;
+}
+
+uint64_t ImageInfo::uploadRowPitch() const
+{
+    return AlignUpToMul<uint64_t, TEXTURE_DATA_PITCH_ALIGNMENT>{}(rowSize());
+}
+
+ImageDecoder::ImageDecoder() : mInfo(), mDestination() { }
+
+ImageDecoder::~ImageDecoder() = default;
+
+void ImageDecoder::setDestination(const ImageDestination& destination)
+{
+    mDestination = destination;
+}
+
+const ImageInfo& ImageDecoder::info() const
+{
+    return mInfo;
+}
+
+std::unique_ptr<ImageDecoder> ImageDecoder::sCreate(const byte* pHeader, uint64_t size)
+{
+    if (PngDecoder::sIsPng(pHeader, size)) return std::make_unique<PngDecoder>();
+    return std::make_unique<TgaDecoder>();
+}
+
+void DecodeImages(ImageDecodeJob* pJobs, uint64_t numJobs)
+{
+    ParallelFor(0, numJobs, 1, [pJobs](uint64_t begin, uint64_t end)
+    {
+        for (uint64_t i = begin; i < end; ++i)
+        {
+            ImageDecodeJob& job = pJobs[i];
+            job.mInfo = {};
+            job.mStatus = job.mPath.empty() ? DecodeFromMemory(job) : DecodeFromFile(job);
+        }
+    });
+}
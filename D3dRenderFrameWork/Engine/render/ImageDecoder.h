@@ -0,0 +1,73 @@
+#pragma once
+#include "Engine/pch.h"
+#include "Engine/render/Texture.h"
+
+enum class DecodeStatus : uint8_t
+{
+    NEED_INPUT,
+    NEED_DESTINATION,
+    DONE,
+    FAILED,
+};
+
+struct ImageInfo
+{
+    uint64_t rowSize() const;
+    uint64_t uploadRowPitch() const;
+
+    uint32_t mWidth;
+    uint32_t mHeight;
+    TextureFormat mFormat;
+};
+
+// where decoded rows land: row y starts at mData + y * mRowPitch and holds tightly packed texels of ImageInfo::mFormat.
+// point it into a mapped upload buffer to skip the staging copy.
+struct ImageDestination
+{
+    byte* mData;
+    uint64_t mRowPitch;
+};
+
+// incremental image decoder. input is fed in chunks of any size, pixels are written straight into the destination
+// as soon as their rows are complete, nothing but a couple of scanlines is buffered.
+class ImageDecoder
+{
+public:
+    // consumes input until it runs dry, the header is known and a destination is missing, or the image is done.
+    // pConsumed receives the number of bytes used, hand the rest back in after setDestination.
+    virtual DecodeStatus feed(const byte* pData, uint64_t size, uint64_t* pConsumed) = 0;
+    void setDestination(const ImageDestination& destination);
+    const ImageInfo& info() const;
+
+    // picks the decoder from the file signature, anything that isn't a png is treated as tga.
+    static std::unique_ptr<ImageDecoder> sCreate(const byte* pHeader, uint64_t size);
+
+    virtual ~ImageDecoder();
+
+    DELETE_COPY_CONSTRUCTOR(ImageDecoder)
+    DELETE_COPY_OPERATOR(ImageDecoder)
+    DELETE_MOVE_CONSTRUCTOR(ImageDecoder)
+    DELETE_MOVE_OPERATOR(ImageDecoder)
+
+protected:
+    ImageDecoder();
+
+    ImageInfo mInfo;
+    ImageDestination mDestination;
+};
+
+struct ImageDecodeJob
+{
+    // a file streamed from disk in chunks, or encoded bytes already in memory when mPath is empty.
+    String mPath;
+    const byte* mSource;
+    uint64_t mSourceSize;
+    // called once the header is parsed, from whichever worker decodes the image.
+    std::function<ImageDestination(const ImageInfo&)> mAllocDestination;
+
+    ImageInfo mInfo;
+    DecodeStatus mStatus;
+};
+
+// decodes independent images in parallel, one image per worker.
+void DecodeImages(ImageDecodeJob* pJobs, uint64_t numJobs);
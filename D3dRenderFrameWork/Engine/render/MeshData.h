@@ -21,6 +21,7 @@ struct MeshData
 	uint32_t mVertexCount;
 	uint32_t mIndexCount;
 	std::vector<SubMesh> mSubMeshes;
+	DirectX::BoundingBox mBounds;	// object space
 };
 
 struct Mesh
@@ -37,6 +38,7 @@ public:
     uint64_t numVertex() const;
     uint64_t numIndex() const;
     uint32_t calcVertexSize() const;
+    DirectX::BoundingBox calcBounds() const;
 	uint64_t vertexBufferSize() const;
 	void setVertex();
 	void emplaceVertex(std::vector<DirectX::XMFLOAT3>&& vertex);
@@ -132,6 +134,14 @@ inline uint32_t Mesh::calcVertexSize() const
 	return size;
 }
 
+inline DirectX::BoundingBox Mesh::calcBounds() const
+{
+	DirectX::BoundingBox bounds{ { 0, 0, 0 }, { 0, 0, 0 } };
+	if (mVertex.empty()) return bounds;
+	DirectX::BoundingBox::CreateFromPoints(bounds, mVertex.size(), mVertex.data(), sizeof(DirectX::XMFLOAT3));
+	return bounds;
+}
+
 inline uint64_t Mesh::vertexBufferSize() const
 {
 	return mVertexBuffer.size() * sizeof(float);
@@ -0,0 +1,241 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+#include "Engine/common/Exception.h"
+
+struct CommandStateStats
+{
+    uint64_t mNumIssued;
+    uint64_t mNumSkipped;   // calls that would have set what was already bound
+};
+
+// remembers what is bound on a graphics command list and only forwards the calls that change something.
+// CommandList is ID3D12GraphicsCommandList in the renderer, anything with the same member functions works,
+// e.g. a stand-in that records the calls it receives.
+// the cache assumes it sees every state call made on the list, call invalidate() after touching it directly.
+template<typename CommandList>
+class CommandStateCache
+{
+public:
+    // root signatures are limited to 64 dwords, no parameter takes less than one
+    static constexpr uint32_t MAX_ROOT_PARAMETERS = 64;
+    static constexpr uint32_t MAX_VERTEX_BUFFERS = D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+
+    void setDescriptorHeaps(uint32_t numHeaps, ID3D12DescriptorHeap* const* ppHeaps);
+    void setGraphicsRootSignature(ID3D12RootSignature* pRootSignature);
+    void setGraphicsRootDescriptorTable(uint32_t rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor);
+    void setGraphicsRootConstantBufferView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation);
+    // root constants are not compared, they are always forwarded
+    void setGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t numValues, const void* pData);
+    void setGraphicsRootShaderResourceView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation);
+    void setPipelineState(ID3D12PipelineState* pPipelineState);
+    void setVertexBuffers(uint32_t startSlot, uint32_t numViews, const D3D12_VERTEX_BUFFER_VIEW* pViews);
+    void setIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view);
+    void setPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology);
+    // forgets everything, the next call of every kind is forwarded
+    void invalidate();
+    CommandList* commandList() const;
+    const CommandStateStats& stats() const;
+
+    explicit CommandStateCache(CommandList* pCommandList);
+
+    DELETE_COPY_CONSTRUCTOR(CommandStateCache)
+    DELETE_COPY_OPERATOR(CommandStateCache)
+    DEFAULT_MOVE_CONSTRUCTOR(CommandStateCache)
+    DEFAULT_MOVE_OPERATOR(CommandStateCache)
+
+private:
+    bool count(bool isRedundant);
+    bool isRootArgumentBound(uint32_t rootParameterIndex, uint64_t argument) const;
+    void bindRootArgument(uint32_t rootParameterIndex, uint64_t argument);
+
+    CommandList* mCommandList;
+    ID3D12DescriptorHeap* mHeaps[2];
+    uint32_t mNumHeaps;
+    ID3D12RootSignature* mRootSignature;
+    ID3D12PipelineState* mPipelineState;
+    uint64_t mRootArguments[MAX_ROOT_PARAMETERS];      // table handle or buffer address per root parameter
+    uint64_t mBoundRootArguments;                       // bit i set when mRootArguments[i] is known
+    D3D12_VERTEX_BUFFER_VIEW mVertexBuffers[MAX_VERTEX_BUFFERS];
+    uint32_t mBoundVertexBuffers;                       // bit i set when mVertexBuffers[i] is known
+    D3D12_INDEX_BUFFER_VIEW mIndexBuffer;
+    bool mIsIndexBufferBound;
+    D3D12_PRIMITIVE_TOPOLOGY mTopology;
+    CommandStateStats mStats;
+};
+
+template <typename CommandList>
+CommandStateCache<CommandList>::CommandStateCache(CommandList* pCommandList) : mCommandList(pCommandList), mStats{}
+{
+    invalidate();
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::invalidate()
+{
+    mNumHeaps = 0;
+    mHeaps[0] = mHeaps[1] = nullptr;
+    mRootSignature = nullptr;
+    mPipelineState = nullptr;
+    mBoundRootArguments = 0;
+    mBoundVertexBuffers = 0;
+    mIsIndexBufferBound = false;
+    mTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+}
+
+template <typename CommandList>
+bool CommandStateCache<CommandList>::count(bool isRedundant)
+{
+    ++(isRedundant ? mStats.mNumSkipped : mStats.mNumIssued);
+    return isRedundant;
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::setDescriptorHeaps(uint32_t numHeaps, ID3D12DescriptorHeap* const* ppHeaps)
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(numHeaps <= 2, TEXT("at most a cbv/srv/uav and a sampler heap can be bound\n"));
+#endif
+    bool isRedundant = numHeaps == mNumHeaps;
+    for (uint32_t i = 0; i < numHeaps && isRedundant; ++i)
+    {
+        isRedundant = ppHeaps[i] == mHeaps[i];
+    }
+    if (count(isRedundant)) return;
+    mCommandList->SetDescriptorHeaps(numHeaps, ppHeaps);
+    mNumHeaps = numHeaps;
+    for (uint32_t i = 0; i < numHeaps; ++i)
+    {
+        mHeaps[i] = ppHeaps[i];
+    }
+    // tables point into the heaps, they are undefined after a heap change
+    mBoundRootArguments = 0;
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::setGraphicsRootSignature(ID3D12RootSignature* pRootSignature)
+{
+    if (count(pRootSignature == mRootSignature)) return;
+    mCommandList->SetGraphicsRootSignature(pRootSignature);
+    mRootSignature = pRootSignature;
+    // setting a root signature resets all root arguments
+    mBoundRootArguments = 0;
+}
+
+template <typename CommandList>
+bool CommandStateCache<CommandList>::isRootArgumentBound(uint32_t rootParameterIndex, uint64_t argument) const
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(rootParameterIndex < MAX_ROOT_PARAMETERS, TEXT("root parameter index out of range\n"));
+#endif
+    return (mBoundRootArguments >> rootParameterIndex & 1) && mRootArguments[rootParameterIndex] == argument;
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::bindRootArgument(uint32_t rootParameterIndex, uint64_t argument)
+{
+    mRootArguments[rootParameterIndex] = argument;
+    mBoundRootArguments |= uint64_t{ 1 } << rootParameterIndex;
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::setGraphicsRootDescriptorTable(uint32_t rootParameterIndex,
+                                                                    D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+{
+    if (count(isRootArgumentBound(rootParameterIndex, baseDescriptor.ptr))) return;
+    mCommandList->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+    bindRootArgument(rootParameterIndex, baseDescriptor.ptr);
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::setGraphicsRootConstantBufferView(uint32_t rootParameterIndex,
+                                                                       D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+    if (count(isRootArgumentBound(rootParameterIndex, bufferLocation))) return;
+    mCommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+    bindRootArgument(rootParameterIndex, bufferLocation);
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::setGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t numValues,
+                                                                   const void* pData)
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(rootParameterIndex < MAX_ROOT_PARAMETERS, TEXT("root parameter index out of range\n"));
+#endif
+    count(false);
+    mCommandList->SetGraphicsRoot32BitConstants(rootParameterIndex, numValues, pData, 0);
+    mBoundRootArguments &= ~(uint64_t{ 1 } << rootParameterIndex);
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::setGraphicsRootShaderResourceView(uint32_t rootParameterIndex,
+                                                                       D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+    if (count(isRootArgumentBound(rootParameterIndex, bufferLocation))) return;
+    mCommandList->SetGraphicsRootShaderResourceView(rootParameterIndex, bufferLocation);
+    bindRootArgument(rootParameterIndex, bufferLocation);
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::setPipelineState(ID3D12PipelineState* pPipelineState)
+{
+    if (count(pPipelineState == mPipelineState)) return;
+    mCommandList->SetPipelineState(pPipelineState);
+    mPipelineState = pPipelineState;
+}
+
+// forwards the whole range when any of its slots differs, slots are never split into several calls
+template <typename CommandList>
+void CommandStateCache<CommandList>::setVertexBuffers(uint32_t startSlot, uint32_t numViews,
+                                                      const D3D12_VERTEX_BUFFER_VIEW* pViews)
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(startSlot + numViews <= MAX_VERTEX_BUFFERS, TEXT("vertex buffer slot out of range\n"));
+#endif
+    bool isRedundant = true;
+    for (uint32_t i = 0; i < numViews && isRedundant; ++i)
+    {
+        const D3D12_VERTEX_BUFFER_VIEW& bound = mVertexBuffers[startSlot + i];
+        isRedundant = (mBoundVertexBuffers >> (startSlot + i) & 1) && bound.BufferLocation == pViews[i].BufferLocation &&
+                      bound.SizeInBytes == pViews[i].SizeInBytes && bound.StrideInBytes == pViews[i].StrideInBytes;
+    }
+    if (count(isRedundant)) return;
+    mCommandList->IASetVertexBuffers(startSlot, numViews, pViews);
+    for (uint32_t i = 0; i < numViews; ++i)
+    {
+        mVertexBuffers[startSlot + i] = pViews[i];
+        mBoundVertexBuffers |= 1u << (startSlot + i);
+    }
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::setIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view)
+{
+    if (count(mIsIndexBufferBound && mIndexBuffer.BufferLocation == view.BufferLocation &&
+              mIndexBuffer.SizeInBytes == view.SizeInBytes && mIndexBuffer.Format == view.Format)) return;
+    mCommandList->IASetIndexBuffer(&view);
+    mIndexBuffer = view;
+    mIsIndexBufferBound = true;
+}
+
+template <typename CommandList>
+void CommandStateCache<CommandList>::setPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+{
+    if (count(topology == mTopology)) return;
+    mCommandList->IASetPrimitiveTopology(topology);
+    mTopology = topology;
+}
+
+template <typename CommandList>
+CommandList* CommandStateCache<CommandList>::commandList() const
+{
+    return mCommandList;
+}
+
+template <typename CommandList>
+const CommandStateStats& CommandStateCache<CommandList>::stats() const
+{
+    return mStats;
+}
+#endif
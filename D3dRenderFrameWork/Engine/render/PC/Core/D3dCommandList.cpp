@@ -4,6 +4,7 @@
 #include "Engine/common/Exception.h"
 #include "Engine/render/PC/Resource/D3dResource.h"
 #include "Engine/render/PC/Resource/StaticBuffer.h"
+#include "Engine/render/TextureFootprint.h"
 
 class DynamicBuffer;
 
@@ -78,6 +79,32 @@ void D3dCommandList::copyResource(StaticBuffer& dst, const D3dResource& src)
     nativePtr()->CopyResource(dst.nativePtr(), src.nativePtr());
 }
 
+// update a byte range of the default buffer
+void D3dCommandList::copyBufferRegion(StaticBuffer& dst, uint64_t dstOffset,
+                                      const D3dResource& src, uint64_t srcOffset, uint64_t size)
+{
+    transition(dst, ResourceState::COPY_DEST);
+    nativePtr()->CopyBufferRegion(dst.nativePtr(), dstOffset, src.nativePtr(), srcOffset, size);
+}
+
+// copy one subresource of a texture out of a buffer laid out by GetCopyableFootprints
+void D3dCommandList::copyTextureRegion(D3dResource& dst, uint32_t subResourceIndex,
+                                       const D3dResource& src, const SubResourceFootprint& footprint, TextureFormat format)
+{
+    transition(dst, subResourceIndex, ResourceState::COPY_DEST);
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT placedFootprint = {
+        footprint.mOffset,
+        {
+            static_cast<DXGI_FORMAT>(format),
+            footprint.mWidth, footprint.mHeight, footprint.mDepth,
+            static_cast<UINT>(footprint.mRowPitch)
+        }
+    };
+    CD3DX12_TEXTURE_COPY_LOCATION dstLocation{ dst.nativePtr(), subResourceIndex };
+    CD3DX12_TEXTURE_COPY_LOCATION srcLocation{ src.nativePtr(), placedFootprint };
+    nativePtr()->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, nullptr);
+}
+
 void D3dCommandList::close() const
 {
     nativePtr()->Close();
@@ -12,6 +12,8 @@ class D3dAllocator;
 class StaticBuffer;
 enum class ResourceState : uint32_t;
 class D3dResource;
+struct SubResourceFootprint;
+enum class TextureFormat : uint8_t;
 
 class Fence : public D3dObject
 {
@@ -45,6 +47,10 @@ public:
     void transition(D3dResource& resource, ResourceState dstState);
     void copyResource(StaticBuffer& dst,
                       const D3dResource& src);
+    void copyBufferRegion(StaticBuffer& dst, uint64_t dstOffset,
+                          const D3dResource& src, uint64_t srcOffset, uint64_t size);
+    void copyTextureRegion(D3dResource& dst, uint32_t subResourceIndex,
+                           const D3dResource& src, const SubResourceFootprint& footprint, TextureFormat format);
     void drawMeshInstanced() const;
     void drawMesh(const Mesh& meshData, const DirectX::XMMATRIX& matrix, const Material& material) const;
 
@@ -2,17 +2,43 @@
 #ifdef WIN32
 #include "D3dRenderer.h"
 #include "Engine/common/Exception.h"
+#include "Engine/common/RadixSort.h"
+#include "Engine/common/StreamCopy.h"
+#include "Engine/math/FrustumCulling.h"
+#include "Engine/math/TransformBatch.h"
 #include "Engine/render/PC/D3dUtil.h"
 #include "Engine/render/PC/Core/D3dContext.h"
 #include "Engine/render/PC/Resource/D3dAllocator.h"
 #include "Engine/render/PC/Resource/DynamicBuffer.h"
 #include "Engine/render/PC/Resource/RenderItem.h"
+#include "Engine/render/PC/Resource/RenderScene.h"
 #include "Engine/render/PC/Resource/RenderTexture.h"
 #include "Engine/render/PC/Resource/Shader.h"
+#include "Engine/render/RawTexture.h"
+#include "Engine/render/TextureFootprint.h"
 
 #undef max
 #undef min
 
+namespace
+{
+    // root parameters of the global root signature
+    constexpr uint32_t PASS_CONSTANTS_ROOT_INDEX = 0;
+    constexpr uint32_t INSTANCES_ROOT_INDEX = 1;
+    constexpr uint32_t OBJECT_CONSTANTS_ROOT_INDEX = 2;     // one per per object register
+    // a root signature holds 64 dwords, a table takes one and a root descriptor two
+    constexpr uint32_t MAX_ROOT_SIGNATURE_DWORDS = 64;
+
+    // XMMATRIX and Matrix4x4 share the row vector convention and the layout
+    Matrix4x4 ToMatrix4x4(DirectX::FXMMATRIX matrix)
+    {
+        static_assert(sizeof(DirectX::XMMATRIX) == sizeof(Matrix4x4), "matrix layouts differ");
+        Matrix4x4 result;
+        memcpy(&result, &matrix, sizeof(result));
+        return result;
+    }
+}
+
 Renderer* Renderer::sRenderer()
 {
     return D3dRenderer::sD3dRenderer();
@@ -142,11 +168,6 @@ uint64_t D3dRenderer::sCalcPassCbvStartIdx(const GraphicSetting& graphicSettings
     return cpuWorkingPageIdx * graphicSettings.mNumPassConstants;
 }
 
-uint64_t D3dRenderer::sCalcObjectCbvStartIdx(const GraphicSetting& graphicSettings, uint8_t cpuWorkingPageIdx)
-{
-    return cpuWorkingPageIdx * graphicSettings.mMaxRenderItemsPerFrame * graphicSettings.mNumPerObjectConstants + graphicSettings.mNumPassConstants * graphicSettings.mNumBackBuffers;
-}
-
 void D3dRenderer::createRootSignature()
 {
     // CD3DX12_DESCRIPTOR_RANGE1 range;
@@ -157,17 +178,30 @@ void D3dRenderer::createRootSignature()
     // desc.Init_1_1(1, &rootParam, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
     //
     std::vector<CD3DX12_DESCRIPTOR_RANGE1> ranges1;
-    std::vector<CD3DX12_DESCRIPTOR_RANGE1> ranges2;
     std::vector<CD3DX12_ROOT_PARAMETER1> rootParams;
     
-    // TODO: remove magic number
     ranges1.resize(1);
-    ranges2.resize(1);
-    rootParams.resize(2);
+    rootParams.resize(OBJECT_CONSTANTS_ROOT_INDEX + mGraphicSettings.mNumPerObjectConstants);
     ranges1[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, mGraphicSettings.mNumPassConstants, 0);
-    rootParams[0].InitAsDescriptorTable(ranges1.size(), ranges1.data());
-    ranges2[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, mGraphicSettings.mNumPerObjectConstants, mGraphicSettings.mNumPassConstants);
-    rootParams[1].InitAsDescriptorTable(ranges2.size(), ranges2.data());
+    rootParams[PASS_CONSTANTS_ROOT_INDEX].InitAsDescriptorTable(ranges1.size(), ranges1.data());
+    // instance transforms at t0, the address points at the first instance of the draw
+    rootParams[INSTANCES_ROOT_INDEX].InitAsShaderResourceView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE,
+                                                              D3D12_SHADER_VISIBILITY_VERTEX);
+    // per object registers follow the pass registers. small ones are root constants, the rest root cbvs into the
+    // frame's constant ring, draws need no descriptors either way
+    for (uint32_t i = 0; i < mGraphicSettings.mNumPerObjectConstants; ++i)
+    {
+        uint32_t shaderRegister = static_cast<uint32_t>(mGraphicSettings.mNumPassConstants + i);
+        if (mObjectRootConstants[i])
+        {
+            rootParams[OBJECT_CONSTANTS_ROOT_INDEX + i].InitAsConstants(mObjectRootConstants[i], shaderRegister);
+        }
+        else
+        {
+            rootParams[OBJECT_CONSTANTS_ROOT_INDEX + i].InitAsConstantBufferView(shaderRegister, 0,
+                D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
+        }
+    }
     
     auto&& staticSamplers = sGetStaticSamplers();
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC desc;
@@ -206,6 +240,10 @@ void D3dRenderer::initializeImpl(HWND hWindow)
     DXGI_SWAP_CHAIN_DESC1 desc;
     mSwapChain->GetDesc1(&desc);
 
+    // nothing is reflected yet, every per object register starts out as a root cbv
+    mObjectRootConstants.assign(mGraphicSettings.mNumPerObjectConstants, 0);
+    mObjectConstantsSizes.assign(mGraphicSettings.mNumPerObjectConstants, 0);
+    mPipelineGeneration = 0;
     createRootSignature();
 
     mRtDescHeap.reset(mD3dContext->createDescriptorHeap(
@@ -216,7 +254,7 @@ void D3dRenderer::initializeImpl(HWND hWindow)
         mGraphicSettings.mMaxNumRenderTarget));
     mCbSrUaDescHeap.reset(mD3dContext->createDescriptorHeap(
         D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
-        mGraphicSettings.mNumBackBuffers * (mGraphicSettings.mNumPassConstants + mGraphicSettings.mMaxRenderItemsPerFrame * mGraphicSettings.mNumPerObjectConstants)));
+        mGraphicSettings.mNumBackBuffers * mGraphicSettings.mNumPassConstants));
 
     // TODO: 
     D3D12_CPU_DESCRIPTOR_HANDLE descHandle = mRtDescHeap->cpuHandle(0);
@@ -250,87 +288,361 @@ void D3dRenderer::initializeImpl(HWND hWindow)
     D3dCommandListPool::initialize(*mD3dContext, mGraphicSettings.mNumBackBuffers);
     mAllocator = D3dAllocator{mD3dContext.get()};
 
-    mPassConstantsData.resize(mGraphicSettings.mNumPassConstants);
+    // every pass register gets a fixed slot in the arena and in the pass buffers of every frame, so updates
+    // never allocate
+    uint64_t passSlotSize = passConstantsSlotSize();
+    mPassConstantsArena.assign(passSlotSize * mGraphicSettings.mNumPassConstants, 0);
+    mPassConstantsSizes.assign(mGraphicSettings.mNumPassConstants, 0);
+    mPassConstantsVersions.assign(mGraphicSettings.mNumPassConstants, 0);
     mReleasingResources = new std::vector<uint64_t>[mGraphicSettings.mNumBackBuffers];
     mRenderData = new RenderData[mGraphicSettings.mNumBackBuffers];
+    for (int i = 0; i < mGraphicSettings.mNumBackBuffers; ++i)
+    {
+        RenderData& renderData = mRenderData[i];
+        renderData.mFrameConstants = ConstantRing{ &mAllocator, mGraphicSettings.mConstantRingPageSize };
+        renderData.mPassConstantsVersions.assign(mGraphicSettings.mNumPassConstants, 0);
+        renderData.mConstantsBuffers.resize(mGraphicSettings.mNumPassConstants);
+        for (uint32_t j = 0; j < mGraphicSettings.mNumPassConstants; ++j)
+        {
+            auto& cb = renderData.mConstantsBuffers[j];
+            cb = mAllocator.allocDynamicBuffer(passSlotSize);
+            D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc{ cb->gpuHandle(), static_cast<uint32_t>(passSlotSize) };
+            mD3dContext->deviceHandle()->CreateConstantBufferView(
+                &cbvDesc, mCbSrUaDescHeap->cpuHandle(mGraphicSettings.mNumPassConstants * i + j));
+        }
+    }
 }
 
-void D3dRenderer::registerShaders(const std::vector<Shader*>& shaders)
+uint64_t D3dRenderer::passConstantsSlotSize() const
+{
+    return std::max<uint64_t>(::AlignUpToMul<uint64_t, 256>()(mGraphicSettings.mMaxPassConstantsSize), 256);
+}
+
+// the data goes to the arena and the pass buffer of the frame being recorded next, the other frames copy it from
+// the arena when they come around with an older version
+void D3dRenderer::updatePassConstants(uint8_t registerIndex, const void* pData, uint64_t size)
+{
+#if defined(DEBUG) || defined(_DEBUG)
+    ASSERT(registerIndex < mGraphicSettings.mNumPassConstants, TEXT("register of pass constants buffer exceeded."));
+    ASSERT(size <= mGraphicSettings.mMaxPassConstantsSize, TEXT("pass constants larger than mMaxPassConstantsSize\n"));
+#endif
+    memcpy(mPassConstantsArena.data() + registerIndex * passConstantsSlotSize(), pData, size);
+    mPassConstantsSizes[registerIndex] = size;
+    uint64_t version = ++mPassConstantsVersions[registerIndex];
+
+    // writing the working page's buffer in place needs the gpu to be done with it. onRender starts by waiting until
+    // the copy and graphics queues are idle, so only the frame submitted last can still run, and it used the page
+    // before this one. the version stamps rely on it: a page is refreshed when onRender records it next, which
+    // breaks once frames may overlap the page being written.
+    RenderData& renderData = mRenderData[mCpuWorkingPageIdx];
+    StreamCopy(renderData.mConstantsBuffers[registerIndex]->mappedPointer(), pData, size);
+    renderData.mPassConstantsVersions[registerIndex] = version;
+}
+
+void D3dRenderer::updateBufferRange(const ResourceHandle& resourceHandle, uint64_t offset, const void* data, uint64_t size)
+{
+#if defined(DEBUG) || defined(_DEBUG)
+    ASSERT(dynamic_cast<StaticBuffer*>(mResources[resourceHandle.mIndex]), TEXT("range update of a buffer that is not static\n"));
+    ASSERT(offset + size <= mResources[resourceHandle.mIndex]->size(), TEXT("range update past the end of the buffer\n"));
+#endif
+    if (size == 0) return;
+    uint64_t dataOffset = mBufferUpdateData.size();
+    mBufferUpdateData.resize(dataOffset + size);
+    memcpy(mBufferUpdateData.data() + dataOffset, data, size);
+    mBufferUpdates.push_back({ resourceHandle.mIndex, offset, dataOffset, size });
+}
+
+// the dirty ranges of every buffer are merged where they overlap or touch and staged in the frame's constant ring,
+// one copy per merged range in a single copy submission the graphics queue waits for
+void D3dRenderer::flushBufferUpdates(RenderData& renderData)
+{
+    if (mBufferUpdates.empty()) return;
+    // the updates of a buffer next to each other, still in call order
+    std::stable_sort(mBufferUpdates.begin(), mBufferUpdates.end(),
+                     [](const BufferUpdate& a, const BufferUpdate& b) { return a.mResource < b.mResource; });
+
+    const std::vector<uint64_t>& releasedResources = mReleasingResources[mGraphicSettings.mNumBackBuffers];
+    D3dCommandList* pCommandList = D3dCommandListPool::getCommandList(D3dCommandListType::COPY);
+    uint64_t numCopies = 0;
+    uint64_t first = 0;
+    while (first < mBufferUpdates.size())
+    {
+        uint64_t resource = mBufferUpdates[first].mResource;
+        uint64_t last = first + 1;
+        while (last < mBufferUpdates.size() && mBufferUpdates[last].mResource == resource) ++last;
+        // released before this frame, the buffer is gone at its end
+        if (std::find(releasedResources.begin(), releasedResources.end(), resource) != releasedResources.end())
+        {
+            first = last;
+            continue;
+        }
+
+        mDirtyRanges.clear();
+        for (uint64_t i = first; i < last; ++i)
+        {
+            const BufferUpdate& update = mBufferUpdates[i];
+            mDirtyRanges.push_back({ update.mDstOffset, update.mDstOffset + update.mSize, 0 });
+        }
+        std::sort(mDirtyRanges.begin(), mDirtyRanges.end(),
+                  [](const DirtyRange& a, const DirtyRange& b) { return a.mBegin < b.mBegin; });
+        uint64_t numRanges = 0;
+        uint64_t stagingSize = 0;
+        for (const DirtyRange& range : mDirtyRanges)
+        {
+            if (numRanges > 0 && range.mBegin <= mDirtyRanges[numRanges - 1].mEnd)
+            {
+                DirtyRange& merged = mDirtyRanges[numRanges - 1];
+                stagingSize += (std::max)(merged.mEnd, range.mEnd) - merged.mEnd;
+                merged.mEnd = (std::max)(merged.mEnd, range.mEnd);
+                continue;
+            }
+            mDirtyRanges[numRanges++] = { range.mBegin, range.mEnd, stagingSize };
+            stagingSize += range.mEnd - range.mBegin;
+        }
+        mDirtyRanges.resize(numRanges);
+
+        // replayed in call order, the latest bytes win where updates overlap. the ranges are assembled in cached
+        // memory, the upload memory is written once
+        mDirtyRangeData.resize(stagingSize);
+        for (uint64_t i = first; i < last; ++i)
+        {
+            const BufferUpdate& update = mBufferUpdates[i];
+            auto range = std::upper_bound(mDirtyRanges.begin(), mDirtyRanges.end(), update.mDstOffset,
+                                          [](uint64_t offset, const DirtyRange& r) { return offset < r.mBegin; }) - 1;
+            memcpy(mDirtyRangeData.data() + range->mStagingOffset + (update.mDstOffset - range->mBegin),
+                   mBufferUpdateData.data() + update.mDataOffset, update.mSize);
+        }
+        ConstantAllocation staging = renderData.mFrameConstants.allocate(stagingSize);
+        StreamWrite(staging.mCpuAddress, mDirtyRangeData.data(), stagingSize);
+
+        StaticBuffer* pBuffer = dynamic_cast<StaticBuffer*>(mResources[resource]);
+        for (const DirtyRange& range : mDirtyRanges)
+        {
+            pCommandList->copyBufferRegion(*pBuffer, range.mBegin, *staging.mPage, staging.mOffset + range.mStagingOffset,
+                                           range.mEnd - range.mBegin);
+        }
+        numCopies += mDirtyRanges.size();
+        first = last;
+    }
+    StreamFence();
+    mBufferUpdates.clear();
+    mBufferUpdateData.clear();
+
+    pCommandList->close();
+    if (numCopies > 0)
+    {
+        mCopyContext.executeCommandList(pCommandList);
+        mCopyQueue->Signal(mCopyFence.nativePtr(), ++mCopyFenceValue);
+        mMainGraphicQueue->Wait(mCopyFence.nativePtr(), mCopyFenceValue);
+    }
+    D3dCommandListPool::recycle(pCommandList);
+}
+
+ID3D12PipelineState* D3dRenderer::createPipelineState(Shader* shader) const
 {
     D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc{};
-    for (Shader* shader : shaders)
+    ID3DBlob* binary = const_cast<ID3DBlob*>(shader->vsBinary());
+    if (binary) psoDesc.VS = {binary->GetBufferPointer(), binary->GetBufferSize() };
+    binary = const_cast<ID3DBlob*>(shader->hsBinary());
+    if (binary) psoDesc.HS = { binary->GetBufferPointer(), binary->GetBufferSize() };
+    binary = const_cast<ID3DBlob*>(shader->dsBinary());
+    if (binary) psoDesc.DS = { binary->GetBufferPointer(), binary->GetBufferSize() };
+    binary = const_cast<ID3DBlob*>(shader->gsBinary());
+    if (binary) psoDesc.GS = { binary->GetBufferPointer(), binary->GetBufferSize() };
+    binary = const_cast<ID3DBlob*>(shader->psBinary());
+    if (binary) psoDesc.PS = { binary->GetBufferPointer(), binary->GetBufferSize() };
+
+    D3D12_INPUT_LAYOUT_DESC inputLayoutDesc = shader->inputLayout();
+    psoDesc.InputLayout = inputLayoutDesc;
+    psoDesc.pRootSignature = mGlobalRootSignature;
+    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    psoDesc.SampleMask = 0xffffffff;
+    psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC{D3D12_DEFAULT};
+
+    // rt-ds info
+    psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC1(D3D12_DEFAULT);
+    psoDesc.NumRenderTargets = 1;
+    psoDesc.RTVFormats[0] = static_cast<DXGI_FORMAT>(mGraphicSettings.mBackBufferFormat);
+    psoDesc.DSVFormat = static_cast<DXGI_FORMAT>(mGraphicSettings.mDepthStencilFormat);
+    psoDesc.SampleDesc = mGraphicSettings.mSampleDesc;
+
+    return mD3dContext->createPipelineStateObject(psoDesc);
+}
+
+// per object registers up to mMaxRootConstantsSize become root constants while the root signature has room,
+// registers no shader uses yet stay root cbvs
+std::vector<uint32_t> D3dRenderer::reflectObjectRootConstants() const
+{
+    std::vector<uint32_t> rootConstants(mGraphicSettings.mNumPerObjectConstants, 0);
+    uint32_t numDwords = 1 + 2 + 2 * static_cast<uint32_t>(mGraphicSettings.mNumPerObjectConstants);
+    for (uint32_t i = 0; i < mGraphicSettings.mNumPerObjectConstants; ++i)
     {
-        ID3DBlob* binary = const_cast<ID3DBlob*>(shader->vsBinary());
-        if (binary) psoDesc.VS = {binary->GetBufferPointer(), binary->GetBufferSize() };
-        binary = const_cast<ID3DBlob*>(shader->hsBinary());
-        if (binary) psoDesc.HS = { binary->GetBufferPointer(), binary->GetBufferSize() };
-        binary = const_cast<ID3DBlob*>(shader->dsBinary());
-        if (binary) psoDesc.DS = { binary->GetBufferPointer(), binary->GetBufferSize() };
-        binary = const_cast<ID3DBlob*>(shader->gsBinary());
-        if (binary) psoDesc.GS = { binary->GetBufferPointer(), binary->GetBufferSize() };
-        binary = const_cast<ID3DBlob*>(shader->psBinary());
-        if (binary) psoDesc.PS = { binary->GetBufferPointer(), binary->GetBufferSize() };
-
-        D3D12_INPUT_LAYOUT_DESC inputLayoutDesc = shader->inputLayout();
-        psoDesc.InputLayout = inputLayoutDesc;
-        psoDesc.pRootSignature = mGlobalRootSignature;
-        psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-        psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-        psoDesc.SampleMask = 0xffffffff;
-        psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC{D3D12_DEFAULT};
-
-        // rt-ds info
-        psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC1(D3D12_DEFAULT);
-        psoDesc.NumRenderTargets = 1;
-        psoDesc.RTVFormats[0] = static_cast<DXGI_FORMAT>(mGraphicSettings.mBackBufferFormat);
-        psoDesc.DSVFormat = static_cast<DXGI_FORMAT>(mGraphicSettings.mDepthStencilFormat);
-        psoDesc.SampleDesc = mGraphicSettings.mSampleDesc;
-
-        mPipelineStates[shader] = mD3dContext->createPipelineStateObject(psoDesc);
+        auto size = Shader::mShaderPropSizes.find(mGraphicSettings.mNumPassConstants + i);
+        if (size == Shader::mShaderPropSizes.end() || size->second > mGraphicSettings.mMaxRootConstantsSize) continue;
+        uint32_t numValues = static_cast<uint32_t>((size->second + 3) / 4);
+        // the constants replace a root cbv of two dwords
+        if (numDwords + numValues - 2 > MAX_ROOT_SIGNATURE_DWORDS) continue;
+        numDwords += numValues - 2;
+        rootConstants[i] = numValues;
     }
+    return rootConstants;
+}
 
-    uint64_t perObjectStart = mGraphicSettings.mNumBackBuffers * mGraphicSettings.mNumPassConstants;
-    for (uint32_t i = 0; i < mGraphicSettings.mNumBackBuffers; ++i)
+// the root signature follows the constant buffers reflected so far. when the shaders change its layout, the psos
+// of the shaders registered before are built again. psos are only replaced once the gpu is drained
+void D3dRenderer::registerShaders(const std::vector<Shader*>& shaders)
+{
+    std::vector<uint32_t> objectRootConstants = reflectObjectRootConstants();
+    bool layoutChanged = objectRootConstants != mObjectRootConstants;
+    bool replacesPipelines = layoutChanged || std::any_of(shaders.begin(), shaders.end(),
+        [this](Shader* shader) { return mPipelineStates.find(shader) != mPipelineStates.end(); });
+    if (replacesPipelines)
     {
-        std::vector<DynamicBuffer*>& constantBuffer = mRenderData[i].mConstantsBuffers;
-        constantBuffer.resize(mGraphicSettings.mNumPassConstants + mGraphicSettings.mMaxRenderItemsPerFrame * mGraphicSettings.mNumPerObjectConstants);
-        
-        // constants buffer footprint
-        uint8_t registerIndex = 0;
-        for (uint32_t j = 0; j < mGraphicSettings.mNumPassConstants; ++j)
+        mMainGraphicQueue->Signal(mGraphicFence.nativePtr(), ++mFrameFenceValue);
+        mGraphicFence.wait(mFrameFenceValue);
+        ++mPipelineGeneration;
+    }
+    if (layoutChanged)
+    {
+        mObjectRootConstants = std::move(objectRootConstants);
+        mGlobalRootSignature->Release();
+        createRootSignature();
+        for (auto& pipelineState : mPipelineStates)
         {
-            uint64_t size = std::max<uint64_t>(Shader::mShaderPropSizes[registerIndex + j], 256);
-            auto& cb = constantBuffer[j];
-            cb = mAllocator.allocDynamicBuffer(size);
-            D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc{ cb->gpuHandle(), static_cast<uint32_t>(size) };
-            mD3dContext->deviceHandle()->CreateConstantBufferView(
-                &cbvDesc, mCbSrUaDescHeap->cpuHandle(mGraphicSettings.mNumPassConstants * i + j));
+            pipelineState.second->Release();
+            pipelineState.second = createPipelineState(pipelineState.first);
         }
-        registerIndex = mGraphicSettings.mNumPassConstants;
-        for (uint32_t j = 0; j < mGraphicSettings.mNumPerObjectConstants; ++j)
+    }
+    for (Shader* shader : shaders)
+    {
+        auto pipelineState = mPipelineStates.find(shader);
+        if (pipelineState == mPipelineStates.end())
         {
-            uint64_t size = std::max<uint64_t>(Shader::mShaderPropSizes[registerIndex + j], 256);
-            for (uint32_t k = 0; k < mGraphicSettings.mMaxRenderItemsPerFrame; ++k)
+            mPipelineStates.emplace(shader, createPipelineState(shader));
+            continue;
+        }
+        // built for the new layout just above
+        if (layoutChanged) continue;
+        pipelineState->second->Release();
+        pipelineState->second = createPipelineState(shader);
+    }
+
+    for (uint32_t i = 0; i < mGraphicSettings.mNumPerObjectConstants; ++i)
+    {
+        auto size = Shader::mShaderPropSizes.find(mGraphicSettings.mNumPassConstants + i);
+        mObjectConstantsSizes[i] = size == Shader::mShaderPropSizes.end() ? 0 : size->second;
+    }
+
+    for (uint32_t i = 0; i < mGraphicSettings.mNumPassConstants; ++i)
+    {
+        auto size = Shader::mShaderPropSizes.find(i);
+        ASSERT(size == Shader::mShaderPropSizes.end() || size->second <= mGraphicSettings.mMaxPassConstantsSize,
+               TEXT("pass constants buffer of the shader is larger than mMaxPassConstantsSize\n"));
+    }
+}
+
+void D3dRenderer::drawScene(RenderScene& scene, DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj)
+{
+    if (scene.packetGeneration() != mPipelineGeneration) scene.rebakeDrawPackets();
+    Matrix4x4 viewMatrix = ToMatrix4x4(view);
+    mPendingViews.push_back({ &scene, viewMatrix, viewMatrix * ToMatrix4x4(proj) });
+}
+
+DrawPacket D3dRenderer::bakeDrawPacket(const MeshData& meshData, const Material* pMaterial) const
+{
+    auto pipelineState = mPipelineStates.find(pMaterial->shader);
+    ASSERT(pipelineState != mPipelineStates.end(), TEXT("shader of the material is not registered\n"));
+    ASSERT(!meshData.mSubMeshes.empty(), TEXT("mesh without sub meshes\n"));
+    uint32_t vertexSize = pMaterial->shader->vertexSize();
+    DrawPacket packet;
+    packet.mPipelineState = pipelineState->second;
+    packet.mMaterial = pMaterial;
+    packet.mVertexBuffer = {
+        mResources[meshData.mVertexBuffer.mIndex]->gpuHandle(), meshData.mVertexCount * vertexSize, vertexSize
+    };
+    packet.mIndexBuffer = {
+        mResources[meshData.mIndexBuffer.mIndex]->gpuHandle(),
+        meshData.mIndexCount * static_cast<uint32_t>(sizeof(uint32_t)), DXGI_FORMAT_R32_UINT
+    };
+    packet.mSubMesh = meshData.mSubMeshes[0];
+    packet.mNumSubMeshes = static_cast<uint32_t>(meshData.mSubMeshes.size());
+    return packet;
+}
+
+// creates a default heap texture for every raw texture and copies all of their subresources through one staging
+// buffer in a single copy queue submission. waits for the copy queue, so the textures are usable on return.
+std::vector<ResourceHandle> D3dRenderer::uploadTextures(const RawTexture* const* pTextures, uint64_t numTextures)
+{
+    std::vector<ResourceHandle> handles;
+    if (numTextures == 0) return handles;
+    handles.reserve(numTextures);
+
+    // lay every subresource of every texture out back to back in the staging buffer
+    std::vector<SubResourceFootprint> footprints;
+    std::vector<uint64_t> firstFootprints(numTextures);
+    uint64_t stagingSize = 0;
+    for (uint64_t i = 0; i < numTextures; ++i)
+    {
+        const RawTexture& texture = *pTextures[i];
+#if defined(DEBUG) or defined(_DEBUG)
+        ASSERT(texture.SampleCount() == 1, TEXT("multisampled textures can't be uploaded\n"));
+#endif
+        firstFootprints[i] = footprints.size();
+        footprints.resize(footprints.size() + GetSubResourceCount(texture));
+        stagingSize += GetCopyableFootprints(texture, stagingSize, footprints.data() + firstFootprints[i]);
+    }
+
+    DynamicBuffer* pStagingBuffer = mAllocator.allocDynamicBuffer(stagingSize);
+    byte* pStagingData = pStagingBuffer->mappedPointer();
+    D3dCommandList* pCommandList = D3dCommandListPool::getCommandList(D3dCommandListType::COPY);
+    for (uint64_t i = 0; i < numTextures; ++i)
+    {
+        const RawTexture& texture = *pTextures[i];
+        RenderTexture2D* pTexture = mAllocator.allocTexture(texture);
+        const SubResourceFootprint* pFootprints = footprints.data() + firstFootprints[i];
+        uint8_t numMips = texture.MipLevels();
+        for (uint32_t slice = 0; slice < texture.arraySize(); ++slice)
+        {
+            for (uint8_t mip = 0; mip < numMips; ++mip)
             {
-                auto& cb = constantBuffer[mGraphicSettings.mNumPassConstants + mGraphicSettings.mNumPerObjectConstants * k + j]; 
-                cb = mAllocator.allocDynamicBuffer(size);
-                D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc{ cb->gpuHandle(), static_cast<uint32_t>(size) };
-                mD3dContext->deviceHandle()->CreateConstantBufferView(
-                    &cbvDesc, mCbSrUaDescHeap->cpuHandle(perObjectStart +
-                        (i * mGraphicSettings.mNumPerObjectConstants + k) * mGraphicSettings.mNumPerObjectConstants + j)
-                        );
+                uint32_t subResourceIndex = mip + slice * numMips;
+                if (texture.layout() == TextureLayout::TILED)
+                {
+                    CopyTiledToFootprint(pFootprints[subResourceIndex], texture.subResourcePtr(mip, slice), pStagingData,
+                            GetFormatTraits(texture.Format()).mBytesPerBlock);
+                }
+                else
+                {
+                    CopyToFootprint(pFootprints[subResourceIndex], texture.subResourcePtr(mip, slice), pStagingData);
+                }
+                pCommandList->copyTextureRegion(*pTexture, subResourceIndex, *pStagingBuffer, pFootprints[subResourceIndex], texture.Format());
             }
         }
+        handles.push_back(registerResource(pTexture));
     }
+    pCommandList->close();
+    mCopyContext.executeCommandList(pCommandList);
+    mCopyQueue->Signal(mCopyFence.nativePtr(), ++mCopyFenceValue);
+    mCopyFence.wait(mCopyFenceValue);
+    D3dCommandListPool::recycle(pCommandList);
+
+    pStagingBuffer->release();
+    delete pStagingBuffer;
+    return handles;
 }
 
-void D3dRenderer::appendRenderLists(std::vector<RenderList>&& renderLists)
+ResourceHandle D3dRenderer::registerResource(D3dResource* pResource)
 {
-    mPendingRenderLists.reserve(mPendingRenderLists.size() + renderLists.size());
-    for (auto& renderList : renderLists)
+    if (mAvailableResourceAddresses.empty())
     {
-        mPendingRenderLists.push_back(renderList);
+        mResources.push_back(pResource);
+        return { mResources.size() - 1 };
     }
+    ResourceHandle resourceHandle = { mAvailableResourceAddresses.top() };
+    mAvailableResourceAddresses.pop();
+    mResources[resourceHandle.mIndex] = pResource;
+    return resourceHandle;
 }
 
 D3dRenderer::~D3dRenderer() = default;
@@ -348,6 +660,11 @@ void D3dRenderer::onRender()
     mGraphicFence.wait(mFrameFenceValue);
     
     D3dCommandListPool::sGetCommandAllocator(D3dCommandListType::DIRECT)->Reset();
+    D3dCommandListPool::sGetCommandAllocator(D3dCommandListType::COPY)->Reset();
+    // the gpu is done with the frame that used this page last
+    RenderData& renderData = mRenderData[mCpuWorkingPageIdx];
+    renderData.mFrameConstants.reset();
+    flushBufferUpdates(renderData);
 
     // ------------------------------RenderPath Input---------------------------------
     mGraphicContext.reset(mMainGraphicQueue.Get());
@@ -360,26 +677,69 @@ void D3dRenderer::onRender()
     
     // ------------------------------RenderPath Start---------------------------------
     ID3D12GraphicsCommandList* nativeCmdList = pCommandList->nativePtr();
+    CommandStateCache<ID3D12GraphicsCommandList> stateCache{ nativeCmdList };
     // fill the pass constants part of descriptors in descriptor heap.
     // total pass constants descriptor = constant count per pass * back buffer count
     // they stores in heap like below:
     // | pass0 : constant0, constant1, ... | pass1 : constant0, constant1, ... | ...
 
-    if (mNumDirtyFrames)
+    // pass buffers of this frame that missed updates since it was last recorded get the latest data
+    for (uint32_t i = 0; i < mGraphicSettings.mNumPassConstants; ++i)
     {
-        for (int i = 0; i < mGraphicSettings.mNumPassConstants; ++i)
-        {
-            auto* passConstantsBuffer = mRenderData[mCpuWorkingPageIdx].mConstantsBuffers[i];
-            memcpy(passConstantsBuffer->mappedPointer(), mPassConstantsData[i], passConstantsBuffer->size());
-        }
-        mNumDirtyFrames--;
+        if (renderData.mPassConstantsVersions[i] == mPassConstantsVersions[i]) continue;
+        StreamCopy(renderData.mConstantsBuffers[i]->mappedPointer(),
+                   mPassConstantsArena.data() + i * passConstantsSlotSize(), mPassConstantsSizes[i]);
+        renderData.mPassConstantsVersions[i] = mPassConstantsVersions[i];
     }
     
     ID3D12DescriptorHeap* heaps[] = { mCbSrUaDescHeap->nativePtr() };
-    nativeCmdList->SetDescriptorHeaps(1, heaps); // do in render
-    nativeCmdList->SetGraphicsRootSignature(mGlobalRootSignature); // do in dc
-    nativeCmdList->SetGraphicsRootDescriptorTable(0, mCbSrUaDescHeap->gpuHandle(sCalcPassCbvStartIdx(mGraphicSettings, mCpuWorkingPageIdx)));
-    nativeCmdList->SetGraphicsRootDescriptorTable(1, mCbSrUaDescHeap->gpuHandle(sCalcObjectCbvStartIdx(mGraphicSettings, mCpuWorkingPageIdx)));
+    stateCache.setDescriptorHeaps(1, heaps); // do in render
+    stateCache.setGraphicsRootSignature(mGlobalRootSignature); // do in dc
+    stateCache.setGraphicsRootDescriptorTable(PASS_CONSTANTS_ROOT_INDEX, mCbSrUaDescHeap->gpuHandle(sCalcPassCbvStartIdx(mGraphicSettings, mCpuWorkingPageIdx)));
+    
+    // the proxies of a scene are culled against the frustum of every view straight from the scene's world bounds,
+    // then put in draw key order. every visible proxy of a view owns an instance in that order, the transforms
+    // of a view are computed in one batch and written straight into its block of the frame's constant ring
+    uint64_t transformStride = sizeof(TransformBatch::ObjectMatrices);
+    mVisibleItems.clear();
+    mNumVisibleItems.clear();
+    mInstanceTransforms.clear();
+    for (const SceneView& view : mPendingViews)
+    {
+        const RenderScene& scene = *view.mScene;
+        uint64_t numProxies = scene.numProxies();
+        uint64_t firstVisible = mVisibleItems.size();
+        mVisibleItems.resize(firstVisible + numProxies);
+        uint64_t numVisible = FrustumCulling::CullAabbs(Frustum::FromViewProjection(view.mViewProjection),
+                                                        scene.worldBounds(), numProxies, mVisibleItems.data() + firstVisible);
+        mVisibleItems.resize(firstVisible + numVisible);
+        mNumVisibleItems.push_back(numVisible);
+
+        uint32_t* pVisible = mVisibleItems.data() + firstVisible;
+        FrustumCulling::AabbArrays bounds = scene.worldBounds();
+        const float (&v)[4][4] = view.mView.m;
+        mSortKeys.resize(numVisible);
+        mSortKeyScratch.resize(numVisible);
+        mSortValueScratch.resize(numVisible);
+        for (uint64_t i = 0; i < numVisible; ++i)
+        {
+            uint32_t proxyIndex = pVisible[i];
+            float depth = bounds.mCenter[0][proxyIndex] * v[0][2] + bounds.mCenter[1][proxyIndex] * v[1][2] +
+                          bounds.mCenter[2][proxyIndex] * v[2][2] + v[3][2];
+            mSortKeys[i] = DrawKey::Make(scene.stateKeys()[proxyIndex], depth);
+        }
+        RadixSort(mSortKeys.data(), pVisible, numVisible, mSortKeyScratch.data(), mSortValueScratch.data());
+
+        mWorldMatrices.resize(numVisible);
+        for (uint64_t i = 0; i < numVisible; ++i)
+        {
+            mWorldMatrices[i] = scene.worlds()[pVisible[i]];
+        }
+        ConstantAllocation transforms = renderData.mFrameConstants.allocate((std::max)(numVisible, uint64_t{ 1 }) * transformStride);
+        TransformBatch::WriteObjectMatrices(mWorldMatrices.data(), view.mViewProjection, transforms.mCpuAddress,
+                                            transformStride, numVisible);
+        mInstanceTransforms.push_back(transforms.mGpuAddress);
+    }
     
     // set render target
     D3D12_CPU_DESCRIPTOR_HANDLE hRTV = mRtDescHeap->cpuHandle(mCpuWorkingPageIdx);
@@ -388,12 +748,14 @@ void D3dRenderer::onRender()
     pCommandList->transition(mBackBuffers[mCpuWorkingPageIdx], ResourceState::RENDER_TARGET);
     
     // ----------------------------------Pass Start-----------------------------------
-    for (const auto& renderList : mPendingRenderLists)
+    uint64_t objectIndex = 0;
+    const Material* pBoundMaterial = nullptr;
+    for (uint64_t viewIndex = 0; viewIndex < mPendingViews.size(); ++viewIndex)
     {
-        TransformConstants transform{};
-        transform.mView = renderList.mView;
-        transform.mProjection = renderList.mProj;
-        // update buffers
+        const RenderScene& scene = *mPendingViews[viewIndex].mScene;
+#if defined(DEBUG) or defined(_DEBUG)
+        ASSERT(scene.packetGeneration() == mPipelineGeneration, TEXT("draw packets refer to replaced psos\n"));
+#endif
         nativeCmdList->OMSetRenderTargets(1, &hRTV, false, &hDSV);
         nativeCmdList->ClearRenderTargetView(hRTV, DirectX::Colors::LightSteelBlue, 0, nullptr);
     
@@ -402,54 +764,87 @@ void D3dRenderer::onRender()
         nativeCmdList->RSSetViewports(1, reinterpret_cast<const D3D12_VIEWPORT*>(&viewport));
         nativeCmdList->RSSetScissorRects(1, reinterpret_cast<const D3D12_RECT*>(&scissorRect));
         // ------------------------------Draw Call Begin----------------------------------
-        for (uint64_t i = 0; i < renderList.mRenderItems.size(); ++i)
+        // draws come in key order, so proxies sharing mesh and material are next to each other unless depth order
+        // separates them. every run of them is one instanced draw, its instance transforms are contiguous in the
+        // view's transform block. the packets carry everything else, the state cache drops what the previous draw bound
+        const DrawPacket* pPackets = scene.packets();
+        const uint32_t* pMeshIds = scene.meshIds();
+        uint64_t viewStart = objectIndex;
+        uint64_t viewEnd = objectIndex + mNumVisibleItems[viewIndex];
+        while (objectIndex < viewEnd)
         {
-            uint64_t objectConstantsStart = mGraphicSettings.mNumPassConstants + mGraphicSettings.mNumPerObjectConstants * i;
-            const auto& renderItem = renderList.mRenderItems[i];
-            const auto& materialConstants = renderItem.mMaterial->mConstants;
-            // copy all constants data to dynamic buffers that bound to the registers through descriptors heap.
-            // register 1 is bound to per-object transform data
-            auto& transformBuffer = mRenderData[mCpuWorkingPageIdx].mConstantsBuffers[objectConstantsStart];
-            transform.mModel = renderItem.mModel;
-            memcpy(transformBuffer->mappedPointer(), &transform, sizeof(TransformConstants));
-            // copy material data
-            for (auto& constant : materialConstants)
+            uint32_t proxyIndex = mVisibleItems[objectIndex];
+            const DrawPacket& packet = pPackets[proxyIndex];
+            uint64_t groupEnd = objectIndex + 1;
+            while (groupEnd < viewEnd)
+            {
+                uint32_t nextIndex = mVisibleItems[groupEnd];
+                // the same buffers can hold several meshes, only equal index ranges draw alike
+                if (pPackets[nextIndex].mMaterial != packet.mMaterial || pMeshIds[nextIndex] != pMeshIds[proxyIndex]) break;
+                ++groupEnd;
+            }
+            uint32_t numInstances = static_cast<uint32_t>(groupEnd - objectIndex);
+
+            stateCache.setGraphicsRootShaderResourceView(INSTANCES_ROOT_INDEX,
+                mInstanceTransforms[viewIndex] + (objectIndex - viewStart) * transformStride);
+            // material constants are written to the ring when the material changes, draws of a material in a row
+            // share them. every register of the root signature is bound, the ones the material leaves out or
+            // fills short read zeros instead of what the previous material bound
+            if (packet.mMaterial != pBoundMaterial)
             {
-                auto& constantBuffer = mRenderData[mCpuWorkingPageIdx].mConstantsBuffers[objectConstantsStart + constant.first]; 
-                memcpy(constantBuffer->mappedPointer(), constant.second.data(), constant.second.size());    // TODO: grow dynamic buffer if needed
+                for (uint32_t i = 0; i < mGraphicSettings.mNumPerObjectConstants; ++i)
+                {
+                    const std::vector<byte>* pData = nullptr;
+                    for (auto& constant : packet.mMaterial->mConstants)
+                    {
+                        if (constant.first == i) pData = &constant.second;
+                    }
+                    uint64_t dataSize = pData ? pData->size() : 0;
+                    uint32_t rootIndex = OBJECT_CONSTANTS_ROOT_INDEX + i;
+                    if (uint32_t numValues = mObjectRootConstants[i])
+                    {
+                        uint32_t values[MAX_ROOT_SIGNATURE_DWORDS] = {};
+                        if (dataSize) memcpy(values, pData->data(), (std::min)(dataSize, uint64_t{ numValues } * 4));
+                        stateCache.setGraphicsRoot32BitConstants(rootIndex, numValues, values);
+                        continue;
+                    }
+                    // the shader reads the reflected size through the root cbv, not the size of the material's block
+                    uint64_t size = mObjectConstantsSizes[i];
+                    ConstantAllocation constants = renderData.mFrameConstants.allocate((std::max)(size, ConstantRing::ALIGNMENT));
+                    uint64_t copySize = (std::min)(dataSize, size);
+                    if (copySize) StreamWrite(constants.mCpuAddress, pData->data(), copySize);
+                    if (copySize < size) memset(constants.mCpuAddress + copySize, 0, size - copySize);
+                    stateCache.setGraphicsRootConstantBufferView(rootIndex, constants.mGpuAddress);
+                }
+                StreamFence();
+                pBoundMaterial = packet.mMaterial;
             }
-            const auto& meshData = renderItem.mMeshData;
-            uint32_t vertexSize = renderItem.mMaterial->shader->vertexSize();
-            D3dResource* vertexBuffer = mResources[meshData.mVertexBuffer.mIndex];
-            D3dResource* indexBuffer = mResources[meshData.mIndexBuffer.mIndex];
-            D3D12_VERTEX_BUFFER_VIEW vBufferDesc = {
-                vertexBuffer->nativePtr()->GetGPUVirtualAddress(),
-                (meshData.mVertexCount * vertexSize), vertexSize
-            };
-            D3D12_INDEX_BUFFER_VIEW iBufferDesc = {
-                indexBuffer->nativePtr()->GetGPUVirtualAddress(),
-                meshData.mIndexCount * static_cast<uint32_t>(sizeof(uint32_t)), DXGI_FORMAT_R32_UINT
-            };
-            nativeCmdList->SetPipelineState(mPipelineStates[renderItem.mMaterial->shader]);
+            stateCache.setPipelineState(packet.mPipelineState);
             // Input Assemble
-            nativeCmdList->IASetVertexBuffers(0, 1, &vBufferDesc);
-            nativeCmdList->IASetIndexBuffer(&iBufferDesc);
-            nativeCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            stateCache.setVertexBuffers(0, 1, &packet.mVertexBuffer);
+            stateCache.setIndexBuffer(packet.mIndexBuffer);
+            stateCache.setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
             // Draw Call
-            for (const auto& subMesh : renderItem.mMeshData.mSubMeshes)
+            const SubMesh& subMesh = packet.mSubMesh;
+            nativeCmdList->DrawIndexedInstanced(subMesh.mIndexNum, numInstances, subMesh.mStartIndex, subMesh.mBaseVertex, 0);
+            for (uint32_t i = 1; i < packet.mNumSubMeshes; ++i)
             {
-                nativeCmdList->DrawIndexedInstanced(subMesh.mIndexNum, 1, subMesh.mStartIndex, subMesh.mBaseVertex, 0);
+                const SubMesh& nextSubMesh = scene.meshes()[proxyIndex].mSubMeshes[i];
+                nativeCmdList->DrawIndexedInstanced(nextSubMesh.mIndexNum, numInstances, nextSubMesh.mStartIndex,
+                                                    nextSubMesh.mBaseVertex, 0);
             }
+            objectIndex = groupEnd;
         }
         // -------------------------------Draw Call End-----------------------------------
     }
     pCommandList->transition(mBackBuffers[mCpuWorkingPageIdx], ResourceState::PRESENT);
     pCommandList->close();
+    mStateStats = stateCache.stats();
     mGraphicContext.executeCommandList(pCommandList);
     ThrowIfFailed(mSwapChain->Present(1, 0));
 
     // -------------------------------Release Resources-------------------------------
-    mPendingRenderLists.clear();
+    mPendingViews.clear();
     auto& releasingResources = mReleasingResources[mCpuWorkingPageIdx]; 
     releasingResources.clear();
     releasingResources.swap(mReleasingResources[mGraphicSettings.mNumBackBuffers]);
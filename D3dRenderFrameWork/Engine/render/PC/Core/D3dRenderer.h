@@ -5,21 +5,32 @@
 #ifdef WIN32
 #include "Engine/pch.h"
 #include "Engine/common/helper.h"
+#include "Engine/math/Matrix.h"
 #include "Engine/render/Renderer.h"
+#include "Engine/render/PC/Resource/ConstantRing.h"
 #include "Engine/render/PC/Resource/RenderTexture.h"
 #include "Engine/render/PC/Core/DescriptorHeap.h"
+#include "Engine/render/PC/Core/CommandStateCache.h"
+#include "Engine/render/PC/Core/DrawPacket.h"
 
 
 // SampleRenderPath* gSampleRenderPath();
 
 struct ShaderConstant;
-struct RenderList;
+class RenderScene;
 class Shader;
 class D3dContext;
+class RawTexture;
 
 struct RenderData
 {
+    // one buffer per pass constants register
     std::vector<DynamicBuffer*> mConstantsBuffers;
+    // version of the pass constants each buffer holds
+    std::vector<uint64_t> mPassConstantsVersions;
+    // per object data of the frame: TransformBatch::ObjectMatrices of every visible proxy in draw order, read by
+    // instance id, and the material constants of every draw, bound as root cbvs
+    ConstantRing mFrameConstants;
 };
 
 struct GraphicSetting
@@ -29,8 +40,11 @@ struct GraphicSetting
     DXGI_SAMPLE_DESC mSampleDesc = {1, 0};
     
     uint64_t mNumPassConstants = 2;
+    uint64_t mMaxPassConstantsSize = 256;       // per register
     uint64_t mNumPerObjectConstants = 2;
-    uint64_t mMaxRenderItemsPerFrame = 256;
+    uint64_t mConstantRingPageSize = 1 << 20;
+    // per object constant buffers up to this size are bound as root constants, 0 binds all of them as root cbvs
+    uint64_t mMaxRootConstantsSize = 64;
     uint64_t mNumGlobalTexture = 4;
     uint8_t mNumBackBuffers = 3;
     uint16_t mMaxNumRenderTarget = 8;
@@ -48,15 +62,28 @@ public:
     static bool sIsRenderingThread();
     static std::vector<D3D12_STATIC_SAMPLER_DESC> sGetStaticSamplers();
     static uint64_t sCalcPassCbvStartIdx(const GraphicSetting& graphicSettings, uint8_t cpuWorkingPageIdx);
-    static uint64_t sCalcObjectCbvStartIdx(const GraphicSetting& graphicSettings, uint8_t cpuWorkingPageIdx);
     
+    // builds the psos, may change the root signature layout. replacing psos drains the gpu and bumps
+    // pipelineGeneration(), scenes baked before are baked again when they are drawn next
     void registerShaders(const std::vector<Shader*>& shaders);
+    uint64_t pipelineGeneration() const;
+    // resolves the views and the pso of a draw, the buffers of the mesh and the shader must already exist
+    DrawPacket bakeDrawPacket(const MeshData& meshData, const Material* pMaterial) const;
     template<typename T, typename = std::enable_if_t<std::is_base_of_v<D3dResource, T>>> ResourceHandle allocateBuffer(uint64_t size);
-    template<typename T, typename = std::enable_if_t<std::is_base_of_v<D3dResource, T>>> void updateResource(const ResourceHandle& resourceHandle, const void* data) const;
+    template<typename T, typename = std::enable_if_t<std::is_base_of_v<D3dResource, T>>> void updateResource(const ResourceHandle& resourceHandle, const void* data);
+    // writes size bytes at offset of a static buffer. the data is copied right away, the gpu side changes with the
+    // next frame, which uploads the dirty ranges of all buffers in one copy submission
+    void updateBufferRange(const ResourceHandle& resourceHandle, uint64_t offset, const void* data, uint64_t size);
     void releaseResource(const ResourceHandle& resourceHandle) const;
-    void updatePassConstants(uint8_t registerIndex, void* pData, uint64_t size);
-    void appendRenderLists(std::vector<RenderList>&& renderLists);
+    void swapResources(const ResourceHandle& a, const ResourceHandle& b);
+    std::vector<ResourceHandle> uploadTextures(const RawTexture* const* pTextures, uint64_t numTextures);
+    void updatePassConstants(uint8_t registerIndex, const void* pData, uint64_t size);
+    // draws the scene from this camera in the next frame, the scene must stay alive and unchanged until render().
+    // draw packets baked against replaced psos are baked again
+    void drawScene(RenderScene& scene, DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj);
     void render();
+    // state calls the draw loop of the last frame issued and dropped as redundant
+    const CommandStateStats& lastFrameStateStats() const;
     void release();
     ~D3dRenderer() override;
 
@@ -69,13 +96,45 @@ public:
     DELETE_MOVE_CONSTRUCTOR(D3dRenderer)
 
 private:
+    struct SceneView
+    {
+        const RenderScene* mScene;
+        Matrix4x4 mView;
+        Matrix4x4 mViewProjection;
+    };
+
+    struct BufferUpdate
+    {
+        uint64_t mResource;
+        uint64_t mDstOffset;
+        uint64_t mDataOffset;       // in mBufferUpdateData
+        uint64_t mSize;
+    };
+
+    struct DirtyRange
+    {
+        uint64_t mBegin;
+        uint64_t mEnd;
+        uint64_t mStagingOffset;
+    };
+
     void onPreRender();
     void onRender();
     void initializeImpl(HWND hWindow);
     void createRootSignature();
+    uint64_t passConstantsSlotSize() const;
+    ID3D12PipelineState* createPipelineState(Shader* shader) const;
+    std::vector<uint32_t> reflectObjectRootConstants() const;
+    ResourceHandle registerResource(D3dResource* pResource);
+    void flushBufferUpdates(RenderData& renderData);
     D3dRenderer();
 
     ID3D12RootSignature* mGlobalRootSignature;
+    // 32 bit values of every per object register bound as root constants, 0 for the ones bound as root cbvs
+    std::vector<uint32_t> mObjectRootConstants;
+    // reflected size of every per object register, 0 when no shader declares it
+    std::vector<uint64_t> mObjectConstantsSizes;
+    uint64_t mPipelineGeneration;       // bumped whenever psos are replaced
 
     std::thread::id mRenderingThreadId;
 
@@ -98,15 +157,32 @@ private:
     D3dAllocator mAllocator;
     
     std::unordered_map<Shader*,ID3D12PipelineState*, HashPtrAsTyped<Shader*>> mPipelineStates;
-    std::vector<RenderList> mPendingRenderLists;
+    std::vector<SceneView> mPendingViews;
+    // per frame scratch of culling and the transform kernel
+    std::vector<Matrix3x4> mWorldMatrices;
+    std::vector<uint32_t> mVisibleItems;        // proxy indices of the visible proxies of every view, in draw order
+    std::vector<uint64_t> mNumVisibleItems;     // per view
+    std::vector<D3D12_GPU_VIRTUAL_ADDRESS> mInstanceTransforms;     // per view, in the frame's constant ring
+    std::vector<uint64_t> mSortKeys;
+    std::vector<uint64_t> mSortKeyScratch;
+    std::vector<uint32_t> mSortValueScratch;
+    CommandStateStats mStateStats{};
 
     // std::vector<D3dResource*>* mConstantBuffers;
-    std::vector<void*> mPassConstantsData;
+    // latest pass constants, one slot of passConstantsSlotSize() per register
+    std::vector<byte> mPassConstantsArena;
+    std::vector<uint64_t> mPassConstantsSizes;
+    std::vector<uint64_t> mPassConstantsVersions;   // bumped by every update
     RenderData* mRenderData;
-    uint8_t mNumDirtyFrames;
     std::vector<D3dResource*> mResources;
     std::stack<uint64_t> mAvailableResourceAddresses;
     std::vector<uint64_t>* mReleasingResources;
+    // static buffer updates since the last frame in call order, and their bytes
+    std::vector<BufferUpdate> mBufferUpdates;
+    std::vector<byte> mBufferUpdateData;
+    // scratch of the flush: merged ranges of a buffer and their content
+    std::vector<DirtyRange> mDirtyRanges;
+    std::vector<byte> mDirtyRangeData;
 
     RenderContext mCopyContext;
     ComPtr<ID3D12CommandQueue> mCopyQueue;
@@ -119,16 +195,14 @@ private:
     uint64_t mFrameFenceValue;
 };
 
-inline void D3dRenderer::updatePassConstants(uint8_t registerIndex, void* pData, uint64_t size)
+inline uint64_t D3dRenderer::pipelineGeneration() const
 {
-#if defined(DEBUG) || defined(_DEBUG)
-    ASSERT(registerIndex < mGraphicSettings.mNumPassConstants, TEXT("register of pass constants buffer exceeded."));
-#endif
-    byte* buffer = new byte[size];
-    memcpy(buffer, pData, size);
-    delete[] static_cast<byte*>(mPassConstantsData[registerIndex]);
-    mPassConstantsData[registerIndex] = buffer;
-    mNumDirtyFrames = 3;
+    return mPipelineGeneration;
+}
+
+inline const CommandStateStats& D3dRenderer::lastFrameStateStats() const
+{
+    return mStateStats;
 }
 
 //
@@ -162,54 +236,37 @@ inline void D3dRenderer::updatePassConstants(uint8_t registerIndex, void* pData,
 template <>
 inline ResourceHandle D3dRenderer::allocateBuffer<DynamicBuffer>(uint64_t size)
 {
-    auto dynamicBuffer = mAllocator.allocDynamicBuffer(size);
-    if (mAvailableResourceAddresses.empty())
-    {
-        mResources.push_back(dynamicBuffer);
-        return { mResources.size() - 1 };
-    }
-    ResourceHandle resourceHandle = { mAvailableResourceAddresses.top() };
-    mResources[resourceHandle.mIndex] = dynamicBuffer;
-    return resourceHandle;
+    return registerResource(mAllocator.allocDynamicBuffer(size));
 }
 
 template <>
 inline ResourceHandle D3dRenderer::allocateBuffer<StaticBuffer>(uint64_t size)
 {
-    auto staticBuffer = mAllocator.allocStaticBuffer(size);
-    if (mAvailableResourceAddresses.empty())
-    {
-        mResources.push_back(staticBuffer);
-        return { mResources.size() - 1 };
-    }
-    ResourceHandle resourceHandle = { mAvailableResourceAddresses.top() };
-    mResources[resourceHandle.mIndex] = staticBuffer;
-    return resourceHandle;
+    return registerResource(mAllocator.allocStaticBuffer(size));
 }
 
 template <>
-inline void D3dRenderer::updateResource<DynamicBuffer>(const ResourceHandle& resourceHandle, const void* data) const
+inline void D3dRenderer::updateResource<DynamicBuffer>(const ResourceHandle& resourceHandle, const void* data)
 {
     DynamicBuffer* stagingBuffer = dynamic_cast<DynamicBuffer*>(mResources[resourceHandle.mIndex]);
-    memcpy(stagingBuffer->mappedPointer(), data, stagingBuffer->size());
+    StreamCopy(stagingBuffer->mappedPointer(), data, stagingBuffer->size());
 }
 
 template <>
-inline void D3dRenderer::updateResource<StaticBuffer>(const ResourceHandle& resourceHandle, const void* data) const
+inline void D3dRenderer::updateResource<StaticBuffer>(const ResourceHandle& resourceHandle, const void* data)
 {
-    D3dCommandList* pCommandList = D3dCommandListPool::getCommandList(D3dCommandListType::COPY);
-    StaticBuffer* staticBuffer = dynamic_cast<StaticBuffer*>(mResources[resourceHandle.mIndex]);
-    uint64_t size = staticBuffer->size(); 
-    DynamicBuffer* stagingBuffer = mAllocator.allocDynamicBuffer(size);
-    memcpy(stagingBuffer->mappedPointer(), data, size);
-    pCommandList->copyResource(*staticBuffer, *stagingBuffer);
-    pCommandList->close();
-    mCopyContext.executeCommandList(pCommandList);
-    D3dCommandListPool::recycle(pCommandList);
+    updateBufferRange(resourceHandle, 0, data, mResources[resourceHandle.mIndex]->size());
 }
 
 inline void D3dRenderer::releaseResource(const ResourceHandle& resourceHandle) const
 {
     mReleasingResources[mGraphicSettings.mNumBackBuffers].push_back(resourceHandle.mIndex);
 }
+
+// exchanges the resources behind two handles, so a replacement can take over a handle that is already handed out.
+// the replaced resource ends up behind the other handle, release that one to keep it alive for the frames in flight.
+inline void D3dRenderer::swapResources(const ResourceHandle& a, const ResourceHandle& b)
+{
+    std::swap(mResources[a.mIndex], mResources[b.mIndex]);
+}
 #endif
@@ -0,0 +1,23 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+#include "Engine/render/MeshData.h"
+
+class Material;
+
+// everything a draw binds, resolved once when the proxy is registered so submission doesn't touch the resource
+// table, the pso map or the shader. one cache line per packet, only the per object slots are filled per frame.
+// the views hold gpu addresses, a packet has to be baked again when the buffers behind its mesh are swapped or
+// its shader is registered again.
+struct alignas(64) DrawPacket
+{
+    ID3D12PipelineState* mPipelineState;
+    const Material* mMaterial;                  // constants are still copied per frame, they can change any time
+    D3D12_VERTEX_BUFFER_VIEW mVertexBuffer;
+    D3D12_INDEX_BUFFER_VIEW mIndexBuffer;
+    SubMesh mSubMesh;                           // first sub mesh, the rest are read from the MeshData
+    uint32_t mNumSubMeshes;
+};
+
+static_assert(sizeof(DrawPacket) == 64, "a draw packet is meant to fill exactly one cache line");
+#endif
@@ -0,0 +1,98 @@
+// standalone check of CommandStateCache against a command list stand-in that records the calls it receives.
+// not part of the project, build it on its own: cl /std:c++17 /DWIN32 /I<repo>\D3dRenderFrameWork CommandStateCacheTest.cpp
+#include "Engine/render/PC/Core/CommandStateCache.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct RecordingCommandList
+    {
+        void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) { mCalls.push_back("heaps"); }
+        void SetGraphicsRootSignature(ID3D12RootSignature*) { mCalls.push_back("rootSignature"); }
+        void SetGraphicsRootDescriptorTable(UINT index, D3D12_GPU_DESCRIPTOR_HANDLE) { mCalls.push_back("table" + std::to_string(index)); }
+        void SetGraphicsRootConstantBufferView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS) { mCalls.push_back("cbv" + std::to_string(index)); }
+        void SetGraphicsRoot32BitConstants(UINT index, UINT, const void*, UINT) { mCalls.push_back("constants" + std::to_string(index)); }
+        void SetGraphicsRootShaderResourceView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS) { mCalls.push_back("srv" + std::to_string(index)); }
+        void SetPipelineState(ID3D12PipelineState*) { mCalls.push_back("pso"); }
+        void IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW*) { mCalls.push_back("vertexBuffer"); }
+        void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) { mCalls.push_back("indexBuffer"); }
+        void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) { mCalls.push_back("topology"); }
+
+        std::vector<std::string> mCalls;
+    };
+
+    // distinct addresses, the cache only compares them
+    template<typename T>
+    T* FakeObject(uintptr_t id)
+    {
+        return reinterpret_cast<T*>(id * 64);
+    }
+
+    int gNumFailed = 0;
+
+    void Check(bool condition, const char* pWhat)
+    {
+        if (condition) return;
+        printf("failed: %s\n", pWhat);
+        ++gNumFailed;
+    }
+}
+
+int main()
+{
+    RecordingCommandList commandList;
+    CommandStateCache<RecordingCommandList> cache{ &commandList };
+    ID3D12DescriptorHeap* pHeap = FakeObject<ID3D12DescriptorHeap>(1);
+    ID3D12PipelineState* pPipelineA = FakeObject<ID3D12PipelineState>(2);
+    ID3D12PipelineState* pPipelineB = FakeObject<ID3D12PipelineState>(3);
+    D3D12_VERTEX_BUFFER_VIEW vertexBuffer = { 0x1000, 64, 16 };
+    D3D12_INDEX_BUFFER_VIEW indexBuffer = { 0x2000, 32, DXGI_FORMAT_R32_UINT };
+    uint32_t constants = 0;
+
+    cache.setDescriptorHeaps(1, &pHeap);
+    cache.setGraphicsRootSignature(FakeObject<ID3D12RootSignature>(4));
+    cache.setGraphicsRootDescriptorTable(0, { 5 });
+    // four draws, two per pso, all on the same buffers. only the first draw of each pso changes anything
+    for (uint32_t draw = 0; draw < 4; ++draw)
+    {
+        cache.setPipelineState(draw < 2 ? pPipelineA : pPipelineB);
+        cache.setVertexBuffers(0, 1, &vertexBuffer);
+        cache.setIndexBuffer(indexBuffer);
+        cache.setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        cache.setGraphicsRootDescriptorTable(1, { draw / 2 });
+    }
+    cache.setGraphicsRootConstantBufferView(2, 0x3000);
+    cache.setGraphicsRootConstantBufferView(2, 0x3000);
+    // root constants are always forwarded and replace what the parameter held
+    cache.setGraphicsRoot32BitConstants(2, 1, &constants);
+    cache.setGraphicsRootConstantBufferView(2, 0x3000);
+    cache.setGraphicsRootShaderResourceView(1, 0x4000);
+    cache.setGraphicsRootShaderResourceView(1, 0x4000);
+    // a new root signature drops every root argument
+    cache.setGraphicsRootSignature(FakeObject<ID3D12RootSignature>(6));
+    cache.setGraphicsRootDescriptorTable(0, { 5 });
+    cache.setDescriptorHeaps(1, &pHeap);
+
+    std::vector<std::string> expected = {
+        "heaps", "rootSignature", "table0",
+        "pso", "vertexBuffer", "indexBuffer", "topology", "table1",
+        "pso", "table1",
+        "cbv2", "constants2", "cbv2", "srv1",
+        "rootSignature", "table0",
+    };
+    Check(commandList.mCalls == expected, "forwarded calls");
+    Check(cache.stats().mNumIssued == expected.size(), "issued count");
+    Check(cache.stats().mNumSkipped == 32 - expected.size(), "skipped count");
+
+    // after invalidate() the next call of every kind goes through
+    cache.invalidate();
+    commandList.mCalls.clear();
+    cache.setPipelineState(pPipelineB);
+    cache.setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    Check(commandList.mCalls == std::vector<std::string>{ "pso", "topology" }, "calls after invalidate");
+
+    if (gNumFailed == 0) printf("CommandStateCache: all checks passed\n");
+    return gNumFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#ifdef WIN32
+#include "Engine/render/PC/Resource/ConstantRing.h"
+#include "Engine/common/helper.h"
+#include "Engine/render/PC/Resource/D3dAllocator.h"
+#include "Engine/render/PC/Resource/DynamicBuffer.h"
+
+#undef max
+#undef min
+
+ConstantAllocation ConstantRing::allocate(uint64_t size)
+{
+    uint64_t alignedSize = ::AlignUpToMul<uint64_t, ALIGNMENT>()(size);
+    if (mCurrentPage < mPages.size() && mOffset > 0 && mOffset + alignedSize > mPages[mCurrentPage]->size())
+    {
+        ++mCurrentPage;
+        mOffset = 0;
+    }
+    // the pages after the current one are free, one that is too small is replaced in place
+    if (mCurrentPage == mPages.size())
+    {
+        mPages.push_back(mAllocator->allocDynamicBuffer((std::max)(mPageSize, alignedSize)));
+    }
+    else if (mPages[mCurrentPage]->size() < alignedSize)
+    {
+        delete mPages[mCurrentPage];
+        mPages[mCurrentPage] = mAllocator->allocDynamicBuffer((std::max)(mPageSize, alignedSize));
+    }
+
+    DynamicBuffer* pPage = mPages[mCurrentPage];
+    ConstantAllocation allocation = { pPage->mappedPointer() + mOffset, pPage->gpuHandle() + mOffset, pPage, mOffset };
+    mOffset += alignedSize;
+    mAllocatedSize += alignedSize;
+    return allocation;
+}
+
+void ConstantRing::reset()
+{
+    mCurrentPage = 0;
+    mOffset = 0;
+    mAllocatedSize = 0;
+}
+
+ConstantRing::ConstantRing() : mAllocator(nullptr), mPageSize(0), mCurrentPage(0), mOffset(0), mAllocatedSize(0) { }
+
+ConstantRing::ConstantRing(const D3dAllocator* pAllocator, uint64_t pageSize) :
+    mAllocator(pAllocator), mPageSize(::AlignUpToMul<uint64_t, ALIGNMENT>()(pageSize)), mCurrentPage(0), mOffset(0),
+    mAllocatedSize(0)
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(pageSize > 0, TEXT("constant ring needs a page size\n"));
+#endif
+}
+
+ConstantRing::~ConstantRing()
+{
+    release();
+}
+
+ConstantRing::ConstantRing(ConstantRing&& other) noexcept :
+    mAllocator(other.mAllocator), mPageSize(other.mPageSize), mPages(std::move(other.mPages)),
+    mCurrentPage(other.mCurrentPage), mOffset(other.mOffset), mAllocatedSize(other.mAllocatedSize)
+{
+    other.mPages.clear();
+    other.reset();
+}
+
+ConstantRing& ConstantRing::operator=(ConstantRing&& other) noexcept
+{
+    if (&other != this)
+    {
+        release();
+        mAllocator = other.mAllocator;
+        mPageSize = other.mPageSize;
+        mPages = std::move(other.mPages);
+        mCurrentPage = other.mCurrentPage;
+        mOffset = other.mOffset;
+        mAllocatedSize = other.mAllocatedSize;
+        other.mPages.clear();
+        other.reset();
+    }
+    return *this;
+}
+
+void ConstantRing::release()
+{
+    for (DynamicBuffer* pPage : mPages)
+    {
+        delete pPage;
+    }
+    mPages.clear();
+    reset();
+}
+#endif
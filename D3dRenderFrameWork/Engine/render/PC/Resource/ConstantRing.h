@@ -0,0 +1,62 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+#include "Engine/common/Exception.h"
+
+class D3dAllocator;
+class DynamicBuffer;
+
+struct ConstantAllocation
+{
+    byte* mCpuAddress;
+    D3D12_GPU_VIRTUAL_ADDRESS mGpuAddress;
+    // where it lives, for copies out of the ring
+    const DynamicBuffer* mPage;
+    uint64_t mOffset;
+};
+
+// linear allocator over persistently mapped upload pages, one ring per frame in flight. everything the cpu writes
+// for a frame (constants, instance transforms, staged buffer updates) is carved out of it at constant buffer
+// alignment and dropped as a whole by reset() once the frame's fences passed. pages are kept and reused, a frame
+// that needs more adds pages, an allocation larger than a page gets a page of its own.
+class ConstantRing
+{
+public:
+    static constexpr uint64_t ALIGNMENT = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+    ConstantAllocation allocate(uint64_t size);
+    // the gpu must be done with everything allocated since the last reset
+    void reset();
+    uint64_t numPages() const;
+    uint64_t allocatedSize() const;     // bytes handed out since the last reset, alignment included
+
+    ConstantRing();
+    ConstantRing(const D3dAllocator* pAllocator, uint64_t pageSize);
+    ~ConstantRing();
+
+    DELETE_COPY_CONSTRUCTOR(ConstantRing)
+    DELETE_COPY_OPERATOR(ConstantRing)
+    ConstantRing(ConstantRing&& other) noexcept;
+    ConstantRing& operator=(ConstantRing&& other) noexcept;
+
+private:
+    void release();
+
+    const D3dAllocator* mAllocator;
+    uint64_t mPageSize;
+    std::vector<DynamicBuffer*> mPages;
+    uint64_t mCurrentPage;
+    uint64_t mOffset;                   // in the current page
+    uint64_t mAllocatedSize;
+};
+
+inline uint64_t ConstantRing::numPages() const
+{
+    return mPages.size();
+}
+
+inline uint64_t ConstantRing::allocatedSize() const
+{
+    return mAllocatedSize;
+}
+#endif
@@ -49,6 +49,21 @@ uint64_t D3dAllocator::allocRenderTexture2D(uint64_t width,
         });
 }
 
+// render layer use only
+// default heap texture matching the description of a cpu side texture, fill it through the copy queue
+RenderTexture2D* D3dAllocator::allocTexture(const Texture& texture) const
+{
+    DXGI_FORMAT format = static_cast<DXGI_FORMAT>(texture.Format());
+    const D3D12_RESOURCE_DESC desc = texture.Type() == TextureType::TEXTURE_3D ?
+        CD3DX12_RESOURCE_DESC::Tex3D(format, texture.Width(), static_cast<UINT>(texture.Height()),
+                static_cast<UINT16>(texture.Depth()), texture.MipLevels()) :
+        CD3DX12_RESOURCE_DESC::Tex2D(format, texture.Width(), static_cast<UINT>(texture.Height()),
+                static_cast<UINT16>(texture.Depth()), texture.MipLevels(),
+                texture.SampleCount(), texture.SampleQuality());
+    return new RenderTexture2D{ createD3dResource(D3D12_HEAP_FLAG_NONE,
+            CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), desc) };
+}
+
 D3dAllocator::~D3dAllocator() = default;
 
 D3dResource D3dAllocator::createD3dResource(D3D12_HEAP_FLAGS heapFlags, const D3D12_HEAP_PROPERTIES& heapProp,
@@ -11,6 +11,7 @@ class DynamicBuffer;
 enum class TextureType : uint8_t;
 enum class TextureFormat : uint8_t;
 class RenderTexture2D;
+class Texture;
 
 class D3dAllocator
 {
@@ -19,6 +20,7 @@ public:
     RenderTexture2D* allocDepthStencilResource(uint64_t width, uint64_t height, TextureFormat format) const;
     DynamicBuffer* allocDynamicBuffer(uint64_t size) const;
     StaticBuffer* allocStaticBuffer(uint64_t size) const;
+    RenderTexture2D* allocTexture(const Texture& texture) const;
     uint64_t allocRenderTexture2D(uint64_t width, uint64_t height, uint32_t arraySize, TextureFormat format, uint8_t numMips = 1, uint8_t sampleCount = 1, uint8_t sampleQuality = 0, bool isDynamic = false, bool allowSimultaneous = false) const;
     D3dAllocator();
     D3dAllocator(D3dContext* pContext);
@@ -66,6 +66,7 @@ public:
 private:
     uint64_t mNumSubResource;
     ResourceState* mResourceStates;
+    mutable uint64_t mSize;     // 0 until first queried
 };
 
 struct ResourceHandle
@@ -92,8 +93,10 @@ inline D3D12_GPU_VIRTUAL_ADDRESS D3dResource::gpuHandle() const
     return nativePtr()->GetGPUVirtualAddress();
 }
 
+// the footprint query walks the driver, so the result is cached
 inline uint64_t D3dResource::size() const
 {
+    if (mSize) return mSize;
     uint64_t size;
     auto desc = nativePtr()->GetDesc();
     device()->GetCopyableFootprints(
@@ -106,6 +109,7 @@ inline uint64_t D3dResource::size() const
         nullptr,      // pRowSizeInBytes (optional)
         &size  // 输出总大小
     );
+    mSize = size;
     return size;
 }
 
@@ -130,12 +134,13 @@ inline D3dResource::~D3dResource()
     D3dResource::release();
 }
 
-inline D3dResource::D3dResource() : D3dObject(nullptr), mNumSubResource(0), mResourceStates(nullptr) { }
+inline D3dResource::D3dResource() : D3dObject(nullptr), mNumSubResource(0), mResourceStates(nullptr), mSize(0) { }
 
-inline D3dResource::D3dResource(D3dResource&& other) noexcept : D3dObject(std::move(other)), mNumSubResource(other.mNumSubResource), mResourceStates(other.mResourceStates)
+inline D3dResource::D3dResource(D3dResource&& other) noexcept : D3dObject(std::move(other)), mNumSubResource(other.mNumSubResource), mResourceStates(other.mResourceStates), mSize(other.mSize)
 {
     other.mResourceStates = nullptr;
     other.mNumSubResource = 0;
+    other.mSize = 0;
 }
 
 inline bool D3dResource::operator==(const D3dResource& other) const noexcept
@@ -155,8 +160,10 @@ inline D3dResource& D3dResource::operator=(D3dResource&& other) noexcept
         D3dObject::operator=(std::move(other));
         mResourceStates = other.mResourceStates;
         mNumSubResource = other.mNumSubResource;
+        mSize = other.mSize;
         other.mResourceStates = nullptr;
         other.mNumSubResource = 0;
+        other.mSize = 0;
     }
     return *this;
 }
@@ -166,7 +173,8 @@ inline D3dResource::D3dResource(ID3D12Resource* pResource,
                                 ResourceState initialState) :
         D3dObject(pResource),
         mNumSubResource(subResourceCount),
-        mResourceStates(new ResourceState[subResourceCount])
+        mResourceStates(new ResourceState[subResourceCount]),
+        mSize(0)
 {
     for (int i = 0; i < subResourceCount; ++i)
     {
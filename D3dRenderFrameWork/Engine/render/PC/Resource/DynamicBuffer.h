@@ -2,6 +2,7 @@
 #include "Engine/common/Exception.h"
 #ifdef WIN32
 #include "Engine/pch.h"
+#include "Engine/common/StreamCopy.h"
 #include "Engine/render/PC/Resource/D3dResource.h"
 
 class DynamicBuffer : public D3dResource
@@ -24,7 +25,7 @@ public:
 	DELETE_COPY_OPERATOR(DynamicBuffer)
 	
 private:
-	byte* mBufferMapper;
+	byte* mBufferMapper = nullptr;
 };
 
 inline DynamicBuffer::DynamicBuffer(DynamicBuffer&& other) noexcept : D3dResource(std::move(other)), mBufferMapper(other.mBufferMapper)
@@ -37,7 +38,7 @@ inline void DynamicBuffer::updateRange(const byte* data, uint64_t startPos, uint
 #if defined(DEBUG) or defined(_DEBUG)
 	ASSERT(nativePtr(), TEXT("try to update uninitialized upload buffer\n"));
 #endif
-	memcpy(mBufferMapper + startPos, data, width);
+	StreamCopy(mBufferMapper + startPos, data, width);
 }
 
 inline uint8_t* DynamicBuffer::mappedPointer() const
@@ -55,8 +56,13 @@ inline uint64_t DynamicBuffer::size() const
 
 inline void DynamicBuffer::release()
 {
-	CD3DX12_RANGE readRange(0, 0);
-	nativePtr()->Unmap(0, &readRange);
+	if (mBufferMapper)
+	{
+		UploadMemory::Unregister(mBufferMapper);
+		CD3DX12_RANGE readRange(0, 0);
+		nativePtr()->Unmap(0, &readRange);
+		mBufferMapper = nullptr;
+	}
 	D3dResource::release();
 }
 
@@ -93,5 +99,6 @@ inline DynamicBuffer::DynamicBuffer(D3dResource&& resource) : D3dResource(std::m
 {
 	CD3DX12_RANGE readRange(0, 0);
 	ThrowIfFailed(DynamicBuffer::nativePtr()->Map(0, &readRange, reinterpret_cast<void**>(&mBufferMapper)));
+	UploadMemory::Register(mBufferMapper, size());
 }
 #endif
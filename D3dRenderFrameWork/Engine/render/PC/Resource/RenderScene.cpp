@@ -0,0 +1,210 @@
+#ifdef WIN32
+#include "Engine/render/PC/Resource/RenderScene.h"
+#include "Engine/render/PC/Core/D3dRenderer.h"
+#include <tuple>
+
+namespace
+{
+    constexpr uint32_t FREE = ~0u;
+
+    // ids stay dense, with no free id left all ids below the size of the map are taken
+    template <typename Map, typename Key>
+    uint32_t AcquireId(Map& ids, std::vector<uint32_t>& freeIds, Key&& key)
+    {
+        auto [it, inserted] = ids.try_emplace(std::forward<Key>(key));
+        if (inserted)
+        {
+            if (freeIds.empty())
+            {
+                it->second.mId = static_cast<uint32_t>(ids.size() - 1);
+            }
+            else
+            {
+                it->second.mId = freeIds.back();
+                freeIds.pop_back();
+            }
+            it->second.mNumRefs = 0;
+        }
+        ++it->second.mNumRefs;
+        return it->second.mId;
+    }
+
+    template <typename Map, typename Key>
+    void ReleaseId(Map& ids, std::vector<uint32_t>& freeIds, const Key& key)
+    {
+        auto it = ids.find(key);
+#if defined(DEBUG) or defined(_DEBUG)
+        ASSERT(it != ids.end() && it->second.mNumRefs > 0, TEXT("releasing an id no proxy holds\n"));
+#endif
+        if (--it->second.mNumRefs > 0) return;
+        freeIds.push_back(it->second.mId);
+        ids.erase(it);
+    }
+}
+
+RenderProxyHandle RenderScene::add(MeshData&& meshData, Material* pMaterial, const Matrix3x4& world)
+{
+    RenderProxyHandle proxy;
+    if (mFreeHandles.empty())
+    {
+        proxy.mIndex = static_cast<uint32_t>(mPackedIndices.size());
+        mPackedIndices.push_back(FREE);
+    }
+    else
+    {
+        proxy.mIndex = mFreeHandles.back();
+        mFreeHandles.pop_back();
+    }
+
+    uint32_t index = numProxies();
+    mPackedIndices[proxy.mIndex] = index;
+    mProxies.push_back(proxy.mIndex);
+    mNodes.push_back(FREE);
+    mMeshIdsByProxy.push_back(internMesh(meshData));
+    mPipelineShaders.push_back(nullptr);
+    mStateKeys.push_back(makeStateKey(index, pMaterial));
+    mPackets.push_back(D3dRenderer::sD3dRenderer()->bakeDrawPacket(meshData, pMaterial));
+    mMeshes.push_back(std::move(meshData));
+    mMaterials.push_back(pMaterial);
+    mWorlds.emplace_back();
+    for (auto& component : mWorldBounds) component.emplace_back();
+    updateWorld(index, world);
+    return proxy;
+}
+
+void RenderScene::remove(RenderProxyHandle proxy)
+{
+    bindTransform(proxy, TransformHierarchy::INVALID_HANDLE);
+    uint32_t index = packedIndex(proxy);
+    releaseStateIds(index);
+    ReleaseId(mMeshIds, mFreeMeshIds, MeshKey(mMeshes[index]));
+    uint32_t last = numProxies() - 1;
+    if (index != last)
+    {
+        mWorlds[index] = mWorlds[last];
+        for (auto& component : mWorldBounds) component[index] = component[last];
+        mMeshes[index] = std::move(mMeshes[last]);
+        mMaterials[index] = mMaterials[last];
+        mStateKeys[index] = mStateKeys[last];
+        mMeshIdsByProxy[index] = mMeshIdsByProxy[last];
+        mPipelineShaders[index] = mPipelineShaders[last];
+        mPackets[index] = mPackets[last];
+        mProxies[index] = mProxies[last];
+        mNodes[index] = mNodes[last];
+        mPackedIndices[mProxies[index]] = index;
+    }
+    mWorlds.pop_back();
+    for (auto& component : mWorldBounds) component.pop_back();
+    mMeshes.pop_back();
+    mMaterials.pop_back();
+    mStateKeys.pop_back();
+    mMeshIdsByProxy.pop_back();
+    mPipelineShaders.pop_back();
+    mPackets.pop_back();
+    mProxies.pop_back();
+    mNodes.pop_back();
+    mPackedIndices[proxy.mIndex] = FREE;
+    mFreeHandles.push_back(proxy.mIndex);
+}
+
+void RenderScene::setWorld(RenderProxyHandle proxy, const Matrix3x4& world)
+{
+    updateWorld(packedIndex(proxy), world);
+}
+
+void RenderScene::setMaterial(RenderProxyHandle proxy, Material* pMaterial)
+{
+    uint32_t index = packedIndex(proxy);
+    releaseStateIds(index);
+    mMaterials[index] = pMaterial;
+    mStateKeys[index] = makeStateKey(index, pMaterial);
+    mPackets[index] = D3dRenderer::sD3dRenderer()->bakeDrawPacket(mMeshes[index], pMaterial);
+}
+
+void RenderScene::rebakeDrawPackets()
+{
+    D3dRenderer* pRenderer = D3dRenderer::sD3dRenderer();
+    for (uint32_t i = 0; i < numProxies(); ++i)
+    {
+        mPackets[i] = pRenderer->bakeDrawPacket(mMeshes[i], mMaterials[i]);
+    }
+    mPacketGeneration = pRenderer->pipelineGeneration();
+}
+
+void RenderScene::bindTransform(RenderProxyHandle proxy, TransformHandle node)
+{
+    uint32_t index = packedIndex(proxy);
+    if (mNodes[index] != FREE) mNodeProxies[mNodes[index]] = FREE;
+    mNodes[index] = node.mIndex;
+    if (node == TransformHierarchy::INVALID_HANDLE) return;
+
+    if (node.mIndex >= mNodeProxies.size()) mNodeProxies.resize(node.mIndex + 1, FREE);
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(mNodeProxies[node.mIndex] == FREE, TEXT("transform already drives a render proxy\n"));
+#endif
+    mNodeProxies[node.mIndex] = proxy.mIndex;
+}
+
+// only the changed nodes are visited, the cost follows what moved and not the size of the scene
+void RenderScene::applyTransforms(const TransformHierarchy& hierarchy)
+{
+    for (TransformHandle node : hierarchy.changedNodes())
+    {
+        if (node.mIndex >= mNodeProxies.size() || mNodeProxies[node.mIndex] == FREE) continue;
+        updateWorld(mPackedIndices[mNodeProxies[node.mIndex]], hierarchy.world(node));
+    }
+}
+
+// keeps the world space aabb of the mesh bounds next to the world matrix, so culling reads the arrays as they are
+void RenderScene::updateWorld(uint32_t index, const Matrix3x4& world)
+{
+    mWorlds[index] = world;
+    const DirectX::BoundingBox& bounds = mMeshes[index].mBounds;
+    Vector3 center = world.TransformPoint({ bounds.Center.x, bounds.Center.y, bounds.Center.z });
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        mWorldBounds[axis][index] = center[axis];
+        mWorldBounds[3 + axis][index] = std::fabs(world.m[axis][0]) * bounds.Extents.x +
+            std::fabs(world.m[axis][1]) * bounds.Extents.y + std::fabs(world.m[axis][2]) * bounds.Extents.z;
+    }
+}
+
+RenderScene::MeshKey::MeshKey(const MeshData& meshData) :
+    mVertexBuffer(meshData.mVertexBuffer.mIndex), mIndexBuffer(meshData.mIndexBuffer.mIndex),
+    mVertexCount(meshData.mVertexCount), mIndexCount(meshData.mIndexCount), mSubMeshes(meshData.mSubMeshes)
+{ }
+
+bool RenderScene::MeshKey::operator<(const MeshKey& rhs) const
+{
+    if (mVertexBuffer != rhs.mVertexBuffer) return mVertexBuffer < rhs.mVertexBuffer;
+    if (mIndexBuffer != rhs.mIndexBuffer) return mIndexBuffer < rhs.mIndexBuffer;
+    if (mVertexCount != rhs.mVertexCount) return mVertexCount < rhs.mVertexCount;
+    if (mIndexCount != rhs.mIndexCount) return mIndexCount < rhs.mIndexCount;
+    return std::lexicographical_compare(mSubMeshes.begin(), mSubMeshes.end(), rhs.mSubMeshes.begin(), rhs.mSubMeshes.end(),
+        [](const SubMesh& a, const SubMesh& b)
+        {
+            return std::tie(a.mStartIndex, a.mIndexNum, a.mBaseVertex) < std::tie(b.mStartIndex, b.mIndexNum, b.mBaseVertex);
+        });
+}
+
+// meshes sharing buffers but not counts or index ranges get ids of their own
+uint32_t RenderScene::internMesh(const MeshData& meshData)
+{
+    return AcquireId(mMeshIds, mFreeMeshIds, MeshKey(meshData));
+}
+
+// takes the pipeline and material ids for the proxy at index, releaseStateIds gives them back
+uint64_t RenderScene::makeStateKey(uint32_t index, const Material* pMaterial)
+{
+    mPipelineShaders[index] = pMaterial->shader;
+    uint32_t pipeline = AcquireId(mPipelineIds, mFreePipelineIds, mPipelineShaders[index]);
+    uint32_t material = AcquireId(mMaterialIds, mFreeMaterialIds, pMaterial);
+    return DrawKey::MakeState(pMaterial->mLayer, pipeline, material, mMeshIdsByProxy[index]);
+}
+
+void RenderScene::releaseStateIds(uint32_t index)
+{
+    ReleaseId(mPipelineIds, mFreePipelineIds, mPipelineShaders[index]);
+    ReleaseId(mMaterialIds, mFreeMaterialIds, static_cast<const Material*>(mMaterials[index]));
+}
+#endif
@@ -0,0 +1,167 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+#include "Engine/common/Exception.h"
+#include "Engine/game/TransformHierarchy.h"
+#include "Engine/math/FrustumCulling.h"
+#include "Engine/render/PC/Core/DrawPacket.h"
+#include "Engine/render/PC/Resource/RenderItem.h"
+#include <map>
+
+struct RenderProxyHandle
+{
+    uint32_t mIndex;
+
+    bool operator==(const RenderProxyHandle& rhs) const { return mIndex == rhs.mIndex; }
+    bool operator!=(const RenderProxyHandle& rhs) const { return mIndex != rhs.mIndex; }
+};
+
+// retained draw data of a scene. a proxy is registered once and only touched again when its transform or material
+// changes. proxies are packed into parallel arrays (world matrix, world space aabb, mesh, material, draw packet), the
+// renderer culls and draws straight from them. removing a proxy moves the last one into its place, handles stay valid.
+class RenderScene
+{
+public:
+    static constexpr RenderProxyHandle INVALID_HANDLE = { ~0u };
+
+    RenderProxyHandle add(MeshData&& meshData, Material* pMaterial, const Matrix3x4& world);
+    void remove(RenderProxyHandle proxy);
+    void setWorld(RenderProxyHandle proxy, const Matrix3x4& world);
+    void setMaterial(RenderProxyHandle proxy, Material* pMaterial);
+    // bakes the draw packets of all proxies again, after buffers behind their meshes were swapped. the renderer
+    // calls it itself when psos were replaced since the last bake
+    void rebakeDrawPackets();
+    // D3dRenderer::pipelineGeneration() at the last rebakeDrawPackets
+    uint64_t packetGeneration() const;
+    // the proxy follows the node, applyTransforms picks up the worlds the last update of the hierarchy changed.
+    // a node drives at most one proxy, INVALID_HANDLE unbinds.
+    void bindTransform(RenderProxyHandle proxy, TransformHandle node);
+    void applyTransforms(const TransformHierarchy& hierarchy);
+    uint32_t numProxies() const;
+
+    // packed arrays, numProxies() long, entry i of every array belongs to the same proxy
+    const Matrix3x4* worlds() const;
+    FrustumCulling::AabbArrays worldBounds() const;
+    const MeshData* meshes() const;
+    Material* const* materials() const;
+    // DrawKey::MakeState of every proxy, rebuilt when its material changes
+    const uint64_t* stateKeys() const;
+    // proxies of equal ids draw the same buffers and index ranges. unlike the mesh bits of the state key these
+    // never wrap, equal ids and materials can be drawn as instances of each other
+    const uint32_t* meshIds() const;
+    // D3dRenderer::bakeDrawPacket of every proxy, baked when it's added or its material changes
+    const DrawPacket* packets() const;
+
+    RenderScene() = default;
+    DEFAULT_COPY_CONSTRUCTOR(RenderScene)
+    DEFAULT_COPY_OPERATOR(RenderScene)
+    DEFAULT_MOVE_CONSTRUCTOR(RenderScene)
+    DEFAULT_MOVE_OPERATOR(RenderScene)
+
+private:
+    // what two meshes must share to be drawn alike
+    struct MeshKey
+    {
+        uint64_t mVertexBuffer;
+        uint64_t mIndexBuffer;
+        uint32_t mVertexCount;
+        uint32_t mIndexCount;
+        std::vector<SubMesh> mSubMeshes;
+
+        explicit MeshKey(const MeshData& meshData);
+        bool operator<(const MeshKey& rhs) const;
+    };
+
+    // an id and the number of proxies holding it, the id is freed when the last one lets go
+    struct InternedId
+    {
+        uint32_t mId;
+        uint32_t mNumRefs;
+    };
+
+    uint32_t packedIndex(RenderProxyHandle proxy) const;
+    void updateWorld(uint32_t index, const Matrix3x4& world);
+    uint32_t internMesh(const MeshData& meshData);
+    uint64_t makeStateKey(uint32_t index, const Material* pMaterial);
+    void releaseStateIds(uint32_t index);
+
+    std::vector<Matrix3x4> mWorlds;
+    std::vector<float> mWorldBounds[6];         // center x, y, z, extent x, y, z
+    std::vector<MeshData> mMeshes;
+    std::vector<Material*> mMaterials;
+    std::vector<uint64_t> mStateKeys;
+    std::vector<uint32_t> mMeshIdsByProxy;
+    std::vector<const Shader*> mPipelineShaders;    // shader the pipeline id was taken for, the material's can change
+    std::vector<DrawPacket> mPackets;
+    std::vector<uint32_t> mProxies;             // handle of every packed index
+    std::vector<uint32_t> mNodes;               // bound transform of every packed index, ~0u when unbound
+
+    std::vector<uint32_t> mPackedIndices;       // by handle, ~0u for free handles
+    std::vector<uint32_t> mFreeHandles;
+    std::vector<uint32_t> mNodeProxies;         // proxy handle by transform handle, ~0u when unbound
+    // small ids for the sort keys, handed out on first use and recycled when no proxy uses them any more, so
+    // a shader, material or buffer allocated where a released one was never inherits its id
+    std::unordered_map<const Shader*, InternedId> mPipelineIds;
+    std::unordered_map<const Material*, InternedId> mMaterialIds;
+    std::map<MeshKey, InternedId> mMeshIds;
+    std::vector<uint32_t> mFreePipelineIds;
+    std::vector<uint32_t> mFreeMaterialIds;
+    std::vector<uint32_t> mFreeMeshIds;
+    uint64_t mPacketGeneration = 0;
+};
+
+inline uint32_t RenderScene::numProxies() const
+{
+    return static_cast<uint32_t>(mProxies.size());
+}
+
+inline const Matrix3x4* RenderScene::worlds() const
+{
+    return mWorlds.data();
+}
+
+inline FrustumCulling::AabbArrays RenderScene::worldBounds() const
+{
+    return {
+        { mWorldBounds[0].data(), mWorldBounds[1].data(), mWorldBounds[2].data() },
+        { mWorldBounds[3].data(), mWorldBounds[4].data(), mWorldBounds[5].data() } };
+}
+
+inline const MeshData* RenderScene::meshes() const
+{
+    return mMeshes.data();
+}
+
+inline Material* const* RenderScene::materials() const
+{
+    return mMaterials.data();
+}
+
+inline const uint64_t* RenderScene::stateKeys() const
+{
+    return mStateKeys.data();
+}
+
+inline const uint32_t* RenderScene::meshIds() const
+{
+    return mMeshIdsByProxy.data();
+}
+
+inline uint64_t RenderScene::packetGeneration() const
+{
+    return mPacketGeneration;
+}
+
+inline const DrawPacket* RenderScene::packets() const
+{
+    return mPackets.data();
+}
+
+inline uint32_t RenderScene::packedIndex(RenderProxyHandle proxy) const
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(proxy.mIndex < mPackedIndices.size() && mPackedIndices[proxy.mIndex] != ~0u, TEXT("invalid render proxy handle\n"));
+#endif
+    return mPackedIndices[proxy.mIndex];
+}
+#endif
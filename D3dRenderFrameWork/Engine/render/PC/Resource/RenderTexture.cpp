@@ -1,6 +1,8 @@
 ﻿#ifdef WIN32
 #include "Engine/render/PC/Resource/RenderTexture.h"
 #include "Engine/render/PC/Resource/DynamicBuffer.h"
+#include "Engine/render/TextureFootprint.h"
+#include "Engine/common/helper.h"
 #include "Engine/common/Exception.h"
 
 bool RenderTexture2D::allowSimultaneous() const
@@ -29,21 +31,10 @@ const byte* RenderTexture2D::subDatePtr(uint8_t mip) const
 #if defined(DEBUG) or defined(_DEBUG)
     ASSERT(isDynamic(), TEXT("Texture is static\n"))
 #endif
-    D3D12_RESOURCE_DESC desc = nativePtr()->GetDesc();
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
-    ID3D12Device* pDevice;
-    nativePtr()->GetDevice(IID_PPV_ARGS(&pDevice));
-    pDevice->GetCopyableFootprints(
-        &desc,              // 资源描述
-        mip,                // 起始 Mip Level
-        1,                  // 计算的 Mip Levels 数量
-        0,                  // 偏移量（一般为 0）
-        &footprint,         // 输出：每个 Mip Level 的内存布局信息
-        nullptr,
-        nullptr,
-        nullptr       
-    );
-    return mMappedPointer + footprint.Offset;
+    // the mip starts on the first placement boundary after the mips in front of it
+    if (mip == 0) return mMappedPointer;
+    uint64_t offset = GetCopyableFootprints(Type(), Format(), Width(), Height(), Depth(), MipLevels(), 0, mip, 0, nullptr);
+    return mMappedPointer + AlignUpToMul<uint64_t, TEXTURE_DATA_PLACEMENT_ALIGNMENT>{}(offset);
 }
 
 void RenderTexture2D::release()
@@ -58,7 +49,8 @@ void RenderTexture2D::release()
 
 RenderTexture2D::RenderTexture2D() : mMappedPointer(nullptr) { }
 
-RenderTexture2D::RenderTexture2D(D3dResource&& resource) : Texture(TextureType::TEXTURE_2D, resource.nativePtr()->GetDesc()), D3dResource(std::move(resource)), mMappedPointer(nullptr)
+// the texture type follows the dimension of the resource, volume textures share this class
+RenderTexture2D::RenderTexture2D(D3dResource&& resource) : Texture(static_cast<TextureType>(resource.nativePtr()->GetDesc().Dimension), resource.nativePtr()->GetDesc()), D3dResource(std::move(resource)), mMappedPointer(nullptr)
 {
     if (!isDynamic()) return;
     constexpr D3D12_RANGE range = {0, 0};
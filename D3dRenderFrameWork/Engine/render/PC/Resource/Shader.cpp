@@ -76,9 +76,12 @@ bool Shader::sBindShaderProps(ID3D12ShaderReflection* pReflector)
     pReflector->GetDesc(&shaderDesc);
     for (uint32_t i = 0; i < shaderDesc.ConstantBuffers; ++i)
     {
-        pReflector->GetResourceBindingDesc(i, &bindingDesc);
         auto* pBuffer = pReflector->GetConstantBufferByIndex(i);
         pBuffer->GetDesc(&bufferDesc);
+        // structured buffers are listed too, they are bound by root descriptors and take no constant slots
+        if (bufferDesc.Type != D3D_CT_CBUFFER) continue;
+        // resource bindings are numbered over all resources, not just the constant buffers
+        ThrowIfFailed(pReflector->GetResourceBindingDescByName(bufferDesc.Name, &bindingDesc));
         String bufferName = AsciiToUtf8(bindingDesc.Name);
         mPropBindingReadMutex.lock_shared();
         auto it = mShaderPropBindings.find(bufferName);
@@ -87,7 +90,7 @@ bool Shader::sBindShaderProps(ID3D12ShaderReflection* pReflector)
         {
             mPropBindingReadMutex.lock();
             mShaderPropBindings.emplace(bufferName, bindingDesc.BindPoint);
-            mShaderPropSizes.emplace(bindingDesc.BindPoint, ::AlignUpToMul<uint64_t, 256>()(bufferDesc.Size));
+            mShaderPropSizes.emplace(bindingDesc.BindPoint, bufferDesc.Size);
             mPropBindingReadMutex.unlock();
         }
         else if (it->second != bindingDesc.BindPoint)
@@ -101,7 +104,9 @@ bool Shader::sBindShaderProps(ID3D12ShaderReflection* pReflector)
 ID3DBlob* Shader::sNativeCompile(const std::string& name, const char* source, uint64_t size, const std::string& entry, ShaderType type)
 {
     // TODO: replace this
-    static constexpr char COMPILE_TARGETS[] = "vs_4_0\0hs_4_0\0ds_4_0\0gs_4_0\0ps_4_0";
+    // shader model 5.0 is the minimum, the instance transforms are a StructuredBuffer read by SV_InstanceID and 4.0
+    // has no structured buffers. shaders written for 4.0 compile under the 5.0 rules as well.
+    static constexpr char COMPILE_TARGETS[] = "vs_5_0\0hs_5_0\0ds_5_0\0gs_5_0\0ps_5_0";
     ID3DBlob* bin;
     ID3DBlob* error;
     if (FAILED(D3DCompile(source, size, name.c_str(), nullptr,
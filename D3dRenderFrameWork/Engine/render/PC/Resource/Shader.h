@@ -68,6 +68,7 @@ public:
     DELETE_COPY_OPERATOR(Shader)
 
     // TODO: make private
+    // unaligned size of every reflected constant buffer by register
     static std::unordered_map<uint64_t, uint64_t> mShaderPropSizes;
 
 private:
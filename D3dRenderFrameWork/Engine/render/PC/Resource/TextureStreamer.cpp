@@ -0,0 +1,283 @@
+#ifdef WIN32
+#include "Engine/render/PC/Resource/TextureStreamer.h"
+#include "Engine/render/PC/Core/D3dRenderer.h"
+#include "Engine/render/PC/Resource/RenderScene.h"
+#include "Engine/render/TextureFootprint.h"
+#include "Engine/render/TextureLoader.h"
+#include <cfloat>
+#include <cmath>
+
+#undef max
+#undef min
+
+// block compressed resources need whole blocks on their top mip, so a chain can't start at any mip
+bool TextureStreamer::sIsValidFirstMip(const Texture& texture, uint8_t mip)
+{
+    if (mip == 0) return true;
+    TextureFormatTraits traits = GetFormatTraits(texture.Format());
+    uint64_t width = texture.Width() >> mip;
+    uint64_t height = texture.Height() >> mip;
+    return width >= traits.mBlockWidth && height >= traits.mBlockHeight &&
+           width % traits.mBlockWidth == 0 && height % traits.mBlockHeight == 0;
+}
+
+uint8_t TextureStreamer::sGetTailMip(const Texture& texture)
+{
+    uint8_t mip = 0;
+    while (mip + 1 < texture.MipLevels() && (std::max)(texture.Width(), texture.Height()) >> mip > TAIL_SIZE) ++mip;
+    while (!sIsValidFirstMip(texture, mip)) --mip;
+    return mip;
+}
+
+// copies the chain out of the mapping, touching the mapped pages is what does the actual file io
+RawTexture TextureStreamer::sLoadMips(const RawTexture& source, uint8_t firstMip)
+{
+    uint32_t depth = source.Type() == TextureType::TEXTURE_3D ? (std::max)(source.Depth() >> firstMip, 1u) : source.Depth();
+    RawTexture mips{ source.Type(),
+            (std::max)(source.Width() >> firstMip, uint64_t{ 1 }), (std::max)(source.Height() >> firstMip, uint64_t{ 1 }), depth,
+            source.Format(), nullptr, static_cast<uint8_t>(source.MipLevels() - firstMip) };
+    for (uint32_t slice = 0; slice < source.arraySize(); ++slice)
+    {
+        for (uint8_t mip = firstMip; mip < source.MipLevels(); ++mip)
+        {
+            mips.SetSubData(static_cast<uint8_t>(mip - firstMip), slice, source.subResourcePtr(mip, slice));
+        }
+    }
+    return mips;
+}
+
+// nearest mip at or finer than the given one that a chain can start at, never coarser than the tail
+uint8_t TextureStreamer::fitMip(const StreamedTexture& texture, uint8_t mip) const
+{
+    mip = (std::min)(mip, texture.mTailMip);
+    while (!sIsValidFirstMip(*texture.mSource, mip)) --mip;
+    return mip;
+}
+
+ResourceHandle TextureStreamer::registerTexture(const String& path)
+{
+    StreamedTexture texture;
+    texture.mSource = std::make_shared<const RawTexture>(TextureLoader::Load(path));
+    const RawTexture& source = *texture.mSource;
+    texture.mTailMip = sGetTailMip(source);
+    texture.mChainSizes.resize(source.MipLevels());
+    for (uint8_t mip = 0; mip < source.MipLevels(); ++mip)
+    {
+        uint32_t depth = source.Type() == TextureType::TEXTURE_3D ? (std::max)(source.Depth() >> mip, 1u) : source.Depth();
+        uint8_t numMips = static_cast<uint8_t>(source.MipLevels() - mip);
+        texture.mChainSizes[mip] = GetCopyableFootprints(source.Type(), source.Format(),
+                (std::max)(source.Width() >> mip, uint64_t{ 1 }), (std::max)(source.Height() >> mip, uint64_t{ 1 }), depth, numMips,
+                0, GetSubResourceCount(source.Type(), depth, numMips), 0, nullptr);
+    }
+    texture.mCoverage = 0;
+    texture.mRequestedMip = texture.mTailMip;
+    texture.mResidentMip = texture.mTailMip;
+    texture.mPendingMip = texture.mTailMip;
+
+    // the tail goes up synchronously, so the handle is usable before the first update
+    RawTexture tail = sLoadMips(source, texture.mTailMip);
+    const RawTexture* pTail = &tail;
+    texture.mHandle = mRenderer->uploadTextures(&pTail, 1)[0];
+    mResidentSize += texture.mChainSizes[texture.mTailMip];
+
+    ResourceHandle handle = texture.mHandle;
+    mTextureIndices.emplace(handle.mIndex, static_cast<uint32_t>(mTextures.size()));
+    mTextures.push_back(std::move(texture));
+    return handle;
+}
+
+// the texture is assumed to wrap the bounds once, so its texels cover the projected size of the bounds
+void TextureStreamer::gatherRequests(const RenderScene& scene, DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj,
+                                     float viewportHeight)
+{
+    // pixels one unit spans at view depth one
+    float pixelsPerUnit = DirectX::XMVectorGetY(proj.r[1]) * viewportHeight * 0.5f;
+    DirectX::XMFLOAT4X4 viewMatrix;
+    DirectX::XMStoreFloat4x4(&viewMatrix, view);
+    FrustumCulling::AabbArrays bounds = scene.worldBounds();
+    for (uint32_t i = 0; i < scene.numProxies(); ++i)
+    {
+        const Material* pMaterial = scene.materials()[i];
+        if (!pMaterial || pMaterial->mTextures.empty()) continue;
+        // sphere around the world space aabb, views don't scale so only the center is transformed
+        float radius = Vector3(bounds.mExtent[0][i], bounds.mExtent[1][i], bounds.mExtent[2][i]).Length();
+        float depth = bounds.mCenter[0][i] * viewMatrix._13 + bounds.mCenter[1][i] * viewMatrix._23 +
+                      bounds.mCenter[2][i] * viewMatrix._33 + viewMatrix._43;
+        if (depth + radius <= 0) continue;
+        // measured at the nearest point of the bounds, cameras inside the bounds get full detail
+        float nearestDepth = depth - radius;
+        float coverage = nearestDepth > 0 ? 2 * radius * pixelsPerUnit / nearestDepth : FLT_MAX;
+
+        for (const auto& slot : pMaterial->mTextures)
+        {
+            auto itr = mTextureIndices.find(slot.second.mIndex);
+            if (itr == mTextureIndices.end()) continue;
+            StreamedTexture& texture = mTextures[itr->second];
+            float size = static_cast<float>((std::max)(texture.mSource->Width(), texture.mSource->Height()));
+            uint8_t mip = coverage >= size ? 0 : static_cast<uint8_t>((std::min)(std::floor(std::log2(size / coverage)), 255.0f));
+            texture.mRequestedMip = (std::min)(texture.mRequestedMip, fitMip(texture, mip));
+            texture.mCoverage = (std::max)(texture.mCoverage, coverage);
+        }
+    }
+}
+
+void TextureStreamer::update()
+{
+    applyLoads();
+    schedule();
+}
+
+// uploads every finished chain in one batch and swaps them in behind the registered handles
+void TextureStreamer::applyLoads()
+{
+    std::vector<LoadResult> results;
+    {
+        std::lock_guard<std::mutex> lock{ mResultMutex };
+        results.swap(mResults);
+    }
+    if (results.empty()) return;
+
+    std::vector<const RawTexture*> pMips;
+    pMips.reserve(results.size());
+    for (const LoadResult& result : results)
+    {
+        pMips.push_back(&result.mMips);
+    }
+    std::vector<ResourceHandle> handles = mRenderer->uploadTextures(pMips.data(), pMips.size());
+    for (uint64_t i = 0; i < results.size(); ++i)
+    {
+        StreamedTexture& texture = mTextures[results[i].mTexture];
+        uint64_t oldSize = texture.mChainSizes[texture.mResidentMip];
+        uint64_t newSize = texture.mChainSizes[results[i].mFirstMip];
+        if (newSize > oldSize) mReservedSize -= newSize - oldSize;
+        mResidentSize = mResidentSize - oldSize + newSize;
+        texture.mResidentMip = results[i].mFirstMip;
+        texture.mPendingMip = results[i].mFirstMip;
+        mRenderer->swapResources(texture.mHandle, handles[i]);
+        mRenderer->releaseResource(handles[i]);
+    }
+}
+
+// hands the budget out by screen coverage, evictions only happen when the space is needed and are queued ahead of loads.
+// a load only starts once its growth fits next to what is resident and already in flight.
+void TextureStreamer::schedule()
+{
+    std::vector<uint32_t> order(mTextures.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+    {
+        return mTextures[a].mCoverage > mTextures[b].mCoverage;
+    });
+
+    std::vector<uint8_t> allowedMips(mTextures.size());
+    uint64_t committedSize = 0;
+    for (const StreamedTexture& texture : mTextures)
+    {
+        committedSize += texture.mChainSizes[texture.mTailMip];
+    }
+    for (uint32_t index : order)
+    {
+        const StreamedTexture& texture = mTextures[index];
+        uint64_t tailSize = texture.mChainSizes[texture.mTailMip];
+        uint8_t mip = texture.mRequestedMip;
+        while (mip < texture.mTailMip && committedSize - tailSize + texture.mChainSizes[mip] > mBudget)
+        {
+            do ++mip; while (!sIsValidFirstMip(*texture.mSource, mip));
+        }
+        committedSize += texture.mChainSizes[mip] - tailSize;
+        allowedMips[index] = mip;
+    }
+    // finer mips that are already resident stay while there is room, so looking away and back doesn't reload them
+    for (uint32_t index : order)
+    {
+        const StreamedTexture& texture = mTextures[index];
+        uint8_t mip = allowedMips[index];
+        if (texture.mResidentMip >= mip) continue;
+        uint64_t keptSize = committedSize - texture.mChainSizes[mip] + texture.mChainSizes[texture.mResidentMip];
+        if (keptSize > mBudget) continue;
+        committedSize = keptSize;
+        allowedMips[index] = texture.mResidentMip;
+    }
+
+    std::vector<LoadRequest> requests;
+    for (uint32_t index : order)
+    {
+        StreamedTexture& texture = mTextures[index];
+        uint8_t mip = allowedMips[index];
+        if (texture.mPendingMip != texture.mResidentMip || mip == texture.mResidentMip) continue;
+        if (mip > texture.mResidentMip)
+        {
+            requests.push_back({ texture.mSource, FLT_MAX, index, mip });
+        }
+        else
+        {
+            uint64_t growth = texture.mChainSizes[mip] - texture.mChainSizes[texture.mResidentMip];
+            if (mResidentSize + mReservedSize + growth > mBudget) continue;
+            mReservedSize += growth;
+            requests.push_back({ texture.mSource, texture.mCoverage * (texture.mResidentMip - mip), index, mip });
+        }
+        texture.mPendingMip = mip;
+    }
+    if (!requests.empty())
+    {
+        std::lock_guard<std::mutex> lock{ mRequestMutex };
+        for (LoadRequest& request : requests)
+        {
+            mRequests.push(std::move(request));
+        }
+    }
+    mRequestReady.notify_all();
+
+    // requests are rebuilt from scratch every frame, textures nobody looks at fall back to their tail
+    for (StreamedTexture& texture : mTextures)
+    {
+        texture.mRequestedMip = texture.mTailMip;
+        texture.mCoverage = 0;
+    }
+}
+
+void TextureStreamer::ioLoop()
+{
+    while (true)
+    {
+        LoadRequest request;
+        {
+            std::unique_lock<std::mutex> lock{ mRequestMutex };
+            mRequestReady.wait(lock, [this] { return mIsQuitting || !mRequests.empty(); });
+            if (mIsQuitting) return;
+            request = mRequests.top();
+            mRequests.pop();
+        }
+        RawTexture mips = sLoadMips(*request.mSource, request.mFirstMip);
+        std::lock_guard<std::mutex> lock{ mResultMutex };
+        mResults.push_back({ std::move(mips), request.mTexture, request.mFirstMip });
+    }
+}
+
+TextureStreamer::TextureStreamer(D3dRenderer* pRenderer, uint64_t budget, uint32_t numIoThreads) :
+    mRenderer(pRenderer), mBudget(budget), mResidentSize(0), mReservedSize(0), mIsQuitting(false)
+{
+    mIoThreads.reserve(numIoThreads);
+    for (uint32_t i = 0; i < numIoThreads; ++i)
+    {
+        mIoThreads.emplace_back(&TextureStreamer::ioLoop, this);
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock{ mRequestMutex };
+        mIsQuitting = true;
+    }
+    mRequestReady.notify_all();
+    for (std::thread& thread : mIoThreads)
+    {
+        thread.join();
+    }
+    for (const StreamedTexture& texture : mTextures)
+    {
+        mRenderer->releaseResource(texture.mHandle);
+    }
+}
+#endif
@@ -0,0 +1,106 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+#include "Engine/render/RawTexture.h"
+#include "Engine/render/PC/Resource/D3dResource.h"
+#include <condition_variable>
+
+class D3dRenderer;
+class RenderScene;
+
+// keeps every registered texture at the mip its on screen size asks for, under one vram budget.
+// the gpu texture behind a handle is swapped in place, materials keep the handle registerTexture returned.
+// mip chains are read out of the memory mapped file on background threads, uploads happen in update().
+class TextureStreamer
+{
+public:
+    // loads the mip tail right away, everything finer is streamed on demand.
+    ResourceHandle registerTexture(const String& path);
+    // collects the mips the proxies of a scene ask for when seen from view, call it for every view of the frame
+    // before update().
+    void gatherRequests(const RenderScene& scene, DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj, float viewportHeight);
+    // swaps in finished loads, then schedules loads and evictions for this frame's requests. rendering thread only.
+    void update();
+    uint64_t budget() const;
+    uint64_t residentSize() const;
+
+    TextureStreamer(D3dRenderer* pRenderer, uint64_t budget, uint32_t numIoThreads = 2);
+    ~TextureStreamer();
+
+    DELETE_COPY_CONSTRUCTOR(TextureStreamer)
+    DELETE_COPY_OPERATOR(TextureStreamer)
+    DELETE_MOVE_CONSTRUCTOR(TextureStreamer)
+    DELETE_MOVE_OPERATOR(TextureStreamer)
+
+private:
+    // mips at or below this size are always resident
+    static constexpr uint64_t TAIL_SIZE = 64;
+
+    struct StreamedTexture
+    {
+        std::shared_ptr<const RawTexture> mSource;  // shared with the io threads, read only
+        std::vector<uint64_t> mChainSizes;          // gpu bytes of the chain starting at each mip
+        ResourceHandle mHandle;
+        float mCoverage;                            // largest projected size in pixels this frame
+        uint8_t mRequestedMip;
+        uint8_t mResidentMip;
+        uint8_t mPendingMip;                        // equals mResidentMip while nothing is in flight
+        uint8_t mTailMip;
+    };
+
+    struct LoadRequest
+    {
+        std::shared_ptr<const RawTexture> mSource;
+        float mPriority;
+        uint32_t mTexture;
+        uint8_t mFirstMip;
+
+        bool operator<(const LoadRequest& other) const;
+    };
+
+    struct LoadResult
+    {
+        RawTexture mMips;
+        uint32_t mTexture;
+        uint8_t mFirstMip;
+    };
+
+    static bool sIsValidFirstMip(const Texture& texture, uint8_t mip);
+    static uint8_t sGetTailMip(const Texture& texture);
+    static RawTexture sLoadMips(const RawTexture& source, uint8_t firstMip);
+    uint8_t fitMip(const StreamedTexture& texture, uint8_t mip) const;
+    void applyLoads();
+    void schedule();
+    void ioLoop();
+
+    D3dRenderer* mRenderer;
+    std::vector<StreamedTexture> mTextures;
+    std::unordered_map<uint64_t, uint32_t> mTextureIndices;    // handle index -> texture
+    uint64_t mBudget;
+    uint64_t mResidentSize;
+    uint64_t mReservedSize;                                     // growth of the loads in flight
+
+    std::vector<std::thread> mIoThreads;
+    std::mutex mRequestMutex;
+    std::condition_variable mRequestReady;
+    std::priority_queue<LoadRequest> mRequests;
+    std::mutex mResultMutex;
+    std::vector<LoadResult> mResults;
+    bool mIsQuitting;
+};
+
+inline uint64_t TextureStreamer::budget() const
+{
+    return mBudget;
+}
+
+inline uint64_t TextureStreamer::residentSize() const
+{
+    return mResidentSize;
+}
+
+inline bool TextureStreamer::LoadRequest::operator<(const LoadRequest& other) const
+{
+    return mPriority < other.mPriority;
+}
+#endif
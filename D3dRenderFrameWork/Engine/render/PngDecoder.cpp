@@ -0,0 +1,509 @@
+#include "Engine/render/PngDecoder.h"
+
+namespace
+{
+    constexpr byte PNG_SIGNATURE[8] = { 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    constexpr uint32_t MakeChunkType(char c0, char c1, char c2, char c3)
+    {
+        return static_cast<uint32_t>(static_cast<uint8_t>(c0)) << 24 |
+               static_cast<uint32_t>(static_cast<uint8_t>(c1)) << 16 |
+               static_cast<uint32_t>(static_cast<uint8_t>(c2)) << 8 |
+               static_cast<uint32_t>(static_cast<uint8_t>(c3));
+    }
+
+    constexpr uint32_t CHUNK_IHDR = MakeChunkType('I', 'H', 'D', 'R');
+    constexpr uint32_t CHUNK_PLTE = MakeChunkType('P', 'L', 'T', 'E');
+    constexpr uint32_t CHUNK_IDAT = MakeChunkType('I', 'D', 'A', 'T');
+    constexpr uint32_t CHUNK_IEND = MakeChunkType('I', 'E', 'N', 'D');
+    constexpr uint32_t CHUNK_TRNS = MakeChunkType('t', 'R', 'N', 'S');
+    // ancillary chunks have bit 5 of their first letter set, only critical ones get their crc checked
+    constexpr uint32_t CHUNK_ANCILLARY_BIT = 0x20000000;
+
+    // x0, y0, dx, dy of the adam7 passes
+    constexpr uint8_t ADAM7[7][4] = {
+        { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+
+    uint32_t ReadBE32(const byte* pData)
+    {
+        return static_cast<uint32_t>(pData[0]) << 24 | static_cast<uint32_t>(pData[1]) << 16 |
+               static_cast<uint32_t>(pData[2]) << 8 | static_cast<uint32_t>(pData[3]);
+    }
+
+    uint16_t ReadBE16(const byte* pData)
+    {
+        return static_cast<uint16_t>(pData[0] << 8 | pData[1]);
+    }
+
+    const uint32_t* CrcTable()
+    {
+        static const std::array<uint32_t, 256> sTable = []
+        {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (uint32_t bit = 0; bit < 8; ++bit)
+                {
+                    crc = crc & 1 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+                }
+                table[i] = crc;
+            }
+            return table;
+        }();
+        return sTable.data();
+    }
+
+    uint32_t UpdateCrc(uint32_t crc, const byte* pData, uint64_t size)
+    {
+        const uint32_t* pTable = CrcTable();
+        for (uint64_t i = 0; i < size; ++i)
+        {
+            crc = pTable[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    uint8_t PaethPredictor(int a, int b, int c)
+    {
+        int p = a + b - c;
+        int pa = std::abs(p - a);
+        int pb = std::abs(p - b);
+        int pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+        if (pb <= pc) return static_cast<uint8_t>(b);
+        return static_cast<uint8_t>(c);
+    }
+
+    bool Unfilter(uint8_t filter, byte* pRow, const byte* pPrevious, uint64_t length, uint32_t bpp)
+    {
+        switch (filter)
+        {
+        case 0:
+            return true;
+        case 1:
+            for (uint64_t i = bpp; i < length; ++i) pRow[i] = static_cast<byte>(pRow[i] + pRow[i - bpp]);
+            return true;
+        case 2:
+            for (uint64_t i = 0; i < length; ++i) pRow[i] = static_cast<byte>(pRow[i] + pPrevious[i]);
+            return true;
+        case 3:
+            for (uint64_t i = 0; i < bpp && i < length; ++i) pRow[i] = static_cast<byte>(pRow[i] + (pPrevious[i] >> 1));
+            for (uint64_t i = bpp; i < length; ++i)
+            {
+                pRow[i] = static_cast<byte>(pRow[i] + ((pRow[i - bpp] + pPrevious[i]) >> 1));
+            }
+            return true;
+        case 4:
+            for (uint64_t i = 0; i < bpp && i < length; ++i) pRow[i] = static_cast<byte>(pRow[i] + pPrevious[i]);
+            for (uint64_t i = bpp; i < length; ++i)
+            {
+                pRow[i] = static_cast<byte>(pRow[i] + PaethPredictor(pRow[i - bpp], pPrevious[i], pPrevious[i - bpp]));
+            }
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // sample i of a row packed with less than 8 bits per sample, msb first
+    uint8_t PackedSample(const byte* pRow, uint32_t i, uint8_t bitDepth)
+    {
+        uint32_t bit = i * bitDepth;
+        return static_cast<uint8_t>((pRow[bit >> 3] >> (8 - bitDepth - (bit & 7))) & ((1u << bitDepth) - 1));
+    }
+
+    void StoreLE16(byte* pDst, uint16_t value)
+    {
+        pDst[0] = static_cast<byte>(value & 0xFF);
+        pDst[1] = static_cast<byte>(value >> 8);
+    }
+}
+
+bool PngDecoder::sIsPng(const byte* pHeader, uint64_t size)
+{
+    return size >= sizeof(PNG_SIGNATURE) && memcmp(pHeader, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0;
+}
+
+PngDecoder::PngDecoder() :
+    mPalette(), mCurrentRow(nullptr), mPreviousRow(nullptr), mRowStride(0), mRowFilled(0),
+    mChunkLength(0), mChunkType(0), mChunkRemaining(0), mCrc(0),
+    mPassWidth(0), mPassHeight(0), mPassRow(0), mTransparentKey(), mPaletteSize(0), mStaging(), mStagingSize(0),
+    mBitDepth(0), mColorType(0), mNumChannels(0), mPass(0),
+    mIsInterlaced(false), mHasTransparentKey(false), mIsImageDone(false), mState(State::SIGNATURE) { }
+
+PngDecoder::~PngDecoder() = default;
+
+DecodeStatus PngDecoder::fail()
+{
+    mState = State::FAILED;
+    return DecodeStatus::FAILED;
+}
+
+DecodeStatus PngDecoder::feed(const byte* pData, uint64_t size, uint64_t* pConsumed)
+{
+    const byte* p = pData;
+    const byte* pEnd = pData + size;
+    // gathers fixed size fields that may straddle two feeds
+    auto stage = [&](uint8_t count)
+    {
+        uint8_t n = static_cast<uint8_t>((std::min)(static_cast<uint64_t>(count - mStagingSize), static_cast<uint64_t>(pEnd - p)));
+        memcpy(mStaging + mStagingSize, p, n);
+        mStagingSize = static_cast<uint8_t>(mStagingSize + n);
+        p += n;
+        if (mStagingSize < count) return false;
+        mStagingSize = 0;
+        return true;
+    };
+
+    DecodeStatus status = DecodeStatus::NEED_INPUT;
+    bool isRunning = true;
+    while (isRunning)
+    {
+        switch (mState)
+        {
+        case State::SIGNATURE:
+            if (!stage(8)) { isRunning = false; break; }
+            if (!sIsPng(mStaging, 8)) { status = fail(); isRunning = false; break; }
+            mState = State::CHUNK_HEADER;
+            break;
+        case State::CHUNK_HEADER:
+        {
+            if (!stage(8)) { isRunning = false; break; }
+            mChunkLength = ReadBE32(mStaging);
+            mChunkType = ReadBE32(mStaging + 4);
+            mChunkRemaining = mChunkLength;
+            bool isFirst = mInfo.mWidth == 0;
+            bool isValid = mChunkLength < 0x80000000u && isFirst == (mChunkType == CHUNK_IHDR);
+            // chunks we keep are bounded, everything else streams through
+            if (mChunkType == CHUNK_IHDR) isValid &= mChunkLength == 13;
+            else if (mChunkType == CHUNK_PLTE) isValid &= mChunkLength <= 768 && mChunkLength % 3 == 0;
+            else if (mChunkType == CHUNK_TRNS) isValid &= mChunkLength <= 256;
+            if (!isValid) { status = fail(); isRunning = false; break; }
+
+            mCrc = UpdateCrc(0xFFFFFFFFu, mStaging + 4, 4);
+            mChunkData.clear();
+            if (mChunkType == CHUNK_IDAT && !mCurrentRow && !prepareImage())
+            {
+                status = fail();
+                isRunning = false;
+                break;
+            }
+            mState = State::CHUNK_DATA;
+            break;
+        }
+        case State::CHUNK_DATA:
+        {
+            if (mChunkType == CHUNK_IDAT && !mDestination.mData)
+            {
+                status = DecodeStatus::NEED_DESTINATION;
+                isRunning = false;
+                break;
+            }
+            uint64_t n = (std::min)(static_cast<uint64_t>(mChunkRemaining), static_cast<uint64_t>(pEnd - p));
+            if (!(mChunkType & CHUNK_ANCILLARY_BIT)) mCrc = UpdateCrc(mCrc, p, n);
+            if (mChunkType == CHUNK_IDAT)
+            {
+                if (!inflateImageData(p, n)) { status = fail(); isRunning = false; break; }
+            }
+            else if (mChunkType == CHUNK_IHDR || mChunkType == CHUNK_PLTE || mChunkType == CHUNK_TRNS)
+            {
+                mChunkData.insert(mChunkData.end(), p, p + n);
+            }
+            p += n;
+            mChunkRemaining -= static_cast<uint32_t>(n);
+            if (mChunkRemaining) { isRunning = false; break; }
+            mState = State::CHUNK_CRC;
+            break;
+        }
+        case State::CHUNK_CRC:
+        {
+            if (!stage(4)) { isRunning = false; break; }
+            if (!(mChunkType & CHUNK_ANCILLARY_BIT) && (mCrc ^ 0xFFFFFFFFu) != ReadBE32(mStaging))
+            {
+                status = fail();
+                isRunning = false;
+                break;
+            }
+            bool isValid = true;
+            if (mChunkType == CHUNK_IHDR)
+            {
+                isValid = parseHeader();
+            }
+            else if (mChunkType == CHUNK_PLTE)
+            {
+                mPaletteSize = static_cast<uint16_t>(mChunkData.size() / 3);
+                for (uint32_t i = 0; i < mPaletteSize; ++i)
+                {
+                    memcpy(&mPalette[i * 4], &mChunkData[i * 3], 3);
+                }
+            }
+            else if (mChunkType == CHUNK_TRNS)
+            {
+                if (mColorType == 3)
+                {
+                    for (uint32_t i = 0; i < mChunkData.size(); ++i) mPalette[i * 4 + 3] = mChunkData[i];
+                }
+                else if (mColorType == 0 && mChunkData.size() >= 2)
+                {
+                    mTransparentKey[0] = ReadBE16(mChunkData.data());
+                    mHasTransparentKey = true;
+                }
+                else if (mColorType == 2 && mChunkData.size() >= 6)
+                {
+                    for (uint32_t i = 0; i < 3; ++i) mTransparentKey[i] = ReadBE16(mChunkData.data() + i * 2);
+                    mHasTransparentKey = true;
+                }
+            }
+            else if (mChunkType == CHUNK_IEND)
+            {
+                isValid = mIsImageDone;
+                mState = State::DONE;
+            }
+            if (!isValid) { status = fail(); isRunning = false; break; }
+            if (mState == State::CHUNK_CRC) mState = State::CHUNK_HEADER;
+            break;
+        }
+        case State::DONE:
+            status = DecodeStatus::DONE;
+            isRunning = false;
+            break;
+        case State::FAILED:
+            status = DecodeStatus::FAILED;
+            isRunning = false;
+            break;
+        }
+    }
+    if (pConsumed) *pConsumed = static_cast<uint64_t>(p - pData);
+    return status;
+}
+
+bool PngDecoder::parseHeader()
+{
+    const byte* pHeader = mChunkData.data();
+    uint32_t width = ReadBE32(pHeader);
+    uint32_t height = ReadBE32(pHeader + 4);
+    mBitDepth = pHeader[8];
+    mColorType = pHeader[9];
+    mIsInterlaced = pHeader[12] == 1;
+    if (width == 0 || height == 0 || width > 0x7FFFFFFFu || height > 0x7FFFFFFFu) return false;
+    if (pHeader[10] != 0 || pHeader[11] != 0 || pHeader[12] > 1) return false;
+
+    bool isValidDepth;
+    switch (mColorType)
+    {
+    case 0: mNumChannels = 1; isValidDepth = mBitDepth == 1 || mBitDepth == 2 || mBitDepth == 4 || mBitDepth == 8 || mBitDepth == 16; break;
+    case 2: mNumChannels = 3; isValidDepth = mBitDepth == 8 || mBitDepth == 16; break;
+    case 3: mNumChannels = 1; isValidDepth = mBitDepth == 1 || mBitDepth == 2 || mBitDepth == 4 || mBitDepth == 8; break;
+    case 4: mNumChannels = 2; isValidDepth = mBitDepth == 8 || mBitDepth == 16; break;
+    case 6: mNumChannels = 4; isValidDepth = mBitDepth == 8 || mBitDepth == 16; break;
+    default: return false;
+    }
+    if (!isValidDepth) return false;
+
+    mInfo.mWidth = width;
+    mInfo.mHeight = height;
+    for (uint32_t i = 0; i < 256; ++i) mPalette[i * 4 + 3] = 0xFF;
+    return true;
+}
+
+bool PngDecoder::prepareImage()
+{
+    if (mColorType == 3 && mPaletteSize == 0) return false;
+    bool isWide = mBitDepth == 16;
+    switch (mColorType)
+    {
+    case 0:
+        if (mHasTransparentKey) mInfo.mFormat = isWide ? TextureFormat::R16G16_UNORM : TextureFormat::R8G8_UNORM;
+        else mInfo.mFormat = isWide ? TextureFormat::R16_UNORM : TextureFormat::R8_UNORM;
+        break;
+    case 4:
+        mInfo.mFormat = isWide ? TextureFormat::R16G16_UNORM : TextureFormat::R8G8_UNORM;
+        break;
+    case 3:
+        mInfo.mFormat = TextureFormat::R8G8B8A8_UNORM;
+        break;
+    default:
+        mInfo.mFormat = isWide ? TextureFormat::R16G16B16A16_UNORM : TextureFormat::R8G8B8A8_UNORM;
+        break;
+    }
+
+    uint64_t maxStride = 1 + (static_cast<uint64_t>(mInfo.mWidth) * mNumChannels * mBitDepth + 7) / 8;
+    mScanlines.assign(maxStride * 2, 0);
+    mCurrentRow = mScanlines.data();
+    mPreviousRow = mScanlines.data() + maxStride;
+    mPass = 0;
+    startPass();
+    return true;
+}
+
+bool PngDecoder::startPass()
+{
+    uint8_t numPasses = mIsInterlaced ? 7 : 1;
+    for (; mPass < numPasses; ++mPass)
+    {
+        if (mIsInterlaced)
+        {
+            const uint8_t* pass = ADAM7[mPass];
+            mPassWidth = mInfo.mWidth > pass[0] ? (mInfo.mWidth - pass[0] + pass[2] - 1) / pass[2] : 0;
+            mPassHeight = mInfo.mHeight > pass[1] ? (mInfo.mHeight - pass[1] + pass[3] - 1) / pass[3] : 0;
+        }
+        else
+        {
+            mPassWidth = mInfo.mWidth;
+            mPassHeight = mInfo.mHeight;
+        }
+        if (mPassWidth && mPassHeight)
+        {
+            mRowStride = 1 + (static_cast<uint64_t>(mPassWidth) * mNumChannels * mBitDepth + 7) / 8;
+            // the row above the first row of a pass counts as zeros
+            memset(mPreviousRow, 0, mRowStride);
+            mPassRow = 0;
+            mRowFilled = 0;
+            return true;
+        }
+    }
+    mIsImageDone = true;
+    return false;
+}
+
+bool PngDecoder::inflateImageData(const byte* pData, uint64_t size)
+{
+    const byte* pIn = pData;
+    const byte* pInEnd = pData + size;
+    while (true)
+    {
+        if (mIsImageDone)
+        {
+            // all rows are out, the rest of the stream only holds the end of block and the checksum
+            byte* pOut = nullptr;
+            return mInflater.inflate(pIn, pInEnd, pOut, pOut) != Inflater::Status::FAILED;
+        }
+        byte* pOut = mCurrentRow + mRowFilled;
+        Inflater::Status status = mInflater.inflate(pIn, pInEnd, pOut, mCurrentRow + mRowStride);
+        mRowFilled = static_cast<uint64_t>(pOut - mCurrentRow);
+        if (mRowFilled == mRowStride)
+        {
+            uint32_t bpp = (std::max)(static_cast<uint32_t>(mNumChannels * mBitDepth / 8), 1u);
+            if (!Unfilter(mCurrentRow[0], mCurrentRow + 1, mPreviousRow + 1, mRowStride - 1, bpp)) return false;
+            finishRow();
+            continue;
+        }
+        // the stream must not end before the last row
+        return status == Inflater::Status::NEED_INPUT;
+    }
+}
+
+void PngDecoder::finishRow()
+{
+    uint32_t x0 = 0;
+    uint32_t dx = 1;
+    uint32_t y = mPassRow;
+    if (mIsInterlaced)
+    {
+        x0 = ADAM7[mPass][0];
+        dx = ADAM7[mPass][2];
+        y = ADAM7[mPass][1] + mPassRow * ADAM7[mPass][3];
+    }
+    emitRow(mCurrentRow + 1, y, x0, dx, mPassWidth);
+
+    std::swap(mCurrentRow, mPreviousRow);
+    mRowFilled = 0;
+    if (++mPassRow == mPassHeight)
+    {
+        mPass++;
+        startPass();
+    }
+}
+
+void PngDecoder::emitRow(const byte* pRow, uint32_t y, uint32_t x0, uint32_t dx, uint32_t numPixels) const
+{
+    uint32_t texelSize = GetFormatTraits(mInfo.mFormat).mBytesPerBlock;
+    byte* pDst = mDestination.mData + y * mDestination.mRowPitch + static_cast<uint64_t>(x0) * texelSize;
+    uint64_t dstStep = static_cast<uint64_t>(dx) * texelSize;
+
+    switch (mColorType)
+    {
+    case 0:
+        if (mBitDepth == 16)
+        {
+            for (uint32_t i = 0; i < numPixels; ++i, pDst += dstStep)
+            {
+                uint16_t gray = ReadBE16(pRow + i * 2);
+                StoreLE16(pDst, gray);
+                if (mHasTransparentKey) StoreLE16(pDst + 2, gray == mTransparentKey[0] ? 0 : 0xFFFF);
+            }
+        }
+        else if (mBitDepth == 8 && dx == 1 && !mHasTransparentKey)
+        {
+            memcpy(pDst, pRow, numPixels);
+        }
+        else
+        {
+            // low bit depths are stretched over the full byte range, the key compares against the raw sample
+            uint8_t scale = static_cast<uint8_t>(255 / ((1u << mBitDepth) - 1));
+            for (uint32_t i = 0; i < numPixels; ++i, pDst += dstStep)
+            {
+                uint8_t gray = mBitDepth == 8 ? pRow[i] : PackedSample(pRow, i, mBitDepth);
+                pDst[0] = static_cast<byte>(gray * scale);
+                if (mHasTransparentKey) pDst[1] = gray == mTransparentKey[0] ? 0 : 0xFF;
+            }
+        }
+        break;
+    case 2:
+        if (mBitDepth == 16)
+        {
+            for (uint32_t i = 0; i < numPixels; ++i, pDst += dstStep)
+            {
+                const byte* pSrc = pRow + i * 6;
+                uint16_t r = ReadBE16(pSrc);
+                uint16_t g = ReadBE16(pSrc + 2);
+                uint16_t b = ReadBE16(pSrc + 4);
+                bool isKey = mHasTransparentKey && r == mTransparentKey[0] && g == mTransparentKey[1] && b == mTransparentKey[2];
+                StoreLE16(pDst, r);
+                StoreLE16(pDst + 2, g);
+                StoreLE16(pDst + 4, b);
+                StoreLE16(pDst + 6, isKey ? 0 : 0xFFFF);
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < numPixels; ++i, pDst += dstStep)
+            {
+                const byte* pSrc = pRow + i * 3;
+                bool isKey = mHasTransparentKey &&
+                             pSrc[0] == mTransparentKey[0] && pSrc[1] == mTransparentKey[1] && pSrc[2] == mTransparentKey[2];
+                pDst[0] = pSrc[0];
+                pDst[1] = pSrc[1];
+                pDst[2] = pSrc[2];
+                pDst[3] = isKey ? 0 : 0xFF;
+            }
+        }
+        break;
+    case 3:
+        for (uint32_t i = 0; i < numPixels; ++i, pDst += dstStep)
+        {
+            uint8_t index = mBitDepth == 8 ? pRow[i] : PackedSample(pRow, i, mBitDepth);
+            memcpy(pDst, &mPalette[index * 4], 4);
+        }
+        break;
+    default:
+        // gray alpha and rgba are already laid out like the output, 16 bit samples only need a byte swap
+        if (mBitDepth == 8 && dx == 1)
+        {
+            memcpy(pDst, pRow, static_cast<uint64_t>(numPixels) * texelSize);
+        }
+        else if (mBitDepth == 8)
+        {
+            for (uint32_t i = 0; i < numPixels; ++i, pDst += dstStep) memcpy(pDst, pRow + i * texelSize, texelSize);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < numPixels; ++i, pDst += dstStep)
+            {
+                for (uint32_t c = 0; c < mNumChannels; ++c) StoreLE16(pDst + c * 2, ReadBE16(pRow + (i * mNumChannels + c) * 2));
+            }
+        }
+        break;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "Engine/pch.h"
+#include "Engine/render/ImageDecoder.h"
+#include "Engine/common/Inflate.h"
+
+// streaming png decoder, idat data is inflated and unfiltered one scanline at a time and converted into the
+// destination row in place. handles every color type and bit depth, trns and adam7 interlacing.
+// gray -> R8 / R16, gray alpha -> R8G8 / R16G16 (also gray with trns), everything else -> R8G8B8A8 / R16G16B16A16.
+class PngDecoder : public ImageDecoder
+{
+public:
+    DecodeStatus feed(const byte* pData, uint64_t size, uint64_t* pConsumed) override;
+
+    static bool sIsPng(const byte* pHeader, uint64_t size);
+
+    PngDecoder();
+    ~PngDecoder() override;
+
+private:
+    enum class State : uint8_t
+    {
+        SIGNATURE,
+        CHUNK_HEADER,
+        CHUNK_DATA,
+        CHUNK_CRC,
+        DONE,
+        FAILED,
+    };
+
+    bool parseHeader();
+    bool prepareImage();
+    bool inflateImageData(const byte* pData, uint64_t size);
+    bool startPass();
+    void finishRow();
+    void emitRow(const byte* pRow, uint32_t y, uint32_t x0, uint32_t dx, uint32_t numPixels) const;
+    DecodeStatus fail();
+
+    Inflater mInflater;
+    std::vector<byte> mChunkData;
+    std::vector<byte> mScanlines;
+    std::array<byte, 256 * 4> mPalette;
+    byte* mCurrentRow;
+    byte* mPreviousRow;
+    uint64_t mRowStride;            // filter byte + packed samples of the current pass
+    uint64_t mRowFilled;
+    uint32_t mChunkLength;
+    uint32_t mChunkType;
+    uint32_t mChunkRemaining;
+    uint32_t mCrc;
+    uint32_t mPassWidth;
+    uint32_t mPassHeight;
+    uint32_t mPassRow;
+    uint16_t mTransparentKey[3];
+    uint16_t mPaletteSize;
+    uint8_t mStaging[8];
+    uint8_t mStagingSize;
+    uint8_t mBitDepth;
+    uint8_t mColorType;
+    uint8_t mNumChannels;
+    uint8_t mPass;
+    bool mIsInterlaced;
+    bool mHasTransparentKey;
+    bool mIsImageDone;
+    State mState;
+};
@@ -4,89 +4,231 @@
 
 const byte* RawTexture::dataPtr() const
 {
-    return mData;
+    return subResourcePtr(0, 0);
 }
 
 const byte* RawTexture::subDatePtr(uint8_t mip) const
 {
-    return mData + GetMip(mip);
+    return subResourcePtr(mip, 0);
 }
 
-void RawTexture::SetData(const byte* data) const
+const byte* RawTexture::subResourcePtr(uint8_t mip, uint32_t slice) const
 {
-    uint64_t size = GetMip(MipLevels());
-    memcpy(mData, data, size);
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(mip < MipLevels() && slice < arraySize(), TEXT("index out of bound"));
+#endif
+    return mStorage.get() + mSubResourceOffsets[mip + slice * MipLevels()];
+}
+
+uint64_t RawTexture::subResourceSize(uint8_t mip) const
+{
+    return GetMipSize(mip);
+}
+
+uint64_t RawTexture::dataSize() const
+{
+    return GetMip(MipLevels()) * arraySize();
+}
+
+uint32_t RawTexture::arraySize() const
+{
+    return Type() == TextureType::TEXTURE_3D ? 1 : Depth();
+}
+
+bool RawTexture::isBorrowed() const
+{
+    return mIsBorrowed;
 }
 
-void RawTexture::SetSubData(uint8_t mip, const byte* subData) const
+bool RawTexture::isShared() const
+{
+    return mIsBorrowed || mStorage.use_count() > 1;
+}
+
+byte* RawTexture::writableSubResourcePtr(uint8_t mip, uint32_t slice)
+{
+    makeWritable();
+    return const_cast<byte*>(subResourcePtr(mip, slice));
+}
+
+RawTexture RawTexture::mipView(uint8_t firstMip, uint8_t numMips) const
 {
 #if defined(DEBUG) or defined(_DEBUG)
-    ASSERT(mip < MipLevels(), TEXT("index out of bound"));
+    ASSERT(numMips > 0 && firstMip + numMips <= MipLevels(), TEXT("index out of bound"));
 #endif
-    uint64_t index = GetMip(MipLevels());
-    memcpy(mData + index, subData, GetMipSize(mip));
+    uint32_t depth = Type() == TextureType::TEXTURE_3D ? (std::max)(Depth() >> firstMip, 1u) : Depth();
+    std::vector<uint64_t> offsets;
+    offsets.reserve(static_cast<size_t>(numMips) * arraySize());
+    for (uint32_t slice = 0; slice < arraySize(); ++slice)
+    {
+        for (uint8_t mip = firstMip; mip < firstMip + numMips; ++mip)
+        {
+            offsets.push_back(mSubResourceOffsets[mip + slice * MipLevels()]);
+        }
+    }
+    RawTexture view{ Type(), (std::max)(Width() >> firstMip, uint64_t{ 1 }), (std::max)(Height() >> firstMip, uint64_t{ 1 }),
+            depth, Format(), numMips, mStorage, std::move(offsets), SampleCount(), SampleQuality() };
+    view.mLayout = mLayout;
+    return view;
+}
+
+TextureLayout RawTexture::layout() const
+{
+    return mLayout;
+}
+
+RawTexture RawTexture::toLayout(TextureLayout layout) const
+{
+    if (layout == mLayout) return *this;
+    ASSERT(!IsBlockCompressed(Format()), TEXT("block compressed textures are always linear"));
+    // the copy only shares the storage, the one allocation is sized for the new layout
+    RawTexture result{ *this };
+    result.mLayout = layout;
+    result.mIsBorrowed = false;
+    result.allocate(nullptr);
+    uint32_t texelSize = GetFormatTraits(Format()).mBytesPerBlock;
+    for (uint32_t slice = 0; slice < arraySize(); ++slice)
+    {
+        for (uint8_t mip = 0; mip < MipLevels(); ++mip)
+        {
+            uint32_t width = static_cast<uint32_t>((std::max)(Width() >> mip, uint64_t{ 1 }));
+            uint32_t height = static_cast<uint32_t>((std::max)(Height() >> mip, uint64_t{ 1 }));
+            uint32_t depth = Type() == TextureType::TEXTURE_3D ? (std::max)(Depth() >> mip, 1u) : 1;
+            uint64_t rowPitch = static_cast<uint64_t>(width) * texelSize;
+            uint64_t linearSize = rowPitch * height;
+            uint64_t tiledSize = TiledLayout::GetTiledSize(width, height, texelSize);
+            const byte* pSrc = subResourcePtr(mip, slice);
+            byte* pDst = result.writableSubResourcePtr(mip, slice);
+            for (uint32_t z = 0; z < depth; ++z)
+            {
+                if (layout == TextureLayout::TILED)
+                {
+                    TiledLayout::LinearToTiled(pSrc + z * linearSize, rowPitch, pDst + z * tiledSize, width, height, texelSize);
+                }
+                else
+                {
+                    TiledLayout::TiledToLinear(pSrc + z * tiledSize, pDst + z * linearSize, rowPitch, width, height, texelSize);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+void RawTexture::SetData(const byte* data)
+{
+    // everything gets overwritten, shared pixels don't need to be copied first.
+    if (isShared())
+    {
+        mIsBorrowed = false;
+        allocate(data);
+        return;
+    }
+    memcpy(const_cast<byte*>(mStorage.get()), data, dataSize());
+}
+
+void RawTexture::SetSubData(uint8_t mip, const byte* subData)
+{
+    SetSubData(mip, 0, subData);
+}
+
+void RawTexture::SetSubData(uint8_t mip, uint32_t slice, const byte* subData)
+{
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(mip < MipLevels() && slice < arraySize(), TEXT("index out of bound"));
+#endif
+    makeWritable();
+    memcpy(const_cast<byte*>(subResourcePtr(mip, slice)), subData, GetMipSize(mip));
 }
 
 RawTexture::RawTexture(TextureType type,
     uint64_t width, uint64_t height, uint32_t depth, TextureFormat format,
     const byte* data, uint8_t numMips, uint8_t sampleCount, uint8_t sampleQuality) :
-    Texture(type, width, height, depth, format, numMips, sampleCount, sampleQuality) 
+    Texture(type, width, height, depth, format, numMips, sampleCount, sampleQuality), mIsBorrowed(false), mLayout(TextureLayout::LINEAR)
 {
-    uint64_t size = GetMip(numMips);
-    mData = new byte[size];
-    memcpy(mData, data, height * width * depth);
+    allocate(data);
 }
 
-RawTexture::RawTexture(const RawTexture& o) noexcept: Texture(o)
+RawTexture::RawTexture(TextureType type,
+    uint64_t width, uint64_t height, uint32_t depth, TextureFormat format, uint8_t numMips,
+    std::shared_ptr<const byte> storage, std::vector<uint64_t> subResourceOffsets, uint8_t sampleCount, uint8_t sampleQuality) :
+    Texture(type, width, height, depth, format, numMips, sampleCount, sampleQuality),
+    mStorage(std::move(storage)), mSubResourceOffsets(std::move(subResourceOffsets)), mIsBorrowed(true), mLayout(TextureLayout::LINEAR)
 {
-    uint64_t size = GetMip(MipLevels());
-    mData = new uint8_t[size];
-    memcpy(mData, o.mData, size);
+#if defined(DEBUG) or defined(_DEBUG)
+    ASSERT(mSubResourceOffsets.size() == static_cast<size_t>(numMips) * arraySize(), TEXT("subresource count mismatch"));
+#endif
 }
 
-RawTexture::~RawTexture()
+RawTexture::~RawTexture() = default;
+
+void RawTexture::makeWritable()
 {
-    delete[] mData;
+    // storage only this texture references can be written in place. the count can't go up behind our back,
+    // that would need a copy of this texture made concurrently with the write.
+    if (!mIsBorrowed && mStorage.use_count() == 1) return;
+    // gather the shared subresources into a packed copy before the first write.
+    std::shared_ptr<const byte> shared = std::move(mStorage);
+    std::vector<uint64_t> sharedOffsets = std::move(mSubResourceOffsets);
+    allocate(nullptr);
+    byte* pDst = const_cast<byte*>(mStorage.get());
+    for (size_t i = 0; i < sharedOffsets.size(); ++i)
+    {
+        uint8_t mip = static_cast<uint8_t>(i % MipLevels());
+        memcpy(pDst + mSubResourceOffsets[i], shared.get() + sharedOffsets[i], GetMipSize(mip));
+    }
+    mIsBorrowed = false;
 }
 
-RawTexture& RawTexture::operator=(const RawTexture& o) noexcept
+void RawTexture::allocate(const byte* data)
 {
-    if (this != &o)
+    // slices are packed one after another, each holding its full mip chain.
+    uint64_t sliceSize = GetMip(MipLevels());
+    uint32_t numSlices = arraySize();
+    mSubResourceOffsets.resize(static_cast<size_t>(MipLevels()) * numSlices);
+    for (uint32_t slice = 0; slice < numSlices; ++slice)
     {
-        Texture::operator=(o);
-        uint64_t size = GetMip(MipLevels());
-        mData = new uint8_t[size];
-        memcpy(mData, o.mData, size);
+        for (uint8_t mip = 0; mip < MipLevels(); ++mip)
+        {
+            mSubResourceOffsets[mip + slice * MipLevels()] = slice * sliceSize + GetMip(mip);
+        }
     }
-    return *this;
-}
 
+    uint64_t size = sliceSize * numSlices;
+    byte* pData = new byte[size];
+    if (data) memcpy(pData, data, size);
+    else memset(pData, 0, size);
+    mStorage = std::shared_ptr<const byte>(pData, std::default_delete<byte[]>());
+}
 
 uint64_t RawTexture::GetMip(uint8_t mip) const
 {
     uint64_t index = 0;
-    uint64_t width = Width();
-    uint64_t height = Height();
-    uint64_t depth = Depth();
-    while (mip)
+    for (uint8_t i = 0; i < mip; ++i)
     {
-        index += width * height * depth;
-        width = width > 2 ? width >> 1 : width;
-        height = height > 2 ? height >> 1 : height;
-        depth = depth >= 2 ? depth >> 1 : depth;
-        mip--;
+        index += GetMipSize(i);
     }
     return index;
 }
 
 uint64_t RawTexture::GetMipSize(uint8_t mip) const
 {
-    uint64_t width = Width() << mip;
-    uint64_t height = Height() << mip;
-    uint64_t depth = Depth() << mip;
-    width = width > 0 ? width : 1;
-    height = height > 0 ? height : 1;
-    depth = depth > 0 ? depth : 1;
-    return width * height * depth;
+    if (mLayout == TextureLayout::LINEAR) return sGetMipSize(Type(), Format(), Width(), Height(), Depth(), mip);
+    uint32_t width = static_cast<uint32_t>((std::max)(Width() >> mip, uint64_t{ 1 }));
+    uint32_t height = static_cast<uint32_t>((std::max)(Height() >> mip, uint64_t{ 1 }));
+    uint32_t depth = Type() == TextureType::TEXTURE_3D ? (std::max)(Depth() >> mip, 1u) : 1;
+    return TiledLayout::GetTiledSize(width, height, GetFormatTraits(Format()).mBytesPerBlock) * depth;
+}
+
+uint64_t RawTexture::sGetMipSize(TextureType type, TextureFormat format,
+    uint64_t width, uint64_t height, uint32_t depth, uint8_t mip)
+{
+    TextureFormatTraits traits = GetFormatTraits(format);
+    uint64_t mipWidth = (std::max)(width >> mip, static_cast<uint64_t>(1));
+    uint64_t mipHeight = (std::max)(height >> mip, static_cast<uint64_t>(1));
+    uint64_t mipDepth = type == TextureType::TEXTURE_3D ? (std::max)(depth >> mip, 1u) : 1;
+    uint64_t blocksWide = (mipWidth + traits.mBlockWidth - 1) / traits.mBlockWidth;
+    uint64_t blocksHigh = (mipHeight + traits.mBlockHeight - 1) / traits.mBlockHeight;
+    return blocksWide * blocksHigh * mipDepth * traits.mBytesPerBlock;
 }
-#endif
\ No newline at end of file
+#endif
@@ -2,30 +2,66 @@
 #ifdef WIN32
 #include "Engine/pch.h"
 #include "Engine/render/Texture.h"
+#include "Engine/render/TiledLayout.h"
 
+// cpu side pixels of a texture. subresources are addressed in d3d12 order (mip + slice * numMips),
+// the pixels either live in memory owned by the texture or are borrowed in place from a mapped file.
+// pixel storage is immutable and reference counted: copies and views share it, the first write through
+// a texture whose storage is shared or borrowed gives that texture its own packed copy.
+// uncompressed textures can be kept tiled for cpu side processing, every depth slice of a mip is tiled on its own.
 class RawTexture : public Texture
 {
 public:
-    void SetData(const byte* data) const;
-    void SetSubData(uint8_t mip, const byte* subData) const;
+    void SetData(const byte* data);
+    void SetSubData(uint8_t mip, const byte* subData);
+    void SetSubData(uint8_t mip, uint32_t slice, const byte* subData);
 
     const byte* dataPtr() const override;
     const byte* subDatePtr(uint8_t mip) const override;
+    const byte* subResourcePtr(uint8_t mip, uint32_t slice) const;
+    // unshares the storage first, the pointer is valid until this texture is copied or assigned.
+    byte* writableSubResourcePtr(uint8_t mip, uint32_t slice);
+    // bytes of one tightly packed subresource in this texture's layout, 3d textures include all depth slices of the mip.
+    uint64_t subResourceSize(uint8_t mip) const;
+    uint64_t dataSize() const;
+    uint32_t arraySize() const;
+    bool isBorrowed() const;
+    bool isShared() const;
+    // mips [firstMip, firstMip + numMips) of every slice as a texture of their own, sharing this texture's storage.
+    RawTexture mipView(uint8_t firstMip, uint8_t numMips = 1) const;
+    TextureLayout layout() const;
+    // the same pixels in another layout, block compressed textures are always linear.
+    RawTexture toLayout(TextureLayout layout) const;
+
+    // tightly packed size of one linear subresource of the given mip.
+    static uint64_t sGetMipSize(TextureType type, TextureFormat format,
+            uint64_t width, uint64_t height, uint32_t depth, uint8_t mip);
     
     RawTexture(TextureType type, uint64_t width, uint64_t height, uint32_t depth,
             TextureFormat format, const byte* data = nullptr,
             uint8_t numMips = 1, uint8_t sampleCount = 1, uint8_t sampleQuality = 0);
-    RawTexture(const RawTexture& o) noexcept;
+    // references pixels in place, storage keeps their owner alive.
+    // subResourceOffsets holds one byte offset per subresource, relative to storage.
+    RawTexture(TextureType type, uint64_t width, uint64_t height, uint32_t depth,
+            TextureFormat format, uint8_t numMips,
+            std::shared_ptr<const byte> storage, std::vector<uint64_t> subResourceOffsets,
+            uint8_t sampleCount = 1, uint8_t sampleQuality = 0);
     ~RawTexture() override;
 
+    DEFAULT_COPY_CONSTRUCTOR(RawTexture)
+    DEFAULT_COPY_OPERATOR(RawTexture)
     DEFAULT_MOVE_CONSTRUCTOR(RawTexture)
     DEFAULT_MOVE_OPERATOR(RawTexture)
-    RawTexture& operator=(const RawTexture& o) noexcept;
     
 private:
+    void makeWritable();
+    void allocate(const byte* data);
     uint64_t GetMip(uint8_t mip) const;
     uint64_t GetMipSize(uint8_t mip) const;
     
-    byte* mData;
+    std::shared_ptr<const byte> mStorage;
+    std::vector<uint64_t> mSubResourceOffsets;
+    bool mIsBorrowed;       // offsets point into foreign storage rather than a packed chain of our own
+    TextureLayout mLayout;
 };
-#endif
\ No newline at end of file
+#endif
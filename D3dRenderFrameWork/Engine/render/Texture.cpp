@@ -48,10 +48,12 @@ Texture::Texture(TextureType type, uint64_t width, uint64_t height, uint32_t dep
 
 Texture::Texture(const Texture& o) noexcept = default;
 
+#ifdef WIN32
 Texture::Texture(TextureType type, const D3D12_RESOURCE_DESC& desc) :
         mType(type), mFormat(static_cast<TextureFormat>(desc.Format)), mNumMips(static_cast<uint8_t>(desc.MipLevels)), mSampleCount(static_cast<uint8_t>(desc.SampleDesc.Count)),
         mSampleQuality(static_cast<uint8_t>(desc.SampleDesc.Quality)), mDepth(desc.DepthOrArraySize),
         mWidth(desc.Width), mHeight(desc.Height) { }
+#endif
 
 Texture::Texture() :
     mType(), mFormat(),
@@ -1,48 +1,212 @@
 ﻿#pragma once
 #include "Engine/pch.h"
 
+// values match DXGI_FORMAT so the enum casts straight to the d3d12 format, but stay usable without the sdk.
 enum class TextureFormat : uint8_t
 {
-    R8_UNORM = DXGI_FORMAT_R8_UNORM,
-    R8G8_UNORM = DXGI_FORMAT_R8G8_UNORM,
-    R8G8B8A8_UNORM = DXGI_FORMAT_R8G8B8A8_UNORM,
-    R8G8B8A8_UNORM_SRGB = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
-    R8_SNORM = DXGI_FORMAT_R8_SNORM,
-    R8G8_SNORM = DXGI_FORMAT_R8G8_SNORM,
-    R8G8B8A8_SNORM = DXGI_FORMAT_R8G8B8A8_SNORM,
-    R8_UINT = DXGI_FORMAT_R8_UINT,
-    R8G8_UINT = DXGI_FORMAT_R8G8_UINT,
-    R8G8B8A8_UINT = DXGI_FORMAT_R8G8B8A8_UINT,
-    R8_SINT = DXGI_FORMAT_R8_SINT,
-    R8G8_SINT = DXGI_FORMAT_R8G8_SINT,
-    R8G8B8A8_SINT = DXGI_FORMAT_R8G8B8A8_SINT,
-    R16_UNORM = DXGI_FORMAT_R16_UNORM,
-    R16G16_UNORM = DXGI_FORMAT_R16G16_UNORM,
-    R16G16B16A16_UNORM = DXGI_FORMAT_R16G16B16A16_UNORM,
-    R16_SNORM = DXGI_FORMAT_R16_SNORM,
-    R16G16_SNORM = DXGI_FORMAT_R16G16_SNORM,
-    R16G16B16A16_SNORM = DXGI_FORMAT_R16G16B16A16_SNORM,
-    R16_UINT = DXGI_FORMAT_R16_UINT,
-    R16G16_UINT = DXGI_FORMAT_R16G16_UINT,
-    R16G16B16A16_UINT = DXGI_FORMAT_R16G16B16A16_UINT,
-    R16_SINT = DXGI_FORMAT_R16_SINT,
-    R16G16_SINT = DXGI_FORMAT_R16G16_SINT,
-    R16G16B16A16_SINT = DXGI_FORMAT_R16G16B16A16_SINT,
-    R32_TYPELESS = DXGI_FORMAT_R32_TYPELESS,
-    R32G32_TYPELESS = DXGI_FORMAT_R32G32_TYPELESS,
-    R32G32B32A32_TYPELESS = DXGI_FORMAT_R32G32B32A32_TYPELESS,
-    R32_FLOAT = DXGI_FORMAT_R32_FLOAT,
-    R32G32_FLOAT = DXGI_FORMAT_R32G32_FLOAT,
-    R32G32B32A32_FLOAT = DXGI_FORMAT_R32G32B32A32_FLOAT,
-    D24_UNORM_S8_UINT = DXGI_FORMAT_D24_UNORM_S8_UINT,
+    R8_UNORM = 61,
+    R8G8_UNORM = 49,
+    R8G8B8A8_UNORM = 28,
+    R8G8B8A8_UNORM_SRGB = 29,
+    R8_SNORM = 63,
+    R8G8_SNORM = 51,
+    R8G8B8A8_SNORM = 31,
+    R8_UINT = 62,
+    R8G8_UINT = 50,
+    R8G8B8A8_UINT = 30,
+    R8_SINT = 64,
+    R8G8_SINT = 52,
+    R8G8B8A8_SINT = 32,
+    R16_UNORM = 56,
+    R16G16_UNORM = 35,
+    R16G16B16A16_UNORM = 11,
+    R16_SNORM = 58,
+    R16G16_SNORM = 37,
+    R16G16B16A16_SNORM = 13,
+    R16_UINT = 57,
+    R16G16_UINT = 36,
+    R16G16B16A16_UINT = 12,
+    R16_SINT = 59,
+    R16G16_SINT = 38,
+    R16G16B16A16_SINT = 14,
+    R16_FLOAT = 54,
+    R16G16_FLOAT = 34,
+    R16G16B16A16_FLOAT = 10,
+    R32_TYPELESS = 39,
+    R32G32_TYPELESS = 15,
+    R32G32B32A32_TYPELESS = 1,
+    R32_FLOAT = 41,
+    R32G32_FLOAT = 16,
+    R32G32B32A32_FLOAT = 2,
+    D24_UNORM_S8_UINT = 45,
+    BC1_UNORM = 71,
+    BC1_UNORM_SRGB = 72,
+    BC2_UNORM = 74,
+    BC2_UNORM_SRGB = 75,
+    BC3_UNORM = 77,
+    BC3_UNORM_SRGB = 78,
+    BC4_UNORM = 80,
+    BC4_SNORM = 81,
+    BC5_UNORM = 83,
+    BC5_SNORM = 84,
+    BC6H_UF16 = 95,
+    BC6H_SF16 = 96,
+    BC7_UNORM = 98,
+    BC7_UNORM_SRGB = 99,
 };
 
+// block footprint of a format, uncompressed formats are treated as 1x1 blocks.
+struct TextureFormatTraits
+{
+    uint8_t mBlockWidth;
+    uint8_t mBlockHeight;
+    uint8_t mBytesPerBlock;
+    uint8_t mNumComponents;
+    bool mIsSrgb;
+};
+
+constexpr TextureFormatTraits GetFormatTraits(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::R8_UNORM:
+    case TextureFormat::R8_SNORM:
+    case TextureFormat::R8_UINT:
+    case TextureFormat::R8_SINT:
+        return { 1, 1, 1, 1, false };
+    case TextureFormat::R8G8_UNORM:
+    case TextureFormat::R8G8_SNORM:
+    case TextureFormat::R8G8_UINT:
+    case TextureFormat::R8G8_SINT:
+        return { 1, 1, 2, 2, false };
+    case TextureFormat::R8G8B8A8_UNORM:
+    case TextureFormat::R8G8B8A8_SNORM:
+    case TextureFormat::R8G8B8A8_UINT:
+    case TextureFormat::R8G8B8A8_SINT:
+        return { 1, 1, 4, 4, false };
+    case TextureFormat::R8G8B8A8_UNORM_SRGB:
+        return { 1, 1, 4, 4, true };
+    case TextureFormat::R16_UNORM:
+    case TextureFormat::R16_SNORM:
+    case TextureFormat::R16_UINT:
+    case TextureFormat::R16_SINT:
+    case TextureFormat::R16_FLOAT:
+        return { 1, 1, 2, 1, false };
+    case TextureFormat::R16G16_UNORM:
+    case TextureFormat::R16G16_SNORM:
+    case TextureFormat::R16G16_UINT:
+    case TextureFormat::R16G16_SINT:
+    case TextureFormat::R16G16_FLOAT:
+        return { 1, 1, 4, 2, false };
+    case TextureFormat::R16G16B16A16_UNORM:
+    case TextureFormat::R16G16B16A16_SNORM:
+    case TextureFormat::R16G16B16A16_UINT:
+    case TextureFormat::R16G16B16A16_SINT:
+    case TextureFormat::R16G16B16A16_FLOAT:
+        return { 1, 1, 8, 4, false };
+    case TextureFormat::R32_TYPELESS:
+    case TextureFormat::R32_FLOAT:
+        return { 1, 1, 4, 1, false };
+    case TextureFormat::R32G32_TYPELESS:
+    case TextureFormat::R32G32_FLOAT:
+        return { 1, 1, 8, 2, false };
+    case TextureFormat::R32G32B32A32_TYPELESS:
+    case TextureFormat::R32G32B32A32_FLOAT:
+        return { 1, 1, 16, 4, false };
+    case TextureFormat::D24_UNORM_S8_UINT:
+        return { 1, 1, 4, 2, false };
+    case TextureFormat::BC1_UNORM:
+        return { 4, 4, 8, 4, false };
+    case TextureFormat::BC1_UNORM_SRGB:
+        return { 4, 4, 8, 4, true };
+    case TextureFormat::BC2_UNORM:
+    case TextureFormat::BC3_UNORM:
+        return { 4, 4, 16, 4, false };
+    case TextureFormat::BC2_UNORM_SRGB:
+    case TextureFormat::BC3_UNORM_SRGB:
+        return { 4, 4, 16, 4, true };
+    case TextureFormat::BC4_UNORM:
+    case TextureFormat::BC4_SNORM:
+        return { 4, 4, 8, 1, false };
+    case TextureFormat::BC5_UNORM:
+    case TextureFormat::BC5_SNORM:
+        return { 4, 4, 16, 2, false };
+    case TextureFormat::BC6H_UF16:
+    case TextureFormat::BC6H_SF16:
+        return { 4, 4, 16, 3, false };
+    case TextureFormat::BC7_UNORM:
+        return { 4, 4, 16, 4, false };
+    case TextureFormat::BC7_UNORM_SRGB:
+        return { 4, 4, 16, 4, true };
+    }
+    return { 1, 1, 0, 0, false };
+}
+
+constexpr bool IsBlockCompressed(TextureFormat format)
+{
+    return GetFormatTraits(format).mBlockWidth > 1;
+}
+
 enum class TextureType : uint8_t
 {
-    TEXTURE_2D = D3D12_RESOURCE_DIMENSION_TEXTURE2D,
-    TEXTURE_3D = D3D12_RESOURCE_DIMENSION_TEXTURE3D,
+    TEXTURE_2D = 3,     // D3D12_RESOURCE_DIMENSION_TEXTURE2D
+    TEXTURE_3D = 4,     // D3D12_RESOURCE_DIMENSION_TEXTURE3D
 };
 
+#ifdef WIN32
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8_UNORM) == DXGI_FORMAT_R8_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8G8_UNORM) == DXGI_FORMAT_R8G8_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8G8B8A8_UNORM) == DXGI_FORMAT_R8G8B8A8_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8G8B8A8_UNORM_SRGB) == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8_SNORM) == DXGI_FORMAT_R8_SNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8G8_SNORM) == DXGI_FORMAT_R8G8_SNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8G8B8A8_SNORM) == DXGI_FORMAT_R8G8B8A8_SNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8_UINT) == DXGI_FORMAT_R8_UINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8G8_UINT) == DXGI_FORMAT_R8G8_UINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8G8B8A8_UINT) == DXGI_FORMAT_R8G8B8A8_UINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8_SINT) == DXGI_FORMAT_R8_SINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8G8_SINT) == DXGI_FORMAT_R8G8_SINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R8G8B8A8_SINT) == DXGI_FORMAT_R8G8B8A8_SINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16_UNORM) == DXGI_FORMAT_R16_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16_UNORM) == DXGI_FORMAT_R16G16_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16B16A16_UNORM) == DXGI_FORMAT_R16G16B16A16_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16_SNORM) == DXGI_FORMAT_R16_SNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16_SNORM) == DXGI_FORMAT_R16G16_SNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16B16A16_SNORM) == DXGI_FORMAT_R16G16B16A16_SNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16_UINT) == DXGI_FORMAT_R16_UINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16_UINT) == DXGI_FORMAT_R16G16_UINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16B16A16_UINT) == DXGI_FORMAT_R16G16B16A16_UINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16_SINT) == DXGI_FORMAT_R16_SINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16_SINT) == DXGI_FORMAT_R16G16_SINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16B16A16_SINT) == DXGI_FORMAT_R16G16B16A16_SINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16_FLOAT) == DXGI_FORMAT_R16_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16_FLOAT) == DXGI_FORMAT_R16G16_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R16G16B16A16_FLOAT) == DXGI_FORMAT_R16G16B16A16_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R32_TYPELESS) == DXGI_FORMAT_R32_TYPELESS);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R32G32_TYPELESS) == DXGI_FORMAT_R32G32_TYPELESS);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R32G32B32A32_TYPELESS) == DXGI_FORMAT_R32G32B32A32_TYPELESS);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R32_FLOAT) == DXGI_FORMAT_R32_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R32G32_FLOAT) == DXGI_FORMAT_R32G32_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::R32G32B32A32_FLOAT) == DXGI_FORMAT_R32G32B32A32_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::D24_UNORM_S8_UINT) == DXGI_FORMAT_D24_UNORM_S8_UINT);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC1_UNORM) == DXGI_FORMAT_BC1_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC1_UNORM_SRGB) == DXGI_FORMAT_BC1_UNORM_SRGB);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC2_UNORM) == DXGI_FORMAT_BC2_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC2_UNORM_SRGB) == DXGI_FORMAT_BC2_UNORM_SRGB);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC3_UNORM) == DXGI_FORMAT_BC3_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC3_UNORM_SRGB) == DXGI_FORMAT_BC3_UNORM_SRGB);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC4_UNORM) == DXGI_FORMAT_BC4_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC4_SNORM) == DXGI_FORMAT_BC4_SNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC5_UNORM) == DXGI_FORMAT_BC5_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC5_SNORM) == DXGI_FORMAT_BC5_SNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC6H_UF16) == DXGI_FORMAT_BC6H_UF16);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC6H_SF16) == DXGI_FORMAT_BC6H_SF16);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC7_UNORM) == DXGI_FORMAT_BC7_UNORM);
+static_assert(static_cast<DXGI_FORMAT>(TextureFormat::BC7_UNORM_SRGB) == DXGI_FORMAT_BC7_UNORM_SRGB);
+static_assert(static_cast<D3D12_RESOURCE_DIMENSION>(TextureType::TEXTURE_2D) == D3D12_RESOURCE_DIMENSION_TEXTURE2D);
+static_assert(static_cast<D3D12_RESOURCE_DIMENSION>(TextureType::TEXTURE_3D) == D3D12_RESOURCE_DIMENSION_TEXTURE3D);
+#endif
+
 class Texture
 {
 public:
@@ -68,7 +232,9 @@ public:
     Texture& operator=(const Texture& o) noexcept;
     
 protected:
+#ifdef WIN32
     Texture(TextureType type, const D3D12_RESOURCE_DESC& desc);
+#endif
     Texture();
 
 private:
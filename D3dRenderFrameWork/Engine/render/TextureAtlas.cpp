@@ -0,0 +1,272 @@
+#ifdef WIN32
+#include "Engine/render/TextureAtlas.h"
+#include "Engine/common/Exception.h"
+#include "Engine/common/Parallel.h"
+#include "Engine/render/FormatConversion.h"
+
+#undef max
+#undef min
+
+namespace
+{
+    // texels of the destination mip per parallel grain when filtering
+    constexpr uint64_t TEXELS_PER_GRAIN = 16 * 1024;
+}
+
+TextureAtlas::Packer::Packer(uint32_t size) : mFreeRects{ { 0, 0, size, size } }
+{
+}
+
+// best short side fit, the rect goes to the top left corner of the free rect it fills most tightly
+bool TextureAtlas::Packer::insert(uint32_t width, uint32_t height, Rect& rect)
+{
+    const Rect* pBest = nullptr;
+    uint32_t bestShortSide = UINT32_MAX;
+    uint32_t bestLongSide = UINT32_MAX;
+    for (const Rect& freeRect : mFreeRects)
+    {
+        if (freeRect.mWidth < width || freeRect.mHeight < height) continue;
+        uint32_t leftoverX = freeRect.mWidth - width;
+        uint32_t leftoverY = freeRect.mHeight - height;
+        uint32_t shortSide = (std::min)(leftoverX, leftoverY);
+        uint32_t longSide = (std::max)(leftoverX, leftoverY);
+        if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+        {
+            pBest = &freeRect;
+            bestShortSide = shortSide;
+            bestLongSide = longSide;
+        }
+    }
+    if (!pBest) return false;
+
+    rect = { pBest->mX, pBest->mY, width, height };
+    split(rect);
+    prune();
+    return true;
+}
+
+// every free rect the new rect overlaps is replaced by the up to four maximal rects around it
+void TextureAtlas::Packer::split(const Rect& used)
+{
+    std::vector<Rect> splitRects;
+    for (size_t i = 0; i < mFreeRects.size();)
+    {
+        Rect freeRect = mFreeRects[i];
+        if (used.mX >= freeRect.mX + freeRect.mWidth || used.mX + used.mWidth <= freeRect.mX ||
+            used.mY >= freeRect.mY + freeRect.mHeight || used.mY + used.mHeight <= freeRect.mY)
+        {
+            ++i;
+            continue;
+        }
+        if (used.mX > freeRect.mX)
+        {
+            splitRects.push_back({ freeRect.mX, freeRect.mY, used.mX - freeRect.mX, freeRect.mHeight });
+        }
+        if (used.mX + used.mWidth < freeRect.mX + freeRect.mWidth)
+        {
+            splitRects.push_back({ used.mX + used.mWidth, freeRect.mY,
+                    freeRect.mX + freeRect.mWidth - used.mX - used.mWidth, freeRect.mHeight });
+        }
+        if (used.mY > freeRect.mY)
+        {
+            splitRects.push_back({ freeRect.mX, freeRect.mY, freeRect.mWidth, used.mY - freeRect.mY });
+        }
+        if (used.mY + used.mHeight < freeRect.mY + freeRect.mHeight)
+        {
+            splitRects.push_back({ freeRect.mX, used.mY + used.mHeight,
+                    freeRect.mWidth, freeRect.mY + freeRect.mHeight - used.mY - used.mHeight });
+        }
+        mFreeRects[i] = mFreeRects.back();
+        mFreeRects.pop_back();
+    }
+    mFreeRects.insert(mFreeRects.end(), splitRects.begin(), splitRects.end());
+}
+
+// drops free rects that lie inside another one
+void TextureAtlas::Packer::prune()
+{
+    auto contains = [](const Rect& outer, const Rect& inner)
+    {
+        return inner.mX >= outer.mX && inner.mY >= outer.mY &&
+               inner.mX + inner.mWidth <= outer.mX + outer.mWidth &&
+               inner.mY + inner.mHeight <= outer.mY + outer.mHeight;
+    };
+    for (size_t i = 0; i < mFreeRects.size(); ++i)
+    {
+        for (size_t j = i + 1; j < mFreeRects.size();)
+        {
+            if (contains(mFreeRects[i], mFreeRects[j]))
+            {
+                mFreeRects[j] = mFreeRects.back();
+                mFreeRects.pop_back();
+            }
+            else if (contains(mFreeRects[j], mFreeRects[i]))
+            {
+                mFreeRects[i] = mFreeRects.back();
+                mFreeRects.pop_back();
+                j = i + 1;
+            }
+            else
+            {
+                ++j;
+            }
+        }
+    }
+}
+
+uint32_t TextureAtlas::add(std::shared_ptr<const RawTexture> pTexture)
+{
+    ASSERT(FormatConversion::IsConvertible(pTexture->Format()), TEXT("atlas textures must be uncompressed"));
+    ASSERT(pTexture->layout() == TextureLayout::LINEAR, TEXT("atlas textures must be linear"));
+    mTextures.push_back(std::move(pTexture));
+    return static_cast<uint32_t>(mTextures.size() - 1);
+}
+
+void TextureAtlas::build()
+{
+    auto getCells = [this](uint64_t size)
+    {
+        return static_cast<uint32_t>((size + 3 * mCellSize - 1) / mCellSize);
+    };
+    // large textures first, small ones fill the gaps they leave
+    std::vector<uint32_t> order(mTextures.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+    {
+        uint64_t sizeA = (std::max)(mTextures[a]->Width(), mTextures[a]->Height());
+        uint64_t sizeB = (std::max)(mTextures[b]->Width(), mTextures[b]->Height());
+        if (sizeA != sizeB) return sizeA > sizeB;
+        return mTextures[a]->Width() * mTextures[a]->Height() > mTextures[b]->Width() * mTextures[b]->Height();
+    });
+
+    uint32_t gridSize = mPageSize / mCellSize;
+    uint64_t pageBytes = static_cast<uint64_t>(mPageSize) * mPageSize * GetFormatTraits(mFormat).mBytesPerBlock;
+    std::vector<Packer> packers;
+    std::vector<std::vector<byte>> topMips;
+    mEntries.assign(mTextures.size(), {});
+    for (uint32_t index : order)
+    {
+        const RawTexture& texture = *mTextures[index];
+        uint32_t cellsX = getCells(texture.Width());
+        uint32_t cellsY = getCells(texture.Height());
+        ASSERT(cellsX <= gridSize && cellsY <= gridSize, TEXT("texture with its gutter doesn't fit on an atlas page"));
+
+        Rect cell;
+        uint32_t page = 0;
+        while (page < packers.size() && !packers[page].insert(cellsX, cellsY, cell)) ++page;
+        if (page == packers.size())
+        {
+            packers.emplace_back(gridSize);
+            topMips.emplace_back(pageBytes);
+            packers.back().insert(cellsX, cellsY, cell);
+        }
+        blit(texture, topMips[page].data(), cell);
+
+        float texelSize = 1.0f / static_cast<float>(mPageSize);
+        Entry& entry = mEntries[index];
+        entry.mPage = page;
+        entry.mOffset[0] = static_cast<float>((cell.mX + 1) * mCellSize) * texelSize;
+        entry.mOffset[1] = static_cast<float>((cell.mY + 1) * mCellSize) * texelSize;
+        entry.mScale[0] = static_cast<float>(texture.Width()) * texelSize;
+        entry.mScale[1] = static_cast<float>(texture.Height()) * texelSize;
+    }
+
+    mPages.clear();
+    mPages.reserve(topMips.size());
+    for (std::vector<byte>& topMip : topMips)
+    {
+        mPages.emplace_back(TextureType::TEXTURE_2D, mPageSize, mPageSize, 1, mFormat, nullptr, mNumMips);
+        generateMips(mPages.back(), std::move(topMip));
+    }
+}
+
+// converts the texture into its cell one gutter in from the corner, then repeats the edge texels out to the cell border
+void TextureAtlas::blit(const RawTexture& texture, byte* pPage, const Rect& cell) const
+{
+    uint64_t texelSize = GetFormatTraits(mFormat).mBytesPerBlock;
+    uint64_t pagePitch = mPageSize * texelSize;
+    uint32_t width = static_cast<uint32_t>(texture.Width());
+    uint32_t height = static_cast<uint32_t>(texture.Height());
+    uint32_t cellX = cell.mX * mCellSize;
+    uint32_t cellY = cell.mY * mCellSize;
+    uint32_t cellWidth = cell.mWidth * mCellSize;
+    uint32_t cellHeight = cell.mHeight * mCellSize;
+    uint32_t gutter = mCellSize;
+
+    auto texelAt = [&](uint32_t x, uint32_t y)
+    {
+        return pPage + (cellY + y) * pagePitch + (cellX + x) * texelSize;
+    };
+    uint64_t srcPitch = texture.Width() * GetFormatTraits(texture.Format()).mBytesPerBlock;
+    FormatConversion::Convert(texture.Format(), texture.dataPtr(), srcPitch,
+                              mFormat, texelAt(gutter, gutter), pagePitch, width, height);
+
+    for (uint32_t y = gutter; y < gutter + height; ++y)
+    {
+        for (uint32_t x = 0; x < gutter; ++x)
+        {
+            memcpy(texelAt(x, y), texelAt(gutter, y), texelSize);
+        }
+        for (uint32_t x = gutter + width; x < cellWidth; ++x)
+        {
+            memcpy(texelAt(x, y), texelAt(gutter + width - 1, y), texelSize);
+        }
+    }
+    for (uint32_t y = 0; y < gutter; ++y)
+    {
+        memcpy(texelAt(0, y), texelAt(0, gutter), cellWidth * texelSize);
+    }
+    for (uint32_t y = gutter + height; y < cellHeight; ++y)
+    {
+        memcpy(texelAt(0, y), texelAt(0, gutter + height - 1), cellWidth * texelSize);
+    }
+}
+
+void TextureAtlas::generateMips(RawTexture& page, std::vector<byte> topMip) const
+{
+    uint64_t texelSize = GetFormatTraits(mFormat).mBytesPerBlock;
+    page.SetSubData(0, topMip.data());
+    std::vector<byte> srcMip = std::move(topMip);
+    for (uint8_t mip = 1; mip < mNumMips; ++mip)
+    {
+        uint32_t srcSize = mPageSize >> (mip - 1);
+        uint32_t dstSize = srcSize / 2;
+        std::vector<byte> dstMip(static_cast<uint64_t>(dstSize) * dstSize * texelSize);
+        const byte* pSrc = srcMip.data();
+        byte* pDst = dstMip.data();
+        TextureFormat format = mFormat;
+        uint64_t grainSize = (std::max)(TEXELS_PER_GRAIN / dstSize, uint64_t{ 1 });
+        ParallelFor(0, dstSize, grainSize, [=](uint64_t begin, uint64_t end)
+        {
+            std::vector<float> rows(static_cast<uint64_t>(srcSize) * 8);
+            std::vector<float> filtered(static_cast<uint64_t>(dstSize) * 4);
+            float* pRow0 = rows.data();
+            float* pRow1 = rows.data() + static_cast<uint64_t>(srcSize) * 4;
+            for (uint64_t y = begin; y < end; ++y)
+            {
+                FormatConversion::DecodeRow(format, pSrc + 2 * y * srcSize * texelSize, pRow0, srcSize);
+                FormatConversion::DecodeRow(format, pSrc + (2 * y + 1) * srcSize * texelSize, pRow1, srcSize);
+                for (uint32_t x = 0; x < dstSize; ++x)
+                {
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        uint64_t i = 8 * x + c;
+                        filtered[4 * x + c] = (pRow0[i] + pRow0[i + 4] + pRow1[i] + pRow1[i + 4]) * 0.25f;
+                    }
+                }
+                FormatConversion::EncodeRow(format, filtered.data(), pDst + y * dstSize * texelSize, dstSize);
+            }
+        });
+        page.SetSubData(mip, dstMip.data());
+        srcMip = std::move(dstMip);
+    }
+}
+
+TextureAtlas::TextureAtlas(uint32_t pageSize, TextureFormat format, uint8_t numMips) :
+    mPageSize(pageSize), mCellSize(1u << ((std::max)(numMips, uint8_t{ 1 }) - 1)), mFormat(format), mNumMips((std::max)(numMips, uint8_t{ 1 }))
+{
+    ASSERT(pageSize != 0 && (pageSize & (pageSize - 1)) == 0, TEXT("atlas pages must be a power of two"));
+    ASSERT(mCellSize <= pageSize, TEXT("too many mips for the atlas page size"));
+    ASSERT(FormatConversion::IsConvertible(format), TEXT("atlas pages must be uncompressed"));
+}
+#endif
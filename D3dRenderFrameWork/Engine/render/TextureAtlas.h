@@ -0,0 +1,86 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+#include "Engine/render/RawTexture.h"
+
+// packs many small textures into a few large pages so they share one resource and descriptor.
+// rects are placed with maxrects (best short side fit) on a grid of 2^(numMips - 1) texels, so every texel block a mip
+// averages belongs to a single texture. each texture gets a gutter of edge texels that is still one texel wide on the
+// last mip, bilinear filtering at any level never reads a neighbour.
+class TextureAtlas
+{
+public:
+    // a uv inside the packed texture maps to mOffset + uv * mScale on its page
+    struct Entry
+    {
+        uint32_t mPage;
+        float mOffset[2];
+        float mScale[2];
+    };
+
+    // queues a texture, only its top mip is used. returns the index of its entry.
+    uint32_t add(std::shared_ptr<const RawTexture> pTexture);
+    // packs everything added so far into fresh pages and builds their mip chains.
+    void build();
+    const std::vector<RawTexture>& pages() const;
+    const Entry& entry(uint32_t index) const;
+    uint32_t numEntries() const;
+
+    TextureAtlas(uint32_t pageSize, TextureFormat format, uint8_t numMips);
+
+    DELETE_COPY_CONSTRUCTOR(TextureAtlas)
+    DELETE_COPY_OPERATOR(TextureAtlas)
+    DEFAULT_MOVE_CONSTRUCTOR(TextureAtlas)
+    DEFAULT_MOVE_OPERATOR(TextureAtlas)
+
+private:
+    struct Rect
+    {
+        uint32_t mX;
+        uint32_t mY;
+        uint32_t mWidth;
+        uint32_t mHeight;
+    };
+
+    // free space of one page in grid cells
+    class Packer
+    {
+    public:
+        bool insert(uint32_t width, uint32_t height, Rect& rect);
+        explicit Packer(uint32_t size);
+
+    private:
+        void split(const Rect& used);
+        void prune();
+
+        std::vector<Rect> mFreeRects;
+    };
+
+    void blit(const RawTexture& texture, byte* pPage, const Rect& cell) const;
+    // box filtered through linear floats, fills every mip below the top one
+    void generateMips(RawTexture& page, std::vector<byte> topMip) const;
+
+    std::vector<std::shared_ptr<const RawTexture>> mTextures;
+    std::vector<Entry> mEntries;
+    std::vector<RawTexture> mPages;
+    uint32_t mPageSize;
+    uint32_t mCellSize;     // grid size and gutter width in texels
+    TextureFormat mFormat;
+    uint8_t mNumMips;
+};
+
+inline const std::vector<RawTexture>& TextureAtlas::pages() const
+{
+    return mPages;
+}
+
+inline const TextureAtlas::Entry& TextureAtlas::entry(uint32_t index) const
+{
+    return mEntries[index];
+}
+
+inline uint32_t TextureAtlas::numEntries() const
+{
+    return static_cast<uint32_t>(mEntries.size());
+}
+#endif
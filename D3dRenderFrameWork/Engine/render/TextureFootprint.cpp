@@ -0,0 +1,92 @@
+#include "Engine/render/TextureFootprint.h"
+#include "Engine/common/helper.h"
+#include "Engine/common/StreamCopy.h"
+#include "Engine/render/TiledLayout.h"
+
+uint32_t GetArraySize(TextureType type, uint32_t depthOrArraySize)
+{
+    return type == TextureType::TEXTURE_3D ? 1 : depthOrArraySize;
+}
+
+uint32_t GetSubResourceCount(TextureType type, uint32_t depthOrArraySize, uint8_t numMips)
+{
+    return GetArraySize(type, depthOrArraySize) * numMips;
+}
+
+uint32_t GetSubResourceCount(const Texture& texture)
+{
+    return GetSubResourceCount(texture.Type(), texture.Depth(), texture.MipLevels());
+}
+
+SubResourceFootprint GetSubResourceFootprint(TextureType type, TextureFormat format,
+        uint64_t width, uint64_t height, uint32_t depthOrArraySize, uint8_t mip, uint64_t offset)
+{
+    TextureFormatTraits traits = GetFormatTraits(format);
+    uint64_t mipWidth = (std::max)(width >> mip, uint64_t{ 1 });
+    uint64_t mipHeight = (std::max)(height >> mip, uint64_t{ 1 });
+    uint32_t mipDepth = type == TextureType::TEXTURE_3D ? (std::max)(depthOrArraySize >> mip, 1u) : 1;
+    uint64_t blocksWide = (mipWidth + traits.mBlockWidth - 1) / traits.mBlockWidth;
+    uint64_t blocksHigh = (mipHeight + traits.mBlockHeight - 1) / traits.mBlockHeight;
+
+    SubResourceFootprint footprint;
+    footprint.mOffset = offset;
+    footprint.mRowSize = blocksWide * traits.mBytesPerBlock;
+    footprint.mRowPitch = AlignUpToMul<uint64_t, TEXTURE_DATA_PITCH_ALIGNMENT>{}(footprint.mRowSize);
+    footprint.mWidth = static_cast<uint32_t>(blocksWide * traits.mBlockWidth);
+    footprint.mHeight = static_cast<uint32_t>(blocksHigh * traits.mBlockHeight);
+    footprint.mDepth = mipDepth;
+    footprint.mNumRows = static_cast<uint32_t>(blocksHigh);
+    return footprint;
+}
+
+uint64_t GetCopyableFootprints(TextureType type, TextureFormat format,
+        uint64_t width, uint64_t height, uint32_t depthOrArraySize, uint8_t numMips,
+        uint32_t firstSubResource, uint32_t numSubResources, uint64_t baseOffset,
+        SubResourceFootprint* pLayouts)
+{
+    uint64_t offset = AlignUpToMul<uint64_t, TEXTURE_DATA_PLACEMENT_ALIGNMENT>{}(baseOffset);
+    uint64_t end = offset;
+    for (uint32_t i = 0; i < numSubResources; ++i)
+    {
+        uint8_t mip = static_cast<uint8_t>((firstSubResource + i) % numMips);
+        SubResourceFootprint footprint = GetSubResourceFootprint(type, format, width, height, depthOrArraySize, mip, offset);
+        if (pLayouts) pLayouts[i] = footprint;
+        // the final row of a subresource doesn't need its padding
+        end = offset + footprint.mRowPitch * (static_cast<uint64_t>(footprint.mNumRows) * footprint.mDepth - 1) + footprint.mRowSize;
+        offset = AlignUpToMul<uint64_t, TEXTURE_DATA_PLACEMENT_ALIGNMENT>{}(end);
+    }
+    return end - baseOffset;
+}
+
+uint64_t GetCopyableFootprints(const Texture& texture, uint64_t baseOffset, SubResourceFootprint* pLayouts)
+{
+    return GetCopyableFootprints(texture.Type(), texture.Format(), texture.Width(), texture.Height(), texture.Depth(),
+            texture.MipLevels(), 0, GetSubResourceCount(texture), baseOffset, pLayouts);
+}
+
+void CopyToFootprint(const SubResourceFootprint& footprint, const byte* pSrc, byte* pDstBase)
+{
+    byte* pDst = pDstBase + footprint.mOffset;
+    uint64_t numRows = static_cast<uint64_t>(footprint.mNumRows) * footprint.mDepth;
+    if (footprint.mRowPitch == footprint.mRowSize)
+    {
+        StreamCopy(pDst, pSrc, footprint.mRowSize * numRows);
+        return;
+    }
+    for (uint64_t row = 0; row < numRows; ++row)
+    {
+        StreamWrite(pDst + row * footprint.mRowPitch, pSrc + row * footprint.mRowSize, footprint.mRowSize);
+    }
+    StreamFence();
+}
+
+void CopyTiledToFootprint(const SubResourceFootprint& footprint, const byte* pSrc, byte* pDstBase, uint32_t texelSize)
+{
+    byte* pDst = pDstBase + footprint.mOffset;
+    uint64_t tiledSize = TiledLayout::GetTiledSize(footprint.mWidth, footprint.mHeight, texelSize);
+    for (uint32_t z = 0; z < footprint.mDepth; ++z)
+    {
+        TiledLayout::TiledToLinear(pSrc + z * tiledSize, pDst + z * footprint.mRowPitch * footprint.mNumRows,
+                                   footprint.mRowPitch, footprint.mWidth, footprint.mHeight, texelSize);
+    }
+}
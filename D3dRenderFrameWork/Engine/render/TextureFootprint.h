@@ -0,0 +1,46 @@
+#pragma once
+#include "Engine/pch.h"
+#include "Engine/render/Texture.h"
+
+// D3D12_TEXTURE_DATA_PITCH_ALIGNMENT / D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, buffer side copy rules of d3d12.
+constexpr uint64_t TEXTURE_DATA_PITCH_ALIGNMENT = 256;
+constexpr uint64_t TEXTURE_DATA_PLACEMENT_ALIGNMENT = 512;
+
+// layout of one subresource inside a buffer, same numbers ID3D12Device::GetCopyableFootprints reports
+// through its layouts, num rows and row size outputs.
+// width and height are padded to whole blocks, rows are block rows for compressed formats.
+struct SubResourceFootprint
+{
+    uint64_t mOffset;
+    uint64_t mRowPitch;
+    uint64_t mRowSize;      // bytes of one row without padding
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mDepth;
+    uint32_t mNumRows;      // rows per depth slice
+};
+
+// array slices of a 2d texture, 3d textures have a single slice holding every depth level.
+uint32_t GetArraySize(TextureType type, uint32_t depthOrArraySize);
+uint32_t GetSubResourceCount(TextureType type, uint32_t depthOrArraySize, uint8_t numMips);
+uint32_t GetSubResourceCount(const Texture& texture);
+
+// footprint of a single subresource placed at offset.
+SubResourceFootprint GetSubResourceFootprint(TextureType type, TextureFormat format,
+        uint64_t width, uint64_t height, uint32_t depthOrArraySize, uint8_t mip, uint64_t offset = 0);
+
+// device independent GetCopyableFootprints. subresources are indexed mip + slice * numMips, each one starts
+// on a placement boundary after baseOffset. pLayouts may be null, returns the total bytes the range spans
+// (the last row of the last subresource is not padded).
+// planar depth stencil formats only describe their depth plane, they're never uploaded from the cpu.
+uint64_t GetCopyableFootprints(TextureType type, TextureFormat format,
+        uint64_t width, uint64_t height, uint32_t depthOrArraySize, uint8_t numMips,
+        uint32_t firstSubResource, uint32_t numSubResources, uint64_t baseOffset,
+        SubResourceFootprint* pLayouts);
+// every subresource of the texture.
+uint64_t GetCopyableFootprints(const Texture& texture, uint64_t baseOffset, SubResourceFootprint* pLayouts);
+
+// copies tightly packed rows of a subresource into its footprint.
+void CopyToFootprint(const SubResourceFootprint& footprint, const byte* pSrc, byte* pDstBase);
+// same for a subresource in TextureLayout::TILED, each depth slice is detiled on its own.
+void CopyTiledToFootprint(const SubResourceFootprint& footprint, const byte* pSrc, byte* pDstBase, uint32_t texelSize);
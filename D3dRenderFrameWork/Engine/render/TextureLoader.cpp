@@ -0,0 +1,402 @@
+#ifdef WIN32
+#include "Engine/render/TextureLoader.h"
+#include "Engine/common/Exception.h"
+#include "Engine/common/PC/MappedFile.h"
+
+namespace
+{
+    constexpr uint32_t MakeFourCC(char c0, char c1, char c2, char c3)
+    {
+        return static_cast<uint32_t>(static_cast<uint8_t>(c0)) |
+               static_cast<uint32_t>(static_cast<uint8_t>(c1)) << 8 |
+               static_cast<uint32_t>(static_cast<uint8_t>(c2)) << 16 |
+               static_cast<uint32_t>(static_cast<uint8_t>(c3)) << 24;
+    }
+
+    // ------------------------------------DDS------------------------------------------- //
+
+    constexpr uint32_t DDS_MAGIC = MakeFourCC('D', 'D', 'S', ' ');
+    constexpr uint32_t DDPF_FOURCC = 0x4;
+    constexpr uint32_t DDPF_RGB = 0x40;
+    constexpr uint32_t DDPF_LUMINANCE = 0x20000;
+    constexpr uint32_t DDPF_BUMPDUDV = 0x80000;
+    constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+    constexpr uint32_t DDS_DIMENSION_TEXTURE3D = 4;
+    constexpr uint32_t DDS_MISC_TEXTURECUBE = 0x4;
+
+    struct DdsPixelFormat
+    {
+        uint32_t mSize;
+        uint32_t mFlags;
+        uint32_t mFourCC;
+        uint32_t mRGBBitCount;
+        uint32_t mRBitMask;
+        uint32_t mGBitMask;
+        uint32_t mBBitMask;
+        uint32_t mABitMask;
+    };
+
+    struct DdsHeader
+    {
+        uint32_t mSize;
+        uint32_t mFlags;
+        uint32_t mHeight;
+        uint32_t mWidth;
+        uint32_t mPitchOrLinearSize;
+        uint32_t mDepth;
+        uint32_t mMipMapCount;
+        uint32_t mReserved1[11];
+        DdsPixelFormat mPixelFormat;
+        uint32_t mCaps;
+        uint32_t mCaps2;
+        uint32_t mCaps3;
+        uint32_t mCaps4;
+        uint32_t mReserved2;
+    };
+
+    struct DdsHeaderDx10
+    {
+        uint32_t mDxgiFormat;
+        uint32_t mResourceDimension;
+        uint32_t mMiscFlag;
+        uint32_t mArraySize;
+        uint32_t mMiscFlags2;
+    };
+
+    static_assert(sizeof(DdsHeader) == 124, "unexpected dds header size");
+    static_assert(sizeof(DdsHeaderDx10) == 20, "unexpected dds dx10 header size");
+
+    bool IsSupportedFormat(uint32_t dxgiFormat)
+    {
+        return dxgiFormat != 0 && dxgiFormat <= UINT8_MAX &&
+               GetFormatTraits(static_cast<TextureFormat>(dxgiFormat)).mBytesPerBlock != 0;
+    }
+
+    bool HasMasks(const DdsPixelFormat& pf, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return pf.mRBitMask == r && pf.mGBitMask == g && pf.mBBitMask == b && pf.mABitMask == a;
+    }
+
+    // maps a pre-dx10 pixel format, only layouts that exist in TextureFormat are accepted.
+    bool GetLegacyFormat(const DdsPixelFormat& pf, TextureFormat& format)
+    {
+        if (pf.mFlags & DDPF_FOURCC)
+        {
+            switch (pf.mFourCC)
+            {
+            case MakeFourCC('D', 'X', 'T', '1'): format = TextureFormat::BC1_UNORM; return true;
+            case MakeFourCC('D', 'X', 'T', '2'):
+            case MakeFourCC('D', 'X', 'T', '3'): format = TextureFormat::BC2_UNORM; return true;
+            case MakeFourCC('D', 'X', 'T', '4'):
+            case MakeFourCC('D', 'X', 'T', '5'): format = TextureFormat::BC3_UNORM; return true;
+            case MakeFourCC('A', 'T', 'I', '1'):
+            case MakeFourCC('B', 'C', '4', 'U'): format = TextureFormat::BC4_UNORM; return true;
+            case MakeFourCC('B', 'C', '4', 'S'): format = TextureFormat::BC4_SNORM; return true;
+            case MakeFourCC('A', 'T', 'I', '2'):
+            case MakeFourCC('B', 'C', '5', 'U'): format = TextureFormat::BC5_UNORM; return true;
+            case MakeFourCC('B', 'C', '5', 'S'): format = TextureFormat::BC5_SNORM; return true;
+            // d3dformat values stored in the fourcc field
+            case 36: format = TextureFormat::R16G16B16A16_UNORM; return true;
+            case 110: format = TextureFormat::R16G16B16A16_SNORM; return true;
+            case 111: format = TextureFormat::R16_FLOAT; return true;
+            case 112: format = TextureFormat::R16G16_FLOAT; return true;
+            case 113: format = TextureFormat::R16G16B16A16_FLOAT; return true;
+            case 114: format = TextureFormat::R32_FLOAT; return true;
+            case 115: format = TextureFormat::R32G32_FLOAT; return true;
+            case 116: format = TextureFormat::R32G32B32A32_FLOAT; return true;
+            default: return false;
+            }
+        }
+        if (pf.mFlags & DDPF_RGB)
+        {
+            if (pf.mRGBBitCount == 32)
+            {
+                if (HasMasks(pf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000) ||
+                    HasMasks(pf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0))
+                {
+                    format = TextureFormat::R8G8B8A8_UNORM;
+                    return true;
+                }
+                if (HasMasks(pf, 0x0000ffff, 0xffff0000, 0, 0)) { format = TextureFormat::R16G16_UNORM; return true; }
+                if (HasMasks(pf, 0xffffffff, 0, 0, 0)) { format = TextureFormat::R32_FLOAT; return true; }
+            }
+            return false;
+        }
+        if (pf.mFlags & DDPF_LUMINANCE)
+        {
+            if (pf.mRGBBitCount == 8 && HasMasks(pf, 0xff, 0, 0, 0)) { format = TextureFormat::R8_UNORM; return true; }
+            if (pf.mRGBBitCount == 16 && HasMasks(pf, 0xffff, 0, 0, 0)) { format = TextureFormat::R16_UNORM; return true; }
+            if (pf.mRGBBitCount == 16 && HasMasks(pf, 0xff, 0, 0, 0xff00)) { format = TextureFormat::R8G8_UNORM; return true; }
+            return false;
+        }
+        if (pf.mFlags & DDPF_BUMPDUDV)
+        {
+            if (pf.mRGBBitCount == 16 && HasMasks(pf, 0x00ff, 0xff00, 0, 0)) { format = TextureFormat::R8G8_SNORM; return true; }
+            if (pf.mRGBBitCount == 32 && HasMasks(pf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+            {
+                format = TextureFormat::R8G8B8A8_SNORM;
+                return true;
+            }
+            if (pf.mRGBBitCount == 32 && HasMasks(pf, 0x0000ffff, 0xffff0000, 0, 0)) { format = TextureFormat::R16G16_SNORM; return true; }
+        }
+        return false;
+    }
+
+    // ------------------------------------KTX2------------------------------------------ //
+
+    constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    struct Ktx2Header
+    {
+        uint8_t mIdentifier[12];
+        uint32_t mVkFormat;
+        uint32_t mTypeSize;
+        uint32_t mPixelWidth;
+        uint32_t mPixelHeight;
+        uint32_t mPixelDepth;
+        uint32_t mLayerCount;
+        uint32_t mFaceCount;
+        uint32_t mLevelCount;
+        uint32_t mSupercompressionScheme;
+        uint32_t mDfdByteOffset;
+        uint32_t mDfdByteLength;
+        uint32_t mKvdByteOffset;
+        uint32_t mKvdByteLength;
+        uint64_t mSgdByteOffset;
+        uint64_t mSgdByteLength;
+    };
+
+    struct Ktx2LevelIndex
+    {
+        uint64_t mByteOffset;
+        uint64_t mByteLength;
+        uint64_t mUncompressedByteLength;
+    };
+
+    static_assert(sizeof(Ktx2Header) == 80, "unexpected ktx2 header size");
+    static_assert(sizeof(Ktx2LevelIndex) == 24, "unexpected ktx2 level index size");
+
+    bool GetVkFormat(uint32_t vkFormat, TextureFormat& format)
+    {
+        switch (vkFormat)
+        {
+        case 9: format = TextureFormat::R8_UNORM; return true;
+        case 10: format = TextureFormat::R8_SNORM; return true;
+        case 13: format = TextureFormat::R8_UINT; return true;
+        case 14: format = TextureFormat::R8_SINT; return true;
+        case 16: format = TextureFormat::R8G8_UNORM; return true;
+        case 17: format = TextureFormat::R8G8_SNORM; return true;
+        case 20: format = TextureFormat::R8G8_UINT; return true;
+        case 21: format = TextureFormat::R8G8_SINT; return true;
+        case 37: format = TextureFormat::R8G8B8A8_UNORM; return true;
+        case 38: format = TextureFormat::R8G8B8A8_SNORM; return true;
+        case 41: format = TextureFormat::R8G8B8A8_UINT; return true;
+        case 42: format = TextureFormat::R8G8B8A8_SINT; return true;
+        case 43: format = TextureFormat::R8G8B8A8_UNORM_SRGB; return true;
+        case 70: format = TextureFormat::R16_UNORM; return true;
+        case 71: format = TextureFormat::R16_SNORM; return true;
+        case 74: format = TextureFormat::R16_UINT; return true;
+        case 75: format = TextureFormat::R16_SINT; return true;
+        case 76: format = TextureFormat::R16_FLOAT; return true;
+        case 77: format = TextureFormat::R16G16_UNORM; return true;
+        case 78: format = TextureFormat::R16G16_SNORM; return true;
+        case 81: format = TextureFormat::R16G16_UINT; return true;
+        case 82: format = TextureFormat::R16G16_SINT; return true;
+        case 83: format = TextureFormat::R16G16_FLOAT; return true;
+        case 91: format = TextureFormat::R16G16B16A16_UNORM; return true;
+        case 92: format = TextureFormat::R16G16B16A16_SNORM; return true;
+        case 95: format = TextureFormat::R16G16B16A16_UINT; return true;
+        case 96: format = TextureFormat::R16G16B16A16_SINT; return true;
+        case 97: format = TextureFormat::R16G16B16A16_FLOAT; return true;
+        case 100: format = TextureFormat::R32_FLOAT; return true;
+        case 103: format = TextureFormat::R32G32_FLOAT; return true;
+        case 109: format = TextureFormat::R32G32B32A32_FLOAT; return true;
+        case 129: format = TextureFormat::D24_UNORM_S8_UINT; return true;
+        case 131:
+        case 133: format = TextureFormat::BC1_UNORM; return true;
+        case 132:
+        case 134: format = TextureFormat::BC1_UNORM_SRGB; return true;
+        case 135: format = TextureFormat::BC2_UNORM; return true;
+        case 136: format = TextureFormat::BC2_UNORM_SRGB; return true;
+        case 137: format = TextureFormat::BC3_UNORM; return true;
+        case 138: format = TextureFormat::BC3_UNORM_SRGB; return true;
+        case 139: format = TextureFormat::BC4_UNORM; return true;
+        case 140: format = TextureFormat::BC4_SNORM; return true;
+        case 141: format = TextureFormat::BC5_UNORM; return true;
+        case 142: format = TextureFormat::BC5_SNORM; return true;
+        case 143: format = TextureFormat::BC6H_UF16; return true;
+        case 144: format = TextureFormat::BC6H_SF16; return true;
+        case 145: format = TextureFormat::BC7_UNORM; return true;
+        case 146: format = TextureFormat::BC7_UNORM_SRGB; return true;
+        default: return false;
+        }
+    }
+
+    uint8_t MaxMipLevels(uint64_t width, uint64_t height, uint32_t depth)
+    {
+        uint64_t extent = (std::max)((std::max)(width, height), static_cast<uint64_t>(depth));
+        uint8_t numMips = 1;
+        while (extent > 1)
+        {
+            extent >>= 1;
+            numMips++;
+        }
+        return numMips;
+    }
+
+    // offsets are checked against the file before the texture may touch them.
+    void ValidateSubResource(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        ASSERT(offset <= fileSize && size <= fileSize - offset, TEXT("texture data exceeds file size"));
+    }
+}
+
+RawTexture TextureLoader::LoadDDS(const String& path)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::sOpen(path);
+    uint64_t size = file->size();
+    const byte* pData = file->data();
+    return ParseDDS(std::shared_ptr<const byte>(std::move(file), pData), size);
+}
+
+RawTexture TextureLoader::LoadKTX2(const String& path)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::sOpen(path);
+    uint64_t size = file->size();
+    const byte* pData = file->data();
+    return ParseKTX2(std::shared_ptr<const byte>(std::move(file), pData), size);
+}
+
+RawTexture TextureLoader::Load(const String& path)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::sOpen(path);
+    uint64_t size = file->size();
+    const byte* pData = file->data();
+    std::shared_ptr<const byte> pFile{ std::move(file), pData };
+    if (size >= sizeof(KTX2_IDENTIFIER) && memcmp(pData, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+    {
+        return ParseKTX2(std::move(pFile), size);
+    }
+    return ParseDDS(std::move(pFile), size);
+}
+
+RawTexture TextureLoader::ParseDDS(std::shared_ptr<const byte> pFile, uint64_t size)
+{
+    const byte* pData = pFile.get();
+    uint32_t magic;
+    DdsHeader header;
+    ASSERT(size >= sizeof(magic) + sizeof(header), TEXT("file too small to be a dds"));
+    memcpy(&magic, pData, sizeof(magic));
+    memcpy(&header, pData + sizeof(magic), sizeof(header));
+    ASSERT(magic == DDS_MAGIC && header.mSize == sizeof(DdsHeader) &&
+           header.mPixelFormat.mSize == sizeof(DdsPixelFormat), TEXT("invalid dds header"));
+
+    uint64_t dataOffset = sizeof(magic) + sizeof(header);
+    TextureType type = TextureType::TEXTURE_2D;
+    TextureFormat format;
+    uint32_t depth = 1;
+    uint32_t numSlices = 1;
+    if ((header.mPixelFormat.mFlags & DDPF_FOURCC) && header.mPixelFormat.mFourCC == MakeFourCC('D', 'X', '1', '0'))
+    {
+        DdsHeaderDx10 dx10;
+        ASSERT(size >= dataOffset + sizeof(dx10), TEXT("truncated dds dx10 header"));
+        memcpy(&dx10, pData + dataOffset, sizeof(dx10));
+        dataOffset += sizeof(dx10);
+        ASSERT(IsSupportedFormat(dx10.mDxgiFormat), TEXT("unsupported dds format"));
+        format = static_cast<TextureFormat>(dx10.mDxgiFormat);
+        if (dx10.mResourceDimension == DDS_DIMENSION_TEXTURE3D)
+        {
+            type = TextureType::TEXTURE_3D;
+            depth = (std::max)(header.mDepth, 1u);
+        }
+        else
+        {
+            numSlices = (std::max)(dx10.mArraySize, 1u);
+            if (dx10.mMiscFlag & DDS_MISC_TEXTURECUBE) numSlices *= 6;
+        }
+    }
+    else
+    {
+        ASSERT(GetLegacyFormat(header.mPixelFormat, format), TEXT("unsupported dds format"));
+        if (header.mCaps2 & DDSCAPS2_VOLUME)
+        {
+            type = TextureType::TEXTURE_3D;
+            depth = (std::max)(header.mDepth, 1u);
+        }
+        else if (header.mCaps2 & DDSCAPS2_CUBEMAP)
+        {
+            // partial cube maps are not supported
+            ASSERT((header.mCaps2 & 0xFC00) == 0xFC00, TEXT("dds cube map is missing faces"));
+            numSlices = 6;
+        }
+    }
+
+    uint64_t width = (std::max)(header.mWidth, 1u);
+    uint64_t height = (std::max)(header.mHeight, 1u);
+    uint32_t numMips = (std::max)(header.mMipMapCount, 1u);
+    ASSERT(numMips <= MaxMipLevels(width, height, depth), TEXT("invalid dds mip count"));
+
+    // dds stores every slice with its full mip chain, the same order as d3d12 subresources.
+    std::vector<uint64_t> subResourceOffsets(static_cast<size_t>(numMips) * numSlices);
+    uint64_t offset = dataOffset;
+    for (uint32_t slice = 0; slice < numSlices; ++slice)
+    {
+        for (uint32_t mip = 0; mip < numMips; ++mip)
+        {
+            uint64_t mipSize = RawTexture::sGetMipSize(type, format, width, height, depth, static_cast<uint8_t>(mip));
+            ValidateSubResource(offset, mipSize, size);
+            subResourceOffsets[mip + slice * numMips] = offset;
+            offset += mipSize;
+        }
+    }
+
+    uint32_t depthOrArraySize = type == TextureType::TEXTURE_3D ? depth : numSlices;
+    return RawTexture(type, width, height, depthOrArraySize, format, static_cast<uint8_t>(numMips),
+                      std::move(pFile), std::move(subResourceOffsets));
+}
+
+RawTexture TextureLoader::ParseKTX2(std::shared_ptr<const byte> pFile, uint64_t size)
+{
+    const byte* pData = pFile.get();
+    Ktx2Header header;
+    ASSERT(size >= sizeof(header), TEXT("file too small to be a ktx2"));
+    memcpy(&header, pData, sizeof(header));
+    ASSERT(memcmp(header.mIdentifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0, TEXT("invalid ktx2 identifier"));
+    // supercompressed levels would have to be inflated first, which defeats reading them in place.
+    ASSERT(header.mSupercompressionScheme == 0, TEXT("supercompressed ktx2 is not supported"));
+    TextureFormat format;
+    ASSERT(GetVkFormat(header.mVkFormat, format), TEXT("unsupported ktx2 format"));
+    ASSERT(header.mFaceCount == 1 || header.mFaceCount == 6, TEXT("invalid ktx2 face count"));
+
+    TextureType type = header.mPixelDepth > 0 ? TextureType::TEXTURE_3D : TextureType::TEXTURE_2D;
+    uint64_t width = (std::max)(header.mPixelWidth, 1u);
+    uint64_t height = (std::max)(header.mPixelHeight, 1u);
+    uint32_t depth = (std::max)(header.mPixelDepth, 1u);
+    uint32_t numSlices = (std::max)(header.mLayerCount, 1u) * header.mFaceCount;
+    ASSERT(type == TextureType::TEXTURE_2D || numSlices == 1, TEXT("3d ktx2 arrays are not supported"));
+    // a level count of 0 asks the loader to generate mips, only the base level is stored then.
+    uint32_t numMips = (std::max)(header.mLevelCount, 1u);
+    ASSERT(numMips <= MaxMipLevels(width, height, depth), TEXT("invalid ktx2 mip count"));
+    ASSERT(sizeof(header) + numMips * sizeof(Ktx2LevelIndex) <= size, TEXT("truncated ktx2 level index"));
+
+    // each level holds its layers, faces and z slices back to back.
+    std::vector<uint64_t> subResourceOffsets(static_cast<size_t>(numMips) * numSlices);
+    for (uint32_t mip = 0; mip < numMips; ++mip)
+    {
+        Ktx2LevelIndex level;
+        memcpy(&level, pData + sizeof(header) + mip * sizeof(Ktx2LevelIndex), sizeof(level));
+        uint64_t mipSize = RawTexture::sGetMipSize(type, format, width, height, depth, static_cast<uint8_t>(mip));
+        ASSERT(level.mByteLength >= mipSize * numSlices, TEXT("ktx2 level is smaller than its images"));
+        ValidateSubResource(level.mByteOffset, level.mByteLength, size);
+        for (uint32_t slice = 0; slice < numSlices; ++slice)
+        {
+            subResourceOffsets[mip + slice * numMips] = level.mByteOffset + slice * mipSize;
+        }
+    }
+
+    uint32_t depthOrArraySize = type == TextureType::TEXTURE_3D ? depth : numSlices;
+    return RawTexture(type, width, height, depthOrArraySize, format, static_cast<uint8_t>(numMips),
+                      std::move(pFile), std::move(subResourceOffsets));
+}
+#endif
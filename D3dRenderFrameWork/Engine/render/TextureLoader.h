@@ -0,0 +1,20 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+#include "Engine/render/RawTexture.h"
+
+// container loaders for pre-baked textures. the file is memory mapped and only its header is parsed,
+// the returned RawTexture points at the mip data inside the mapping and keeps it alive.
+// cube maps come back as 2d arrays with 6 slices per cube.
+namespace TextureLoader
+{
+    RawTexture LoadDDS(const String& path);
+    RawTexture LoadKTX2(const String& path);
+    // picks the container from the file identifier.
+    RawTexture Load(const String& path);
+
+    // same as above for a file that is already in memory, pFile is retained by the texture.
+    RawTexture ParseDDS(std::shared_ptr<const byte> pFile, uint64_t size);
+    RawTexture ParseKTX2(std::shared_ptr<const byte> pFile, uint64_t size);
+}
+#endif
@@ -0,0 +1,374 @@
+#ifdef WIN32
+#include "Engine/render/TextureSampler.h"
+#include "Engine/common/Exception.h"
+#include "Engine/common/Parallel.h"
+#include "Engine/common/Simd.h"
+#include "Engine/render/BCnDecoder.h"
+#include "Engine/render/FormatConversion.h"
+#include <cmath>
+
+#undef max
+#undef min
+
+namespace
+{
+    // texels per parallel grain when decoding mips
+    constexpr uint64_t TEXELS_PER_GRAIN = 64 * 1024;
+
+    // largest coordinate below 1, wrapped coordinates stay inside the texture
+    constexpr float ONE_MINUS_EPSILON = 0.99999994f;
+
+#ifdef SIMD_SSE2
+    // sse2 has no floor, truncation is off by one for negative non integers
+    __m128 Floor(__m128 x)
+    {
+        __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+        return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+    }
+
+    __m128 Lerp(__m128 a, __m128 b, __m128 t)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    }
+#endif
+
+    float ClampLod(float lod, float maxLod)
+    {
+        // nan and -inf (zero derivatives) pick the top mip
+        return lod > 0.0f ? (std::min)(lod, maxLod) : 0.0f;
+    }
+}
+
+SamplerDesc TextureSampler::sGetStaticSampler(uint32_t shaderRegister)
+{
+    switch (shaderRegister)
+    {
+    case 0: return { SamplerFilter::POINT, SamplerAddressMode::CLAMP, SamplerAddressMode::CLAMP, 1 };
+    case 1: return { SamplerFilter::LINEAR, SamplerAddressMode::WRAP, SamplerAddressMode::WRAP, 1 };
+    case 2: return { SamplerFilter::ANISOTROPIC, SamplerAddressMode::WRAP, SamplerAddressMode::WRAP, 1 };
+    case 3: return { SamplerFilter::ANISOTROPIC, SamplerAddressMode::WRAP, SamplerAddressMode::WRAP, 16 };
+    default: THROW_EXCEPTION(TEXT("no static sampler at this register"));
+    }
+}
+
+void TextureSampler::sampleLevel(const SamplerDesc& sampler, const float* pU, const float* pV, float lod,
+                                 float* pRgba, uint64_t count) const
+{
+    sampleLevels(sampler, pU, pV, &lod, 0, pRgba, count);
+}
+
+void TextureSampler::sampleLevel(const SamplerDesc& sampler, const float* pU, const float* pV, const float* pLods,
+                                 float* pRgba, uint64_t count) const
+{
+    sampleLevels(sampler, pU, pV, pLods, 1, pRgba, count);
+}
+
+void TextureSampler::sampleLevels(const SamplerDesc& sampler, const float* pU, const float* pV, const float* pLods, uint64_t lodStride,
+                                  float* pRgba, uint64_t count) const
+{
+    for (uint64_t i = 0; i < count; i += 4)
+    {
+        // a partial last batch repeats its last sample in the unused lanes
+        TapBatch taps;
+        for (uint64_t lane = 0; lane < 4; ++lane)
+        {
+            uint64_t sample = (std::min)(i + lane, count - 1);
+            taps.mU[lane] = pU[sample];
+            taps.mV[lane] = pV[sample];
+            taps.mLod[lane] = pLods[sample * lodStride];
+            taps.mWeight[lane] = 1.0f;
+        }
+        alignas(16) float result[16] = {};
+        sampleMips(sampler, taps, result);
+        memcpy(pRgba + i * 4, result, (std::min)(count - i, uint64_t{ 4 }) * 4 * sizeof(float));
+    }
+}
+
+// the footprint of a pixel is the parallelogram spanned by the derivatives. anisotropic filtering takes up to
+// mMaxAnisotropy trilinear taps along its longer side, at the lod of its shorter side.
+void TextureSampler::sampleGrad(const SamplerDesc& sampler, const float* pU, const float* pV,
+                                const float* pDuDx, const float* pDvDx, const float* pDuDy, const float* pDvDy,
+                                float* pRgba, uint64_t count) const
+{
+    float width = static_cast<float>(mMips[0].mWidth);
+    float height = static_cast<float>(mMips[0].mHeight);
+    bool isAnisotropic = sampler.mFilter == SamplerFilter::ANISOTROPIC && sampler.mMaxAnisotropy > 1;
+    for (uint64_t i = 0; i < count; i += 4)
+    {
+        float lods[4];
+        float axisU[4];
+        float axisV[4];
+        uint32_t numTaps[4];
+        uint32_t maxTaps = 1;
+        for (uint64_t lane = 0; lane < 4; ++lane)
+        {
+            uint64_t sample = (std::min)(i + lane, count - 1);
+            float lengthX = std::hypot(pDuDx[sample] * width, pDvDx[sample] * height);
+            float lengthY = std::hypot(pDuDy[sample] * width, pDvDy[sample] * height);
+            float major = (std::max)(lengthX, lengthY);
+            float minor = (std::min)(lengthX, lengthY);
+            numTaps[lane] = 1;
+            axisU[lane] = 0.0f;
+            axisV[lane] = 0.0f;
+            if (isAnisotropic && minor > 0.0f)
+            {
+                float ratio = (std::min)(std::ceil(major / minor), static_cast<float>(sampler.mMaxAnisotropy));
+                numTaps[lane] = static_cast<uint32_t>(ratio);
+                bool isXMajor = lengthX >= lengthY;
+                axisU[lane] = isXMajor ? pDuDx[sample] : pDuDy[sample];
+                axisV[lane] = isXMajor ? pDvDx[sample] : pDvDy[sample];
+            }
+            lods[lane] = std::log2(major / static_cast<float>(numTaps[lane]));
+            maxTaps = (std::max)(maxTaps, numTaps[lane]);
+        }
+
+        alignas(16) float result[16] = {};
+        for (uint32_t tap = 0; tap < maxTaps; ++tap)
+        {
+            TapBatch taps;
+            for (uint64_t lane = 0; lane < 4; ++lane)
+            {
+                uint64_t sample = (std::min)(i + lane, count - 1);
+                float offset = (static_cast<float>(tap) + 0.5f) / static_cast<float>(numTaps[lane]) - 0.5f;
+                taps.mU[lane] = pU[sample] + axisU[lane] * offset;
+                taps.mV[lane] = pV[sample] + axisV[lane] * offset;
+                taps.mLod[lane] = lods[lane];
+                taps.mWeight[lane] = tap < numTaps[lane] ? 1.0f / static_cast<float>(numTaps[lane]) : 0.0f;
+            }
+            sampleMips(sampler, taps, result);
+        }
+        memcpy(pRgba + i * 4, result, (std::min)(count - i, uint64_t{ 4 }) * 4 * sizeof(float));
+    }
+}
+
+// point filtering reads the nearest mip, the others blend the two mips around the lod
+void TextureSampler::sampleMips(const SamplerDesc& sampler, const TapBatch& taps, float* pResult) const
+{
+    bool isLinear = sampler.mFilter != SamplerFilter::POINT;
+    bool isWrapU = sampler.mAddressU == SamplerAddressMode::WRAP;
+    bool isWrapV = sampler.mAddressV == SamplerAddressMode::WRAP;
+    float maxLod = static_cast<float>(mMips.size() - 1);
+    uint8_t fineMips[4];
+    uint8_t coarseMips[4];
+    alignas(16) float fineWeights[4];
+    alignas(16) float coarseWeights[4];
+    bool hasCoarse = false;
+    for (uint32_t lane = 0; lane < 4; ++lane)
+    {
+        float lod = ClampLod(taps.mLod[lane], maxLod);
+        if (!isLinear)
+        {
+            fineMips[lane] = static_cast<uint8_t>(lod + 0.5f);
+            fineWeights[lane] = taps.mWeight[lane];
+            coarseMips[lane] = fineMips[lane];
+            coarseWeights[lane] = 0.0f;
+            continue;
+        }
+        float mip = std::floor(lod);
+        float blend = lod - mip;
+        fineMips[lane] = static_cast<uint8_t>(mip);
+        coarseMips[lane] = static_cast<uint8_t>((std::min)(mip + 1.0f, maxLod));
+        fineWeights[lane] = taps.mWeight[lane] * (1.0f - blend);
+        coarseWeights[lane] = taps.mWeight[lane] * blend;
+        hasCoarse |= coarseWeights[lane] > 0.0f;
+    }
+    accumulateTaps(isLinear, isWrapU, isWrapV, fineMips, taps.mU, taps.mV, fineWeights, pResult);
+    if (hasCoarse) accumulateTaps(isLinear, isWrapU, isWrapV, coarseMips, taps.mU, taps.mV, coarseWeights, pResult);
+}
+
+// adds weight * (bilinear or nearest texel) of 4 lanes to their rgba results. texel centers sit at half integers,
+// wrapping happens on the coordinate so both columns of a bilinear tap can straddle the border. u and v address
+// on their own, like the d3d12 sampler.
+void TextureSampler::accumulateTaps(bool isLinear, bool isWrapU, bool isWrapV, const uint8_t* pMips, const float* pU, const float* pV,
+                                    const float* pWeights, float* pResult) const
+{
+    alignas(16) float widths[4];
+    alignas(16) float heights[4];
+    for (uint32_t lane = 0; lane < 4; ++lane)
+    {
+        widths[lane] = static_cast<float>(mMips[pMips[lane]].mWidth);
+        heights[lane] = static_cast<float>(mMips[pMips[lane]].mHeight);
+    }
+    alignas(16) int32_t x0s[4];
+    alignas(16) int32_t y0s[4];
+    alignas(16) int32_t x1s[4];
+    alignas(16) int32_t y1s[4];
+    alignas(16) float fractionsX[4];
+    alignas(16) float fractionsY[4];
+
+#ifdef SIMD_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(isLinear ? 0.5f : 0.0f);
+    __m128 width = _mm_load_ps(widths);
+    __m128 height = _mm_load_ps(heights);
+    __m128 u = _mm_loadu_ps(pU);
+    __m128 v = _mm_loadu_ps(pV);
+    // max / min pick their second operand on nan, which keeps garbage coordinates inside the texture
+    const __m128 almostOne = _mm_set1_ps(ONE_MINUS_EPSILON);
+    u = isWrapU ? _mm_min_ps(_mm_max_ps(_mm_sub_ps(u, Floor(u)), zero), almostOne) : _mm_min_ps(_mm_max_ps(u, zero), one);
+    v = isWrapV ? _mm_min_ps(_mm_max_ps(_mm_sub_ps(v, Floor(v)), zero), almostOne) : _mm_min_ps(_mm_max_ps(v, zero), one);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(u, width), half);
+    __m128 y = _mm_sub_ps(_mm_mul_ps(v, height), half);
+    __m128 x0 = Floor(x);
+    __m128 y0 = Floor(y);
+    _mm_store_ps(fractionsX, _mm_sub_ps(x, x0));
+    _mm_store_ps(fractionsY, _mm_sub_ps(y, y0));
+    __m128 x1 = _mm_add_ps(x0, one);
+    __m128 y1 = _mm_add_ps(y0, one);
+    __m128 maxX = _mm_sub_ps(width, one);
+    __m128 maxY = _mm_sub_ps(height, one);
+    // wrapped, x0 is at least -1 and x1 at most width
+    if (isWrapU)
+    {
+        x0 = _mm_add_ps(x0, _mm_and_ps(_mm_cmplt_ps(x0, zero), width));
+        x1 = _mm_andnot_ps(_mm_cmpge_ps(x1, width), x1);
+    }
+    else
+    {
+        x0 = _mm_min_ps(_mm_max_ps(x0, zero), maxX);
+        x1 = _mm_min_ps(x1, maxX);
+    }
+    if (isWrapV)
+    {
+        y0 = _mm_add_ps(y0, _mm_and_ps(_mm_cmplt_ps(y0, zero), height));
+        y1 = _mm_andnot_ps(_mm_cmpge_ps(y1, height), y1);
+    }
+    else
+    {
+        y0 = _mm_min_ps(_mm_max_ps(y0, zero), maxY);
+        y1 = _mm_min_ps(y1, maxY);
+    }
+    _mm_store_si128(reinterpret_cast<__m128i*>(x0s), _mm_cvttps_epi32(x0));
+    _mm_store_si128(reinterpret_cast<__m128i*>(y0s), _mm_cvttps_epi32(y0));
+    _mm_store_si128(reinterpret_cast<__m128i*>(x1s), _mm_cvttps_epi32(x1));
+    _mm_store_si128(reinterpret_cast<__m128i*>(y1s), _mm_cvttps_epi32(y1));
+
+    for (uint32_t lane = 0; lane < 4; ++lane)
+    {
+        const Mip& mip = mMips[pMips[lane]];
+        __m128 texel = _mm_loadu_ps(texelPtr(mip, x0s[lane], y0s[lane]));
+        if (isLinear)
+        {
+            __m128 fractionX = _mm_set1_ps(fractionsX[lane]);
+            __m128 top = Lerp(texel, _mm_loadu_ps(texelPtr(mip, x1s[lane], y0s[lane])), fractionX);
+            __m128 bottom = Lerp(_mm_loadu_ps(texelPtr(mip, x0s[lane], y1s[lane])), _mm_loadu_ps(texelPtr(mip, x1s[lane], y1s[lane])), fractionX);
+            texel = Lerp(top, bottom, _mm_set1_ps(fractionsY[lane]));
+        }
+        __m128 accumulated = _mm_loadu_ps(pResult + lane * 4);
+        _mm_storeu_ps(pResult + lane * 4, _mm_add_ps(accumulated, _mm_mul_ps(texel, _mm_set1_ps(pWeights[lane]))));
+    }
+#else
+    for (uint32_t lane = 0; lane < 4; ++lane)
+    {
+        float u = pU[lane];
+        float v = pV[lane];
+        if (isWrapU) u = u - std::floor(u) > 0.0f ? (std::min)(u - std::floor(u), ONE_MINUS_EPSILON) : 0.0f;
+        else u = u > 0.0f ? (std::min)(u, 1.0f) : 0.0f;
+        if (isWrapV) v = v - std::floor(v) > 0.0f ? (std::min)(v - std::floor(v), ONE_MINUS_EPSILON) : 0.0f;
+        else v = v > 0.0f ? (std::min)(v, 1.0f) : 0.0f;
+        float x = u * widths[lane] - (isLinear ? 0.5f : 0.0f);
+        float y = v * heights[lane] - (isLinear ? 0.5f : 0.0f);
+        float x0 = std::floor(x);
+        float y0 = std::floor(y);
+        fractionsX[lane] = x - x0;
+        fractionsY[lane] = y - y0;
+        float x1 = x0 + 1.0f;
+        float y1 = y0 + 1.0f;
+        if (isWrapU)
+        {
+            x0 = x0 < 0.0f ? x0 + widths[lane] : x0;
+            x1 = x1 >= widths[lane] ? 0.0f : x1;
+        }
+        else
+        {
+            x0 = (std::min)((std::max)(x0, 0.0f), widths[lane] - 1.0f);
+            x1 = (std::min)(x1, widths[lane] - 1.0f);
+        }
+        if (isWrapV)
+        {
+            y0 = y0 < 0.0f ? y0 + heights[lane] : y0;
+            y1 = y1 >= heights[lane] ? 0.0f : y1;
+        }
+        else
+        {
+            y0 = (std::min)((std::max)(y0, 0.0f), heights[lane] - 1.0f);
+            y1 = (std::min)(y1, heights[lane] - 1.0f);
+        }
+        x0s[lane] = static_cast<int32_t>(x0);
+        y0s[lane] = static_cast<int32_t>(y0);
+        x1s[lane] = static_cast<int32_t>(x1);
+        y1s[lane] = static_cast<int32_t>(y1);
+    }
+
+    for (uint32_t lane = 0; lane < 4; ++lane)
+    {
+        const Mip& mip = mMips[pMips[lane]];
+        const float* p00 = texelPtr(mip, x0s[lane], y0s[lane]);
+        const float* p10 = texelPtr(mip, x1s[lane], y0s[lane]);
+        const float* p01 = texelPtr(mip, x0s[lane], y1s[lane]);
+        const float* p11 = texelPtr(mip, x1s[lane], y1s[lane]);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            float texel = p00[c];
+            if (isLinear)
+            {
+                float top = texel + (p10[c] - texel) * fractionsX[lane];
+                float bottom = p01[c] + (p11[c] - p01[c]) * fractionsX[lane];
+                texel = top + (bottom - top) * fractionsY[lane];
+            }
+            pResult[lane * 4 + c] += texel * pWeights[lane];
+        }
+    }
+#endif
+}
+
+TextureSampler::TextureSampler(const RawTexture& texture, uint32_t slice, TextureLayout layout) : mLayout(layout)
+{
+    ASSERT(texture.Type() == TextureType::TEXTURE_2D && slice < texture.arraySize(), TEXT("only 2d slices can be sampled"));
+    ASSERT(texture.layout() == TextureLayout::LINEAR, TEXT("sampled textures must be linear, the sampler tiles its own copy"));
+    TextureFormat format = texture.Format();
+    TextureFormatTraits traits = GetFormatTraits(format);
+    ASSERT(IsBlockCompressed(format) || FormatConversion::IsConvertible(format), TEXT("texture format can't be sampled"));
+
+    mMips.resize(texture.MipLevels());
+    std::vector<float> linearTexels;
+    for (uint8_t level = 0; level < texture.MipLevels(); ++level)
+    {
+        Mip& mip = mMips[level];
+        mip.mWidth = static_cast<uint32_t>((std::max)(texture.Width() >> level, uint64_t{ 1 }));
+        mip.mHeight = static_cast<uint32_t>((std::max)(texture.Height() >> level, uint64_t{ 1 }));
+        mip.mGrid = TiledLayout::GetTileGrid(mip.mWidth, mip.mHeight);
+        uint64_t linearSize = static_cast<uint64_t>(mip.mWidth) * mip.mHeight * 4;
+        std::vector<float>& decoded = layout == TextureLayout::TILED ? linearTexels : mip.mTexels;
+        decoded.resize(linearSize);
+
+        const byte* pSrc = texture.subResourcePtr(level, slice);
+        uint64_t srcRowPitch = (mip.mWidth + traits.mBlockWidth - 1) / traits.mBlockWidth * traits.mBytesPerBlock;
+        if (IsBlockCompressed(format))
+        {
+            BCn::DecodeRGBA32F(format, pSrc, mip.mWidth, mip.mHeight, decoded.data(), mip.mWidth * 4 * sizeof(float), srcRowPitch);
+        }
+        else
+        {
+            float* pDst = decoded.data();
+            uint32_t width = mip.mWidth;
+            uint64_t grainSize = (std::max)(TEXELS_PER_GRAIN / width, uint64_t{ 1 });
+            ParallelFor(0, mip.mHeight, grainSize, [=](uint64_t begin, uint64_t end)
+            {
+                for (uint64_t y = begin; y < end; ++y)
+                {
+                    FormatConversion::DecodeRow(format, pSrc + y * srcRowPitch, pDst + y * width * 4, width);
+                }
+            });
+        }
+
+        if (layout == TextureLayout::TILED)
+        {
+            mip.mTexels.resize(TiledLayout::GetTiledSize(mip.mWidth, mip.mHeight, 4 * sizeof(float)) / sizeof(float));
+            TiledLayout::LinearToTiled(reinterpret_cast<const byte*>(linearTexels.data()), mip.mWidth * 4 * sizeof(float),
+                                       reinterpret_cast<byte*>(mip.mTexels.data()), mip.mWidth, mip.mHeight, 4 * sizeof(float));
+        }
+    }
+}
+#endif
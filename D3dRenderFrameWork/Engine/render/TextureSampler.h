@@ -0,0 +1,98 @@
+#pragma once
+#ifdef WIN32
+#include "Engine/pch.h"
+#include "Engine/render/RawTexture.h"
+#include "Engine/render/TiledLayout.h"
+
+enum class SamplerFilter : uint8_t
+{
+    POINT,          // nearest texel of the nearest mip
+    LINEAR,         // trilinear
+    ANISOTROPIC,    // trilinear taps along the major axis of the footprint
+};
+
+enum class SamplerAddressMode : uint8_t
+{
+    WRAP,
+    CLAMP,
+};
+
+struct SamplerDesc
+{
+    SamplerFilter mFilter;
+    SamplerAddressMode mAddressU;
+    SamplerAddressMode mAddressV;
+    uint32_t mMaxAnisotropy;
+};
+
+// cpu sampling of one slice of a texture for baking and gpu free tests. the mips are decoded to linear rgba floats once,
+// samples are filtered 4 at a time with their coordinate math in sse lanes. mips are tiled unless asked otherwise,
+// so the rows of a bilinear footprint don't sit a whole texture row apart.
+// texel centers, wrapping and mip selection follow d3d12, results are not bit exact with any gpu.
+class TextureSampler
+{
+public:
+    // the sampler bound to s<shaderRegister> by D3dRenderer::sGetStaticSamplers.
+    static SamplerDesc sGetStaticSampler(uint32_t shaderRegister);
+
+    // like SampleLevel, every sample reads at the same lod.
+    void sampleLevel(const SamplerDesc& sampler, const float* pU, const float* pV, float lod,
+                     float* pRgba, uint64_t count) const;
+    // like SampleLevel with a lod per sample.
+    void sampleLevel(const SamplerDesc& sampler, const float* pU, const float* pV, const float* pLods,
+                     float* pRgba, uint64_t count) const;
+    // like SampleGrad, lod and anisotropy come from the uv derivatives of each sample.
+    void sampleGrad(const SamplerDesc& sampler, const float* pU, const float* pV,
+                    const float* pDuDx, const float* pDvDx, const float* pDuDy, const float* pDvDy,
+                    float* pRgba, uint64_t count) const;
+    uint8_t numMips() const;
+
+    explicit TextureSampler(const RawTexture& texture, uint32_t slice = 0, TextureLayout layout = TextureLayout::TILED);
+
+    DELETE_COPY_CONSTRUCTOR(TextureSampler)
+    DELETE_COPY_OPERATOR(TextureSampler)
+    DEFAULT_MOVE_CONSTRUCTOR(TextureSampler)
+    DEFAULT_MOVE_OPERATOR(TextureSampler)
+
+private:
+    struct Mip
+    {
+        uint32_t mWidth;
+        uint32_t mHeight;
+        TiledLayout::TileGrid mGrid;
+        std::vector<float> mTexels;     // rgba
+    };
+
+    // where the taps of 4 samples land, the lanes of a batch may read different mips
+    struct TapBatch
+    {
+        alignas(16) float mU[4];
+        alignas(16) float mV[4];
+        alignas(16) float mLod[4];
+        alignas(16) float mWeight[4];
+    };
+
+    const float* texelPtr(const Mip& mip, int32_t x, int32_t y) const;
+    // lodStride 0 reads the same lod for every sample
+    void sampleLevels(const SamplerDesc& sampler, const float* pU, const float* pV, const float* pLods, uint64_t lodStride,
+                      float* pRgba, uint64_t count) const;
+    void sampleMips(const SamplerDesc& sampler, const TapBatch& taps, float* pResult) const;
+    void accumulateTaps(bool isLinear, bool isWrapU, bool isWrapV, const uint8_t* pMips, const float* pU, const float* pV,
+                        const float* pWeights, float* pResult) const;
+
+    std::vector<Mip> mMips;
+    TextureLayout mLayout;
+};
+
+inline const float* TextureSampler::texelPtr(const Mip& mip, int32_t x, int32_t y) const
+{
+    uint64_t index = mLayout == TextureLayout::TILED ? TiledLayout::GetTexelIndex(mip.mGrid, x, y) :
+            static_cast<uint64_t>(y) * mip.mWidth + x;
+    return mip.mTexels.data() + index * 4;
+}
+
+inline uint8_t TextureSampler::numMips() const
+{
+    return static_cast<uint8_t>(mMips.size());
+}
+#endif
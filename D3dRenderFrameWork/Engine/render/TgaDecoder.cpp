@@ -0,0 +1,287 @@
+#include "Engine/render/TgaDecoder.h"
+
+namespace
+{
+    constexpr uint8_t TGA_COLOR_MAPPED = 1;
+    constexpr uint8_t TGA_TRUE_COLOR = 2;
+    constexpr uint8_t TGA_GRAY = 3;
+    constexpr uint8_t TGA_RLE_BIT = 8;
+
+    uint16_t ReadLE16(const byte* pData)
+    {
+        return static_cast<uint16_t>(pData[0] | pData[1] << 8);
+    }
+
+    uint8_t Expand5(uint32_t value)
+    {
+        return static_cast<uint8_t>(value << 3 | value >> 2);
+    }
+
+    // tga stores color as bgr(a), 15 / 16 bit pixels are 5:5:5 with an optional attribute bit
+    void BgrToRgba(const byte* pSrc, uint8_t size, bool hasAlpha, byte* pDst)
+    {
+        switch (size)
+        {
+        case 2:
+        {
+            uint16_t value = ReadLE16(pSrc);
+            pDst[0] = Expand5((value >> 10) & 0x1F);
+            pDst[1] = Expand5((value >> 5) & 0x1F);
+            pDst[2] = Expand5(value & 0x1F);
+            pDst[3] = !hasAlpha || (value & 0x8000) ? 0xFF : 0;
+            break;
+        }
+        case 3:
+            pDst[0] = pSrc[2];
+            pDst[1] = pSrc[1];
+            pDst[2] = pSrc[0];
+            pDst[3] = 0xFF;
+            break;
+        default:
+            pDst[0] = pSrc[2];
+            pDst[1] = pSrc[1];
+            pDst[2] = pSrc[0];
+            pDst[3] = hasAlpha ? pSrc[3] : 0xFF;
+            break;
+        }
+    }
+}
+
+TgaDecoder::TgaDecoder() :
+    mPixelIndex(0), mNumPixels(0), mSkipRemaining(0), mColorMapRemaining(0), mColorMapFirst(0), mPacketRemaining(0),
+    mHeader(), mPixel(), mStagingSize(0), mImageType(0), mPixelSize(0), mMapEntrySize(0), mTexelSize(0),
+    mIsRunLength(false), mIsRunPacket(false), mIsTopDown(false), mIsRightToLeft(false), mHasAlpha(false),
+    mState(State::HEADER) { }
+
+TgaDecoder::~TgaDecoder() = default;
+
+DecodeStatus TgaDecoder::fail()
+{
+    mState = State::FAILED;
+    return DecodeStatus::FAILED;
+}
+
+bool TgaDecoder::parseHeader()
+{
+    uint8_t colorMapType = mHeader[1];
+    mImageType = mHeader[2] & ~TGA_RLE_BIT;
+    mIsRunLength = mHeader[2] & TGA_RLE_BIT;
+    mColorMapFirst = ReadLE16(mHeader + 3);
+    uint32_t colorMapLength = ReadLE16(mHeader + 5);
+    uint8_t colorMapDepth = mHeader[7];
+    uint32_t width = ReadLE16(mHeader + 12);
+    uint32_t height = ReadLE16(mHeader + 14);
+    uint8_t pixelDepth = mHeader[16];
+    uint8_t descriptor = mHeader[17];
+    if (width == 0 || height == 0 || mHeader[2] & ~(TGA_RLE_BIT | 3) || colorMapType > 1) return false;
+
+    mIsTopDown = descriptor & 0x20;
+    mIsRightToLeft = descriptor & 0x10;
+    mPixelSize = static_cast<uint8_t>((pixelDepth + 7) / 8);
+    switch (mImageType)
+    {
+    case TGA_COLOR_MAPPED:
+        if (colorMapType != 1 || (pixelDepth != 8 && pixelDepth != 16)) return false;
+        if (colorMapDepth != 15 && colorMapDepth != 16 && colorMapDepth != 24 && colorMapDepth != 32) return false;
+        mInfo.mFormat = TextureFormat::R8G8B8A8_UNORM;
+        break;
+    case TGA_TRUE_COLOR:
+        if (pixelDepth != 15 && pixelDepth != 16 && pixelDepth != 24 && pixelDepth != 32) return false;
+        mInfo.mFormat = TextureFormat::R8G8B8A8_UNORM;
+        break;
+    case TGA_GRAY:
+        if (pixelDepth != 8 && pixelDepth != 16) return false;
+        mInfo.mFormat = pixelDepth == 8 ? TextureFormat::R8_UNORM : TextureFormat::R8G8_UNORM;
+        break;
+    default:
+        return false;
+    }
+    // 32 bit pixels always carry alpha, 16 bit ones only when the descriptor says there is an attribute bit
+    mHasAlpha = (mImageType == TGA_COLOR_MAPPED ? colorMapDepth : pixelDepth) == 32 || (descriptor & 0xF) != 0;
+    mMapEntrySize = static_cast<uint8_t>((colorMapDepth + 7) / 8);
+    mTexelSize = GetFormatTraits(mInfo.mFormat).mBytesPerBlock;
+
+    mInfo.mWidth = width;
+    mInfo.mHeight = height;
+    mNumPixels = static_cast<uint64_t>(width) * height;
+    mSkipRemaining = mHeader[0];
+    mColorMapRemaining = colorMapType == 1 ? colorMapLength * mMapEntrySize : 0;
+    mColorMap.clear();
+    mColorMap.reserve(mColorMapRemaining);
+    return true;
+}
+
+void TgaDecoder::convertPixel(const byte* pSrc, byte* pDst) const
+{
+    switch (mImageType)
+    {
+    case TGA_GRAY:
+        pDst[0] = pSrc[0];
+        if (mPixelSize == 2) pDst[1] = pSrc[1];
+        break;
+    case TGA_TRUE_COLOR:
+        BgrToRgba(pSrc, mPixelSize, mHasAlpha, pDst);
+        break;
+    default:
+    {
+        uint32_t index = mPixelSize == 1 ? pSrc[0] : ReadLE16(pSrc);
+        index -= mColorMapFirst;
+        if (index < mColorMap.size() / 4) memcpy(pDst, &mColorMap[index * 4], 4);
+        else memset(pDst, 0, 4);
+        break;
+    }
+    }
+}
+
+byte* TgaDecoder::texelPtr(uint64_t pixel) const
+{
+    uint64_t x = pixel % mInfo.mWidth;
+    uint64_t y = pixel / mInfo.mWidth;
+    if (!mIsTopDown) y = mInfo.mHeight - 1 - y;
+    if (mIsRightToLeft) x = mInfo.mWidth - 1 - x;
+    return mDestination.mData + y * mDestination.mRowPitch + x * mTexelSize;
+}
+
+void TgaDecoder::writePixels(const byte* pSrc, uint32_t count, bool isRun)
+{
+    byte texel[4];
+    if (isRun) convertPixel(pSrc, texel);
+    // walk row segments so the destination pointer only has to be computed once per row
+    while (count)
+    {
+        uint32_t x = static_cast<uint32_t>(mPixelIndex % mInfo.mWidth);
+        uint32_t n = (std::min)(count, mInfo.mWidth - x);
+        byte* pDst = texelPtr(mPixelIndex);
+        int64_t step = mIsRightToLeft ? -static_cast<int64_t>(mTexelSize) : mTexelSize;
+        for (uint32_t i = 0; i < n; ++i, pDst += step)
+        {
+            if (isRun)
+            {
+                memcpy(pDst, texel, mTexelSize);
+            }
+            else
+            {
+                convertPixel(pSrc, pDst);
+                pSrc += mPixelSize;
+            }
+        }
+        mPixelIndex += n;
+        count -= n;
+    }
+}
+
+DecodeStatus TgaDecoder::feed(const byte* pData, uint64_t size, uint64_t* pConsumed)
+{
+    const byte* p = pData;
+    const byte* pEnd = pData + size;
+    DecodeStatus status = DecodeStatus::NEED_INPUT;
+    bool isRunning = true;
+    while (isRunning)
+    {
+        switch (mState)
+        {
+        case State::HEADER:
+        {
+            uint64_t n = (std::min)(static_cast<uint64_t>(sizeof(mHeader) - mStagingSize), static_cast<uint64_t>(pEnd - p));
+            memcpy(mHeader + mStagingSize, p, n);
+            mStagingSize = static_cast<uint8_t>(mStagingSize + n);
+            p += n;
+            if (mStagingSize < sizeof(mHeader)) { isRunning = false; break; }
+            mStagingSize = 0;
+            if (!parseHeader()) { status = fail(); isRunning = false; break; }
+            mState = State::IMAGE_ID;
+            break;
+        }
+        case State::IMAGE_ID:
+        {
+            uint64_t n = (std::min)(static_cast<uint64_t>(mSkipRemaining), static_cast<uint64_t>(pEnd - p));
+            p += n;
+            mSkipRemaining -= static_cast<uint32_t>(n);
+            if (mSkipRemaining) { isRunning = false; break; }
+            mState = State::COLOR_MAP;
+            break;
+        }
+        case State::COLOR_MAP:
+        {
+            uint64_t n = (std::min)(static_cast<uint64_t>(mColorMapRemaining), static_cast<uint64_t>(pEnd - p));
+            mColorMap.insert(mColorMap.end(), p, p + n);
+            p += n;
+            mColorMapRemaining -= static_cast<uint32_t>(n);
+            if (mColorMapRemaining) { isRunning = false; break; }
+            if (!mColorMap.empty())
+            {
+                std::vector<byte> colorMap(mColorMap.size() / mMapEntrySize * 4);
+                for (uint64_t i = 0; i < colorMap.size() / 4; ++i)
+                {
+                    BgrToRgba(&mColorMap[i * mMapEntrySize], mMapEntrySize, mHasAlpha, &colorMap[i * 4]);
+                }
+                mColorMap.swap(colorMap);
+            }
+            // uncompressed images are a single raw packet spanning every pixel
+            mPacketRemaining = mIsRunLength ? 0 : static_cast<uint32_t>(mNumPixels);
+            mIsRunPacket = false;
+            mState = mIsRunLength ? State::PACKET_HEADER : State::PIXELS;
+            break;
+        }
+        case State::PACKET_HEADER:
+        {
+            if (!mDestination.mData) { status = DecodeStatus::NEED_DESTINATION; isRunning = false; break; }
+            if (p == pEnd) { isRunning = false; break; }
+            uint8_t header = *p++;
+            mIsRunPacket = header & 0x80;
+            // packets running past the last pixel are clipped
+            mPacketRemaining = static_cast<uint32_t>((std::min)(static_cast<uint64_t>((header & 0x7F) + 1), mNumPixels - mPixelIndex));
+            mState = State::PIXELS;
+            break;
+        }
+        case State::PIXELS:
+        {
+            if (!mDestination.mData) { status = DecodeStatus::NEED_DESTINATION; isRunning = false; break; }
+            // finish a pixel split across two feeds first
+            if (mStagingSize || mIsRunPacket)
+            {
+                uint64_t n = (std::min)(static_cast<uint64_t>(mPixelSize - mStagingSize), static_cast<uint64_t>(pEnd - p));
+                memcpy(mPixel + mStagingSize, p, n);
+                mStagingSize = static_cast<uint8_t>(mStagingSize + n);
+                p += n;
+                if (mStagingSize < mPixelSize) { isRunning = false; break; }
+                mStagingSize = 0;
+                uint32_t count = mIsRunPacket ? mPacketRemaining : 1;
+                writePixels(mPixel, count, mIsRunPacket);
+                mPacketRemaining -= count;
+            }
+            if (mPacketRemaining)
+            {
+                uint32_t count = static_cast<uint32_t>((std::min)(static_cast<uint64_t>(mPacketRemaining),
+                                                                  static_cast<uint64_t>(pEnd - p) / mPixelSize));
+                writePixels(p, count, false);
+                p += static_cast<uint64_t>(count) * mPixelSize;
+                mPacketRemaining -= count;
+                if (mPacketRemaining)
+                {
+                    // keep the partial pixel for the next feed
+                    uint64_t n = static_cast<uint64_t>(pEnd - p);
+                    memcpy(mPixel, p, n);
+                    mStagingSize = static_cast<uint8_t>(n);
+                    p += n;
+                    isRunning = false;
+                    break;
+                }
+            }
+            if (mPixelIndex == mNumPixels) mState = State::DONE;
+            else if (mIsRunLength) mState = State::PACKET_HEADER;
+            break;
+        }
+        case State::DONE:
+            status = DecodeStatus::DONE;
+            isRunning = false;
+            break;
+        case State::FAILED:
+            status = DecodeStatus::FAILED;
+            isRunning = false;
+            break;
+        }
+    }
+    if (pConsumed) *pConsumed = static_cast<uint64_t>(p - pData);
+    return status;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Engine/pch.h"
+#include "Engine/render/ImageDecoder.h"
+
+// streaming tga decoder for true color, gray and color mapped images, raw or run length encoded.
+// pixels are flipped into top down order on the fly, so rows land in the destination in their final place.
+// 8 bit gray -> R8, 16 bit gray alpha -> R8G8, everything else -> R8G8B8A8.
+class TgaDecoder : public ImageDecoder
+{
+public:
+    DecodeStatus feed(const byte* pData, uint64_t size, uint64_t* pConsumed) override;
+
+    TgaDecoder();
+    ~TgaDecoder() override;
+
+private:
+    enum class State : uint8_t
+    {
+        HEADER,
+        IMAGE_ID,
+        COLOR_MAP,
+        PACKET_HEADER,
+        PIXELS,
+        DONE,
+        FAILED,
+    };
+
+    bool parseHeader();
+    void convertPixel(const byte* pSrc, byte* pDst) const;
+    byte* texelPtr(uint64_t pixel) const;
+    void writePixels(const byte* pSrc, uint32_t count, bool isRun);
+    DecodeStatus fail();
+
+    std::vector<byte> mColorMap;        // expanded to rgba8
+    uint64_t mPixelIndex;
+    uint64_t mNumPixels;
+    uint32_t mSkipRemaining;
+    uint32_t mColorMapRemaining;
+    uint32_t mColorMapFirst;
+    uint32_t mPacketRemaining;
+    uint8_t mHeader[18];
+    uint8_t mPixel[4];
+    uint8_t mStagingSize;
+    uint8_t mImageType;
+    uint8_t mPixelSize;                 // bytes per stored pixel or color map index
+    uint8_t mMapEntrySize;
+    uint8_t mTexelSize;
+    bool mIsRunLength;
+    bool mIsRunPacket;
+    bool mIsTopDown;
+    bool mIsRightToLeft;
+    bool mHasAlpha;
+    State mState;
+};
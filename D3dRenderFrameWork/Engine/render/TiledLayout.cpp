@@ -0,0 +1,90 @@
+#include "Engine/render/TiledLayout.h"
+#include "Engine/common/Parallel.h"
+
+#undef max
+#undef min
+
+namespace
+{
+    // tiles per parallel grain when converting
+    constexpr uint64_t TILES_PER_GRAIN = 4 * 1024;
+
+    uint32_t CeilLog2(uint32_t value)
+    {
+        uint32_t bits = 0;
+        while ((1u << bits) < value) ++bits;
+        return bits;
+    }
+}
+
+TiledLayout::TileGrid TiledLayout::GetTileGrid(uint32_t width, uint32_t height)
+{
+    uint32_t bitsX = CeilLog2((width + TILE_SIZE - 1) / TILE_SIZE);
+    uint32_t bitsY = CeilLog2((height + TILE_SIZE - 1) / TILE_SIZE);
+    return { (std::min)(bitsX, bitsY), 1u << bitsX, 1u << bitsY };
+}
+
+uint64_t TiledLayout::GetTiledSize(uint32_t width, uint32_t height, uint32_t texelSize)
+{
+    TileGrid grid = GetTileGrid(width, height);
+    return static_cast<uint64_t>(grid.mTilesX) * grid.mTilesY * TILE_SIZE * TILE_SIZE * texelSize;
+}
+
+void TiledLayout::LinearToTiled(const byte* pSrc, uint64_t srcRowPitch, byte* pDst,
+                                uint32_t width, uint32_t height, uint32_t texelSize)
+{
+    TileGrid grid = GetTileGrid(width, height);
+    uint32_t tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    uint32_t tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    uint64_t grainSize = (std::max)(TILES_PER_GRAIN / tilesX, uint64_t{ 1 });
+    ParallelFor(0, tilesY, grainSize, [=](uint64_t begin, uint64_t end)
+    {
+        for (uint32_t tileY = static_cast<uint32_t>(begin); tileY < end; ++tileY)
+        {
+            for (uint32_t tileX = 0; tileX < tilesX; ++tileX)
+            {
+                byte* pTile = pDst + GetTileIndex(grid, tileX, tileY) * TILE_SIZE * TILE_SIZE * texelSize;
+                uint32_t x = tileX * TILE_SIZE;
+                uint32_t numColumns = (std::min)(width - x, TILE_SIZE);
+                for (uint32_t row = 0; row < TILE_SIZE; ++row)
+                {
+                    uint32_t y = (std::min)(tileY * TILE_SIZE + row, height - 1);
+                    const byte* pRow = pSrc + y * srcRowPitch + static_cast<uint64_t>(x) * texelSize;
+                    byte* pTileRow = pTile + row * TILE_SIZE * texelSize;
+                    memcpy(pTileRow, pRow, numColumns * texelSize);
+                    for (uint32_t column = numColumns; column < TILE_SIZE; ++column)
+                    {
+                        memcpy(pTileRow + column * texelSize, pRow + (numColumns - 1) * texelSize, texelSize);
+                    }
+                }
+            }
+        }
+    });
+}
+
+void TiledLayout::TiledToLinear(const byte* pSrc, byte* pDst, uint64_t dstRowPitch,
+                                uint32_t width, uint32_t height, uint32_t texelSize)
+{
+    TileGrid grid = GetTileGrid(width, height);
+    uint32_t tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    uint32_t tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    uint64_t grainSize = (std::max)(TILES_PER_GRAIN / tilesX, uint64_t{ 1 });
+    ParallelFor(0, tilesY, grainSize, [=](uint64_t begin, uint64_t end)
+    {
+        for (uint32_t tileY = static_cast<uint32_t>(begin); tileY < end; ++tileY)
+        {
+            uint32_t numRows = (std::min)(height - tileY * TILE_SIZE, TILE_SIZE);
+            for (uint32_t tileX = 0; tileX < tilesX; ++tileX)
+            {
+                const byte* pTile = GetTile(pSrc, grid, tileX, tileY, texelSize);
+                uint32_t x = tileX * TILE_SIZE;
+                uint32_t numColumns = (std::min)(width - x, TILE_SIZE);
+                for (uint32_t row = 0; row < numRows; ++row)
+                {
+                    byte* pRow = pDst + (tileY * TILE_SIZE + row) * dstRowPitch + static_cast<uint64_t>(x) * texelSize;
+                    memcpy(pRow, pTile + row * TILE_SIZE * texelSize, numColumns * texelSize);
+                }
+            }
+        }
+    });
+}
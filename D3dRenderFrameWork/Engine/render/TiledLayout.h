@@ -0,0 +1,64 @@
+#pragma once
+#include "Engine/pch.h"
+
+enum class TextureLayout : uint8_t
+{
+    LINEAR,     // row major, what the gpu upload paths expect
+    TILED,      // 4x4 texel tiles along a z order curve
+};
+
+// a tile holds 4 rows of 4 texels back to back, for 4 byte texels that is exactly one cache line.
+// tiles follow a z order curve over the tile grid padded to powers of two per axis, once the shorter axis
+// runs out of bits the longer one continues with whole z order squares. bilinear footprints and vertical
+// neighbours stay within a few cache lines. texels of partial edge tiles repeat the nearest edge texel.
+namespace TiledLayout
+{
+    constexpr uint32_t TILE_SIZE = 4;
+
+    struct TileGrid
+    {
+        uint32_t mSharedBits;   // bits of the tile coordinates that are interleaved
+        uint32_t mTilesX;       // padded to a power of two
+        uint32_t mTilesY;
+    };
+
+    TileGrid GetTileGrid(uint32_t width, uint32_t height);
+    uint64_t GetTiledSize(uint32_t width, uint32_t height, uint32_t texelSize);
+
+    void LinearToTiled(const byte* pSrc, uint64_t srcRowPitch, byte* pDst,
+                       uint32_t width, uint32_t height, uint32_t texelSize);
+    void TiledToLinear(const byte* pSrc, byte* pDst, uint64_t dstRowPitch,
+                       uint32_t width, uint32_t height, uint32_t texelSize);
+
+    // spreads the bits of value over the even bits of the result
+    inline uint64_t SpreadBits(uint32_t value)
+    {
+        uint64_t bits = value;
+        bits = (bits | bits << 16) & 0x0000FFFF0000FFFFull;
+        bits = (bits | bits << 8) & 0x00FF00FF00FF00FFull;
+        bits = (bits | bits << 4) & 0x0F0F0F0F0F0F0F0Full;
+        bits = (bits | bits << 2) & 0x3333333333333333ull;
+        bits = (bits | bits << 1) & 0x5555555555555555ull;
+        return bits;
+    }
+
+    inline uint64_t GetTileIndex(const TileGrid& grid, uint32_t tileX, uint32_t tileY)
+    {
+        uint32_t mask = (1u << grid.mSharedBits) - 1;
+        uint64_t interleaved = SpreadBits(tileX & mask) | SpreadBits(tileY & mask) << 1;
+        // only the longer axis has bits left
+        uint64_t remaining = (tileX >> grid.mSharedBits) | (tileY >> grid.mSharedBits);
+        return interleaved | remaining << (2 * grid.mSharedBits);
+    }
+
+    inline uint64_t GetTexelIndex(const TileGrid& grid, uint32_t x, uint32_t y)
+    {
+        return GetTileIndex(grid, x / TILE_SIZE, y / TILE_SIZE) * TILE_SIZE * TILE_SIZE + (y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE;
+    }
+
+    // the 16 texels of a tile, row major
+    inline const byte* GetTile(const byte* pTiled, const TileGrid& grid, uint32_t tileX, uint32_t tileY, uint32_t texelSize)
+    {
+        return pTiled + GetTileIndex(grid, tileX, tileY) * TILE_SIZE * TILE_SIZE * texelSize;
+    }
+}
@@ -9,12 +9,15 @@ cbuffer PassConstants : register(b0)
 	float4 lightDirection;  
 }
 
-cbuffer ObjectConstants : register(b2)
+struct ObjectMatrices
 {
 	float4x4 m_model;
-	float4x4 m_view;
-	float4x4 m_proj;
-}
+	float4x4 m_modelViewProj;
+	float4x4 m_normal;      // inverse transpose of m_model
+};
+
+// transforms of the instances of a draw, starts at its first instance
+StructuredBuffer<ObjectMatrices> gInstances : register(t0);
 
 struct VertexInput
 {
@@ -39,11 +42,10 @@ struct FragInput
     float4 color : COLOR;
 };
 
-FragInput VsMain(SimpleVertexInput input)
+FragInput VsMain(SimpleVertexInput input, uint instanceId : SV_InstanceID)
 {
     FragInput o;
-    float4 worldPosition = mul(m_model, float4(input.position, 1));
-    o.position = mul(m_proj, mul(m_view, worldPosition));
+    o.position = mul(gInstances[instanceId].m_modelViewProj, float4(input.position, 1));
     o.color = float4(input.position + 0.5, 1);
     //o.position = mul(float4(input.position, 1), objectTransform.m_model);
     //o.position = float4(input.position, 1);